@@ -32,6 +32,7 @@
 #include <cmath>
 
 #define MAX_STACK_SIZE 64
+#define BIH_RAY_PACKET_SIZE 8
 
 static inline uint32 floatToRawIntBits(float f)
 {
@@ -257,6 +258,202 @@ class BIH
             }
         }
 
+        /**
+        Traverses the tree once for a packet of up to BIH_RAY_PACKET_SIZE rays.
+        A node is entered when any ray of the packet reaches it, the clip tests are done
+        for all rays at once on per lane arrays, so the compiler can vectorize them.
+        maxDist and the callback behave like in intersectRay(), with the index of the ray
+        in the packet passed to the callback first.
+        */
+        template<typename RayCallback>
+        void intersectRayPacket(const G3D::Ray* rays, uint32 count, RayCallback& intersectCallback, float* maxDist, bool stopAtFirst=false) const
+        {
+            uint32 const N = BIH_RAY_PACKET_SIZE;
+            if (count > N)
+                count = N;
+
+            float org[3][N];
+            float invDir[3][N];
+            bool negative[3][N];
+            float intervalMin[N];
+            float intervalMax[N];
+            uint32 mask = 0;
+
+            for (uint32 r = 0; r < N; ++r)
+            {
+                uint32 const lane = r < count ? r : 0;  // unused lanes repeat the first ray
+                G3D::Vector3 const& o = rays[lane].origin();
+                G3D::Vector3 const& d = rays[lane].direction();
+                intervalMin[r] = -1.f;
+                intervalMax[r] = -1.f;
+                bool inside = r < count;
+                for (int i=0; i<3; ++i)
+                {
+                    org[i][r] = o[i];
+                    invDir[i][r] = 1.f / d[i];
+                    negative[i][r] = (floatToRawIntBits(d[i]) >> 31) != 0;
+                    if (G3D::fuzzyNe(d[i], 0.0f))
+                    {
+                        float t1 = (bounds.low()[i]  - o[i]) * invDir[i][r];
+                        float t2 = (bounds.high()[i] - o[i]) * invDir[i][r];
+                        if (t1 > t2)
+                            std::swap(t1, t2);
+                        if (t1 > intervalMin[r])
+                            intervalMin[r] = t1;
+                        if (t2 < intervalMax[r] || intervalMax[r] < 0.f)
+                            intervalMax[r] = t2;
+                        if (intervalMax[r] <= 0 || intervalMin[r] >= maxDist[lane])
+                            inside = false;
+                    }
+                }
+
+                if (inside && intervalMin[r] <= intervalMax[r])
+                {
+                    intervalMin[r] = std::max(intervalMin[r], 0.f);
+                    intervalMax[r] = std::min(intervalMax[r], maxDist[lane]);
+                    mask |= 1 << r;
+                }
+            }
+
+            if (!mask)
+                return;
+
+            PacketStackNode stack[MAX_STACK_SIZE];
+            int stackPos = 0;
+            int node = 0;
+            uint32 finished = 0;    // rays that stopped at their first hit
+
+            while (true) {
+                while (true)
+                {
+                    uint32 tn = tree[node];
+                    uint32 axis = (tn & (3 << 30)) >> 30;
+                    bool BVH2 = tn & (1 << 29);
+                    int offset = tn & ~(7 << 29);
+                    if (!BVH2)
+                    {
+                        if (axis < 3)
+                        {
+                            // "normal" interior node, the left child ends at tl, the right one starts at tr
+                            float const tl = intBitsToFloat(tree[node + 1]);
+                            float const tr = intBitsToFloat(tree[node + 2]);
+                            float leftMin[N], leftMax[N], rightMin[N], rightMax[N];
+                            for (uint32 r = 0; r < N; ++r)
+                            {
+                                float const dl = (tl - org[axis][r]) * invDir[axis][r];
+                                float const dr = (tr - org[axis][r]) * invDir[axis][r];
+                                leftMin[r]  = negative[axis][r] ? std::max(intervalMin[r], dl) : intervalMin[r];
+                                leftMax[r]  = negative[axis][r] ? intervalMax[r] : std::min(intervalMax[r], dl);
+                                rightMin[r] = negative[axis][r] ? intervalMin[r] : std::max(intervalMin[r], dr);
+                                rightMax[r] = negative[axis][r] ? std::min(intervalMax[r], dr) : intervalMax[r];
+                            }
+
+                            uint32 leftMask = 0;
+                            uint32 rightMask = 0;
+                            for (uint32 r = 0; r < N; ++r)
+                            {
+                                leftMask |= uint32(leftMin[r] <= leftMax[r]) << r;
+                                rightMask |= uint32(rightMin[r] <= rightMax[r]) << r;
+                            }
+                            leftMask &= mask;
+                            rightMask &= mask;
+
+                            // all rays pass between clip zones
+                            if (!leftMask && !rightMask)
+                                break;
+
+                            if (leftMask && rightMask)
+                            {
+                                // both children are needed, push back right node
+                                stack[stackPos].node = offset + 3;
+                                stack[stackPos].mask = rightMask;
+                                std::copy(rightMin, rightMin + N, stack[stackPos].tnear);
+                                std::copy(rightMax, rightMax + N, stack[stackPos].tfar);
+                                stackPos++;
+                            }
+
+                            if (leftMask)
+                            {
+                                node = offset;
+                                mask = leftMask;
+                                std::copy(leftMin, leftMin + N, intervalMin);
+                                std::copy(leftMax, leftMax + N, intervalMax);
+                            }
+                            else
+                            {
+                                node = offset + 3;
+                                mask = rightMask;
+                                std::copy(rightMin, rightMin + N, intervalMin);
+                                std::copy(rightMax, rightMax + N, intervalMax);
+                            }
+                            continue;
+                        }
+                        else
+                        {
+                            // leaf - test some objects against every ray that got here
+                            int n = tree[node + 1];
+                            while (n > 0 && mask) {
+                                for (uint32 r = 0; r < count; ++r)
+                                {
+                                    if (!(mask & (1 << r)))
+                                        continue;
+
+                                    bool hit = intersectCallback(r, rays[r], objects[offset], maxDist[r], stopAtFirst);
+                                    if (stopAtFirst && hit)
+                                    {
+                                        mask &= ~(1 << r);
+                                        finished |= 1 << r;
+                                    }
+                                }
+                                --n;
+                                ++offset;
+                            }
+                            break;
+                        }
+                    }
+                    else
+                    {
+                        if (axis>2)
+                            return; // should not happen
+                        float const tl = intBitsToFloat(tree[node + 1]);
+                        float const tr = intBitsToFloat(tree[node + 2]);
+                        uint32 overlap = 0;
+                        for (uint32 r = 0; r < N; ++r)
+                        {
+                            float const dl = (tl - org[axis][r]) * invDir[axis][r];
+                            float const dr = (tr - org[axis][r]) * invDir[axis][r];
+                            intervalMin[r] = std::max(intervalMin[r], negative[axis][r] ? dr : dl);
+                            intervalMax[r] = std::min(intervalMax[r], negative[axis][r] ? dl : dr);
+                            overlap |= uint32(intervalMin[r] <= intervalMax[r]) << r;
+                        }
+                        node = offset;
+                        mask &= overlap;
+                        if (!mask)
+                            break;
+                        continue;
+                    }
+                } // traversal loop
+                do
+                {
+                    // stack is empty?
+                    if (stackPos == 0)
+                        return;
+                    // move back up the stack
+                    stackPos--;
+                    mask = stack[stackPos].mask & ~finished;
+                    std::copy(stack[stackPos].tnear, stack[stackPos].tnear + N, intervalMin);
+                    std::copy(stack[stackPos].tfar, stack[stackPos].tfar + N, intervalMax);
+                    for (uint32 r = 0; r < count; ++r)
+                        if (maxDist[r] < intervalMin[r])
+                            mask &= ~(1 << r);
+                    if (!mask)
+                        continue;
+                    node = stack[stackPos].node;
+                    break;
+                } while (true);
+            }
+        }
+
         template<typename IsectCallback>
         void intersectPoint(const G3D::Vector3 &p, IsectCallback& intersectCallback) const
         {
@@ -356,6 +553,13 @@ class BIH
             float tnear;
             float tfar;
         };
+        struct PacketStackNode
+        {
+            uint32 node;
+            uint32 mask;
+            float tnear[BIH_RAY_PACKET_SIZE];
+            float tfar[BIH_RAY_PACKET_SIZE];
+        };
 
         class BuildStats
         {
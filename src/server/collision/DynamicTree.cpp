@@ -19,12 +19,13 @@
 #include "DynamicTree.h"
 //#include "QuadTree.h"
 //#include "RegularGrid.h"
-#include "BoundingIntervalHierarchyWrapper.h"
+#include "PhasedBIHWrap.h"
 
 #include "Log.h"
 #include "RegularGrid.h"
 #include "Timer.h"
 #include "GameObjectModel.h"
+#include "IVMapManager.h"
 #include "ModelInstance.h"
 
 #include <G3D/AABox.h>
@@ -52,17 +53,22 @@ template<> struct BoundsTrait< GameObjectModel> {
     static void getBounds2(const GameObjectModel* g, G3D::AABox& out) { out = g->getBounds();}
 };
 
+template<> struct PhaseTrait< GameObjectModel> {
+    static uint32 getPhaseMask(const GameObjectModel& g) { return g.getPhaseMask(); }
+};
+
 /*
 static bool operator == (const GameObjectModel& mdl, const GameObjectModel& mdl2){
     return &mdl == &mdl2;
 }
 */
 
-typedef RegularGrid2D<GameObjectModel, BIHWrap<GameObjectModel> > ParentTree;
+typedef RegularGrid2D<GameObjectModel, PhasedBIHWrap<GameObjectModel> > ParentTree;
 
 struct DynTreeImpl : public ParentTree/*, public Intersectable*/
 {
     typedef GameObjectModel Model;
+    typedef PhasedBIHWrap<GameObjectModel> Node;
     typedef ParentTree base;
 
     DynTreeImpl() :
@@ -83,12 +89,31 @@ struct DynTreeImpl : public ParentTree/*, public Intersectable*/
         ++unbalanced_times;
     }
 
+    void refresh(const Model& mdl)
+    {
+        if (Node** node = memberTable.getPointer(&mdl))
+        {
+            (*node)->refresh(mdl);
+            ++unbalanced_times;
+        }
+    }
+
     void balance()
     {
         base::balance();
         unbalanced_times = 0;
     }
 
+    // rebuilds only the buckets with enough changes, the others keep testing their few new models one by one
+    void balanceChanged()
+    {
+        for (int x = 0; x < CELL_NUMBER; ++x)
+            for (int y = 0; y < CELL_NUMBER; ++y)
+                if (Node* n = nodes[x][y])
+                    n->balance(false);
+        unbalanced_times = 0;
+    }
+
     void update(uint32 difftime)
     {
         if (!size())
@@ -99,7 +124,7 @@ struct DynTreeImpl : public ParentTree/*, public Intersectable*/
         {
             rebalance_timer.Reset(CHECK_TREE_PERIOD);
             if (unbalanced_times > 0)
-                balance();
+                balanceChanged();
         }
     }
 
@@ -107,7 +132,7 @@ struct DynTreeImpl : public ParentTree/*, public Intersectable*/
     int unbalanced_times;
 };
 
-DynamicMapTree::DynamicMapTree() : impl(new DynTreeImpl()) { }
+DynamicMapTree::DynamicMapTree() : impl(new DynTreeImpl()), _generation(0) { }
 
 DynamicMapTree::~DynamicMapTree()
 {
@@ -117,11 +142,19 @@ DynamicMapTree::~DynamicMapTree()
 void DynamicMapTree::insert(const GameObjectModel& mdl)
 {
     impl->insert(mdl);
+    ++_generation;
 }
 
 void DynamicMapTree::remove(const GameObjectModel& mdl)
 {
     impl->remove(mdl);
+    ++_generation;
+}
+
+void DynamicMapTree::refresh(const GameObjectModel& mdl)
+{
+    impl->refresh(mdl);
+    ++_generation;
 }
 
 bool DynamicMapTree::contains(const GameObjectModel& mdl) const
@@ -151,8 +184,11 @@ struct DynamicTreeIntersectionCallback
     DynamicTreeIntersectionCallback(uint32 phasemask) : did_hit(false), phase_mask(phasemask) { }
     bool operator()(const G3D::Ray& r, const GameObjectModel& obj, float& distance)
     {
-        did_hit = obj.intersectRay(r, distance, true, phase_mask);
-        return did_hit;
+        // a miss must not clear a hit found before
+        bool hit = obj.intersectRay(r, distance, true, phase_mask);
+        if (hit)
+            did_hit = true;
+        return hit;
     }
     bool didHit() const { return did_hit;}
 };
@@ -247,6 +283,20 @@ bool DynamicMapTree::isInLineOfSight(float x1, float y1, float z1, float x2, flo
     return !callback.did_hit;
 }
 
+void DynamicMapTree::isInLineOfSight(VMAP::LineOfSightQuery* queries, uint32 count) const
+{
+    // most maps have no dynamic models at all
+    if (!impl->size())
+        return;
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        VMAP::LineOfSightQuery& query = queries[i];
+        if (query.result)
+            query.result = isInLineOfSight(query.x1, query.y1, query.z1, query.x2, query.y2, query.z2, query.phasemask);
+    }
+}
+
 float DynamicMapTree::getHeight(float x, float y, float z, float maxSearchDist, uint32 phasemask) const
 {
     G3D::Vector3 v(x, y, z);
@@ -28,12 +28,18 @@ namespace G3D
     class Vector3;
 }
 
+namespace VMAP
+{
+    struct LineOfSightQuery;
+}
+
 class GameObjectModel;
 struct DynTreeImpl;
 
 class DynamicMapTree
 {
     DynTreeImpl *impl;
+    uint32 _generation;
 
 public:
 
@@ -42,6 +48,8 @@ public:
 
     bool isInLineOfSight(float x1, float y1, float z1, float x2, float y2,
                          float z2, uint32 phasemask) const;
+    // only refines queries whose result is still true, so it can run after the static tree
+    void isInLineOfSight(VMAP::LineOfSightQuery* queries, uint32 count) const;
 
     bool getIntersectionTime(uint32 phasemask, const G3D::Ray& ray,
                              const G3D::Vector3& endPos, float& maxDist) const;
@@ -57,6 +65,12 @@ public:
     bool contains(const GameObjectModel&) const;
     int size() const;
 
+    // models enabled or disabled in place, moves them to the bucket of their new phase mask
+    void refresh(const GameObjectModel&);
+
+    // bumped whenever a query could give a different result than before
+    uint32 getGeneration() const { return _generation; }
+
     void balance();
     void update(uint32 diff);
 };
@@ -20,6 +20,7 @@
 #define _IVMAPMANAGER_H
 
 #include <string>
+#include <vector>
 #include "Define.h"
 
 //===========================================================
@@ -41,6 +42,51 @@ namespace VMAP
     #define VMAP_INVALID_HEIGHT       -100000.0f            // for check
     #define VMAP_INVALID_HEIGHT_VALUE -200000.0f            // real assigned value in unknown height case
 
+    /**
+    One line of sight query of a batch, result is filled by the batched isInLineOfSight().
+    phasemask is only used by the dynamic tree, the static models are visible in every phase.
+    */
+    struct LineOfSightQuery
+    {
+        float x1, y1, z1;
+        float x2, y2, z2;
+        uint32 phasemask;
+        bool result;
+    };
+
+    /**
+    One height query of a batch, height is filled by the batched getHeight().
+    phasemask is only used by the dynamic tree, like for LineOfSightQuery.
+    */
+    struct HeightQuery
+    {
+        float x, y, z;
+        uint32 phasemask;
+        float height;
+    };
+
+    /**
+    Area info and liquid of one point, as getAreaInfo() and GetLiquidLevel()
+    would return them, collected by getAreaAndLiquidData() in one tree descent.
+    */
+    struct AreaAndLiquidData
+    {
+        AreaAndLiquidData() : hasAreaInfo(false), areaFloorZ(0.0f), mogpFlags(0), adtId(0), rootId(0), groupId(0),
+            hasLiquid(false), liquidLevel(VMAP_INVALID_HEIGHT), liquidFloorZ(VMAP_INVALID_HEIGHT), liquidType(0) { }
+
+        bool hasAreaInfo;
+        float areaFloorZ;
+        uint32 mogpFlags;
+        int32 adtId;
+        int32 rootId;
+        int32 groupId;
+
+        bool hasLiquid;
+        float liquidLevel;
+        float liquidFloorZ;             // also set without liquid when the point is inside a WMO, like GetLiquidLevel() does
+        uint32 liquidType;
+    };
+
     //===========================================================
     class IVMapManager
     {
@@ -57,12 +103,25 @@ namespace VMAP
 
             virtual bool existsMap(const char* pBasePath, unsigned int pMapId, int x, int y) = 0;
 
+            /**
+            Read the models used by a map tile ahead of loadMap(), may be called from any thread.
+            The acquired model names are added to pModels and held until releaseTileModels() is called with them.
+            */
+            virtual bool prefetchMapTile(const char* pBasePath, unsigned int pMapId, int x, int y, std::vector<std::string>& pModels) = 0;
+            virtual void releaseTileModels(std::vector<std::string> const& pModels) = 0;
+
             virtual void unloadMap(unsigned int pMapId, int x, int y) = 0;
             virtual void unloadMap(unsigned int pMapId) = 0;
 
             virtual bool isInLineOfSight(unsigned int pMapId, float x1, float y1, float z1, float x2, float y2, float z2) = 0;
             virtual float getHeight(unsigned int pMapId, float x, float y, float z, float maxSearchDist) = 0;
             /**
+            Batched versions of the above for many queries on the same map, e.g. all targets of an area spell.
+            The rays share the tree traversals, results are the same as calling the single versions in a loop.
+            */
+            virtual void isInLineOfSight(unsigned int pMapId, LineOfSightQuery* pQueries, uint32 pCount) = 0;
+            virtual void getHeight(unsigned int pMapId, HeightQuery* pQueries, uint32 pCount, float maxSearchDist) = 0;
+            /**
             test if we hit an object. return true if we hit one. rx, ry, rz will hold the hit position or the dest position, if no intersection was found
             return a position, that is pReduceDist closer to the origin
             */
@@ -94,6 +153,7 @@ namespace VMAP
             */
             virtual bool getAreaInfo(unsigned int pMapId, float x, float y, float &z, uint32 &flags, int32 &adtId, int32 &rootId, int32 &groupId) const=0;
             virtual bool GetLiquidLevel(uint32 pMapId, float x, float y, float z, uint8 ReqLiquidType, float &level, float &floor, uint32 &type) const=0;
+            virtual void getAreaAndLiquidData(unsigned int pMapId, float x, float y, float z, uint8 reqLiquidType, AreaAndLiquidData& data) const=0;
     };
 
 }
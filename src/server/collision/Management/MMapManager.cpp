@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MMapManager.h"
+#include "MapDefines.h"
+#include "Errors.h"
+#include "Log.h"
+
+#include <ace/Guard_T.h>
+#include <cstring>
+#include <vector>
+
+namespace MMAP
+{
+    MMapData::~MMapData()
+    {
+        for (NavMeshQuerySet::iterator i = navMeshQueries.begin(); i != navMeshQueries.end(); ++i)
+            dtFreeNavMeshQuery(i->second);
+
+        if (navMesh)
+            dtFreeNavMesh(navMesh);
+    }
+
+    // ######################## MMapManager ########################
+    MMapManager::~MMapManager()
+    {
+        for (MMapDataSet::iterator i = iLoadedMMaps.begin(); i != iLoadedMMaps.end(); ++i)
+            delete i->second;
+
+        // by now we should not have maps loaded
+        // if we had, tiles in MMapData->mmapLoadedTiles, their actual data is lost!
+    }
+
+    bool MMapManager::loadMapData(const std::string& basePath, uint32 mapId)
+    {
+        // we already have this map loaded?
+        if (iLoadedMMaps.find(mapId) != iLoadedMMaps.end())
+            return true;
+
+        // load and init dtNavMesh - read parameters from file
+        int const len = basePath.length() + strlen("/%03i.mmap") + 1;
+        std::vector<char> fileName(len);
+        snprintf(fileName.data(), len, (basePath + "/%03i.mmap").c_str(), mapId);
+        FILE* file = fopen(fileName.data(), "rb");
+        if (!file)
+        {
+            TC_LOG_DEBUG("maps", "MMAP:loadMapData: Error: Could not open mmap file '%s'", fileName.data());
+            return false;
+        }
+
+        dtNavMeshParams params;
+        uint32 count = uint32(fread(&params, sizeof(dtNavMeshParams), 1, file));
+        fclose(file);
+        if (count != 1)
+        {
+            TC_LOG_DEBUG("maps", "MMAP:loadMapData: Error: Could not read params from file '%s'", fileName.data());
+            return false;
+        }
+
+        dtNavMesh* mesh = dtAllocNavMesh();
+        ASSERT(mesh);
+        if (dtStatusFailed(mesh->init(&params)))
+        {
+            dtFreeNavMesh(mesh);
+            TC_LOG_ERROR("maps", "MMAP:loadMapData: Failed to initialize dtNavMesh for mmap %03u from file %s", mapId, fileName.data());
+            return false;
+        }
+
+        TC_LOG_DEBUG("maps", "MMAP:loadMapData: Loaded %03i.mmap", mapId);
+
+        // store inside our map list
+        iLoadedMMaps.insert(MMapDataSet::value_type(mapId, new MMapData(mesh)));
+        return true;
+    }
+
+    bool MMapManager::loadMap(const std::string& basePath, uint32 mapId, int32 x, int32 y)
+    {
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, iLoadedMMapsLock, false);
+
+        // make sure the mmap is loaded and ready to load tiles
+        if (!loadMapData(basePath, mapId))
+            return false;
+
+        // get this mmap data
+        MMapData* mmap = iLoadedMMaps[mapId];
+        ASSERT(mmap->navMesh);
+
+        // check if we already have this tile loaded
+        uint32 packedGridPos = packTileID(x, y);
+        if (mmap->loadedTileRefs.find(packedGridPos) != mmap->loadedTileRefs.end())
+            return false;
+
+        // load this tile :: mmaps/MMMXXYY.mmtile
+        int const len = basePath.length() + strlen("/%03i%02i%02i.mmtile") + 1;
+        std::vector<char> fileName(len);
+        snprintf(fileName.data(), len, (basePath + "/%03i%02i%02i.mmtile").c_str(), mapId, x, y);
+        FILE* file = fopen(fileName.data(), "rb");
+        if (!file)
+        {
+            TC_LOG_DEBUG("maps", "MMAP:loadMap: Could not open mmtile file '%s'", fileName.data());
+            return false;
+        }
+
+        // read header
+        MmapTileHeader fileHeader;
+        if (fread(&fileHeader, sizeof(MmapTileHeader), 1, file) != 1 || fileHeader.mmapMagic != MMAP_MAGIC)
+        {
+            TC_LOG_ERROR("maps", "MMAP:loadMap: Bad header in mmap %03u%02i%02i.mmtile", mapId, x, y);
+            fclose(file);
+            return false;
+        }
+
+        if (fileHeader.mmapVersion != MMAP_VERSION || fileHeader.dtVersion != uint32(DT_NAVMESH_VERSION))
+        {
+            TC_LOG_ERROR("maps", "MMAP:loadMap: %03u%02i%02i.mmtile was built with generator v%i, expected v%i",
+                mapId, x, y, fileHeader.mmapVersion, MMAP_VERSION);
+            fclose(file);
+            return false;
+        }
+
+        unsigned char* data = (unsigned char*)dtAlloc(fileHeader.size, DT_ALLOC_PERM);
+        ASSERT(data);
+
+        size_t result = fread(data, fileHeader.size, 1, file);
+        fclose(file);
+        if (!result)
+        {
+            TC_LOG_ERROR("maps", "MMAP:loadMap: Bad header or data in mmap %03u%02i%02i.mmtile", mapId, x, y);
+            dtFree(data);
+            return false;
+        }
+
+        dtMeshHeader* header = (dtMeshHeader*)data;
+        dtTileRef tileRef = 0;
+
+        // memory allocated for data is now managed by detour, and will be deallocated when the tile is removed
+        dtStatus addResult;
+        {
+            ACE_WRITE_GUARD_RETURN(ACE_RW_Thread_Mutex, navMeshGuard, mmap->navMeshLock, false);
+            addResult = mmap->navMesh->addTile(data, fileHeader.size, DT_TILE_FREE_DATA, 0, &tileRef);
+        }
+
+        if (dtStatusSucceed(addResult))
+        {
+            mmap->loadedTileRefs.insert(std::pair<uint32, dtTileRef>(packedGridPos, tileRef));
+            ++iLoadedTiles;
+            TC_LOG_DEBUG("maps", "MMAP:loadMap: Loaded mmtile %03i[%02i,%02i] into %03i[%02i,%02i]", mapId, x, y, mapId, header->x, header->y);
+            return true;
+        }
+
+        TC_LOG_ERROR("maps", "MMAP:loadMap: Could not load %03u%02i%02i.mmtile into navmesh", mapId, x, y);
+        dtFree(data);
+        return false;
+    }
+
+    bool MMapManager::unloadMap(uint32 mapId, int32 x, int32 y)
+    {
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, iLoadedMMapsLock, false);
+
+        // check if we have this map loaded
+        MMapDataSet::const_iterator itr = iLoadedMMaps.find(mapId);
+        if (itr == iLoadedMMaps.end())
+        {
+            // file may not exist, therefore not loaded
+            TC_LOG_DEBUG("maps", "MMAP:unloadMap: Asked to unload not loaded navmesh map. %03u%02i%02i.mmtile", mapId, x, y);
+            return false;
+        }
+
+        MMapData* mmap = itr->second;
+
+        // check if we have this tile loaded
+        uint32 packedGridPos = packTileID(x, y);
+        MMapTileSet::iterator tile = mmap->loadedTileRefs.find(packedGridPos);
+        if (tile == mmap->loadedTileRefs.end())
+        {
+            // file may not exist, therefore not loaded
+            TC_LOG_DEBUG("maps", "MMAP:unloadMap: Asked to unload not loaded navmesh tile. %03u%02i%02i.mmtile", mapId, x, y);
+            return false;
+        }
+
+        // unload, and mark as non loaded
+        dtStatus removeResult;
+        {
+            ACE_WRITE_GUARD_RETURN(ACE_RW_Thread_Mutex, navMeshGuard, mmap->navMeshLock, false);
+            removeResult = mmap->navMesh->removeTile(tile->second, NULL, NULL);
+        }
+
+        if (dtStatusFailed(removeResult))
+        {
+            // this is technically a memory leak
+            // if the grid is later reloaded, dtNavMesh::addTile will return error but no extra memory is used
+            // we cannot recover from this error - assert out
+            TC_LOG_ERROR("maps", "MMAP:unloadMap: Could not unload %03u%02i%02i.mmtile from navmesh", mapId, x, y);
+            ASSERT(false);
+        }
+
+        mmap->loadedTileRefs.erase(tile);
+        --iLoadedTiles;
+        TC_LOG_DEBUG("maps", "MMAP:unloadMap: Unloaded mmtile %03i[%02i,%02i] from %03i", mapId, x, y, mapId);
+        return true;
+    }
+
+    bool MMapManager::unloadMap(uint32 mapId)
+    {
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, iLoadedMMapsLock, false);
+
+        MMapDataSet::iterator itr = iLoadedMMaps.find(mapId);
+        if (itr == iLoadedMMaps.end())
+        {
+            // file may not exist, therefore not loaded
+            TC_LOG_DEBUG("maps", "MMAP:unloadMap: Asked to unload not loaded navmesh map %03u", mapId);
+            return false;
+        }
+
+        // unload all tiles from given map
+        MMapData* mmap = itr->second;
+        {
+            ACE_WRITE_GUARD_RETURN(ACE_RW_Thread_Mutex, navMeshGuard, mmap->navMeshLock, false);
+            for (MMapTileSet::iterator i = mmap->loadedTileRefs.begin(); i != mmap->loadedTileRefs.end(); ++i)
+            {
+                uint32 x = (i->first >> 16);
+                uint32 y = (i->first & 0x0000FFFF);
+                if (dtStatusFailed(mmap->navMesh->removeTile(i->second, NULL, NULL)))
+                    TC_LOG_ERROR("maps", "MMAP:unloadMap: Could not unload %03u%02i%02i.mmtile from navmesh", mapId, x, y);
+                else
+                {
+                    --iLoadedTiles;
+                    TC_LOG_DEBUG("maps", "MMAP:unloadMap: Unloaded mmtile %03i[%02i,%02i] from %03i", mapId, x, y, mapId);
+                }
+            }
+        }
+
+        delete mmap;
+        iLoadedMMaps.erase(itr);
+        TC_LOG_DEBUG("maps", "MMAP:unloadMap: Unloaded %03i.mmap", mapId);
+
+        return true;
+    }
+
+    bool MMapManager::unloadMapInstance(uint32 mapId, uint32 instanceId)
+    {
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, iLoadedMMapsLock, false);
+
+        // check if we have this map loaded
+        MMapDataSet::const_iterator itr = iLoadedMMaps.find(mapId);
+        if (itr == iLoadedMMaps.end())
+        {
+            // file may not exist, therefore not loaded
+            TC_LOG_DEBUG("maps", "MMAP:unloadMapInstance: Asked to unload not loaded navmesh map %03u", mapId);
+            return false;
+        }
+
+        MMapData* mmap = itr->second;
+        NavMeshQuerySet::iterator query = mmap->navMeshQueries.find(instanceId);
+        if (query == mmap->navMeshQueries.end())
+        {
+            TC_LOG_DEBUG("maps", "MMAP:unloadMapInstance: Asked to unload not loaded dtNavMeshQuery mapId %03u instanceId %u", mapId, instanceId);
+            return false;
+        }
+
+        dtFreeNavMeshQuery(query->second);
+        mmap->navMeshQueries.erase(query);
+        TC_LOG_DEBUG("maps", "MMAP:unloadMapInstance: Unloaded mapId %03u instanceId %u", mapId, instanceId);
+
+        return true;
+    }
+
+    dtNavMesh const* MMapManager::GetNavMesh(uint32 mapId)
+    {
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, iLoadedMMapsLock, NULL);
+
+        MMapDataSet::const_iterator itr = iLoadedMMaps.find(mapId);
+        if (itr == iLoadedMMaps.end())
+            return NULL;
+
+        return itr->second->navMesh;
+    }
+
+    ACE_RW_Thread_Mutex* MMapManager::GetNavMeshLock(uint32 mapId)
+    {
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, iLoadedMMapsLock, NULL);
+
+        MMapDataSet::const_iterator itr = iLoadedMMaps.find(mapId);
+        if (itr == iLoadedMMaps.end())
+            return NULL;
+
+        return &itr->second->navMeshLock;
+    }
+
+    dtNavMeshQuery const* MMapManager::GetNavMeshQuery(uint32 mapId, uint32 instanceId)
+    {
+        ACE_GUARD_RETURN(ACE_Thread_Mutex, guard, iLoadedMMapsLock, NULL);
+
+        MMapDataSet::const_iterator itr = iLoadedMMaps.find(mapId);
+        if (itr == iLoadedMMaps.end())
+            return NULL;
+
+        MMapData* mmap = itr->second;
+        NavMeshQuerySet::const_iterator query = mmap->navMeshQueries.find(instanceId);
+        if (query != mmap->navMeshQueries.end())
+            return query->second;
+
+        // allocate mesh query, the node pool limits how far a single search may expand
+        dtNavMeshQuery* navMeshQuery = dtAllocNavMeshQuery();
+        ASSERT(navMeshQuery);
+        if (dtStatusFailed(navMeshQuery->init(mmap->navMesh, iMaxSearchNodes)))
+        {
+            dtFreeNavMeshQuery(navMeshQuery);
+            TC_LOG_ERROR("maps", "MMAP:GetNavMeshQuery: Failed to initialize dtNavMeshQuery for mapId %03u instanceId %u", mapId, instanceId);
+            return NULL;
+        }
+
+        TC_LOG_DEBUG("maps", "MMAP:GetNavMeshQuery: created dtNavMeshQuery for mapId %03u instanceId %u", mapId, instanceId);
+        mmap->navMeshQueries.insert(std::pair<uint32, dtNavMeshQuery*>(instanceId, navMeshQuery));
+        return navMeshQuery;
+    }
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MMAP_MANAGER_H
+#define _MMAP_MANAGER_H
+
+#include "Define.h"
+#include "DetourNavMesh.h"
+#include "DetourNavMeshQuery.h"
+
+#include <ace/RW_Thread_Mutex.h>
+#include <ace/Thread_Mutex.h>
+#include <string>
+#include <unordered_map>
+
+//  move map related classes
+namespace MMAP
+{
+    typedef std::unordered_map<uint32, dtTileRef> MMapTileSet;
+    typedef std::unordered_map<uint32, dtNavMeshQuery*> NavMeshQuerySet;
+
+    // navmesh of one map, shared by all of its instances
+    struct MMapData
+    {
+        MMapData(dtNavMesh* mesh) : navMesh(mesh) { }
+        ~MMapData();
+
+        dtNavMesh* navMesh;
+
+        // the instances of a map search the navmesh from their own threads while
+        // one of them loads or unloads tiles for the base map, tiles are only
+        // added and removed under the write lock and paths searched under the read lock
+        ACE_RW_Thread_Mutex navMeshLock;
+
+        // we have to use single dtNavMeshQuery for every instance, since those are not thread safe
+        NavMeshQuerySet navMeshQueries;     // instanceId to query
+        MMapTileSet loadedTileRefs;         // maps [map grid coords] to [dtTile]
+    };
+
+    typedef std::unordered_map<uint32, MMapData*> MMapDataSet;
+
+    // singleton class
+    // holds all all access to mmap loading unloading and meshes
+    class MMapManager
+    {
+        public:
+            MMapManager() : iLoadedTiles(0), iMaxSearchNodes(1024) { }
+            ~MMapManager();
+
+            // size of the node pool of each query, bounds the work a single path search can do
+            void setMaxSearchNodes(uint32 count) { iMaxSearchNodes = count; }
+
+            bool loadMap(const std::string& basePath, uint32 mapId, int32 x, int32 y);
+            bool unloadMap(uint32 mapId, int32 x, int32 y);
+            bool unloadMap(uint32 mapId);
+            bool unloadMapInstance(uint32 mapId, uint32 instanceId);
+
+            // the returned [dtNavMeshQuery const*] is NOT threadsafe, it must only be used by the map owning instanceId
+            dtNavMeshQuery const* GetNavMeshQuery(uint32 mapId, uint32 instanceId);
+            dtNavMesh const* GetNavMesh(uint32 mapId);
+            // to be read locked while using the navmesh or a query of mapId
+            ACE_RW_Thread_Mutex* GetNavMeshLock(uint32 mapId);
+
+            uint32 getLoadedTilesCount() const { return iLoadedTiles; }
+            uint32 getLoadedMapsCount() const { return iLoadedMMaps.size(); }
+
+        private:
+            bool loadMapData(const std::string& basePath, uint32 mapId);
+            uint32 packTileID(int32 x, int32 y) const { return uint32(x << 16 | y); }
+
+            MMapDataSet iLoadedMMaps;
+            uint32 iLoadedTiles;
+            uint32 iMaxSearchNodes;
+
+            // Maps of different ids load their tiles from different threads
+            ACE_Thread_Mutex iLoadedMMapsLock;
+    };
+}
+
+#endif
@@ -106,6 +106,32 @@ namespace VMAP
         return instanceTree->second->LoadMapTile(tileX, tileY, this);
     }
 
+    bool VMapManager2::prefetchMapTile(const char* basePath, unsigned int mapId, int x, int y, std::vector<std::string>& models)
+    {
+        if (!isMapLoadingEnabled())
+            return false;
+
+        std::string path = basePath;
+        if (path.length() > 0 && path[path.length()-1] != '/' && path[path.length()-1] != '\\')
+            path.push_back('/');
+
+        std::vector<std::string> names;
+        if (!StaticMapTree::ReadTileModelNames(path, mapId, x, y, names))
+            return false;
+
+        for (std::vector<std::string>::const_iterator itr = names.begin(); itr != names.end(); ++itr)
+            if (acquireModelInstance(path, *itr))
+                models.push_back(*itr);
+
+        return true;
+    }
+
+    void VMapManager2::releaseTileModels(std::vector<std::string> const& models)
+    {
+        for (std::vector<std::string>::const_iterator itr = models.begin(); itr != models.end(); ++itr)
+            releaseModelInstance(*itr);
+    }
+
     void VMapManager2::unloadMap(unsigned int mapId)
     {
         InstanceTreeMap::iterator instanceTree = iInstanceMapTrees.find(mapId);
@@ -153,6 +179,40 @@ namespace VMAP
         return true;
     }
 
+    void VMapManager2::isInLineOfSight(unsigned int mapId, LineOfSightQuery* queries, uint32 count)
+    {
+        InstanceTreeMap::iterator instanceTree = iInstanceMapTrees.end();
+        if (isLineOfSightCalcEnabled() && !DisableMgr::IsDisabledFor(DISABLE_TYPE_VMAP, mapId, NULL, VMAP_DISABLE_LOS))
+            instanceTree = iInstanceMapTrees.find(mapId);
+
+        if (instanceTree == iInstanceMapTrees.end())
+        {
+            for (uint32 i = 0; i < count; ++i)
+                queries[i].result = true;
+            return;
+        }
+
+        // converted in chunks on the stack, the tree splits them into ray packets
+        Vector3 pos1[BIH_RAY_PACKET_SIZE * 4];
+        Vector3 pos2[BIH_RAY_PACKET_SIZE * 4];
+        bool results[BIH_RAY_PACKET_SIZE * 4];
+        uint32 const chunkSize = BIH_RAY_PACKET_SIZE * 4;
+        for (uint32 start = 0; start < count; start += chunkSize)
+        {
+            uint32 size = std::min(count - start, chunkSize);
+            for (uint32 i = 0; i < size; ++i)
+            {
+                LineOfSightQuery const& query = queries[start + i];
+                pos1[i] = convertPositionToInternalRep(query.x1, query.y1, query.z1);
+                pos2[i] = convertPositionToInternalRep(query.x2, query.y2, query.z2);
+            }
+
+            instanceTree->second->isInLineOfSight(pos1, pos2, results, size);
+            for (uint32 i = 0; i < size; ++i)
+                queries[start + i].result = results[i];
+        }
+    }
+
     /**
     get the hit position and return true if we hit something
     otherwise the result pos will be the dest pos
@@ -206,6 +266,34 @@ namespace VMAP
         return VMAP_INVALID_HEIGHT_VALUE;
     }
 
+    void VMapManager2::getHeight(unsigned int mapId, HeightQuery* queries, uint32 count, float maxSearchDist)
+    {
+        InstanceTreeMap::iterator instanceTree = iInstanceMapTrees.end();
+        if (isHeightCalcEnabled() && !DisableMgr::IsDisabledFor(DISABLE_TYPE_VMAP, mapId, NULL, VMAP_DISABLE_HEIGHT))
+            instanceTree = iInstanceMapTrees.find(mapId);
+
+        if (instanceTree == iInstanceMapTrees.end())
+        {
+            for (uint32 i = 0; i < count; ++i)
+                queries[i].height = VMAP_INVALID_HEIGHT_VALUE;
+            return;
+        }
+
+        Vector3 pos[BIH_RAY_PACKET_SIZE * 4];
+        float heights[BIH_RAY_PACKET_SIZE * 4];
+        uint32 const chunkSize = BIH_RAY_PACKET_SIZE * 4;
+        for (uint32 start = 0; start < count; start += chunkSize)
+        {
+            uint32 size = std::min(count - start, chunkSize);
+            for (uint32 i = 0; i < size; ++i)
+                pos[i] = convertPositionToInternalRep(queries[start + i].x, queries[start + i].y, queries[start + i].z);
+
+            instanceTree->second->getHeight(pos, heights, size, maxSearchDist);
+            for (uint32 i = 0; i < size; ++i)
+                queries[start + i].height = heights[i] < G3D::inf() ? heights[i] : VMAP_INVALID_HEIGHT_VALUE;
+        }
+    }
+
     bool VMapManager2::getAreaInfo(unsigned int mapId, float x, float y, float& z, uint32& flags, int32& adtId, int32& rootId, int32& groupId) const
     {
         if (!DisableMgr::IsDisabledFor(DISABLE_TYPE_VMAP, mapId, NULL, VMAP_DISABLE_AREAFLAG))
@@ -249,25 +337,79 @@ namespace VMAP
         return false;
     }
 
+    void VMapManager2::getAreaAndLiquidData(unsigned int mapId, float x, float y, float z, uint8 reqLiquidType, AreaAndLiquidData& data) const
+    {
+        bool const checkArea = !DisableMgr::IsDisabledFor(DISABLE_TYPE_VMAP, mapId, NULL, VMAP_DISABLE_AREAFLAG);
+        bool const checkLiquid = !DisableMgr::IsDisabledFor(DISABLE_TYPE_VMAP, mapId, NULL, VMAP_DISABLE_LIQUIDSTATUS);
+        if (!checkArea && !checkLiquid)
+            return;
+
+        InstanceTreeMap::const_iterator instanceTree = iInstanceMapTrees.find(mapId);
+        if (instanceTree == iInstanceMapTrees.end())
+            return;
+
+        Vector3 pos = convertPositionToInternalRep(x, y, z);
+        AreaInfo areaInfo;
+        LocationInfo info;
+        bool const hasLocation = instanceTree->second->getAreaAndLocationInfo(pos, areaInfo, info);
+
+        if (checkArea && areaInfo.result)
+        {
+            data.hasAreaInfo = true;
+            data.areaFloorZ = areaInfo.ground_Z;
+            data.mogpFlags = areaInfo.flags;
+            data.adtId = areaInfo.adtId;
+            data.rootId = areaInfo.rootId;
+            data.groupId = areaInfo.groupId;
+        }
+
+        // same as GetLiquidLevel()
+        if (checkLiquid && hasLocation)
+        {
+            data.liquidFloorZ = info.ground_Z;
+            ASSERT(data.liquidFloorZ < std::numeric_limits<float>::max());
+            data.liquidType = info.hitModel->GetLiquidType();
+            if ((!reqLiquidType || (GetLiquidFlags(data.liquidType) & reqLiquidType)) && info.hitInstance->GetLiquidLevel(pos, info, data.liquidLevel))
+                data.hasLiquid = true;
+        }
+    }
+
     WorldModel* VMapManager2::acquireModelInstance(const std::string& basepath, const std::string& filename)
     {
-        //! Critical section, thread safe access to iLoadedModelFiles
+        {
+            //! Critical section, thread safe access to iLoadedModelFiles
+            ACE_Guard<ACE_Thread_Mutex> guard(LoadedModelFilesLock);
+
+            ModelFileMap::iterator model = iLoadedModelFiles.find(filename);
+            if (model != iLoadedModelFiles.end())
+            {
+                model->second.incRefCount();
+                return model->second.getModel();
+            }
+        }
+
+        // Read the file without holding the lock, so that the prefetch threads
+        // do not block map threads looking up models which are already loaded
+        WorldModel* worldmodel = new WorldModel();
+        if (!worldmodel->readFile(basepath + filename + ".vmo"))
+        {
+            TC_LOG_DEBUG("maps", "VMapManager2: could not load '%s%s.vmo'", basepath.c_str(), filename.c_str());
+            delete worldmodel;
+            return NULL;
+        }
+
         ACE_Guard<ACE_Thread_Mutex> guard(LoadedModelFilesLock);
 
         ModelFileMap::iterator model = iLoadedModelFiles.find(filename);
         if (model == iLoadedModelFiles.end())
         {
-            WorldModel* worldmodel = new WorldModel();
-            if (!worldmodel->readFile(basepath + filename + ".vmo"))
-            {
-                TC_LOG_DEBUG("maps", "VMapManager2: could not load '%s%s.vmo'", basepath.c_str(), filename.c_str());
-                delete worldmodel;
-                return NULL;
-            }
             TC_LOG_DEBUG("maps", "VMapManager2: loading file '%s%s'", basepath.c_str(), filename.c_str());
             model = iLoadedModelFiles.insert(std::pair<std::string, ManagedModel>(filename, ManagedModel())).first;
             model->second.setModel(worldmodel);
         }
+        else
+            delete worldmodel;                              // loaded by another thread meanwhile
+
         model->second.incRefCount();
         return model->second.getModel();
     }
@@ -90,20 +90,26 @@ namespace VMAP
 
             int loadMap(const char* pBasePath, unsigned int mapId, int x, int y);
 
+            bool prefetchMapTile(const char* pBasePath, unsigned int mapId, int x, int y, std::vector<std::string>& models);
+            void releaseTileModels(std::vector<std::string> const& models);
+
             void unloadMap(unsigned int mapId, int x, int y);
             void unloadMap(unsigned int mapId);
 
             bool isInLineOfSight(unsigned int mapId, float x1, float y1, float z1, float x2, float y2, float z2) ;
+            void isInLineOfSight(unsigned int mapId, LineOfSightQuery* queries, uint32 count);
             /**
             fill the hit pos and return true, if an object was hit
             */
             bool getObjectHitPos(unsigned int mapId, float x1, float y1, float z1, float x2, float y2, float z2, float& rx, float& ry, float& rz, float modifyDist);
             float getHeight(unsigned int mapId, float x, float y, float z, float maxSearchDist);
+            void getHeight(unsigned int mapId, HeightQuery* queries, uint32 count, float maxSearchDist);
 
             bool processCommand(char* /*command*/) { return false; } // for debug and extensions
 
             bool getAreaInfo(unsigned int pMapId, float x, float y, float& z, uint32& flags, int32& adtId, int32& rootId, int32& groupId) const;
             bool GetLiquidLevel(uint32 pMapId, float x, float y, float z, uint8 reqLiquidType, float& level, float& floor, uint32& type) const;
+            void getAreaAndLiquidData(unsigned int pMapId, float x, float y, float z, uint8 reqLiquidType, AreaAndLiquidData& data) const;
 
             WorldModel* acquireModelInstance(const std::string& basepath, const std::string& filename);
             void releaseModelInstance(const std::string& filename);
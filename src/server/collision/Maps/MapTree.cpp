@@ -50,6 +50,22 @@ namespace VMAP
         bool hit;
     };
 
+    class MapRayPacketCallback
+    {
+        public:
+            MapRayPacketCallback(ModelInstance* val, bool* hits): prims(val), hit(hits) { }
+            bool operator()(uint32 lane, const G3D::Ray& ray, uint32 entry, float& distance, bool pStopAtFirstHit=true)
+            {
+                bool result = prims[entry].intersectRay(ray, distance, pStopAtFirstHit);
+                if (result)
+                    hit[lane] = true;
+                return result;
+            }
+    protected:
+        ModelInstance* prims;
+        bool* hit;
+    };
+
     class AreaInfoCallback
     {
         public:
@@ -84,6 +100,23 @@ namespace VMAP
             bool result;
     };
 
+    class AreaAndLocationInfoCallback
+    {
+        public:
+            AreaAndLocationInfoCallback(ModelInstance* val, AreaInfo &area, LocationInfo &info): prims(val), aInfo(area), locInfo(info), result(false) { }
+            void operator()(const Vector3& point, uint32 entry)
+            {
+                prims[entry].intersectPoint(point, aInfo);
+                if (prims[entry].GetLocationInfo(point, locInfo))
+                    result = true;
+            }
+
+            ModelInstance* prims;
+            AreaInfo &aInfo;
+            LocationInfo &locInfo;
+            bool result;
+    };
+
     //=========================================================
 
     std::string StaticMapTree::getTileFileName(uint32 mapID, uint32 tileX, uint32 tileY)
@@ -119,6 +152,13 @@ namespace VMAP
         return intersectionCallBack.result;
     }
 
+    bool StaticMapTree::getAreaAndLocationInfo(const Vector3 &pos, AreaInfo &areaInfo, LocationInfo &info) const
+    {
+        AreaAndLocationInfoCallback intersectionCallBack(iTreeValues, areaInfo, info);
+        iTree.intersectPoint(pos, intersectionCallBack);
+        return intersectionCallBack.result;
+    }
+
     StaticMapTree::StaticMapTree(uint32 mapID, const std::string &basePath) :
         iMapID(mapID), iIsTiled(false), iTreeValues(NULL),
         iNTreeValues(0), iBasePath(basePath)
@@ -151,6 +191,21 @@ namespace VMAP
             pMaxDist = distance;
         return intersectionCallBack.didHit();
     }
+
+    void StaticMapTree::getIntersectionTimes(const G3D::Ray* pRays, float* pMaxDist, bool* pHits, uint32 pCount, bool pStopAtFirstHit) const
+    {
+        float distance[BIH_RAY_PACKET_SIZE];
+        for (uint32 i = 0; i < pCount; ++i)
+        {
+            distance[i] = pMaxDist[i];
+            pHits[i] = false;
+        }
+        MapRayPacketCallback intersectionCallBack(iTreeValues, pHits);
+        iTree.intersectRayPacket(pRays, pCount, intersectionCallBack, distance, pStopAtFirstHit);
+        for (uint32 i = 0; i < pCount; ++i)
+            if (pHits[i])
+                pMaxDist[i] = distance[i];
+    }
     //=========================================================
 
     bool StaticMapTree::isInLineOfSight(const Vector3& pos1, const Vector3& pos2) const
@@ -241,6 +296,75 @@ namespace VMAP
 
     //=========================================================
 
+    void StaticMapTree::isInLineOfSight(const Vector3* pos1, const Vector3* pos2, bool* pResults, uint32 pCount) const
+    {
+        G3D::Ray rays[BIH_RAY_PACKET_SIZE];
+        float maxDist[BIH_RAY_PACKET_SIZE];
+        bool hits[BIH_RAY_PACKET_SIZE];
+        uint32 index[BIH_RAY_PACKET_SIZE];
+        uint32 packetSize = 0;
+
+        for (uint32 i = 0; i < pCount; ++i)
+        {
+            // same special cases as the single ray version, only rays that need tracing go into the packet
+            float dist = (pos2[i] - pos1[i]).magnitude();
+            if (dist == std::numeric_limits<float>::max() || dist == std::numeric_limits<float>::infinity() ||
+                dist > std::numeric_limits<float>::max())
+            {
+                pResults[i] = false;
+                continue;
+            }
+            if (dist < 1e-10f)
+            {
+                pResults[i] = true;
+                continue;
+            }
+
+            rays[packetSize] = G3D::Ray::fromOriginAndDirection(pos1[i], (pos2[i] - pos1[i])/dist);
+            maxDist[packetSize] = dist;
+            index[packetSize] = i;
+            if (++packetSize < BIH_RAY_PACKET_SIZE && i + 1 < pCount)
+                continue;
+
+            getIntersectionTimes(rays, maxDist, hits, packetSize, true);
+            for (uint32 r = 0; r < packetSize; ++r)
+                pResults[index[r]] = !hits[r];
+            packetSize = 0;
+        }
+
+        if (packetSize)
+        {
+            getIntersectionTimes(rays, maxDist, hits, packetSize, true);
+            for (uint32 r = 0; r < packetSize; ++r)
+                pResults[index[r]] = !hits[r];
+        }
+    }
+
+    //=========================================================
+
+    void StaticMapTree::getHeight(const Vector3* pPos, float* pHeights, uint32 pCount, float maxSearchDist) const
+    {
+        G3D::Ray rays[BIH_RAY_PACKET_SIZE];
+        float maxDist[BIH_RAY_PACKET_SIZE];
+        bool hits[BIH_RAY_PACKET_SIZE];
+
+        for (uint32 start = 0; start < pCount; start += BIH_RAY_PACKET_SIZE)
+        {
+            uint32 packetSize = std::min<uint32>(pCount - start, BIH_RAY_PACKET_SIZE);
+            for (uint32 r = 0; r < packetSize; ++r)
+            {
+                rays[r] = G3D::Ray(pPos[start + r], Vector3(0, 0, -1));
+                maxDist[r] = maxSearchDist;
+            }
+
+            getIntersectionTimes(rays, maxDist, hits, packetSize, false);
+            for (uint32 r = 0; r < packetSize; ++r)
+                pHeights[start + r] = hits[r] ? pPos[start + r].z - maxDist[r] : G3D::inf();
+        }
+    }
+
+    //=========================================================
+
     bool StaticMapTree::CanLoadMap(const std::string &vmapPath, uint32 mapID, uint32 tileX, uint32 tileY)
     {
         std::string basePath = vmapPath;
@@ -422,6 +546,37 @@ namespace VMAP
         return result;
     }
 
+    //=========================================================
+    /**
+    Only reads the names of the models spawned on a tile, the tree is not touched,
+    so this may run on another thread than the one using the tree
+    */
+    bool StaticMapTree::ReadTileModelNames(const std::string &basePath, uint32 mapID, uint32 tileX, uint32 tileY, std::vector<std::string> &names)
+    {
+        std::string tilefile = basePath + getTileFileName(mapID, tileX, tileY);
+        FILE* tf = fopen(tilefile.c_str(), "rb");
+        if (!tf)
+            return false;
+
+        bool result = true;
+        char chunk[8];
+        uint32 numSpawns = 0;
+        if (!readChunk(tf, chunk, VMAP_MAGIC, 8) || fread(&numSpawns, sizeof(uint32), 1, tf) != 1)
+            result = false;
+
+        for (uint32 i = 0; i < numSpawns && result; ++i)
+        {
+            ModelSpawn spawn;
+            uint32 referencedVal;
+            result = ModelSpawn::readFromFile(tf, spawn) && fread(&referencedVal, sizeof(uint32), 1, tf) == 1;
+            if (result)
+                names.push_back(spawn.name);
+        }
+
+        fclose(tf);
+        return result;
+    }
+
     //=========================================================
 
     void StaticMapTree::UnloadMapTile(uint32 tileX, uint32 tileY, VMapManager2* vm)
@@ -23,6 +23,8 @@
 #include "BoundingIntervalHierarchy.h"
 
 #include <unordered_map>
+#include <string>
+#include <vector>
 
 namespace VMAP
 {
@@ -38,6 +40,8 @@ namespace VMAP
         float ground_Z;
     };
 
+    struct AreaInfo;
+
     class StaticMapTree
     {
         typedef std::unordered_map<uint32, bool> loadedTileMap;
@@ -60,12 +64,15 @@ namespace VMAP
 
         private:
             bool getIntersectionTime(const G3D::Ray& pRay, float &pMaxDist, bool pStopAtFirstHit) const;
+            // traces up to BIH_RAY_PACKET_SIZE rays in one tree traversal, pMaxDist and pHits are per ray
+            void getIntersectionTimes(const G3D::Ray* pRays, float* pMaxDist, bool* pHits, uint32 pCount, bool pStopAtFirstHit) const;
             //bool containsLoadedMapTile(unsigned int pTileIdent) const { return(iLoadedMapTiles.containsKey(pTileIdent)); }
         public:
             static std::string getTileFileName(uint32 mapID, uint32 tileX, uint32 tileY);
             static uint32 packTileID(uint32 tileX, uint32 tileY) { return tileX<<16 | tileY; }
             static void unpackTileID(uint32 ID, uint32 &tileX, uint32 &tileY) { tileX = ID>>16; tileY = ID&0xFF; }
             static bool CanLoadMap(const std::string &basePath, uint32 mapID, uint32 tileX, uint32 tileY);
+            static bool ReadTileModelNames(const std::string &basePath, uint32 mapID, uint32 tileX, uint32 tileY, std::vector<std::string> &names);
 
             StaticMapTree(uint32 mapID, const std::string &basePath);
             ~StaticMapTree();
@@ -73,8 +80,13 @@ namespace VMAP
             bool isInLineOfSight(const G3D::Vector3& pos1, const G3D::Vector3& pos2) const;
             bool getObjectHitPos(const G3D::Vector3& pos1, const G3D::Vector3& pos2, G3D::Vector3& pResultHitPos, float pModifyDist) const;
             float getHeight(const G3D::Vector3& pPos, float maxSearchDist) const;
+            // batched versions of the above, rays are traced in packets sharing one tree traversal
+            void isInLineOfSight(const G3D::Vector3* pos1, const G3D::Vector3* pos2, bool* pResults, uint32 pCount) const;
+            void getHeight(const G3D::Vector3* pPos, float* pHeights, uint32 pCount, float maxSearchDist) const;
             bool getAreaInfo(G3D::Vector3 &pos, uint32 &flags, int32 &adtId, int32 &rootId, int32 &groupId) const;
             bool GetLocationInfo(const G3D::Vector3 &pos, LocationInfo &info) const;
+            // both of the above in one tree descent, returns the result of GetLocationInfo()
+            bool getAreaAndLocationInfo(const G3D::Vector3 &pos, AreaInfo &areaInfo, LocationInfo &info) const;
 
             bool InitMap(const std::string &fname, VMapManager2* vm);
             void UnloadMap(VMapManager2* vm);
@@ -100,9 +100,13 @@ namespace VMAP
             unsigned int iCurrentUniqueNameId;
             MapData mapData;
             std::set<std::string> spawnedModelFiles;
+            uint32 iThreads;
+
+            bool convertMap(uint32 mapId, MapSpawns& spawns, std::set<std::string>& modelFiles) const;
 
         public:
-            TileAssembler(const std::string& pSrcDirName, const std::string& pDestDirName);
+            // pThreads models and maps are converted at the same time, 0 uses all cores
+            TileAssembler(const std::string& pSrcDirName, const std::string& pDestDirName, uint32 pThreads = 0);
             virtual ~TileAssembler();
 
             bool convertWorld2();
@@ -195,6 +195,13 @@ namespace VMAP
         return true;
     }
 
+    void WmoLiquid::getPosInfo(uint32 &tilesX, uint32 &tilesY, Vector3 &corner) const
+    {
+        tilesX = iTilesX;
+        tilesY = iTilesY;
+        corner = iCorner;
+    }
+
     uint32 WmoLiquid::GetFileSize()
     {
         return 2 * sizeof(uint32) +
@@ -410,6 +417,13 @@ namespace VMAP
         return 0;
     }
 
+    void GroupModel::getMeshData(std::vector<Vector3> &outVertices, std::vector<MeshTriangle> &outTriangles, WmoLiquid* &liquid)
+    {
+        outVertices = vertices;
+        outTriangles = triangles;
+        liquid = iLiquid;
+    }
+
     // ===================== WorldModel ==================================
 
     void WorldModel::setGroupModels(std::vector<GroupModel> &models)
@@ -583,4 +597,9 @@ namespace VMAP
         fclose(rf);
         return result;
     }
+
+    void WorldModel::getGroupModels(std::vector<GroupModel> &outGroupModels)
+    {
+        outGroupModels = groupModels;
+    }
 }
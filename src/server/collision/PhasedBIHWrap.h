@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _PHASED_BIH_WRAP
+#define _PHASED_BIH_WRAP
+
+#include "BoundingIntervalHierarchy.h"
+
+#include <G3D/BoundsTrait.h>
+
+#include <unordered_map>
+#include <vector>
+
+/// Provides the phase mask of a model, a model with mask 0 does not collide
+template<class T>
+struct PhaseTrait;
+
+/**
+Grid node of the dynamic tree. Models are kept in one bucket per phase mask,
+each with its own BIH, so queries skip the buckets of other phases entirely.
+Changes do not rebuild a tree right away: removed models leave an empty slot,
+inserted ones are tested one by one until balance() decides the bucket is
+worth rebuilding. Queries never rebuild, so they see a consistent node.
+Query callbacks have to expose the phase mask of the query as phase_mask.
+*/
+template<class T, class BoundsFunc = BoundsTrait<T>, class PhaseFunc = PhaseTrait<T> >
+class PhasedBIHWrap
+{
+    enum
+    {
+        MAX_PENDING_OBJECTS = 8     // inserted models tested linearly before the bucket is rebuilt
+    };
+
+    struct Bucket
+    {
+        Bucket(uint32 mask) : phasemask(mask), removed(0) { }
+
+        uint32 phasemask;
+        BIH tree;
+        std::vector<const T*> objects;      // as indexed by tree, NULL once removed
+        std::vector<const T*> pending;      // not in tree yet
+        uint32 removed;
+
+        bool needsRebuild() const { return pending.size() > MAX_PENDING_OBJECTS || removed * 2 > objects.size(); }
+        bool isDirty() const { return !pending.empty() || removed; }
+    };
+
+    template<class Callback>
+    struct TreeCallback
+    {
+        Bucket const& bucket;
+        Callback& callback;
+
+        TreeCallback(Bucket const& b, Callback& cb) : bucket(b), callback(cb) { }
+
+        bool operator() (const G3D::Ray& ray, uint32 idx, float& maxDist, bool /*stopAtFirst*/)
+        {
+            if (const T* obj = bucket.objects[idx])
+                return callback(ray, *obj, maxDist);
+            return false;
+        }
+
+        void operator() (const G3D::Vector3& point, uint32 idx)
+        {
+            if (const T* obj = bucket.objects[idx])
+                callback(point, *obj);
+        }
+    };
+
+    std::vector<Bucket> m_buckets;
+    std::unordered_map<const T*, uint32> m_bucketOf;   // model -> phase mask of its bucket
+
+    Bucket& getBucket(uint32 phasemask)
+    {
+        for (typename std::vector<Bucket>::iterator itr = m_buckets.begin(); itr != m_buckets.end(); ++itr)
+            if (itr->phasemask == phasemask)
+                return *itr;
+
+        m_buckets.push_back(Bucket(phasemask));
+        return m_buckets.back();
+    }
+
+    static void rebuild(Bucket& bucket)
+    {
+        std::vector<const T*> objects;
+        objects.reserve(bucket.objects.size() - bucket.removed + bucket.pending.size());
+        for (typename std::vector<const T*>::const_iterator itr = bucket.objects.begin(); itr != bucket.objects.end(); ++itr)
+            if (*itr)
+                objects.push_back(*itr);
+        objects.insert(objects.end(), bucket.pending.begin(), bucket.pending.end());
+
+        bucket.tree.build(objects, BoundsFunc::getBounds2);
+        bucket.objects.swap(objects);
+        bucket.pending.clear();
+        bucket.removed = 0;
+    }
+
+public:
+    void insert(const T& obj)
+    {
+        uint32 phasemask = PhaseFunc::getPhaseMask(obj);
+        getBucket(phasemask).pending.push_back(&obj);
+        m_bucketOf[&obj] = phasemask;
+    }
+
+    void remove(const T& obj)
+    {
+        typename std::unordered_map<const T*, uint32>::iterator itr = m_bucketOf.find(&obj);
+        if (itr == m_bucketOf.end())
+            return;
+
+        Bucket& bucket = getBucket(itr->second);
+        m_bucketOf.erase(itr);
+
+        for (typename std::vector<const T*>::iterator pending = bucket.pending.begin(); pending != bucket.pending.end(); ++pending)
+        {
+            if (*pending == &obj)
+            {
+                bucket.pending.erase(pending);
+                return;
+            }
+        }
+
+        for (typename std::vector<const T*>::iterator slot = bucket.objects.begin(); slot != bucket.objects.end(); ++slot)
+        {
+            if (*slot == &obj)
+            {
+                *slot = NULL;
+                ++bucket.removed;
+                return;
+            }
+        }
+    }
+
+    /// Moves a model whose phase mask changed in place to its new bucket
+    void refresh(const T& obj)
+    {
+        typename std::unordered_map<const T*, uint32>::const_iterator itr = m_bucketOf.find(&obj);
+        if (itr == m_bucketOf.end() || itr->second == PhaseFunc::getPhaseMask(obj))
+            return;
+
+        remove(obj);
+        insert(obj);
+    }
+
+    /// Rebuilds the buckets that changed, only those with many changes unless forced
+    void balance(bool force = true)
+    {
+        for (typename std::vector<Bucket>::iterator itr = m_buckets.begin(); itr != m_buckets.end();)
+        {
+            if (itr->objects.size() == itr->removed && itr->pending.empty())
+            {
+                itr = m_buckets.erase(itr);
+                continue;
+            }
+
+            if (force ? itr->isDirty() : itr->needsRebuild())
+                rebuild(*itr);
+            ++itr;
+        }
+    }
+
+    template<typename RayCallback>
+    void intersectRay(const G3D::Ray& ray, RayCallback& intersectCallback, float& maxDist)
+    {
+        for (typename std::vector<Bucket>::const_iterator itr = m_buckets.begin(); itr != m_buckets.end(); ++itr)
+        {
+            if (!(itr->phasemask & intersectCallback.phase_mask))
+                continue;
+
+            // the tree stops at its first hit, so do the other buckets and the pending models
+            TreeCallback<RayCallback> callback(*itr, intersectCallback);
+            itr->tree.intersectRay(ray, callback, maxDist, true);
+            if (intersectCallback.didHit())
+                return;
+
+            for (typename std::vector<const T*>::const_iterator pending = itr->pending.begin(); pending != itr->pending.end(); ++pending)
+                if (intersectCallback(ray, **pending, maxDist))
+                    return;
+        }
+    }
+
+    template<typename IsectCallback>
+    void intersectPoint(const G3D::Vector3& point, IsectCallback& intersectCallback)
+    {
+        for (typename std::vector<Bucket>::const_iterator itr = m_buckets.begin(); itr != m_buckets.end(); ++itr)
+        {
+            if (!(itr->phasemask & intersectCallback.phase_mask))
+                continue;
+
+            TreeCallback<IsectCallback> callback(*itr, intersectCallback);
+            itr->tree.intersectPoint(point, callback);
+            for (typename std::vector<const T*>::const_iterator pending = itr->pending.begin(); pending != itr->pending.end(); ++pending)
+                intersectCallback(point, **pending);
+        }
+    }
+};
+
+#endif // _PHASED_BIH_WRAP
@@ -32,6 +32,7 @@ class AggressorAI : public CreatureAI
         explicit AggressorAI(Creature* c) : CreatureAI(c) {}
 
         void UpdateAI(const uint32);
+        bool HasOutOfCombatTimers() const { return false; }
         static int Permissible(const Creature*);
 };
 
@@ -48,6 +49,7 @@ class CombatAI : public CreatureAI
         void JustDied(Unit* killer);
         void UpdateAI(const uint32 diff);
         void SpellInterrupted(uint32 spellId, uint32 unTimeMs) override;
+        bool HasOutOfCombatTimers() const { return false; }   // events are only scheduled in combat
         static int Permissible(const Creature*);
     protected:
         EventMap events;
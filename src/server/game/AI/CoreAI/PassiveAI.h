@@ -31,6 +31,7 @@ class PassiveAI : public CreatureAI
         void UpdateAI(const uint32);
 
         virtual bool IsPassived() { return true; }
+        bool HasOutOfCombatTimers() const { return false; }
 
         static int Permissible(const Creature*) { return PERMIT_BASE_IDLE;  }
 };
@@ -61,6 +62,7 @@ class NullCreatureAI : public CreatureAI
         void UpdateAI(const uint32) {}
         void EnterEvadeMode() {}
         void OnCharmed(bool /*apply*/) {}
+        bool HasOutOfCombatTimers() const { return false; }
 
         static int Permissible(const Creature*) { return PERMIT_BASE_IDLE;  }
 };
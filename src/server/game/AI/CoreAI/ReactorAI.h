@@ -32,6 +32,7 @@ class ReactorAI : public CreatureAI
         void MoveInLineOfSight(Unit*);
 
         void UpdateAI(const uint32);
+        bool HasOutOfCombatTimers() const { return false; }
         static int Permissible(const Creature*);
 };
 #endif
@@ -136,6 +136,9 @@ class CreatureAI : public UnitAI
         virtual bool IsEscorted() { return false; }
         virtual bool IsPassived() { return false; }
 
+        // Whether UpdateAI has timed work out of combat, such creatures keep the full update rate near players
+        virtual bool HasOutOfCombatTimers() const { return true; }
+
         // Called when creature is spawned or respawned (for reseting variables)
         virtual void JustRespawned() { Reset(); }
 
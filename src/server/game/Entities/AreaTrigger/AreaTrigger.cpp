@@ -184,6 +184,7 @@ void AreaTrigger::AddToWorld()
     if (!IsInWorld())
     {
         sObjectAccessor->AddObject(this);
+        GetMap()->GetObjectRegistry().Insert(GetGUID(), this);
         WorldObject::AddToWorld();
         BindToCaster();
     }
@@ -202,6 +203,7 @@ void AreaTrigger::RemoveFromWorld()
 
         UnbindFromCaster();
         WorldObject::RemoveFromWorld();
+        GetMap()->GetObjectRegistry().Remove(GetGUID());
         sObjectAccessor->RemoveObject(this);
     }
 }
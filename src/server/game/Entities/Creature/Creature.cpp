@@ -146,7 +146,7 @@ lootForPickPocketed(false), lootForBody(false), m_groupLootTimer(0), lootingGrou
 m_PlayerDamageReq(0), m_lootRecipient(0), m_lootRecipientGroup(0), m_corpseRemoveTime(0), m_respawnTime(0),
 m_respawnDelay(300), m_corpseDelay(60), m_respawnradius(0.0f), m_reactState(REACT_AGGRESSIVE),
 m_defaultMovementType(IDLE_MOTION_TYPE), m_DBTableGuid(0), m_equipmentId(0), m_AlreadyCallAssistance(false),
-m_AlreadySearchedAssistance(false), m_regenHealth(true), m_AI_locked(false), m_meleeDamageSchoolMask(SPELL_SCHOOL_MASK_NORMAL),
+m_AlreadySearchedAssistance(false), m_regenHealth(true), m_AI_locked(false), m_scriptedAI(false), m_meleeDamageSchoolMask(SPELL_SCHOOL_MASK_NORMAL),
 m_creatureInfo(NULL), m_creatureData(NULL), m_seerGUID(0), m_path_id(0), m_formation(NULL)
 {
     m_regenTimer = 0;
@@ -189,6 +189,7 @@ void Creature::AddToWorld()
         if (m_zoneScript)
             m_zoneScript->OnCreatureCreate(this);
         sObjectAccessor->AddObject(this);
+        GetMap()->GetObjectRegistry().Insert(GetGUID(), this);
         Unit::AddToWorld();
         SearchFormation();
         AIM_Initialize();
@@ -206,6 +207,7 @@ void Creature::RemoveFromWorld()
         if (m_formation)
             sFormationMgr->RemoveCreatureFromGroup(m_formation, this);
         Unit::RemoveFromWorld();
+        GetMap()->GetObjectRegistry().Remove(GetGUID());
         sObjectAccessor->RemoveObject(this);
     }
 }
@@ -639,6 +641,50 @@ void Creature::Update(uint32 diff)
     }
 }
 
+bool Creature::CanUpdateAtIdleRate(bool nearPlayers) const
+{
+    // anything a player could notice being late stays at full rate: combat,
+    // spline movement, casts, scheduled events and the respawn and death
+    // transitions, as well as creatures belonging to someone
+    if (m_deathState == JUST_DIED || m_deathState == JUST_RESPAWNED || TriggerJustRespawned)
+        return false;
+
+    if (IsInCombat() || IsInEvadeMode() || !movespline->Finalized())
+        return false;
+
+    if (IsSummon() || GetCharmerOrOwnerGUID() || isActiveObject())
+        return false;
+
+    if (!m_Events.Empty() || IsNonMeleeSpellCasted(false))
+        return false;
+
+    // periodic effects tick at most once per update and timed auras would miss
+    // their last ticks, so only permanent passive auras allow skipping updates
+    for (AuraMap::const_iterator itr = GetOwnedAuras().begin(); itr != GetOwnedAuras().end(); ++itr)
+    {
+        Aura const* aura = itr->second;
+        if (!aura->IsPermanent())
+            return false;
+
+        for (uint8 i = 0; i < MAX_SPELL_EFFECTS; ++i)
+            if (aura->HasEffect(i) && aura->GetEffect(i)->IsPeriodic())
+                return false;
+    }
+
+    if (nearPlayers)
+    {
+        // wandering and waypoint pauses are timed by the update, keep them smooth where seen
+        if (GetMotionMaster()->GetCurrentMovementGeneratorType() != IDLE_MOTION_TYPE)
+            return false;
+
+        // script and SmartAI events out of combat
+        if (m_scriptedAI || (IsAIEnabled && AI()->HasOutOfCombatTimers()))
+            return false;
+    }
+
+    return true;
+}
+
 void Creature::RegenerateEnergy()
 {
     uint32 curValue = GetPower(POWER_ENERGY);
@@ -777,6 +823,7 @@ bool Creature::AIM_Initialize(CreatureAI* ai)
     Motion_Initialize();
 
     i_AI = ai ? ai : FactorySelector::selectAI(this);
+    m_scriptedAI = ai || GetScriptId();
     delete oldAI;
     IsAIEnabled = true;
     i_AI->InitializeAI();
@@ -478,7 +478,7 @@ class MapCreature
     friend class Map; //map for moving creatures
 
 protected:
-    MapCreature() : _moveState(CREATURE_CELL_MOVE_NONE) {}
+    MapCreature() : _moveState(CREATURE_CELL_MOVE_NONE), _idleUpdateDiff(0), _idleUpdateDue(0) {}
 
 private:
     Cell _currentCell;
@@ -493,6 +493,10 @@ private:
         _moveState = CREATURE_CELL_MOVE_ACTIVE;
         _newPosition.Relocate(x, y, z, o);
     }
+
+    // time skipped while updated at the idle rate, handed to the next update
+    uint32 _idleUpdateDiff;
+    uint32 _idleUpdateDue;
 };
 
 enum CustomVisibility
@@ -527,6 +531,8 @@ class Creature : public Unit, public GridObject<Creature>, public MapCreature
         uint32 GetDBTableGUIDLow() const { return m_DBTableGuid; }
 
         void Update(uint32 time);                         // overwrited Unit::Update
+        // nothing would change if updates were skipped for a while, see Map::ObjectUpdater
+        bool CanUpdateAtIdleRate(bool nearPlayers) const;
         void GetRespawnPosition(float &x, float &y, float &z, float* ori = NULL, float* dist =NULL) const;
         uint32 GetEquipmentId() const { return GetCreatureTemplate()->equipmentId; }
 
@@ -860,6 +866,7 @@ class Creature : public Unit, public GridObject<Creature>, public MapCreature
         bool m_regenHealth;
         bool m_regenMana;
         bool m_AI_locked;
+        bool m_scriptedAI;                                  // AI of a script, its subclasses of core AIs may still have timers
 
         SpellSchoolMask m_meleeDamageSchoolMask;
         uint32 m_originalEntry;
@@ -54,6 +54,7 @@ void DynamicObject::AddToWorld()
     if (!IsInWorld())
     {
         sObjectAccessor->AddObject(this);
+        GetMap()->GetObjectRegistry().Insert(GetGUID(), this);
         WorldObject::AddToWorld();
         BindToCaster();
     }
@@ -76,6 +77,7 @@ void DynamicObject::RemoveFromWorld()
 
         UnbindFromCaster();
         WorldObject::RemoveFromWorld();
+        GetMap()->GetObjectRegistry().Remove(GetGUID());
         sObjectAccessor->RemoveObject(this);
     }
 }
@@ -139,6 +139,7 @@ void GameObject::AddToWorld()
             m_zoneScript->OnGameObjectCreate(this);
 
         sObjectAccessor->AddObject(this);
+        GetMap()->GetObjectRegistry().Insert(GetGUID(), this);
         // The state can be changed after GameObject::Create but before GameObject::AddToWorld
         bool toggledState = GetGoType() == GAMEOBJECT_TYPE_CHEST ? getLootState() == GO_READY : GetGoState() == GO_STATE_READY;
         if (m_model)
@@ -162,6 +163,7 @@ void GameObject::RemoveFromWorld()
             if (GetMap()->ContainsGameObjectModel(*m_model))
                 GetMap()->RemoveGameObjectModel(*m_model);
         WorldObject::RemoveFromWorld();
+        GetMap()->GetObjectRegistry().Remove(GetGUID());
         sObjectAccessor->RemoveObject(this);
     }
 }
@@ -2076,6 +2078,10 @@ void GameObject::EnableCollision(bool enable)
         GetMap()->InsertGameObjectModel(*m_model);*/
 
     m_model->enable(enable ? GetPhaseMask() : 0);
+
+    // doors and destructible buildings toggle their model in place
+    if (IsInWorld())
+        GetMap()->RefreshGameObjectModel(*m_model);
 }
 
 void GameObject::UpdateModel()
@@ -1259,7 +1259,9 @@ void MovementInfo::Normalize()
 
 WorldObject::WorldObject(bool isWorldObject)
     : m_isActive(false), m_isWorldObject(isWorldObject), m_zoneScript(NULL)
-    , m_transport(NULL), m_currMap(NULL), m_InstanceId(0), m_phaseMask(PHASEMASK_NORMAL)
+    , m_transport(NULL), m_currMap(NULL), m_areaInfoGeneration(0), m_areaInfoValid(false)
+    , m_InstanceId(0), m_phaseMask(PHASEMASK_NORMAL)
+    , m_gridPositions(NULL), m_gridPositionIndex(0)
     , m_explicitSeerGuid()
 {
     m_serverSideVisibility.SetValue(SERVERSIDE_VISIBILITY_GHOST, GHOST_VISIBILITY_ALIVE | GHOST_VISIBILITY_GHOST);
@@ -1332,17 +1334,38 @@ void WorldObject::_Create(uint32 guidlow, HighGuid guidhigh, uint32 phaseMask)
 
 uint32 WorldObject::GetZoneId() const
 {
-    return GetBaseMap()->GetZoneId(m_positionX, m_positionY, m_positionZ);
+    return GetPositionAreaInfo().zoneId;
 }
 
 uint32 WorldObject::GetAreaId() const
 {
-    return GetBaseMap()->GetAreaId(m_positionX, m_positionY, m_positionZ);
+    return GetPositionAreaInfo().areaId;
 }
 
 void WorldObject::GetZoneAndAreaId(uint32& zoneid, uint32& areaid) const
 {
-    GetBaseMap()->GetZoneAndAreaId(zoneid, areaid, m_positionX, m_positionY, m_positionZ);
+    PositionAreaInfo const& info = GetPositionAreaInfo();
+    zoneid = info.zoneId;
+    areaid = info.areaId;
+}
+
+PositionAreaInfo const& WorldObject::GetPositionAreaInfo() const
+{
+    Map const* map = GetBaseMap();
+    uint32 const generation = map->GetQueryCache().GetGeneration();
+    CellCoord const cell = Trinity::ComputeCellCoord(m_positionX, m_positionY);
+
+    if (!m_areaInfoValid || m_areaInfoGeneration != generation || m_areaInfoCell != cell ||
+        GetExactDistSq(&m_areaInfoPosition) > AREA_INFO_REFRESH_DISTANCE * AREA_INFO_REFRESH_DISTANCE)
+    {
+        map->GetPositionAreaInfo(m_positionX, m_positionY, m_positionZ, m_areaInfo);
+        m_areaInfoPosition.Relocate(m_positionX, m_positionY, m_positionZ);
+        m_areaInfoCell = cell;
+        m_areaInfoGeneration = generation;
+        m_areaInfoValid = true;
+    }
+
+    return m_areaInfo;
 }
 
 InstanceScript* WorldObject::GetInstanceScript()
@@ -1746,6 +1769,60 @@ void WorldObject::UpdateAllowedPositionZ(float x, float y, float &z) const
     }
 }
 
+void WorldObject::UpdateAllowedPositionZ(std::vector<G3D::Vector3> &points) const
+{
+    if (points.empty())
+        return;
+
+    bool canFly = false;
+    bool canSwim = false;
+    switch (GetTypeId())
+    {
+        case TYPEID_UNIT:
+            canFly = ToCreature()->CanFly();
+            canSwim = !canFly && (ToCreature()->isPet() || ToCreature()->canSwim());
+            break;
+        case TYPEID_PLAYER:
+            canFly = ToPlayer()->CanFly();
+            canSwim = !canFly;
+            break;
+        default:
+            break;
+    }
+
+    // the water level has no batched query
+    if (canSwim)
+    {
+        for (std::vector<G3D::Vector3>::iterator itr = points.begin(); itr != points.end(); ++itr)
+            UpdateAllowedPositionZ(itr->x, itr->y, itr->z);
+        return;
+    }
+
+    std::vector<VMAP::HeightQuery> queries(points.size());
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        queries[i].x = points[i].x;
+        queries[i].y = points[i].y;
+        queries[i].z = points[i].z;
+        queries[i].phasemask = GetPhaseMask();
+    }
+
+    GetBaseMap()->GetHeight(&queries[0], queries.size(), true);
+
+    // flying units are only kept above the ground, the others are put on it
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        float const ground_z = queries[i].height;
+        if (canFly)
+        {
+            if (points[i].z < ground_z)
+                points[i].z = ground_z;
+        }
+        else if (ground_z > INVALID_HEIGHT)
+            points[i].z = ground_z;
+    }
+}
+
 bool Position::IsPositionValid() const
 {
     return Trinity::IsValidMapCoord(m_positionX, m_positionY, m_positionZ, m_orientation);
@@ -2321,6 +2398,7 @@ void WorldObject::SetMap(Map* map)
         ASSERT(false);
     }
     m_currMap = map;
+    m_areaInfoValid = false;
     m_mapId = map->GetId();
     m_InstanceId = map->GetInstanceId();
     if (IsWorldObject())
@@ -3002,6 +3080,8 @@ void WorldObject::MovePositionToCollisionBetween(Position &pos, float distMin, f
 void WorldObject::SetPhaseMask(uint32 newPhaseMask, bool update)
 {
     m_phaseMask = newPhaseMask;
+    if (m_gridPositions)
+        m_gridPositions->setPhaseMask(m_gridPositionIndex, newPhaseMask);
 
     if (update && IsInWorld())
         UpdateObjectVisibility();
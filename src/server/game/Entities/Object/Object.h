@@ -19,10 +19,12 @@
 #ifndef _OBJECT_H
 #define _OBJECT_H
 
+#include "ContainerPositions.h"
 #include "Errors.h"
 #include "GridDefines.h"
 #include "ObjectDefines.h"
 #include "Locale.hpp"
+#include "PositionAreaInfo.h"
 #include "SharedDefines.h"
 #include "UpdateData.h"
 #include "UpdateFields.h"
@@ -45,6 +47,7 @@
 
 #define DEFAULT_WORLD_OBJECT_SIZE   0.388999998569489f      // player size, also currently used (correctly?) for any non Unit world objects
 #define DEFAULT_COMBAT_REACH        1.5f
+#define AREA_INFO_REFRESH_DISTANCE  0.5f                    // moves shorter than this within a cell keep the cached area info
 #define MIN_MELEE_REACH             2.0f
 #define NOMINAL_MELEE_RANGE         5.0f
 #define MELEE_RANGE                 (NOMINAL_MELEE_RANGE - MIN_MELEE_REACH * 2) //center to center for players
@@ -113,6 +116,11 @@ class Transport;
 class Map;
 struct WMOAreaTableEntry;
 
+namespace G3D
+{
+    class Vector3;
+}
+
 struct ObjectInvisibility final
 {
     ObjectInvisibility(InvisibilityType t, int32 a)
@@ -675,13 +683,17 @@ public:
         return storage_ != nullptr;
     }
 
-    void AddToGrid(ObjectTypeStorage &storage)
+    void AddToGrid(ObjectTypeStorage &storage, Trinity::ContainerPositions &positions)
     {
         ASSERT(!IsInGrid());
 
         storage_ = &storage;
         offset_ = storage_->size();
         storage_->emplace_back(static_cast<ObjectType*>(this));
+
+        ObjectType* const obj = static_cast<ObjectType*>(this);
+        positions.push_back(obj->GetPositionX(), obj->GetPositionY(), obj->GetPositionZ(), obj->GetPhaseMask());
+        obj->SetGridPositions(&positions, offset_);
     }
 
     void RemoveFromGrid()
@@ -692,14 +704,20 @@ public:
         auto &atOffset = (*storage_)[offset_];
         ASSERT(atOffset == static_cast<ObjectType*>(this));
 
+        ObjectType* const obj = static_cast<ObjectType*>(this);
+        Trinity::ContainerPositions* const positions = obj->GetGridPositions();
+        positions->erase(offset_);
+
         if (atOffset != storage_->back())
         {
             std::swap(atOffset, storage_->back());
             static_cast<SelfType*>(atOffset)->offset_ = offset_;
+            atOffset->SetGridPositions(positions, offset_);
         }
 
         storage_->pop_back();
         storage_ = nullptr;
+        obj->SetGridPositions(nullptr, 0);
     }
 
 private:
@@ -821,6 +839,8 @@ class WorldObject : public Object, public WorldLocation
         }
         void UpdateGroundPositionZ(float x, float y, float &z) const;
         void UpdateAllowedPositionZ(float x, float y, float &z) const;
+        //! Same as above for every point, the ground heights are fetched in one batch unless the object can swim
+        void UpdateAllowedPositionZ(std::vector<G3D::Vector3> &points) const;
 
         void GetRandomPoint(const Position &srcPos, float distance, float &rand_x, float &rand_y, float &rand_z) const;
         void GetRandomPoint(const Position &srcPos, float distance, Position &pos) const
@@ -834,6 +854,17 @@ class WorldObject : public Object, public WorldLocation
 
         virtual void SetPhaseMask(uint32 newPhaseMask, bool update);
         uint32 GetPhaseMask() const { return m_phaseMask; }
+
+        // Position::Relocate, keeping the position arrays of the grid cell up to date
+        void Relocate(float x, float y) { Position::Relocate(x, y); UpdateGridPosition(); }
+        void Relocate(float x, float y, float z) { Position::Relocate(x, y, z); UpdateGridPosition(); }
+        void Relocate(float x, float y, float z, float orientation) { Position::Relocate(x, y, z, orientation); UpdateGridPosition(); }
+        void Relocate(const Position &pos) { Position::Relocate(pos); UpdateGridPosition(); }
+        void Relocate(const Position* pos) { Position::Relocate(pos); UpdateGridPosition(); }
+
+        // set by GridObject while the object is stored in a grid cell
+        Trinity::ContainerPositions* GetGridPositions() const { return m_gridPositions; }
+        void SetGridPositions(Trinity::ContainerPositions* positions, std::size_t index) { m_gridPositions = positions; m_gridPositionIndex = index; }
         bool InSamePhase(WorldObject const* obj) const { return InSamePhase(obj->GetPhaseMask()); }
         bool InSamePhase(uint32 phasemask) const { return (GetPhaseMask() & phasemask); }
 
@@ -841,6 +872,11 @@ class WorldObject : public Object, public WorldLocation
         uint32 GetAreaId() const;
         void GetZoneAndAreaId(uint32& zoneid, uint32& areaid) const;
 
+        // area, zone, indoor state and liquid at the current position, computed again once
+        // the object moved AREA_INFO_REFRESH_DISTANCE, changed cell or grids of the map changed
+        PositionAreaInfo const& GetPositionAreaInfo() const;
+        bool IsOutdoors() const { return GetPositionAreaInfo().outdoors; }
+
         InstanceScript* GetInstanceScript();
 
         std::string const& GetName() const { return m_name; }
@@ -1065,10 +1101,25 @@ class WorldObject : public Object, public WorldLocation
     private:
         Map* m_currMap;                                    //current object's Map location
 
+        mutable PositionAreaInfo m_areaInfo;
+        mutable Position m_areaInfoPosition;
+        mutable CellCoord m_areaInfoCell;
+        mutable uint32 m_areaInfoGeneration;
+        mutable bool m_areaInfoValid;
+
         //uint32 m_mapId;                                     // object at map with map_id
         uint32 m_InstanceId;                                // in map copy with instance id
         uint32 m_phaseMask;                                 // in area phase state
 
+        void UpdateGridPosition()
+        {
+            if (m_gridPositions)
+                m_gridPositions->relocate(m_gridPositionIndex, GetPositionX(), GetPositionY(), GetPositionZ());
+        }
+
+        Trinity::ContainerPositions* m_gridPositions;
+        std::size_t m_gridPositionIndex;
+
         virtual bool _IsWithinDist(WorldObject const* obj, float dist2compare, bool is3D) const;
 
         bool CanNeverSee(WorldObject const* obj) const;
@@ -71,6 +71,7 @@ void Pet::AddToWorld()
     {
         ///- Register the pet for guid lookup
         sObjectAccessor->AddObject(this);
+        GetMap()->GetObjectRegistry().Insert(GetGUID(), this);
         Unit::AddToWorld();
         AIM_Initialize();
     }
@@ -95,6 +96,7 @@ void Pet::RemoveFromWorld()
     {
         ///- Don't call the function for Creature, normal mobs + totems go in a different storage
         Unit::RemoveFromWorld();
+        GetMap()->GetObjectRegistry().Remove(GetGUID());
         sObjectAccessor->RemoveObject(this);
     }
 }
@@ -83,6 +83,7 @@
 #include "GameObjectAI.h"
 #include "ScriptMgr.h"
 #include "ObjectVisitors.hpp"
+#include "CharacterCache.h"
 
 #include <cmath>
 
@@ -692,6 +693,8 @@ Player::Player(WorldSession* session)
 
     m_ExtraFlags = 0;
 
+    m_visibilityGeneration = 0;
+
     m_spellModTakingSpell = NULL;
     //m_pad = 0;
 
@@ -2121,8 +2124,10 @@ bool Player::BuildEnumData(PreparedQueryResult result, ByteBuffer* dataBuffer, B
     //    "SELECT characters.guid, characters.name, characters.race, characters.class, characters.gender, characters.playerBytes, characters.playerBytes2, characters.level, "
     //     8                9               10                     11                     12                     13                    14
     //    "characters.zone, characters.map, characters.position_x, characters.position_y, characters.position_z, guild_member.guildid, characters.playerFlags, "
-    //    15                    16                   17                     18                   19               20                     21               22
-    //    "characters.at_login, character_pet.entry, character_pet.modelid, character_pet.level, characters.data, character_banned.guid, characters.slot, character_declinedname.genitive"
+    //    15                    16                   17                     18                   19               20                     21
+    //    "characters.at_login, character_pet.entry, character_pet.modelid, character_pet.level, characters.data, character_banned.guid, characters.slot, "
+    //     22                        23                          24
+    //    "character_banned.bandate, character_banned.unbandate, character_declinedname.genitive"
 
     Field* fields = result->Fetch();
 
@@ -2162,12 +2167,13 @@ bool Player::BuildEnumData(PreparedQueryResult result, ByteBuffer* dataBuffer, B
     if (atLoginFlags & AT_LOGIN_RENAME)
         charFlags |= CHARACTER_FLAG_RENAME;
 
-    if (fields[20].GetUInt32())
+    // expired bans are deactivated asynchronously, they may not be yet
+    if (fields[20].GetUInt32() && (fields[23].GetUInt32() == fields[22].GetUInt32() || fields[23].GetUInt32() > uint32(time(NULL))))
         charFlags |= CHARACTER_FLAG_LOCKED_BY_BILLING;
 
     if (sWorld->getBoolConfig(CONFIG_DECLINED_NAMES_USED))
     {
-        if (!fields[22].GetString().empty())
+        if (!fields[24].GetString().empty())
             charFlags |= CHARACTER_FLAG_DECLINED;
     }
     else
@@ -2742,6 +2748,10 @@ void Player::AddToWorld()
     ///- Do not add/remove the player from the object storage
     ///- It will crash when updating the ObjectAccessor
     ///- The player should only be added when logging in
+    ///- Only the registry of the map follows the player from map to map
+    if (!IsInWorld())
+        GetMap()->GetObjectRegistry().Insert(GetGUID(), this);
+
     Unit::AddToWorld();
 
     for (uint8 i = PLAYER_SLOT_START; i < PLAYER_SLOT_END; ++i)
@@ -2751,8 +2761,10 @@ void Player::AddToWorld()
 
 void Player::RemoveFromWorld()
 {
+    bool const wasInWorld = IsInWorld();
+
     // cleanup
-    if (IsInWorld())
+    if (wasInWorld)
     {
         ///- Release charmed creatures, unsummon totems and remove pets, guardians and battle pets
         StopCastingCharm();
@@ -2768,6 +2780,9 @@ void Player::RemoveFromWorld()
     ///- The player should only be removed when logging out
     Unit::RemoveFromWorld();
 
+    if (wasInWorld)
+        GetMap()->GetObjectRegistry().Remove(GetGUID());
+
     for (uint8 i = PLAYER_SLOT_START; i < PLAYER_SLOT_END; ++i)
     {
         if (m_items[i])
@@ -5818,17 +5833,23 @@ void Player::DeleteFromDB(uint64 playerguid, uint32 accountId, bool updateRealmC
             stmt->setUInt32(0, guid);
             trans->Append(stmt);
 
+            sCharacterCache->InvalidateCharacter(guid, accountId, trans);
             CharacterDatabase.CommitTransaction(trans);
             break;
         }
         // The character gets unlinked from the account, the name gets freed up and appears as deleted ingame
         case CHAR_DELETE_UNLINK:
         {
+            SQLTransaction trans = CharacterDatabase.BeginTransaction();
+
             PreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_UPD_DELETE_INFO);
 
             stmt->setUInt32(0, guid);
 
-            CharacterDatabase.Execute(stmt);
+            trans->Append(stmt);
+
+            sCharacterCache->InvalidateCharacter(guid, accountId, trans);
+            CharacterDatabase.CommitTransaction(trans);
             break;
         }
         default:
@@ -7652,10 +7673,10 @@ void Player::CheckAreaExploreAndOutdoor()
     if (isInFlight())
         return;
 
-    bool isOutdoor;
-    uint16 areaFlag = GetBaseMap()->GetAreaFlag(GetPositionX(), GetPositionY(), GetPositionZ(), &isOutdoor);
+    PositionAreaInfo const& areaInfo = GetPositionAreaInfo();
+    uint16 areaFlag = areaInfo.areaFlag;
 
-    if (sWorld->getBoolConfig(CONFIG_VMAP_INDOOR_CHECK) && !isOutdoor)
+    if (sWorld->getBoolConfig(CONFIG_VMAP_INDOOR_CHECK) && !areaInfo.outdoors)
         RemoveAurasWithAttribute(SPELL_ATTR0_OUTDOORS_ONLY);
 
     if (areaFlag == 0xffff)
@@ -21310,6 +21331,8 @@ void Player::SaveToDB(bool create /*=false*/)
 
     _SaveLFRLootBinds(charTrans);
 
+    sCharacterCache->UpdateCharacter(this, charTrans);
+
     if (create)
     {
         CharacterDatabase.DirectCommitTransaction(charTrans);
@@ -25034,31 +25057,31 @@ bool Player::IsVisibleGloballyFor(Player const *u) const
 }
 
 template<class T>
-inline void UpdateVisibilityOf_helper(UpdateData::GuidSet &s64, T* target, std::set<Unit*>& /*v*/)
+inline void UpdateVisibilityOf_helper(Player::ClientGUIDs& clientGuids, uint32 generation, T* target, std::vector<Unit*>& /*v*/)
 {
-    s64.insert(target->GetGUID());
+    clientGuids[target->GetGUID()] = generation;
 }
 
 template<>
-inline void UpdateVisibilityOf_helper(UpdateData::GuidSet &s64, GameObject* target, std::set<Unit*>& /*v*/)
+inline void UpdateVisibilityOf_helper(Player::ClientGUIDs& clientGuids, uint32 generation, GameObject* target, std::vector<Unit*>& /*v*/)
 {
     // Don't update only GAMEOBJECT_TYPE_TRANSPORT (or all transports and destructible buildings?)
     if ((target->GetGOInfo()->type != GAMEOBJECT_TYPE_TRANSPORT))
-        s64.insert(target->GetGUID());
+        clientGuids[target->GetGUID()] = generation;
 }
 
 template<>
-inline void UpdateVisibilityOf_helper(UpdateData::GuidSet &s64, Creature* target, std::set<Unit*>& v)
+inline void UpdateVisibilityOf_helper(Player::ClientGUIDs& clientGuids, uint32 generation, Creature* target, std::vector<Unit*>& v)
 {
-    s64.insert(target->GetGUID());
-    v.insert(target);
+    clientGuids[target->GetGUID()] = generation;
+    v.push_back(target);
 }
 
 template<>
-inline void UpdateVisibilityOf_helper(UpdateData::GuidSet &s64, Player* target, std::set<Unit*>& v)
+inline void UpdateVisibilityOf_helper(Player::ClientGUIDs& clientGuids, uint32 generation, Player* target, std::vector<Unit*>& v)
 {
-    s64.insert(target->GetGUID());
-    v.insert(target);
+    clientGuids[target->GetGUID()] = generation;
+    v.push_back(target);
 }
 
 template<class T>
@@ -25098,7 +25121,7 @@ void Player::UpdateVisibilityOf(WorldObject* target)
             //    UpdateVisibilityOf(((Unit*)target)->m_Vehicle);
 
             target->SendUpdateToPlayer(this);
-            m_clientGUIDs.insert(target->GetGUID());
+            m_clientGUIDs[target->GetGUID()] = m_visibilityGeneration;
 
             #ifdef TRINITY_DEBUG
                 TC_LOG_DEBUG("maps", "Object %u (Type: %u) is visible now for player %u. Distance = %f", target->GetGUIDLow(), target->GetTypeId(), GetGUIDLow(), GetDistance(target));
@@ -25124,9 +25147,9 @@ void Player::UpdateTriggerVisibility()
     WorldPacket packet;
     for (auto itr = m_clientGUIDs.begin(); itr != m_clientGUIDs.end(); ++itr)
     {
-        if (IS_CREATURE_GUID(*itr))
+        if (IS_CREATURE_GUID(itr->first))
         {
-            Creature* obj = GetMap()->GetCreature(*itr);
+            Creature* obj = GetMap()->GetCreature(itr->first);
             if (!obj || (!obj->isTrigger() && !obj->HasAuraType(SPELL_AURA_TRANSFORM) && !obj->HasFlag(UNIT_FIELD_FLAGS, UNIT_FLAG_NOT_SELECTABLE)))
                 continue;
 
@@ -25134,9 +25157,9 @@ void Player::UpdateTriggerVisibility()
             obj->BuildValuesUpdateBlockForPlayer(&udata, this);
             obj->RemoveFieldNotifyFlag(UF_FLAG_PUBLIC);
         }
-        else if (IS_GAMEOBJECT_GUID((*itr)))
+        else if (IS_GAMEOBJECT_GUID(itr->first))
         {
-            GameObject* go = GetMap()->GetGameObject(*itr);
+            GameObject* go = GetMap()->GetGameObject(itr->first);
             if (!go)
                 continue;
 
@@ -25163,7 +25186,7 @@ void Player::SendInitialVisiblePackets(Unit* target)
 }
 
 template<class T>
-void Player::UpdateVisibilityOf(T* target, UpdateData& data, std::set<Unit*>& visibleNow)
+void Player::UpdateVisibilityOf(T* target, UpdateData& data, std::vector<Unit*>& visibleNow)
 {
     if (HaveAtClient(target))
     {
@@ -25187,7 +25210,7 @@ void Player::UpdateVisibilityOf(T* target, UpdateData& data, std::set<Unit*>& vi
             //    UpdateVisibilityOf(((Unit*)target)->m_Vehicle, data, visibleNow);
 
             target->BuildCreateUpdateBlockForPlayer(&data, this);
-            UpdateVisibilityOf_helper(m_clientGUIDs, target, visibleNow);
+            UpdateVisibilityOf_helper(m_clientGUIDs, m_visibilityGeneration, target, visibleNow);
 
             #ifdef TRINITY_DEBUG
                 TC_LOG_DEBUG("maps", "Object %u (Type: %u, Entry: %u) is visible now for player %u. Distance = %f", target->GetGUIDLow(), target->GetTypeId(), target->GetEntry(), GetGUIDLow(), GetDistance(target));
@@ -25196,12 +25219,12 @@ void Player::UpdateVisibilityOf(T* target, UpdateData& data, std::set<Unit*>& vi
     }
 }
 
-template void Player::UpdateVisibilityOf(Player*        target, UpdateData& data, std::set<Unit*>& visibleNow);
-template void Player::UpdateVisibilityOf(Creature*      target, UpdateData& data, std::set<Unit*>& visibleNow);
-template void Player::UpdateVisibilityOf(Corpse*        target, UpdateData& data, std::set<Unit*>& visibleNow);
-template void Player::UpdateVisibilityOf(GameObject*    target, UpdateData& data, std::set<Unit*>& visibleNow);
-template void Player::UpdateVisibilityOf(DynamicObject* target, UpdateData& data, std::set<Unit*>& visibleNow);
-template void Player::UpdateVisibilityOf(AreaTrigger*   target, UpdateData& data, std::set<Unit*>& visibleNow);
+template void Player::UpdateVisibilityOf(Player*        target, UpdateData& data, std::vector<Unit*>& visibleNow);
+template void Player::UpdateVisibilityOf(Creature*      target, UpdateData& data, std::vector<Unit*>& visibleNow);
+template void Player::UpdateVisibilityOf(Corpse*        target, UpdateData& data, std::vector<Unit*>& visibleNow);
+template void Player::UpdateVisibilityOf(GameObject*    target, UpdateData& data, std::vector<Unit*>& visibleNow);
+template void Player::UpdateVisibilityOf(DynamicObject* target, UpdateData& data, std::vector<Unit*>& visibleNow);
+template void Player::UpdateVisibilityOf(AreaTrigger*   target, UpdateData& data, std::vector<Unit*>& visibleNow);
 
 void Player::UpdateVisibilityForPlayer()
 {
@@ -26121,14 +26144,14 @@ void Player::UpdateForQuestWorldObjects()
     WorldPacket packet;
     for (ClientGUIDs::iterator itr = m_clientGUIDs.begin(); itr != m_clientGUIDs.end(); ++itr)
     {
-        if (IS_GAMEOBJECT_GUID(*itr))
+        if (IS_GAMEOBJECT_GUID(itr->first))
         {
-            if (GameObject* obj = HashMapHolder<GameObject>::Find(*itr))
+            if (GameObject* obj = HashMapHolder<GameObject>::Find(itr->first))
                 obj->BuildValuesUpdateBlockForPlayer(&udata, this);
         }
-        else if (IS_CRE_OR_VEH_GUID(*itr))
+        else if (IS_CRE_OR_VEH_GUID(itr->first))
         {
-            Creature* obj = ObjectAccessor::GetCreatureOrPetOrVehicle(*this, *itr);
+            Creature* obj = ObjectAccessor::GetCreatureOrPetOrVehicle(*this, itr->first);
             if (!obj)
                 continue;
 
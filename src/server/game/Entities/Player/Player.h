@@ -1116,7 +1116,22 @@ enum BattlegroundTimerTypes
     CHALLENGE_TIMER
 };
 
-class Player final : public Unit, public GridObject<Player>
+class MapPlayer
+{
+    friend class Map; //map for moving players between cells
+
+protected:
+    MapPlayer() : _cellMoveQueued(false) {}
+
+private:
+    Cell _currentCell;
+    Cell const& GetCurrentCell() const { return _currentCell; }
+    void SetCurrentCell(Cell const& cell) { _currentCell = cell; }
+
+    bool _cellMoveQueued; //in move list, grid container of another cell than the position
+};
+
+class Player final : public Unit, public GridObject<Player>, public MapPlayer
 {
     friend class WorldSession;
     friend void Item::AddToUpdateQueueOf(Player* player);
@@ -2527,9 +2542,10 @@ class Player final : public Unit, public GridObject<Player>
 
         WorldLocation GetStartPosition() const;
 
-        // currently visible objects at player client
-        typedef std::unordered_set<uint64> ClientGUIDs;
+        // currently visible objects at player client, with the visibility pass that last saw them
+        typedef std::unordered_map<uint64, uint32> ClientGUIDs;
         ClientGUIDs m_clientGUIDs;
+        uint32 m_visibilityGeneration;
 
         bool HaveAtClient(WorldObject const* u) const { return u == this || m_clientGUIDs.find(u->GetGUID()) != m_clientGUIDs.end(); }
 
@@ -2543,7 +2559,7 @@ class Player final : public Unit, public GridObject<Player>
         void UpdateTriggerVisibility();
 
         template<class T>
-        void UpdateVisibilityOf(T* target, UpdateData& data, std::set<Unit*>& visibleNow);
+        void UpdateVisibilityOf(T* target, UpdateData& data, std::vector<Unit*>& visibleNow);
 
         uint8 m_forced_speed_changes[MAX_MOVE_TYPE];
 
@@ -138,24 +138,9 @@ private:
     Unit* m_owner;
 };
 
-class VisibilityUpdateTask final : public BasicEvent
+class VisibilityUpdateTask final
 {
 public:
-    VisibilityUpdateTask(Unit* me, bool loadGrids)
-        : m_owner(me)
-        , m_loadGrids(loadGrids)
-    { }
-
-    bool Execute(uint64, uint32) final
-    {
-        UpdateVisibility(m_owner);
-
-        if (m_loadGrids)
-            m_owner->GetMap()->loadGridsInRange(*m_owner, MAX_VISIBILITY_DISTANCE);
-
-        return true;
-    }
-
     static void UpdateVisibility(Unit* me)
     {
         SharedVisionList const &shList = me->GetSharedVisionList();
@@ -172,9 +157,12 @@ public:
         me->WorldObject::UpdateObjectVisibility(true);
     }
 
-private:
-    Unit* m_owner;
-    bool m_loadGrids;
+    // evaluated with the other changes of the map at the end of its update
+    static void Schedule(Unit* me, bool loadGrids)
+    {
+        if (me->IsInWorld())
+            me->GetMap()->ScheduleVisibilityChange(me, loadGrids);
+    }
 };
 
 DamageInfo::DamageInfo(Unit* _attacker, Unit* _victim, uint32 _damage, SpellInfo const* _spellInfo, SpellSchoolMask _schoolMask, DamageEffectType _damageType)
@@ -278,6 +266,7 @@ Unit::Unit(bool isWorldObject): WorldObject(isWorldObject)
     insightCount = 0;
     m_canDualWield = false;
     m_AINotifyScheduled = false;
+    m_visibilityChangeSlot = -1;
 
     m_rootTimes = 0;
 
@@ -3461,12 +3450,13 @@ bool Unit::isInAccessiblePlaceFor(Creature const* c) const
 
 bool Unit::IsInWater() const
 {
-    return GetBaseMap()->IsInWater(GetPositionX(), GetPositionY(), GetPositionZ());
+    return GetPositionAreaInfo().liquidStatus != LIQUID_MAP_NO_WATER;
 }
 
 bool Unit::IsUnderWater() const
 {
-    return GetBaseMap()->IsUnderWater(GetPositionX(), GetPositionY(), GetPositionZ());
+    PositionAreaInfo const& areaInfo = GetPositionAreaInfo();
+    return (areaInfo.liquidStatus & LIQUID_MAP_UNDER_WATER) && (areaInfo.liquid.type_flags & (MAP_LIQUID_TYPE_WATER | MAP_LIQUID_TYPE_OCEAN));
 }
 
 void Unit::UpdateUnderwaterState(Map* m, float x, float y, float z)
@@ -16239,6 +16229,8 @@ void Unit::RemoveFromWorld()
 
         RemoveAreaAurasDueToLeaveWorld();
 
+        GetMap()->CancelVisibilityChange(this);
+
         if (GetCharmerGUID())
         {
             TC_LOG_FATAL("entities.unit", "Unit %u has charmer guid when removed from world", GetEntry());
@@ -17580,61 +17572,43 @@ void Unit::GetAttackableUnitListInRange(std::list<Unit*> &list, float fMaxSearch
 
 Unit* Unit::SelectNearbyTarget(Unit* exclude, float dist) const
 {
-    std::list<Unit*> targets;
     Trinity::AnyUnfriendlyUnitInObjectRangeCheck u_check(this, this, dist);
-    Trinity::UnitListSearcher<Trinity::AnyUnfriendlyUnitInObjectRangeCheck> searcher(this, targets, u_check);
-    Trinity::VisitNearbyObject(this, dist, searcher);
+    Unit const* victim = GetVictim();
 
-    // remove current target
-    if (GetVictim())
-        targets.remove(GetVictim());
-
-    if (exclude)
-        targets.remove(exclude);
-
-    // remove not LoS targets
-    for (std::list<Unit*>::iterator tIter = targets.begin(); tIter != targets.end();)
+    // current target, excluded and not LoS targets are rejected while searching,
+    // line of sight last as the most expensive
+    auto check = [&](Unit* unit)
     {
         // Add another distance check because the AnyUnfriendlyUnit check includes target size
-        if (GetExactDist(*tIter) > dist || !IsWithinLOSInMap(*tIter) || (*tIter)->isTotem() || (*tIter)->isSpiritService() || (*tIter)->GetCreatureType() == CREATURE_TYPE_CRITTER || !IsValidAttackTarget(*tIter))
-            targets.erase(tIter++);
-        else
-            ++tIter;
-    }
+        return unit != victim && unit != exclude && u_check(unit) && GetExactDist(unit) <= dist
+            && !unit->isTotem() && !unit->isSpiritService() && unit->GetCreatureType() != CREATURE_TYPE_CRITTER
+            && IsValidAttackTarget(unit) && IsWithinLOSInMap(unit);
+    };
 
-    // no appropriate targets
-    if (targets.empty())
-        return NULL;
+    // select random, every appropriate target has the same chance
+    Trinity::RandomSearchBuffer<Unit> target;
+    auto searcher = Trinity::makeContainerSearcher(this, target, check);
+    Trinity::VisitNearbyObject(this, dist, searcher);
 
-    // select random
-    return Trinity::Containers::SelectRandomContainerElement(targets);
+    return target.GetResult();
 }
 
 Unit* Unit::SelectNearbyAlly(Unit* exclude, float dist) const
 {
-    std::list<Unit*> targets;
     Trinity::AnyFriendlyUnitInObjectRangeCheck u_check(this, this, dist);
-    Trinity::UnitListSearcher<Trinity::AnyFriendlyUnitInObjectRangeCheck> searcher(this, targets, u_check);
-    Trinity::VisitNearbyObject(this, dist, searcher);
-
-    if (exclude)
-        targets.remove(exclude);
 
-    // remove not LoS targets
-    for (std::list<Unit*>::iterator tIter = targets.begin(); tIter != targets.end();)
+    auto check = [&](Unit* unit)
     {
-        if (!IsWithinLOSInMap(*tIter) || (*tIter)->isTotem() || (*tIter)->isSpiritService() || (*tIter)->GetCreatureType() == CREATURE_TYPE_CRITTER)
-            targets.erase(tIter++);
-        else
-            ++tIter;
-    }
+        return unit != exclude && u_check(unit) && !unit->isTotem() && !unit->isSpiritService()
+            && unit->GetCreatureType() != CREATURE_TYPE_CRITTER && IsWithinLOSInMap(unit);
+    };
 
-    // no appropriate targets
-    if (targets.empty())
-        return NULL;
+    // select random, every appropriate target has the same chance
+    Trinity::RandomSearchBuffer<Unit> target;
+    auto searcher = Trinity::makeContainerSearcher(this, target, check);
+    Trinity::VisitNearbyObject(this, dist, searcher);
 
-    // select random
-    return Trinity::Containers::SelectRandomContainerElement(targets);
+    return target.GetResult();
 }
 
 // select nearest hostile unit within the given distance (regardless of threat list).
@@ -19301,7 +19275,7 @@ void Unit::OnRelocated()
     if (!m_lastVisibilityUpdPos.IsInDist(this, sWorld->GetVisibilityRelocationLowerLimit()))
     {
         m_lastVisibilityUpdPos = *this;
-        m_Events.AddEvent(new VisibilityUpdateTask(this, GetTypeId() == TYPEID_PLAYER), m_Events.CalculateTime(1));
+        VisibilityUpdateTask::Schedule(this, GetTypeId() == TYPEID_PLAYER);
     }
 
     AINotifyTask::Schedule(this);
@@ -19312,7 +19286,7 @@ void Unit::UpdateObjectVisibility(bool forced)
     if (forced)
         VisibilityUpdateTask::UpdateVisibility(this);
     else
-        m_Events.AddEvent(new VisibilityUpdateTask(this, false), m_Events.CalculateTime(1));
+        VisibilityUpdateTask::Schedule(this, false);
 
     AINotifyTask::Schedule(this);
 }
@@ -1604,6 +1604,10 @@ class Unit : public WorldObject
         bool isAINotifyScheduled() const { return m_AINotifyScheduled; }
         void setAINotifyScheduled(bool val) { m_AINotifyScheduled = val; }
 
+        // position in the visibility change list of the map, -1 when not scheduled
+        int32 GetVisibilityChangeSlot() const { return m_visibilityChangeSlot; }
+        void SetVisibilityChangeSlot(int32 slot) { m_visibilityChangeSlot = slot; }
+
         void SetTarget(uint64 guid)
         {
             if (!_focusSpell)
@@ -1758,6 +1762,7 @@ class Unit : public WorldObject
     private:
         Position m_lastVisibilityUpdPos;
         bool m_AINotifyScheduled;
+        int32 m_visibilityChangeSlot;
 
         uint32 m_rootTimes;
 
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "CharacterCache.h"
+#include "DatabaseEnv.h"
+#include "Player.h"
+#include "World.h"
+#include "WorldSession.h"
+
+CharacterCache::CharacterCache()
+    : m_nameStamp(0)
+{ }
+
+uint32 CharacterCache::GetAccountStamp(uint32 accountId) const
+{
+    GuardType guard(m_lock);
+
+    auto const itr = m_accountStamps.find(accountId);
+    return itr != m_accountStamps.end() ? itr->second : 0;
+}
+
+uint32 CharacterCache::GetNameStamp() const
+{
+    GuardType guard(m_lock);
+    return m_nameStamp;
+}
+
+bool CharacterCache::GetEnum(uint32 accountId, WorldPacket &packet, std::unordered_set<uint32> &guids) const
+{
+    GuardType guard(m_lock);
+
+    auto const itr = m_enums.find(accountId);
+    if (itr == m_enums.end() || itr->second.expireTime <= time(NULL))
+        return false;
+
+    packet = itr->second.packet;
+    guids = itr->second.guids;
+    return true;
+}
+
+void CharacterCache::StoreEnum(uint32 accountId, uint32 stamp, WorldPacket const &packet, std::unordered_set<uint32> const &guids, time_t unbanTime)
+{
+    uint32 const expireTime = sWorld->getIntConfig(CONFIG_CHARACTER_CACHE_ENUM_EXPIRE);
+    if (!expireTime)
+        return;
+
+    GuardType guard(m_lock);
+
+    // Character list is being written, the query may have read it before or after
+    if (m_accountWrites.find(accountId) != m_accountWrites.end())
+        return;
+
+    // Character list was modified while the query was in flight
+    auto const stampItr = m_accountStamps.find(accountId);
+    if ((stampItr != m_accountStamps.end() ? stampItr->second : 0) != stamp)
+        return;
+
+    auto &entry = m_enums[accountId];
+    entry.packet = packet;
+    entry.guids = guids;
+    entry.expireTime = time(NULL) + expireTime;
+    if (unbanTime && unbanTime < entry.expireTime)
+        entry.expireTime = unbanTime;
+
+    for (auto const &guidLow : guids)
+        m_characterAccounts[guidLow] = accountId;
+}
+
+bool CharacterCache::GetNameData(uint32 guidLow, CharacterNameData &data) const
+{
+    GuardType guard(m_lock);
+
+    auto const itr = m_names.find(guidLow);
+    if (itr == m_names.end())
+        return false;
+
+    data = itr->second;
+    return true;
+}
+
+void CharacterCache::StoreNameData(uint32 guidLow, uint32 stamp, CharacterNameData const &data)
+{
+    GuardType guard(m_lock);
+
+    if (stamp == m_nameStamp && m_characterWrites.find(guidLow) == m_characterWrites.end())
+        m_names[guidLow] = data;
+}
+
+void CharacterCache::UpdateCharacter(Player const *player, SQLTransaction const &trans)
+{
+    uint32 const accountId = player->GetSession()->GetAccountId();
+    trans->SetCompletionHook([this, accountId]()
+    {
+        GuardType guard(m_lock);
+        endAccountWrite(accountId);
+    });
+
+    GuardType guard(m_lock);
+
+    auto const itr = m_names.find(player->GetGUIDLow());
+    if (itr != m_names.end())
+    {
+        CharacterNameData &data = itr->second;
+        data.name = player->GetName();
+        data.race = player->getRace();
+        data.gender = player->getGender();
+        data.playerClass = player->getClass();
+        data.level = player->getLevel();
+    }
+
+    beginAccountWrite(accountId);
+}
+
+void CharacterCache::InvalidateCharacter(uint32 guidLow, uint32 accountId)
+{
+    GuardType guard(m_lock);
+    invalidateCharacter(guidLow, accountId);
+}
+
+void CharacterCache::InvalidateCharacter(uint32 guidLow, uint32 accountId, SQLTransaction const &trans)
+{
+    GuardType guard(m_lock);
+
+    accountId = invalidateCharacter(guidLow, accountId);
+    ++m_characterWrites[guidLow];
+    if (accountId)
+        beginAccountWrite(accountId);
+
+    // name data read before the transaction went through is dropped by the stamp
+    trans->SetCompletionHook([this, guidLow, accountId]()
+    {
+        GuardType guard(m_lock);
+
+        auto const itr = m_characterWrites.find(guidLow);
+        if (itr != m_characterWrites.end() && !--itr->second)
+            m_characterWrites.erase(itr);
+
+        invalidateCharacter(guidLow, accountId);
+        if (accountId)
+            endAccountWrite(accountId);
+    });
+}
+
+void CharacterCache::InvalidateAccount(uint32 accountId)
+{
+    GuardType guard(m_lock);
+    invalidateAccount(accountId);
+}
+
+uint32 CharacterCache::invalidateCharacter(uint32 guidLow, uint32 accountId)
+{
+    m_names.erase(guidLow);
+    ++m_nameStamp;
+
+    auto const itr = m_characterAccounts.find(guidLow);
+    if (itr != m_characterAccounts.end())
+    {
+        if (!accountId)
+            accountId = itr->second;
+        else if (accountId != itr->second)
+            invalidateAccount(itr->second);
+        m_characterAccounts.erase(itr);
+    }
+
+    if (accountId)
+        invalidateAccount(accountId);
+    return accountId;
+}
+
+void CharacterCache::beginAccountWrite(uint32 accountId)
+{
+    ++m_accountWrites[accountId];
+    invalidateAccount(accountId);
+}
+
+void CharacterCache::endAccountWrite(uint32 accountId)
+{
+    auto const itr = m_accountWrites.find(accountId);
+    if (itr != m_accountWrites.end() && !--itr->second)
+        m_accountWrites.erase(itr);
+
+    // lists read while the write was in flight are dropped
+    invalidateAccount(accountId);
+}
+
+void CharacterCache::invalidateAccount(uint32 accountId)
+{
+    ++m_accountStamps[accountId];
+    m_enums.erase(accountId);
+}
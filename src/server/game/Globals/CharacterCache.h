@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _CHARACTERCACHE_H
+#define _CHARACTERCACHE_H
+
+#include "Define.h"
+#include "MySQLPtrTypesFwd.h"
+#include "SharedDefines.h"
+#include "Unit.h"
+#include "WorldPacket.h"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+class Player;
+
+//! Name query data of a (possibly offline) character
+struct CharacterNameData
+{
+    CharacterNameData()
+        : race(0), gender(0), playerClass(0), level(0), hasDeclinedName(false)
+    { }
+
+    std::string name;
+    uint8 race;
+    uint8 gender;
+    uint8 playerClass;
+    uint8 level;
+    bool hasDeclinedName;
+    std::string declinedName[MAX_DECLINED_NAME_CASES];
+};
+
+//! Read-through cache of character select lists and name query data.
+//! Entries are filled by the DB callbacks on a miss and dropped whenever the
+//! underlying characters are created, deleted, renamed, customized or saved.
+//! Safe to use from any thread.
+class CharacterCache final
+{
+    struct EnumEntry
+    {
+        WorldPacket packet;
+        std::unordered_set<uint32> guids;
+        time_t expireTime;
+    };
+
+    typedef std::lock_guard<std::mutex> GuardType;
+
+    CharacterCache();
+
+public:
+    static CharacterCache * instance()
+    {
+        static CharacterCache cache;
+        return &cache;
+    }
+
+    //! Returns stamp to be passed back to the Store* methods once the DB
+    //! answered, results of requests overtaken by an invalidation are dropped.
+    uint32 GetAccountStamp(uint32 accountId) const;
+    uint32 GetNameStamp() const;
+
+    bool GetEnum(uint32 accountId, WorldPacket &packet, std::unordered_set<uint32> &guids) const;
+    //! The list is dropped at unbanTime (if set), when the earliest of its temporary bans ends.
+    void StoreEnum(uint32 accountId, uint32 stamp, WorldPacket const &packet, std::unordered_set<uint32> const &guids, time_t unbanTime = 0);
+
+    bool GetNameData(uint32 guidLow, CharacterNameData &data) const;
+    void StoreNameData(uint32 guidLow, uint32 stamp, CharacterNameData const &data);
+
+    //! Refreshes the cached name data from a loaded player and drops the
+    //! character list of its account (level, zone, equipment may have changed).
+    //! The list is not cached again before trans, the save, is done.
+    void UpdateCharacter(Player const *player, SQLTransaction const &trans);
+
+    //! Drops everything cached about the character.
+    void InvalidateCharacter(uint32 guidLow, uint32 accountId = 0);
+
+    //! Same, for changes written by trans: nothing is cached from queries
+    //! that may have read the character before trans is done.
+    void InvalidateCharacter(uint32 guidLow, uint32 accountId, SQLTransaction const &trans);
+
+    //! Drops the cached character list of the account.
+    void InvalidateAccount(uint32 accountId);
+
+private:
+    uint32 invalidateCharacter(uint32 guidLow, uint32 accountId);
+    void beginAccountWrite(uint32 accountId);
+    void endAccountWrite(uint32 accountId);
+    void invalidateAccount(uint32 accountId);
+
+    mutable std::mutex m_lock;
+
+    std::unordered_map<uint32, EnumEntry> m_enums;              //! accountId -> character list
+    std::unordered_map<uint32, uint32> m_accountStamps;         //! accountId -> invalidation count
+    std::unordered_map<uint32, uint32> m_characterAccounts;     //! guidLow -> accountId of cached lists
+    std::unordered_map<uint32, uint32> m_accountWrites;         //! accountId -> saves and deletions not yet in the database
+    std::unordered_map<uint32, uint32> m_characterWrites;       //! guidLow -> changes not yet in the database
+
+    std::unordered_map<uint32, CharacterNameData> m_names;      //! guidLow -> name data
+    uint32 m_nameStamp;
+};
+
+#define sCharacterCache CharacterCache::instance()
+
+#endif
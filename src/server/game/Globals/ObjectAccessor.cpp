@@ -139,9 +139,28 @@ Object* ObjectAccessor::GetObjectByTypeMask(WorldObject const& p, uint64 guid, u
     return NULL;
 }
 
+template<class T> T* ObjectAccessor::GetObjectInMap(uint64 guid, Map* map, T* /*typeSpecifier*/)
+{
+    ASSERT(map);
+    return map->GetObjectRegistry().Find<T>(guid);
+}
+
+Unit* ObjectAccessor::GetObjectInMap(uint64 guid, Map* map, Unit* /*typeSpecifier*/)
+{
+    if (IS_PLAYER_GUID(guid))
+        return GetObjectInMap(guid, map, (Player*)NULL);
+
+    if (IS_PET_GUID(guid))
+        return GetObjectInMap(guid, map, (Pet*)NULL);
+
+    return GetObjectInMap(guid, map, (Creature*)NULL);
+}
+
 Corpse* ObjectAccessor::GetCorpse(WorldObject const& u, uint64 guid)
 {
-    return GetObjectInMap(guid, u.GetMap(), (Corpse*)NULL);
+    // corpses are not kept in the registry of their map
+    Corpse* corpse = GetObjectInWorld(guid, (Corpse*)NULL);
+    return corpse && corpse->GetMap() == u.GetMap() ? corpse : NULL;
 }
 
 GameObject* ObjectAccessor::GetGameObject(WorldObject const& u, uint64 guid)
@@ -181,7 +200,8 @@ Player* ObjectAccessor::GetPlayer(WorldObject const& u, uint64 guid)
 
 Transport* ObjectAccessor::GetTransport(WorldObject const& u, uint64 guid)
 {
-    return GetObjectInMap(guid, u.GetMap(), (Transport*)NULL);
+    Transport* transport = GetObjectInWorld(guid, (Transport*)NULL);
+    return transport && transport->GetMap() == u.GetMap() ? transport : NULL;
 }
 
 Creature* ObjectAccessor::GetCreatureOrPetOrVehicle(WorldObject const& u, uint64 guid)
@@ -441,8 +461,9 @@ void ObjectAccessor::UnloadAll()
 
 /// Define the static members of HashMapHolder
 
-template <class T> std::unordered_map<uint64, T*> HashMapHolder<T>::m_objectMap;
+template <class T> typename HashMapHolder<T>::Shard HashMapHolder<T>::m_shards[HashMapHolder<T>::SHARD_COUNT];
 template <class T> typename HashMapHolder<T>::LockType HashMapHolder<T>::i_lock;
+template <class T> typename HashMapHolder<T>::MapType HashMapHolder<T>::m_objectMap;
 
 /// Global definitions for the hashmap storage
 
@@ -454,6 +475,10 @@ template class HashMapHolder<Creature>;
 template class HashMapHolder<Corpse>;
 template class HashMapHolder<Transport>;
 
+template Creature* ObjectAccessor::GetObjectInMap<Creature>(uint64 guid, Map* map, Creature* /*typeSpecifier*/);
+template GameObject* ObjectAccessor::GetObjectInMap<GameObject>(uint64 guid, Map* map, GameObject* /*typeSpecifier*/);
+template DynamicObject* ObjectAccessor::GetObjectInMap<DynamicObject>(uint64 guid, Map* map, DynamicObject* /*typeSpecifier*/);
+
 template Player* ObjectAccessor::GetObjectInWorld<Player>(uint32 mapid, float x, float y, uint64 guid, Player* /*fake*/);
 template Pet* ObjectAccessor::GetObjectInWorld<Pet>(uint32 mapid, float x, float y, uint64 guid, Pet* /*fake*/);
 template Creature* ObjectAccessor::GetObjectInWorld<Creature>(uint32 mapid, float x, float y, uint64 guid, Creature* /*fake*/);
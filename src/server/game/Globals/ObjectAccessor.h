@@ -29,6 +29,7 @@
 
 #include <ting/shared_mutex.hpp>
 
+#include <iterator>
 #include <set>
 #include <unordered_map>
 
@@ -48,32 +49,124 @@ class HashMapHolder
 {
     public:
 
-        typedef std::unordered_map<uint64, T*> MapType;
+        // objects are spread over the shards by guid, each with its own lock,
+        // so lookups from different map threads rarely meet on the same lock
+        static uint32 const SHARD_COUNT = 64;
+
+        typedef std::unordered_map<uint64, T*> ShardMapType;
+
+        typedef ting::shared_mutex ShardLockType;
+        typedef std::lock_guard<ShardLockType> ShardWriteGuardType;
+        typedef ting::shared_lock<ShardLockType> ShardReadGuardType;
+
+        struct alignas(64) Shard
+        {
+            ShardLockType lock;
+            ShardMapType objects;
+        };
+
+        // all objects, shard by shard; iterate only under a read guard of GetLock()
+        class MapType
+        {
+            public:
+                class const_iterator : public std::iterator<std::forward_iterator_tag, typename ShardMapType::value_type const>
+                {
+                    public:
+                        explicit const_iterator(uint32 shard) : m_shard(shard)
+                        {
+                            if (m_shard < SHARD_COUNT)
+                            {
+                                m_itr = m_shards[m_shard].objects.begin();
+                                SkipEmptyShards();
+                            }
+                        }
+
+                        typename ShardMapType::value_type const& operator*() const { return *m_itr; }
+                        typename ShardMapType::value_type const* operator->() const { return &*m_itr; }
+
+                        const_iterator& operator++()
+                        {
+                            ++m_itr;
+                            SkipEmptyShards();
+                            return *this;
+                        }
+
+                        bool operator==(const_iterator const& other) const
+                        {
+                            return m_shard == other.m_shard && (m_shard == SHARD_COUNT || m_itr == other.m_itr);
+                        }
+
+                        bool operator!=(const_iterator const& other) const { return !(*this == other); }
+
+                    private:
+                        void SkipEmptyShards()
+                        {
+                            while (m_itr == m_shards[m_shard].objects.end())
+                            {
+                                if (++m_shard == SHARD_COUNT)
+                                    return;
+                                m_itr = m_shards[m_shard].objects.begin();
+                            }
+                        }
+
+                        uint32 m_shard;
+                        typename ShardMapType::const_iterator m_itr;
+                };
+
+                const_iterator begin() const { return const_iterator(0); }
+                const_iterator end() const { return const_iterator(SHARD_COUNT); }
+
+                std::size_t size() const
+                {
+                    std::size_t count = 0;
+                    for (uint32 i = 0; i < SHARD_COUNT; ++i)
+                        count += m_shards[i].objects.size();
+                    return count;
+                }
+        };
+
+        // read locks every shard, in order, for iterating the whole container
+        class LockType
+        {
+            public:
+                void lock_shared()
+                {
+                    for (uint32 i = 0; i < SHARD_COUNT; ++i)
+                        m_shards[i].lock.lock_shared();
+                }
+
+                void unlock_shared()
+                {
+                    for (uint32 i = SHARD_COUNT; i > 0; --i)
+                        m_shards[i - 1].lock.unlock_shared();
+                }
+        };
 
-        typedef ting::shared_mutex LockType;
-        typedef std::lock_guard<LockType> WriteGuardType;
         typedef ting::shared_lock<LockType> ReadGuardType;
 
         static void Insert(T* o)
         {
-            WriteGuardType guard(i_lock);
-            m_objectMap[o->GetGUID()] = o;
+            Shard& shard = GetShard(o->GetGUID());
+            ShardWriteGuardType guard(shard.lock);
+            shard.objects[o->GetGUID()] = o;
         }
 
         static void Remove(T* o)
         {
-            WriteGuardType guard(i_lock);
-            m_objectMap.erase(o->GetGUID());
+            Shard& shard = GetShard(o->GetGUID());
+            ShardWriteGuardType guard(shard.lock);
+            shard.objects.erase(o->GetGUID());
         }
 
         static T* Find(uint64 guid)
         {
-            ReadGuardType guard(i_lock);
-            typename MapType::iterator itr = m_objectMap.find(guid);
-            return (itr != m_objectMap.end()) ? itr->second : NULL;
+            Shard& shard = GetShard(guid);
+            ShardReadGuardType guard(shard.lock);
+            typename ShardMapType::const_iterator itr = shard.objects.find(guid);
+            return (itr != shard.objects.end()) ? itr->second : NULL;
         }
 
-        static MapType & GetContainer() { return m_objectMap; }
+        static MapType const& GetContainer() { return m_objectMap; }
 
         static LockType & GetLock() { return i_lock; }
 
@@ -82,8 +175,14 @@ class HashMapHolder
         //Non instanceable only static
         HashMapHolder() {}
 
+        static Shard& GetShard(uint64 guid)
+        {
+            return m_shards[uint32(guid ^ (guid >> 32)) & (SHARD_COUNT - 1)];
+        }
+
+        static Shard m_shards[SHARD_COUNT];
         static LockType i_lock;
-        static MapType  m_objectMap;
+        static MapType m_objectMap;
 };
 
 class ObjectAccessor
@@ -152,15 +251,10 @@ class ObjectAccessor
             return (Unit*)GetObjectInWorld(guid, (Creature*)NULL);
         }
 
-        // returns object if is in map
-        template<class T> static T* GetObjectInMap(uint64 guid, Map* map, T* /*typeSpecifier*/)
-        {
-            ASSERT(map);
-            if (T * obj = GetObjectInWorld(guid, (T*)NULL))
-                if (obj->GetMap() == map)
-                    return obj;
-            return NULL;
-        }
+        // returns object if is in map, looked up in the registry of the map without locking,
+        // so only for use from the thread updating that map
+        template<class T> static T* GetObjectInMap(uint64 guid, Map* map, T* /*typeSpecifier*/);
+        static Unit* GetObjectInMap(uint64 guid, Map* map, Unit* /*typeSpecifier*/);
 
         template<class T> static T* GetObjectInWorld(uint32 mapid, float x, float y, uint64 guid, T* /*fake*/)
         {
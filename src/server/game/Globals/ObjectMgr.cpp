@@ -1426,8 +1426,8 @@ void ObjectMgr::LoadCreatures()
 {
     uint32 oldMSTime = getMSTime();
 
-    //                                               0              1   2    3        4             5           6           7           8            9              10
-    QueryResult result = WorldDatabase.Query("SELECT creature.guid, id, map, modelid, equipment_id, position_x, position_y, position_z, orientation, spawntimesecs, spawndist, "
+    //                                                             0              1   2    3        4             5           6           7           8            9              10
+    PreparedQueryResult result = WorldDatabase.StreamQuery("SELECT creature.guid, id, map, modelid, equipment_id, position_x, position_y, position_z, orientation, spawntimesecs, spawndist, "
     //   11               12         13       14            15         16         17          18          19                20                   21                     22                     23
         "currentwaypoint, curhealth, curmana, MovementType, spawnMask, phaseMask, eventEntry, pool_entry, creature.npcflag, creature.unit_flags, creature.unit_flags2,  creature.dynamicflags, creature.isActive "
         "FROM creature "
@@ -1449,7 +1449,6 @@ void ObjectMgr::LoadCreatures()
                 if (GetMapDifficultyData(i, Difficulty(k)))
                     spawnMasks[i] |= (1 << k);
 
-    _creatureDataStore.rehash(result->GetRowCount());
     uint32 count = 0;
     do
     {
@@ -1579,9 +1578,12 @@ void ObjectMgr::AddCreatureToGrid(uint32 guid, CreatureData const* data)
         if (mask & 1)
         {
             CellCoord cellCoord = Trinity::ComputeCellCoord(data->posX, data->posY);
-            MapObjectWriteGuard guard(_mapObjectGuidsStoreLock);
-            CellObjectGuids& cell_guids = _mapObjectGuidsStore[MAKE_PAIR32(data->mapid, i)][cellCoord.GetId()];
-            cell_guids.creatures.insert(guid);
+            {
+                MapObjectWriteGuard guard(_mapObjectGuidsStoreLock);
+                CellObjectGuids& cell_guids = _mapObjectGuidsStore[MAKE_PAIR32(data->mapid, i)][cellCoord.GetId()];
+                cell_guids.creatures.insert(guid);
+            }
+            InvalidateGridSpawnLayout(data->mapid, i, cellCoord.GetId());
         }
     }
 }
@@ -1594,9 +1596,12 @@ void ObjectMgr::RemoveCreatureFromGrid(uint32 guid, CreatureData const* data)
         if (mask & 1)
         {
             CellCoord cellCoord = Trinity::ComputeCellCoord(data->posX, data->posY);
-            MapObjectWriteGuard guard(_mapObjectGuidsStoreLock);
-            CellObjectGuids& cell_guids = _mapObjectGuidsStore[MAKE_PAIR32(data->mapid, i)][cellCoord.GetId()];
-            cell_guids.creatures.erase(guid);
+            {
+                MapObjectWriteGuard guard(_mapObjectGuidsStoreLock);
+                CellObjectGuids& cell_guids = _mapObjectGuidsStore[MAKE_PAIR32(data->mapid, i)][cellCoord.GetId()];
+                cell_guids.creatures.erase(guid);
+            }
+            InvalidateGridSpawnLayout(data->mapid, i, cellCoord.GetId());
         }
     }
 }
@@ -1744,8 +1749,8 @@ void ObjectMgr::LoadGameobjects()
 
     uint32 count = 0;
 
-    //                                                0               1   2    3           4           5           6
-    QueryResult result = WorldDatabase.Query("SELECT gameobject.guid, id, map, position_x, position_y, position_z, orientation, "
+    //                                                              0               1   2    3           4           5           6
+    PreparedQueryResult result = WorldDatabase.StreamQuery("SELECT gameobject.guid, id, map, position_x, position_y, position_z, orientation, "
     //   7          8          9          10         11             12            13     14        15         16         17          18
         "rotation0, rotation1, rotation2, rotation3, spawntimesecs, animprogress, state, isActive, spawnMask, phaseMask, eventEntry, pool_entry "
         "FROM gameobject LEFT OUTER JOIN game_event_gameobject ON gameobject.guid = game_event_gameobject.guid "
@@ -1766,7 +1771,6 @@ void ObjectMgr::LoadGameobjects()
                 if (GetMapDifficultyData(i, Difficulty(k)))
                     spawnMasks[i] |= (1 << k);
 
-    _gameObjectDataStore.rehash(result->GetRowCount());
 
     do
     {
@@ -1909,9 +1913,12 @@ void ObjectMgr::AddGameobjectToGrid(uint32 guid, GameObjectData const* data)
         if (mask & 1)
         {
             CellCoord cellCoord = Trinity::ComputeCellCoord(data->posX, data->posY);
-            MapObjectWriteGuard guard(_mapObjectGuidsStoreLock);
-            CellObjectGuids& cell_guids = _mapObjectGuidsStore[MAKE_PAIR32(data->mapid, i)][cellCoord.GetId()];
-            cell_guids.gameobjects.insert(guid);
+            {
+                MapObjectWriteGuard guard(_mapObjectGuidsStoreLock);
+                CellObjectGuids& cell_guids = _mapObjectGuidsStore[MAKE_PAIR32(data->mapid, i)][cellCoord.GetId()];
+                cell_guids.gameobjects.insert(guid);
+            }
+            InvalidateGridSpawnLayout(data->mapid, i, cellCoord.GetId());
         }
     }
 }
@@ -1924,9 +1931,12 @@ void ObjectMgr::RemoveGameobjectFromGrid(uint32 guid, GameObjectData const* data
         if (mask & 1)
         {
             CellCoord cellCoord = Trinity::ComputeCellCoord(data->posX, data->posY);
-            MapObjectWriteGuard guard(_mapObjectGuidsStoreLock);
-            CellObjectGuids& cell_guids = _mapObjectGuidsStore[MAKE_PAIR32(data->mapid, i)][cellCoord.GetId()];
-            cell_guids.gameobjects.erase(guid);
+            {
+                MapObjectWriteGuard guard(_mapObjectGuidsStoreLock);
+                CellObjectGuids& cell_guids = _mapObjectGuidsStore[MAKE_PAIR32(data->mapid, i)][cellCoord.GetId()];
+                cell_guids.gameobjects.erase(guid);
+            }
+            InvalidateGridSpawnLayout(data->mapid, i, cellCoord.GetId());
         }
     }
 }
@@ -7442,20 +7452,87 @@ void ObjectMgr::DeleteGOData(uint32 guid)
 
 void ObjectMgr::AddCorpseCellData(uint32 mapid, uint32 cellid, uint32 player_guid, uint32 instance)
 {
-    MapObjectWriteGuard guard(_mapObjectGuidsStoreLock);
+    {
+        MapObjectWriteGuard guard(_mapObjectGuidsStoreLock);
 
-    // corpses are always added to spawn mode 0 and they are spawned by their instance id
-    CellObjectGuids& cell_guids = _mapObjectGuidsStore[MAKE_PAIR32(mapid, 0)][cellid];
-    cell_guids.corpses[player_guid] = instance;
+        // corpses are always added to spawn mode 0 and they are spawned by their instance id
+        CellObjectGuids& cell_guids = _mapObjectGuidsStore[MAKE_PAIR32(mapid, 0)][cellid];
+        cell_guids.corpses[player_guid] = instance;
+    }
+    InvalidateGridSpawnLayout(mapid, 0, cellid);
 }
 
 void ObjectMgr::DeleteCorpseCellData(uint32 mapid, uint32 cellid, uint32 player_guid)
 {
-    MapObjectWriteGuard guard(_mapObjectGuidsStoreLock);
+    {
+        MapObjectWriteGuard guard(_mapObjectGuidsStoreLock);
+
+        // corpses are always added to spawn mode 0 and they are spawned by their instance id
+        CellObjectGuids& cell_guids = _mapObjectGuidsStore[MAKE_PAIR32(mapid, 0)][cellid];
+        cell_guids.corpses.erase(player_guid);
+    }
+    InvalidateGridSpawnLayout(mapid, 0, cellid);
+}
+
+GridSpawnLayoutPtr ObjectMgr::GetGridSpawnLayout(uint16 mapid, uint8 spawnMode, GridCoord const& gridCoord) const
+{
+    uint64 const key = (uint64(MAKE_PAIR32(mapid, spawnMode)) << 32) | gridCoord.GetId();
+
+    std::lock_guard<std::mutex> lock(_gridSpawnLayoutLock);
+    GridSpawnLayoutPtr& layout = _gridSpawnLayoutStore[key];
+    if (!layout)
+        layout = BuildGridSpawnLayout(mapid, spawnMode, gridCoord);
+    return layout;
+}
+
+GridSpawnLayoutPtr ObjectMgr::BuildGridSpawnLayout(uint16 mapid, uint8 spawnMode, GridCoord const& gridCoord) const
+{
+    std::shared_ptr<GridSpawnLayout> layout = std::make_shared<GridSpawnLayout>();
+
+    MapObjectReadGuard guard(_mapObjectGuidsStoreLock);
+
+    MapObjectGuids::const_iterator mapGuids = _mapObjectGuidsStore.find(MAKE_PAIR32(mapid, spawnMode));
+    if (mapGuids == _mapObjectGuidsStore.end())
+        return layout;
+
+    for (uint32 y = 0; y < MAX_NUMBER_OF_CELLS; ++y)
+    {
+        for (uint32 x = 0; x < MAX_NUMBER_OF_CELLS; ++x)
+        {
+            CellCoord const cellCoord(gridCoord.x_coord * MAX_NUMBER_OF_CELLS + x, gridCoord.y_coord * MAX_NUMBER_OF_CELLS + y);
+            CellObjectGuidsMap::const_iterator cellGuids = mapGuids->second.find(cellCoord.GetId());
+            if (cellGuids == mapGuids->second.end())
+                continue;
+
+            CellObjectGuids const& guids = cellGuids->second;
+            if (guids.creatures.empty() && guids.gameobjects.empty() && guids.corpses.empty())
+                continue;
+
+            layout->creatures.insert(layout->creatures.end(), guids.creatures.begin(), guids.creatures.end());
+            layout->gameObjects.insert(layout->gameObjects.end(), guids.gameobjects.begin(), guids.gameobjects.end());
+            layout->corpses.insert(layout->corpses.end(), guids.corpses.begin(), guids.corpses.end());
+
+            GridSpawnLayout::CellSpawns cell;
+            cell.cellX = x;
+            cell.cellY = y;
+            cell.creatureEnd = layout->creatures.size();
+            cell.gameObjectEnd = layout->gameObjects.size();
+            cell.corpseEnd = layout->corpses.size();
+            layout->cells.push_back(cell);
+        }
+    }
+
+    return layout;
+}
+
+void ObjectMgr::InvalidateGridSpawnLayout(uint16 mapid, uint8 spawnMode, uint32 cellId)
+{
+    GridCoord const gridCoord((cellId % TOTAL_NUMBER_OF_CELLS_PER_MAP) / MAX_NUMBER_OF_CELLS, (cellId / TOTAL_NUMBER_OF_CELLS_PER_MAP) / MAX_NUMBER_OF_CELLS);
+    uint64 const key = (uint64(MAKE_PAIR32(mapid, spawnMode)) << 32) | gridCoord.GetId();
 
-    // corpses are always added to spawn mode 0 and they are spawned by their instance id
-    CellObjectGuids& cell_guids = _mapObjectGuidsStore[MAKE_PAIR32(mapid, 0)][cellid];
-    cell_guids.corpses.erase(player_guid);
+    // maps still loading from the old layout keep their reference to it
+    std::lock_guard<std::mutex> lock(_gridSpawnLayoutLock);
+    _gridSpawnLayoutStore.erase(key);
 }
 
 void ObjectMgr::LoadQuestRelationsHelper(QuestRelations& map, std::string table, bool starter, bool go)
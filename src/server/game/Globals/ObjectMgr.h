@@ -45,6 +45,8 @@
 #include <functional>
 #include <limits>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <unordered_map>
 
@@ -140,6 +142,28 @@ struct CellObjectGuids
 typedef std::unordered_map<uint32/*cell_id*/, CellObjectGuids> CellObjectGuidsMap;
 typedef std::unordered_map<uint32/*(mapid, spawnMode) pair*/, CellObjectGuidsMap> MapObjectGuids;
 
+// Spawns of one grid for one spawn mode, flattened from the cell guid store and
+// never changed afterwards, so every map loading that grid reads the same copy.
+// Corpses are only filled in for spawn mode 0, where they are stored.
+struct GridSpawnLayout
+{
+    struct CellSpawns
+    {
+        uint8 cellX;
+        uint8 cellY;
+        uint32 creatureEnd;                                 // each range starts at the end of the previous cell
+        uint32 gameObjectEnd;
+        uint32 corpseEnd;
+    };
+
+    std::vector<CellSpawns> cells;                          // only cells with spawns
+    std::vector<uint32> creatures;
+    std::vector<uint32> gameObjects;
+    std::vector<std::pair<uint32/*player guid*/, uint32/*instance*/> > corpses;
+};
+
+typedef std::shared_ptr<GridSpawnLayout const> GridSpawnLayoutPtr;
+
 // Trinity string ranges
 #define MIN_TRINITY_STRING_ID           1                    // 'trinity_string'
 #define MAX_TRINITY_STRING_ID           2000000000
@@ -847,6 +871,9 @@ class ObjectMgr
             return &j->second;
         }
 
+        // built on first use and dropped again whenever a spawn of the grid is added or removed
+        GridSpawnLayoutPtr GetGridSpawnLayout(uint16 mapid, uint8 spawnMode, GridCoord const& gridCoord) const;
+
        /**
         * Gets temp summon data for all creatures of specified group.
         *
@@ -1241,6 +1268,13 @@ class ObjectMgr
 
         mutable MapObjectLock _mapObjectGuidsStoreLock;
 
+        GridSpawnLayoutPtr BuildGridSpawnLayout(uint16 mapid, uint8 spawnMode, GridCoord const& gridCoord) const;
+        void InvalidateGridSpawnLayout(uint16 mapid, uint8 spawnMode, uint32 cellId);
+
+        typedef std::unordered_map<uint64/*(mapid, spawnMode) pair, grid id*/, GridSpawnLayoutPtr> GridSpawnLayoutContainer;
+        mutable GridSpawnLayoutContainer _gridSpawnLayoutStore;
+        mutable std::mutex _gridSpawnLayoutLock;
+
         CreatureScriptnameContainer _creatureScriptnameStore;
         CreatureDataContainer _creatureDataStore;
         CreatureTemplateContainer _creatureTemplateStore;
@@ -73,6 +73,12 @@ public:
         return i_worldObjects.template count<T>();
     }
 
+    template <typename T>
+    std::size_t GetGridObjectCountInGrid() const
+    {
+        return i_gridObjects.template count<T>();
+    }
+
     // Visit grid objects
     template <typename T>
     void Visit(Trinity::TypeContainerVisitor<T, GridObjectMap> &visitor)
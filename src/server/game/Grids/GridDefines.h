@@ -82,6 +82,13 @@ enum GridMapTypeMask
     GRID_MAP_TYPE_MASK_ALL              = 0x3F
 };
 
+inline uint32 GridMapTypeMaskOf(Corpse const*)        { return GRID_MAP_TYPE_MASK_CORPSE; }
+inline uint32 GridMapTypeMaskOf(Creature const*)      { return GRID_MAP_TYPE_MASK_CREATURE; }
+inline uint32 GridMapTypeMaskOf(DynamicObject const*) { return GRID_MAP_TYPE_MASK_DYNAMICOBJECT; }
+inline uint32 GridMapTypeMaskOf(GameObject const*)    { return GRID_MAP_TYPE_MASK_GAMEOBJECT; }
+inline uint32 GridMapTypeMaskOf(Player const*)        { return GRID_MAP_TYPE_MASK_PLAYER; }
+inline uint32 GridMapTypeMaskOf(AreaTrigger const*)   { return GRID_MAP_TYPE_MASK_AREATRIGGER; }
+
 template <uint32 LIMIT>
 struct CoordPair final
 {
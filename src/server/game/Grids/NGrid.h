@@ -102,7 +102,7 @@ class NGrid final
 public:
     NGrid(int32 x, int32 y, time_t expiry, bool unload = true)
         : i_GridInfo(expiry, unload), i_x(x), i_y(y)
-        , i_cellstate(GRID_STATE_INVALID), i_GridObjectDataLoaded(false)
+        , i_cellstate(GRID_STATE_INVALID), i_lastActiveTime(0), i_GridObjectDataLoaded(false)
     { }
 
     Grid & GetGrid(const uint32 x, const uint32 y)
@@ -121,6 +121,10 @@ public:
     int32 getX() const { return i_x; }
     int32 getY() const { return i_y; }
 
+    // game time the grid was last in use, for unloading the least recently used first
+    time_t GetLastActiveTime() const { return i_lastActiveTime; }
+    void SetLastActiveTime(time_t time) { i_lastActiveTime = time; }
+
     bool isGridObjectDataLoaded() const { return i_GridObjectDataLoaded; }
     void setGridObjectDataLoaded(bool pLoaded) { i_GridObjectDataLoaded = pLoaded; }
 
@@ -157,11 +161,21 @@ public:
         return count;
     }
 
+    template <typename T>
+    std::size_t GetGridObjectCountInNGrid() const
+    {
+        std::size_t count = 0;
+        for (auto &cell : i_cells)
+            count += cell.template GetGridObjectCountInGrid<T>();
+        return count;
+    }
+
 private:
     GridInfo i_GridInfo;
     int32 i_x;
     int32 i_y;
     GridState i_cellstate;
+    time_t i_lastActiveTime;
     Grid i_cells[MAX_NUMBER_OF_CELLS * MAX_NUMBER_OF_CELLS];
     bool i_GridObjectDataLoaded;
 };
@@ -48,28 +48,36 @@ using namespace Trinity;
 
 void VisibleNotifier::SendToSelf()
 {
-    // at this moment i_clientGUIDs have guids that not iterate at grid level checks
+    // at this moment client guids not stamped by this pass were not met at grid level checks
     // but exist one case when this possible and object not out of range: transports
     if (Transport* transport = i_player.GetTransport())
         for (Transport::PlayerSet::const_iterator itr = transport->GetPassengers().begin();itr != transport->GetPassengers().end();++itr)
         {
-            if (vis_guids.find((*itr)->GetGUID()) != vis_guids.end())
+            Player::ClientGUIDs::iterator guid = i_player.m_clientGUIDs.find((*itr)->GetGUID());
+            if (guid != i_player.m_clientGUIDs.end() && guid->second != i_generation)
             {
-                vis_guids.erase((*itr)->GetGUID());
+                guid->second = i_generation;
 
                 i_player.UpdateVisibilityOf((*itr), i_data, i_visibleNow);
                 (*itr)->UpdateVisibilityOf(&i_player);
             }
         }
 
-    for (Player::ClientGUIDs::const_iterator it = vis_guids.begin();it != vis_guids.end(); ++it)
+    for (Player::ClientGUIDs::iterator it = i_player.m_clientGUIDs.begin(); it != i_player.m_clientGUIDs.end();)
     {
-        i_player.m_clientGUIDs.erase(*it);
-        i_data.AddOutOfRangeGUID(*it);
+        if (it->second == i_generation)
+        {
+            ++it;
+            continue;
+        }
 
-        if (IS_PLAYER_GUID(*it))
+        uint64 guid = it->first;
+        it = i_player.m_clientGUIDs.erase(it);
+        i_data.AddOutOfRangeGUID(guid);
+
+        if (IS_PLAYER_GUID(guid))
         {
-            Player* player = ObjectAccessor::FindPlayer(*it);
+            Player* player = ObjectAccessor::FindPlayer(guid);
             if (player && player->IsInWorld())
                 player->UpdateVisibilityOf(&i_player);
         }
@@ -82,7 +90,7 @@ void VisibleNotifier::SendToSelf()
     if (i_data.BuildPacket(&packet))
         i_player.GetSession()->SendPacket(&packet);
 
-    for (std::set<Unit*>::const_iterator it = i_visibleNow.begin(); it != i_visibleNow.end(); ++it)
+    for (std::vector<Unit*>::const_iterator it = i_visibleNow.begin(); it != i_visibleNow.end(); ++it)
         i_player.SendInitialVisiblePackets(*it);
 }
 
@@ -164,15 +172,11 @@ void AIRelocationNotifier::Visit(CreatureMapType &m)
     movedInLos_.clear();
 }
 
-void MessageDistDeliverer::Visit(PlayerMapType &m)
+void MessageDistDeliverer::Visit(PlayerMapType &m, ContainerPositions const &positions)
 {
-    for (auto &target : m)
+    positions.forEachInRange2d(i_source->GetPositionX(), i_source->GetPositionY(), i_distSq, i_phaseMask, [&](std::size_t i)
     {
-        if (!target->InSamePhase(i_phaseMask))
-            continue;
-
-        if (target->GetExactDist2dSq(i_source) > i_distSq)
-            continue;
+        Player* target = m[i];
 
         // Send packet to all who are sharing the player's vision
         if (!target->GetSharedVisionList().empty())
@@ -184,18 +188,14 @@ void MessageDistDeliverer::Visit(PlayerMapType &m)
 
         if (target->m_seer == target || target->GetVehicle())
             SendPacket(target);
-    }
+    });
 }
 
-void MessageDistDeliverer::Visit(CreatureMapType &m)
+void MessageDistDeliverer::Visit(CreatureMapType &m, ContainerPositions const &positions)
 {
-    for (auto &target : m)
+    positions.forEachInRange2d(i_source->GetPositionX(), i_source->GetPositionY(), i_distSq, i_phaseMask, [&](std::size_t i)
     {
-        if (!target->InSamePhase(i_phaseMask))
-            continue;
-
-        if (target->GetExactDist2dSq(i_source) > i_distSq)
-            continue;
+        Creature* target = m[i];
 
         // Send packet to all who are sharing the creature's vision
         if (!target->GetSharedVisionList().empty())
@@ -204,18 +204,14 @@ void MessageDistDeliverer::Visit(CreatureMapType &m)
                 if (player->m_seer == target)
                     SendPacket(player);
         }
-    }
+    });
 }
 
-void MessageDistDeliverer::Visit(DynamicObjectMapType &m)
+void MessageDistDeliverer::Visit(DynamicObjectMapType &m, ContainerPositions const &positions)
 {
-    for (auto &target : m)
+    positions.forEachInRange2d(i_source->GetPositionX(), i_source->GetPositionY(), i_distSq, i_phaseMask, [&](std::size_t i)
     {
-        if (!target->InSamePhase(i_phaseMask))
-            continue;
-
-        if (target->GetExactDist2dSq(i_source) > i_distSq)
-            continue;
+        DynamicObject* target = m[i];
 
         if (IS_PLAYER_GUID(target->GetCasterGUID()))
         {
@@ -224,7 +220,7 @@ void MessageDistDeliverer::Visit(DynamicObjectMapType &m)
             if (caster && caster->m_seer == target)
                 SendPacket(caster);
         }
-    }
+    });
 }
 
 /*
@@ -238,15 +234,11 @@ MessageDistDeliverer::VisitObject(Player* player)
 }
 */
 
-void UnfriendlyMessageDistDeliverer::Visit(PlayerMapType &m)
+void UnfriendlyMessageDistDeliverer::Visit(PlayerMapType &m, ContainerPositions const &positions)
 {
-    for (auto &target : m)
+    positions.forEachInRange2d(i_source->GetPositionX(), i_source->GetPositionY(), i_distSq, i_phaseMask, [&](std::size_t i)
     {
-        if (!target->InSamePhase(i_phaseMask))
-            continue;
-
-        if (target->GetExactDist2dSq(i_source) > i_distSq)
-            continue;
+        Player* target = m[i];
 
         // Send packet to all who are sharing the player's vision
         if (!target->GetSharedVisionList().empty())
@@ -258,7 +250,7 @@ void UnfriendlyMessageDistDeliverer::Visit(PlayerMapType &m)
 
         if (target->m_seer == target || target->GetVehicle())
             SendPacket(target);
-    }
+    });
 }
 
 bool AnyDeadUnitObjectInRangeCheck::operator()(Player* u)
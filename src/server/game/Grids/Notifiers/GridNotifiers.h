@@ -20,6 +20,7 @@
 #define TRINITY_GRIDNOTIFIERS_H
 
 #include "UpdateData.h"
+#include "GridSearchBuffers.h"
 
 #include "Corpse.h"
 #include "AreaTrigger.h"
@@ -30,16 +31,18 @@
 #include "Spell.h"
 #include "SocialMgr.h"
 
+#include <type_traits>
+
 namespace Trinity
 {
     struct VisibleNotifier
     {
         Player &i_player;
         UpdateData i_data;
-        std::set<Unit*> i_visibleNow;
-        Player::ClientGUIDs vis_guids;
+        std::vector<Unit*> i_visibleNow;
+        uint32 i_generation;                // client guids not stamped with it were not met by this pass
 
-        VisibleNotifier(Player &player) : i_player(player), i_data(player.GetMapId()), vis_guids(player.m_clientGUIDs) {}
+        VisibleNotifier(Player &player) : i_player(player), i_data(player.GetMapId()), i_generation(++player.m_visibilityGeneration) {}
 
         void SendToSelf();
 
@@ -92,9 +95,9 @@ namespace Trinity
             , skipped_receiver(skipped)
         { }
 
-        void Visit(PlayerMapType &m);
-        void Visit(CreatureMapType &m);
-        void Visit(DynamicObjectMapType &m);
+        void Visit(PlayerMapType &m, ContainerPositions const &positions);
+        void Visit(CreatureMapType &m, ContainerPositions const &positions);
+        void Visit(DynamicObjectMapType &m, ContainerPositions const &positions);
 
         template <typename NotInterested>
         void Visit(NotInterested &) {}
@@ -127,7 +130,7 @@ namespace Trinity
             : i_source(src), i_message(msg), i_phaseMask(src->GetPhaseMask()), i_distSq(dist * dist)
         { }
 
-        void Visit(PlayerMapType &m);
+        void Visit(PlayerMapType &m, ContainerPositions const &positions);
 
         template <typename NotInterested>
         void Visit(NotInterested &) {}
@@ -591,6 +594,49 @@ namespace Trinity
         void Visit(NotInterested &) {}
     };
 
+    // Container searchers
+
+    // Collects the objects passing the check into any container of pointers
+    // with push_back: a std::list or std::vector like the list searchers fill,
+    // or a SearchBuffer, NearestSearchBuffer or RandomSearchBuffer that does
+    // not allocate at all.
+    // Only the grid containers of types derived from the element type of the
+    // container are visited, so a container of Creature* never looks at
+    // players. The check is any functor taking such an object, a lambda will do.
+    template<class Container, class Check>
+    struct ContainerSearcher
+    {
+        typedef typename std::remove_pointer<typename Container::value_type>::type ObjectType;
+
+        uint32 i_mapTypeMask;
+        uint32 i_phaseMask;
+        Container &i_objects;
+        Check &i_check;
+
+        ContainerSearcher(WorldObject const* searcher, Container &objects, Check &check, uint32 mapTypeMask = GRID_MAP_TYPE_MASK_ALL)
+            : i_mapTypeMask(mapTypeMask), i_phaseMask(searcher->GetPhaseMask()), i_objects(objects), i_check(check) {}
+
+        template <class T>
+        typename std::enable_if<std::is_base_of<ObjectType, T>::value>::type Visit(std::vector<T*> &m)
+        {
+            if (!(i_mapTypeMask & GridMapTypeMaskOf((T const*)NULL)))
+                return;
+
+            for (auto &obj : m)
+                if (obj->InSamePhase(i_phaseMask) && i_check(obj))
+                    i_objects.push_back(obj);
+        }
+
+        template <typename NotInterested>
+        void Visit(NotInterested &) {}
+    };
+
+    template<class Container, class Check>
+    inline ContainerSearcher<Container, Check> makeContainerSearcher(WorldObject const* searcher, Container &objects, Check &check, uint32 mapTypeMask = GRID_MAP_TYPE_MASK_ALL)
+    {
+        return ContainerSearcher<Container, Check>(searcher, objects, check, mapTypeMask);
+    }
+
     // CHECKS && DO classes
 
     // WorldObject check classes
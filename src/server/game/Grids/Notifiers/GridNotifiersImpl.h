@@ -32,8 +32,11 @@ inline void Trinity::VisibleNotifier::Visit(AnyMapType &m)
 {
     for (auto &object : m)
     {
-        vis_guids.erase(object->GetGUID());
         i_player.UpdateVisibilityOf(object, i_data, i_visibleNow);
+
+        Player::ClientGUIDs::iterator itr = i_player.m_clientGUIDs.find(object->GetGUID());
+        if (itr != i_player.m_clientGUIDs.end())
+            itr->second = i_generation;
     }
 }
 
@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_GRIDSEARCHBUFFERS_H
+#define TRINITY_GRIDSEARCHBUFFERS_H
+
+#include "Define.h"
+#include "Object.h"
+#include "Util.h"
+
+#include <cstddef>
+
+namespace Trinity
+{
+    // Results of a grid search kept in place, for up to N objects. Nothing is
+    // allocated, objects found once the buffer is full are dropped and
+    // IsTruncated() tells that this happened.
+    template <class T, std::size_t N>
+    class SearchBuffer
+    {
+        public:
+            typedef T* value_type;
+            typedef T* const* const_iterator;
+
+            SearchBuffer() : m_size(0), m_truncated(false) { }
+
+            void push_back(T* object)
+            {
+                if (m_size < N)
+                    m_objects[m_size++] = object;
+                else
+                    m_truncated = true;
+            }
+
+            // does not keep the order of the other objects
+            void remove(T* object)
+            {
+                for (std::size_t i = 0; i < m_size; ++i)
+                {
+                    if (m_objects[i] == object)
+                    {
+                        m_objects[i] = m_objects[--m_size];
+                        return;
+                    }
+                }
+            }
+
+            void clear()
+            {
+                m_size = 0;
+                m_truncated = false;
+            }
+
+            const_iterator begin() const { return m_objects; }
+            const_iterator end() const { return m_objects + m_size; }
+            T* operator[](std::size_t index) const { return m_objects[index]; }
+
+            std::size_t size() const { return m_size; }
+            bool empty() const { return !m_size; }
+            bool IsTruncated() const { return m_truncated; }
+
+        private:
+            T* m_objects[N];
+            std::size_t m_size;
+            bool m_truncated;
+    };
+
+    // One object picked at random among all the objects of a grid search, each
+    // with the same chance however many are found and without storing them:
+    // the n-th object found replaces the pick with a chance of 1/n.
+    template <class T>
+    class RandomSearchBuffer
+    {
+        public:
+            typedef T* value_type;
+
+            RandomSearchBuffer() : m_object(NULL), m_count(0) { }
+
+            void push_back(T* object)
+            {
+                if (!urand(0, m_count++))
+                    m_object = object;
+            }
+
+            void clear()
+            {
+                m_object = NULL;
+                m_count = 0;
+            }
+
+            T* GetResult() const { return m_object; }
+
+            std::size_t size() const { return m_count; }
+            bool empty() const { return !m_count; }
+
+        private:
+            T* m_object;
+            uint32 m_count;
+    };
+
+    // The N objects nearest to an origin of all the objects of a grid search,
+    // in place of collecting everything, sorting by distance and trimming.
+    // The objects are held in a heap on the distance while searching, call
+    // SortByDistance() once the search is done to get the nearest first.
+    template <class T, std::size_t N>
+    class NearestSearchBuffer
+    {
+        public:
+            typedef T* value_type;
+            typedef T* const* const_iterator;
+
+            explicit NearestSearchBuffer(Position const* origin) : m_origin(origin), m_size(0) { }
+
+            void push_back(T* object)
+            {
+                float const distSq = m_origin->GetExactDistSq(object);
+                if (m_size < N)
+                    SiftUp(m_size++, object, distSq);
+                else if (distSq < m_distSq[0])
+                    SiftDown(0, m_size, object, distSq);
+            }
+
+            void SortByDistance()
+            {
+                // heap sort, the farthest object is moved to the back each time
+                for (std::size_t last = m_size; last > 1; --last)
+                {
+                    T* const object = m_objects[last - 1];
+                    float const distSq = m_distSq[last - 1];
+                    m_objects[last - 1] = m_objects[0];
+                    m_distSq[last - 1] = m_distSq[0];
+                    SiftDown(0, last - 1, object, distSq);
+                }
+            }
+
+            void clear() { m_size = 0; }
+
+            const_iterator begin() const { return m_objects; }
+            const_iterator end() const { return m_objects + m_size; }
+            T* operator[](std::size_t index) const { return m_objects[index]; }
+            float GetDistSq(std::size_t index) const { return m_distSq[index]; }
+
+            std::size_t size() const { return m_size; }
+            bool empty() const { return !m_size; }
+
+        private:
+            void SiftUp(std::size_t index, T* object, float distSq)
+            {
+                while (index)
+                {
+                    std::size_t const parent = (index - 1) / 2;
+                    if (m_distSq[parent] >= distSq)
+                        break;
+
+                    m_objects[index] = m_objects[parent];
+                    m_distSq[index] = m_distSq[parent];
+                    index = parent;
+                }
+
+                m_objects[index] = object;
+                m_distSq[index] = distSq;
+            }
+
+            void SiftDown(std::size_t index, std::size_t size, T* object, float distSq)
+            {
+                while (true)
+                {
+                    std::size_t child = index * 2 + 1;
+                    if (child >= size)
+                        break;
+
+                    if (child + 1 < size && m_distSq[child + 1] > m_distSq[child])
+                        ++child;
+
+                    if (m_distSq[child] <= distSq)
+                        break;
+
+                    m_objects[index] = m_objects[child];
+                    m_distSq[index] = m_distSq[child];
+                    index = child;
+                }
+
+                m_objects[index] = object;
+                m_distSq[index] = distSq;
+            }
+
+            Position const* m_origin;
+            T* m_objects[N];
+            float m_distSq[N];
+            std::size_t m_size;
+    };
+}
+
+#endif
@@ -42,14 +42,14 @@ void AddObjectHelper(Cell const &cell, Map* map, T *obj)
 }
 
 template <typename T>
-uint32 LoadHelper(CellGuidSet const &cellGuids, Cell const &cell, Map *map)
+uint32 LoadHelper(uint32 const *begin, uint32 const *end, Cell const &cell, Map *map)
 {
     uint32 count = 0;
 
-    for (auto const &guid : cellGuids)
+    for (auto guid = begin; guid != end; ++guid)
     {
         auto const obj = new T();
-        if (!obj->LoadFromDB(guid, map))
+        if (!obj->LoadFromDB(*guid, map))
         {
             delete obj;
             continue;
@@ -62,16 +62,16 @@ uint32 LoadHelper(CellGuidSet const &cellGuids, Cell const &cell, Map *map)
     return count;
 }
 
-uint32 LoadHelper(CellCorpseMap const &cellCorpses, Cell const &cell, Map *map)
+uint32 LoadHelper(std::pair<uint32, uint32> const *begin, std::pair<uint32, uint32> const *end, Cell const &cell, Map *map)
 {
     uint32 count = 0;
 
-    for (auto const &kvPair : cellCorpses)
+    for (auto kvPair = begin; kvPair != end; ++kvPair)
     {
-        if (kvPair.second != map->GetInstanceId())
+        if (kvPair->second != map->GetInstanceId())
             continue;
 
-        auto const playerGuid = MAKE_NEW_GUID(kvPair.first, 0, HIGHGUID_PLAYER);
+        auto const playerGuid = MAKE_NEW_GUID(kvPair->first, 0, HIGHGUID_PLAYER);
 
         auto const obj = sObjectAccessor->GetCorpseForPlayerGUID(playerGuid);
         if (!obj)
@@ -106,27 +106,33 @@ void ObjectGridLoader::LoadN(NGrid const &grid, Map *map, Cell cell)
     uint32 creatures = 0;
     uint32 corpses = 0;
 
-    for (uint32 x = 0; x < MAX_NUMBER_OF_CELLS; ++x)
+    GridCoord const gridCoord(cell.GridX(), cell.GridY());
+
+    // the layouts are shared with every other map of this id, only cells with spawns are visited
+    GridSpawnLayoutPtr const layout = sObjectMgr->GetGridSpawnLayout(map->GetId(), map->GetSpawnMode(), gridCoord);
+    uint32 creatureBegin = 0;
+    uint32 gameObjectBegin = 0;
+    for (auto const &cellSpawns : layout->cells)
     {
-        cell.data.Part.cell_x = x;
-        for (uint32 y = 0; y < MAX_NUMBER_OF_CELLS; ++y)
-        {
-            cell.data.Part.cell_y = y;
-
-            // Load creatures and gameobjects
-            if (auto const cellGuids = sObjectMgr->GetCellObjectGuids(map->GetId(), map->GetSpawnMode(), cell.GetCellCoord().GetId()))
-            {
-                creatures += LoadHelper<Creature>(cellGuids->creatures, cell, map);
-                gameObjects += LoadHelper<GameObject>(cellGuids->gameobjects, cell, map);
-            }
-
-            // Load corpses (not bones)
-            if (auto const cellGuids = sObjectMgr->GetCellObjectGuids(map->GetId(), 0, cell.GetCellCoord().GetId()))
-            {
-                // corpses are always added to spawn mode 0 and they are spawned by their instance id
-                corpses += LoadHelper(cellGuids->corpses, cell, map);
-            }
-        }
+        cell.data.Part.cell_x = cellSpawns.cellX;
+        cell.data.Part.cell_y = cellSpawns.cellY;
+
+        creatures += LoadHelper<Creature>(layout->creatures.data() + creatureBegin, layout->creatures.data() + cellSpawns.creatureEnd, cell, map);
+        gameObjects += LoadHelper<GameObject>(layout->gameObjects.data() + gameObjectBegin, layout->gameObjects.data() + cellSpawns.gameObjectEnd, cell, map);
+        creatureBegin = cellSpawns.creatureEnd;
+        gameObjectBegin = cellSpawns.gameObjectEnd;
+    }
+
+    // corpses are always added to spawn mode 0 and they are spawned by their instance id
+    GridSpawnLayoutPtr const corpseLayout = map->GetSpawnMode() ? sObjectMgr->GetGridSpawnLayout(map->GetId(), 0, gridCoord) : layout;
+    uint32 corpseBegin = 0;
+    for (auto const &cellSpawns : corpseLayout->cells)
+    {
+        cell.data.Part.cell_x = cellSpawns.cellX;
+        cell.data.Part.cell_y = cellSpawns.cellY;
+
+        corpses += LoadHelper(corpseLayout->corpses.data() + corpseBegin, corpseLayout->corpses.data() + cellSpawns.corpseEnd, cell, map);
+        corpseBegin = cellSpawns.corpseEnd;
     }
 
     TC_LOG_DEBUG("maps", "%u GameObjects, %u Creatures, and %u Corpses/Bones loaded for grid [%d, %d] on map %u",
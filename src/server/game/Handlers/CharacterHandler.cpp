@@ -47,6 +47,7 @@
 #include "DB2Stores.h"
 #include "SpellAuraEffects.h"
 #include "BattlePetMgr.h"
+#include "CharacterCache.h"
 
 class CharLoginQueryHolder final : public SQLQueryHolder
 {
@@ -294,7 +295,7 @@ bool AuthLoginQueryHolder::Initialize()
     return res;
 }
 
-void WorldSession::HandleCharEnum(PreparedQueryResult result)
+void WorldSession::HandleCharEnum(PreparedQueryResult result, uint32 cacheStamp)
 {
     uint32 unkCount = 0;
     uint32 charCount = 0;
@@ -304,6 +305,10 @@ void WorldSession::HandleCharEnum(PreparedQueryResult result)
     bitBuffer.WriteBit(1); // Must send 1, else receive CHAR_LIST_FAILED error
     bitBuffer.WriteBits(unkCount, 21); // unk uint32 count
 
+    // the cached list must not outlive the temporary bans it shows
+    time_t const now = time(NULL);
+    time_t unbanTime = 0;
+
     if (result)
     {
         _legitCharacters.clear();
@@ -314,7 +319,14 @@ void WorldSession::HandleCharEnum(PreparedQueryResult result)
 
         do
         {
-            uint32 guidLow = (*result)[0].GetUInt32();
+            Field* fields = result->Fetch();
+            uint32 guidLow = fields[0].GetUInt32();
+            if (fields[20].GetUInt32() && fields[23].GetUInt32() != fields[22].GetUInt32())
+            {
+                time_t const unbanDate = time_t(fields[23].GetUInt32());
+                if (unbanDate > now && (!unbanTime || unbanDate < unbanTime))
+                    unbanTime = unbanDate;
+            }
 
             TC_LOG_INFO("network", "Loading char guid %u from account %u.", guidLow, GetAccountId());
 
@@ -334,6 +346,8 @@ void WorldSession::HandleCharEnum(PreparedQueryResult result)
     if (charCount)
         data.append(dataBuffer);
 
+    sCharacterCache->StoreEnum(GetAccountId(), cacheStamp, data, _legitCharacters, unbanTime);
+
     SendPacket(&data);
 }
 
@@ -354,6 +368,16 @@ void WorldSession::HandleCharEnumOpcode(WorldPacket& /*recvData*/)
     PreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_DEL_EXPIRED_BANS);
     CharacterDatabase.Execute(stmt);
 
+    // character list is served from memory until one of the characters changes
+    WorldPacket data;
+    if (sCharacterCache->GetEnum(GetAccountId(), data, _legitCharacters))
+    {
+        SendPacket(&data);
+        return;
+    }
+
+    uint32 const cacheStamp = sCharacterCache->GetAccountStamp(GetAccountId());
+
     /// get all the data necessary for loading all characters (along with their pets) on the account
     if (sWorld->getBoolConfig(CONFIG_DECLINED_NAMES_USED))
         stmt = CharacterDatabase.GetPreparedStatement(CHAR_SEL_ENUM_DECLINED_NAME);
@@ -362,7 +386,7 @@ void WorldSession::HandleCharEnumOpcode(WorldPacket& /*recvData*/)
 
     stmt->setUInt32(0, GetAccountId());
 
-    _charEnumCallback = CharacterDatabase.AsyncQuery(stmt);
+    CharacterDatabase.AsyncQuery(stmt, _queryCallbacks, std::bind(&WorldSession::HandleCharEnum, this, std::placeholders::_1, cacheStamp));
 }
 
 void WorldSession::HandleCharCreateOpcode(WorldPacket& recvData)
@@ -495,20 +519,26 @@ void WorldSession::HandleCharCreateOpcode(WorldPacket& recvData)
         }
     }
 
-    delete _charCreateCallback.GetParam();  // Delete existing if any, to make the callback chain reset to stage 0
-    _charCreateCallback.SetParam(new CharacterCreateInfo(name, race_, class_, gender, skin, face, hairStyle, hairColor, facialHair, outfitId, recvData));
+    // Replaces existing if any, the callback chain of the previous request stops at its next stage
+    _charCreateInfo.reset(new CharacterCreateInfo(name, race_, class_, gender, skin, face, hairStyle, hairColor, facialHair, outfitId, recvData),
+                          [](CharacterCreateInfo *createInfo) { delete createInfo; });
     PreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_SEL_CHECK_NAME);
     stmt->setString(0, name);
-    _charCreateCallback.SetFutureResult(CharacterDatabase.AsyncQuery(stmt));
+    CharacterDatabase.AsyncQuery(stmt, _queryCallbacks, std::bind(&WorldSession::HandleCharCreateCallback, this, std::placeholders::_1, _charCreateInfo, 0));
 }
 
-void WorldSession::HandleCharCreateCallback(PreparedQueryResult result, CharacterCreateInfo* createInfo)
+void WorldSession::HandleCharCreateCallback(PreparedQueryResult result, std::shared_ptr<CharacterCreateInfo> createInfo, uint8 stage)
 {
     /** This is a series of callbacks executed consecutively as a result from the database becomes available.
         This is much more efficient than synchronous requests on packet handler, and much less DoS prone.
         It also prevents data syncrhonisation errors.
     */
-    switch (_charCreateCallback.GetStage())
+    if (createInfo != _charCreateInfo)
+        return;
+
+    auto const nextStage = std::bind(&WorldSession::HandleCharCreateCallback, this, std::placeholders::_1, createInfo, stage + 1);
+
+    switch (stage)
     {
         case 0:
         {
@@ -517,19 +547,14 @@ void WorldSession::HandleCharCreateCallback(PreparedQueryResult result, Characte
                 WorldPacket data(SMSG_CHAR_CREATE, 1);
                 data << uint8(CHAR_CREATE_NAME_IN_USE);
                 SendPacket(&data);
-                delete createInfo;
-                _charCreateCallback.Reset();
+                _charCreateInfo.reset();
                 return;
             }
 
-            ASSERT(_charCreateCallback.GetParam() == createInfo);
-
             PreparedStatement* stmt = LoginDatabase.GetPreparedStatement(LOGIN_SEL_SUM_REALM_CHARACTERS);
             stmt->setUInt32(0, GetAccountId());
 
-            _charCreateCallback.FreeResult();
-            _charCreateCallback.SetFutureResult(LoginDatabase.AsyncQuery(stmt));
-            _charCreateCallback.NextStage();
+            LoginDatabase.AsyncQuery(stmt, _queryCallbacks, nextStage);
         }
         break;
         case 1:
@@ -549,20 +574,14 @@ void WorldSession::HandleCharCreateCallback(PreparedQueryResult result, Characte
                 WorldPacket data(SMSG_CHAR_CREATE, 1);
                 data << uint8(CHAR_CREATE_ACCOUNT_LIMIT);
                 SendPacket(&data);
-                delete createInfo;
-                _charCreateCallback.Reset();
+                _charCreateInfo.reset();
                 return;
             }
 
-
-            ASSERT(_charCreateCallback.GetParam() == createInfo);
-
             PreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_SEL_SUM_CHARS);
             stmt->setUInt32(0, GetAccountId());
 
-            _charCreateCallback.FreeResult();
-            _charCreateCallback.SetFutureResult(CharacterDatabase.AsyncQuery(stmt));
-            _charCreateCallback.NextStage();
+            CharacterDatabase.AsyncQuery(stmt, _queryCallbacks, nextStage);
         }
         break;
         case 2:
@@ -577,8 +596,7 @@ void WorldSession::HandleCharCreateCallback(PreparedQueryResult result, Characte
                     WorldPacket data(SMSG_CHAR_CREATE, 1);
                     data << uint8(CHAR_CREATE_SERVER_LIMIT);
                     SendPacket(&data);
-                    delete createInfo;
-                    _charCreateCallback.Reset();
+                    _charCreateInfo.reset();
                     return;
                 }
             }
@@ -586,20 +604,16 @@ void WorldSession::HandleCharCreateCallback(PreparedQueryResult result, Characte
             bool allowTwoSideAccounts = !sWorld->IsPvPRealm() || sWorld->getBoolConfig(CONFIG_ALLOW_TWO_SIDE_ACCOUNTS) || !AccountMgr::IsPlayerAccount(GetSecurity());
             uint32 skipCinematics = sWorld->getIntConfig(CONFIG_SKIP_CINEMATICS);
 
-            _charCreateCallback.FreeResult();
-
             if (!allowTwoSideAccounts || skipCinematics == 1 || createInfo->Class == CLASS_DEATH_KNIGHT)
             {
                 PreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_SEL_CHAR_CREATE_INFO);
                 stmt->setUInt32(0, GetAccountId());
                 stmt->setUInt32(1, (skipCinematics == 1 || createInfo->Class == CLASS_DEATH_KNIGHT) ? 10 : 1);
-                _charCreateCallback.SetFutureResult(CharacterDatabase.AsyncQuery(stmt));
-                _charCreateCallback.NextStage();
+                CharacterDatabase.AsyncQuery(stmt, _queryCallbacks, nextStage);
                 return;
             }
 
-            _charCreateCallback.NextStage();
-            HandleCharCreateCallback(PreparedQueryResult(NULL), createInfo);   // Will jump to case 3
+            nextStage(PreparedQueryResult());   // Will jump to case 3
         }
         break;
         case 3:
@@ -632,8 +646,7 @@ void WorldSession::HandleCharCreateCallback(PreparedQueryResult result, Characte
                             WorldPacket data(SMSG_CHAR_CREATE, 1);
                             data << uint8(CHAR_CREATE_UNIQUE_CLASS_LIMIT);
                             SendPacket(&data);
-                            delete createInfo;
-                            _charCreateCallback.Reset();
+                            _charCreateInfo.reset();
                             return;
                         }
                     }
@@ -659,8 +672,7 @@ void WorldSession::HandleCharCreateCallback(PreparedQueryResult result, Characte
                         WorldPacket data(SMSG_CHAR_CREATE, 1);
                         data << uint8(CHAR_CREATE_PVP_TEAMS_VIOLATION);
                         SendPacket(&data);
-                        delete createInfo;
-                        _charCreateCallback.Reset();
+                        _charCreateInfo.reset();
                         return;
                     }
                 }
@@ -691,8 +703,7 @@ void WorldSession::HandleCharCreateCallback(PreparedQueryResult result, Characte
                                 WorldPacket data(SMSG_CHAR_CREATE, 1);
                                 data << uint8(CHAR_CREATE_UNIQUE_CLASS_LIMIT);
                                 SendPacket(&data);
-                                delete createInfo;
-                                _charCreateCallback.Reset();
+                                _charCreateInfo.reset();
                                 return;
                             }
                         }
@@ -712,8 +723,7 @@ void WorldSession::HandleCharCreateCallback(PreparedQueryResult result, Characte
                 WorldPacket data(SMSG_CHAR_CREATE, 1);
                 data << uint8(CHAR_CREATE_LEVEL_REQUIREMENT);
                 SendPacket(&data);
-                delete createInfo;
-                _charCreateCallback.Reset();
+                _charCreateInfo.reset();
                 return;
             }
 
@@ -726,7 +736,7 @@ void WorldSession::HandleCharCreateCallback(PreparedQueryResult result, Characte
 
             Player newChar(this);
             newChar.GetMotionMaster()->Initialize();
-            if (!newChar.Create(sObjectMgr->GenerateLowGuid(HIGHGUID_PLAYER), createInfo))
+            if (!newChar.Create(sObjectMgr->GenerateLowGuid(HIGHGUID_PLAYER), createInfo.get()))
             {
                 // Player not create (race/class/etc problem?)
                 newChar.CleanupsBeforeDelete();
@@ -734,8 +744,7 @@ void WorldSession::HandleCharCreateCallback(PreparedQueryResult result, Characte
                 WorldPacket data(SMSG_CHAR_CREATE, 1);
                 data << uint8(CHAR_CREATE_ERROR);
                 SendPacket(&data);
-                delete createInfo;
-                _charCreateCallback.Reset();
+                _charCreateInfo.reset();
                 return;
             }
 
@@ -772,8 +781,7 @@ void WorldSession::HandleCharCreateCallback(PreparedQueryResult result, Characte
             sScriptMgr->OnPlayerCreate(&newChar);
 
             newChar.CleanupsBeforeDelete();
-            delete createInfo;
-            _charCreateCallback.Reset();
+            _charCreateInfo.reset();
         }
         break;
     }
@@ -880,8 +888,16 @@ void WorldSession::HandlePlayerLoginOpcode(WorldPacket& recvData)
         return;
     }
 
-    _charLoginCallback = CharacterDatabase.DelayQueryHolder(charHolder);
-    _authLoginCallback = LoginDatabase.DelayQueryHolder(authHolder);
+    // Both holders complete on this session's update, the last one starts the login
+    auto const pending = std::make_shared<uint8>(2);
+    auto const onLoaded = [this, charHolder, authHolder, pending](SQLQueryHolder *)
+    {
+        if (--*pending == 0)
+            HandlePlayerLogin(charHolder, authHolder);
+    };
+
+    CharacterDatabase.DelayQueryHolder(charHolder, _queryCallbacks, onLoaded);
+    LoginDatabase.DelayQueryHolder(authHolder, _queryCallbacks, onLoaded);
 }
 
 void WorldSession::HandleLoadScreenOpcode(WorldPacket& recvPacket)
@@ -1427,8 +1443,6 @@ void WorldSession::HandleCharRenameOpcode(WorldPacket& recvData)
 
     // Ensure that the character belongs to the current account, that rename at login is enabled
     // and that there is no character with the desired new name
-    _charRenameCallback.SetParam(newName);
-
     PreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_SEL_FREE_NAME);
 
     stmt->setUInt32(0, GUID_LOPART(guid));
@@ -1437,7 +1451,7 @@ void WorldSession::HandleCharRenameOpcode(WorldPacket& recvData)
     stmt->setUInt16(3, AT_LOGIN_RENAME);
     stmt->setString(4, newName);
 
-    _charRenameCallback.SetFutureResult(CharacterDatabase.AsyncQuery(stmt));
+    CharacterDatabase.AsyncQuery(stmt, _queryCallbacks, std::bind(&WorldSession::HandleChangePlayerNameOpcodeCallBack, this, std::placeholders::_1, newName));
 }
 
 void WorldSession::HandleChangePlayerNameOpcodeCallBack(PreparedQueryResult result, std::string newName)
@@ -1552,6 +1566,7 @@ void WorldSession::HandleSetPlayerDeclinedNames(WorldPacket& recvData)
 
     trans->Append(stmt);
 
+    sCharacterCache->InvalidateCharacter(GUID_LOPART(guid), GetAccountId(), trans);
     CharacterDatabase.CommitTransaction(trans);
 
     SendPlayerDeclinedNamesResult(guid, 0);
@@ -2677,4 +2692,6 @@ void WorldSession::HandleReorderCharacters(WorldPacket& recvData)
     }
 
     CharacterDatabase.CommitTransaction(trans);
+
+    sCharacterCache->InvalidateAccount(GetAccountId());
 }
@@ -672,8 +672,7 @@ void WorldSession::HandleAddFriendOpcode(WorldPacket& recvData)
 
     stmt->setString(0, friendName);
 
-    _addFriendCallback.SetParam(friendNote);
-    _addFriendCallback.SetFutureResult(CharacterDatabase.AsyncQuery(stmt));
+    CharacterDatabase.AsyncQuery(stmt, _queryCallbacks, std::bind(&WorldSession::HandleAddFriendOpcodeCallBack, this, std::placeholders::_1, friendNote));
 }
 
 void WorldSession::HandleAddFriendOpcodeCallBack(PreparedQueryResult result, std::string friendNote)
@@ -764,7 +763,7 @@ void WorldSession::HandleAddIgnoreOpcode(WorldPacket& recvData)
 
     stmt->setString(0, ignoreName);
 
-    _addIgnoreCallback = CharacterDatabase.AsyncQuery(stmt);
+    CharacterDatabase.AsyncQuery(stmt, _queryCallbacks, std::bind(&WorldSession::HandleAddIgnoreOpcodeCallBack, this, std::placeholders::_1));
 }
 
 void WorldSession::HandleAddIgnoreOpcodeCallBack(PreparedQueryResult result)
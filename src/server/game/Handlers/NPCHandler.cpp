@@ -549,8 +549,7 @@ void WorldSession::SendPetList(uint64 guid, uint8 first, uint8 last)
     stmt->setUInt8(1, first);
     stmt->setUInt8(2, last);
 
-    _sendPetListCallback.SetParam(guid);
-    _sendPetListCallback.SetFutureResult(CharacterDatabase.AsyncQuery(stmt));
+    CharacterDatabase.AsyncQuery(stmt, _queryCallbacks, std::bind(&WorldSession::SendPetListCallback, this, std::placeholders::_1, guid));
 }
 
 void WorldSession::SendPetListCallback(PreparedQueryResult result, uint64 guid)
@@ -656,8 +655,7 @@ void WorldSession::HandleSetPetSlot(WorldPacket& recvData)
     PreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_SEL_PET_INFO_FOR_SLOT_CHANGE);
     stmt->setUInt32(0, petId);
 
-    _setPetSlotCallback.SetParam(newSlot);
-    _setPetSlotCallback.SetFutureResult(CharacterDatabase.AsyncQuery(stmt));
+    CharacterDatabase.AsyncQuery(stmt, _queryCallbacks, std::bind(&WorldSession::SetPetSlotCallback, this, std::placeholders::_1, newSlot));
 }
 
 void WorldSession::SetPetSlotCallback(PreparedQueryResult result, uint8 newSlot)
@@ -30,6 +30,7 @@
 #include "NPCHandler.h"
 #include "Pet.h"
 #include "MapManager.h"
+#include "CharacterCache.h"
 
 void WorldSession::SendNameQueryOpcode(Player const *player)
 {
@@ -107,6 +108,13 @@ void WorldSession::SendNameQueryOpcode(Player const *player)
 
 void WorldSession::SendNameQueryOpcode(uint64 guid)
 {
+    CharacterNameData nameData;
+    if (sCharacterCache->GetNameData(GUID_LOPART(guid), nameData))
+    {
+        SendNameQueryResponse(guid, &nameData);
+        return;
+    }
+
     uint32 statementId = sWorld->getBoolConfig(CONFIG_DECLINED_NAMES_USED)
             ? CHAR_SEL_NAME_QUERY_DECLINED
             : CHAR_SEL_NAME_QUERY_SIMPLE;
@@ -114,13 +122,39 @@ void WorldSession::SendNameQueryOpcode(uint64 guid)
     auto stmt = CharacterDatabase.GetPreparedStatement(statementId);
     stmt->setUInt32(0, GUID_LOPART(guid));
 
-    PreparedQueryResultFuture result = CharacterDatabase.AsyncQuery(stmt);
+    CharacterDatabase.AsyncQuery(stmt, _queryCallbacks,
+            std::bind(&WorldSession::SendNameQueryOpcodeCallBack, this, guid, sCharacterCache->GetNameStamp(), std::placeholders::_1));
+}
+
+void WorldSession::SendNameQueryOpcodeCallBack(uint64 guid, uint32 cacheStamp, PreparedQueryResult result)
+{
+    if (!result)
+    {
+        SendNameQueryResponse(guid, NULL);
+        return;
+    }
+
+    auto const fields = result->Fetch();
+
+    CharacterNameData nameData;
+    nameData.name = fields[0].GetString();
+    nameData.race = fields[1].GetUInt8();
+    nameData.gender = fields[2].GetUInt8();
+    nameData.playerClass = fields[3].GetUInt8();
+    nameData.level = fields[4].GetUInt8();
+    nameData.hasDeclinedName = sWorld->getBoolConfig(CONFIG_DECLINED_NAMES_USED) && !fields[5].GetString().empty();
+
+    if (nameData.hasDeclinedName)
+    {
+        for (uint8 i = 0; i < MAX_DECLINED_NAME_CASES; ++i)
+            nameData.declinedName[i] = fields[5 + i].GetString();
+    }
 
-    ACE_Guard<ACE_Thread_Mutex> guard(_nameQueryCallbacksLock);
-    _nameQueryCallbacks.emplace_back(guid, result);
+    sCharacterCache->StoreNameData(GUID_LOPART(guid), cacheStamp, nameData);
+    SendNameQueryResponse(guid, &nameData);
 }
 
-void WorldSession::SendNameQueryOpcodeCallBack(uint64 guid, PreparedQueryResult result)
+void WorldSession::SendNameQueryResponse(uint64 guid, CharacterNameData const *nameData)
 {
     WorldPacket data(SMSG_NAME_QUERY_RESPONSE, 8 + 1 + 1 + 1 + 1 + 1 + 10);
 
@@ -132,7 +166,7 @@ void WorldSession::SendNameQueryOpcodeCallBack(uint64 guid, PreparedQueryResult
 
     data.WriteByteSeq<7, 4, 3>(playerGuid);
 
-    if (!result)
+    if (!nameData)
     {
         data << uint8(1);
         data.WriteByteSeq<1, 5, 0, 6, 2>(playerGuid);
@@ -140,43 +174,26 @@ void WorldSession::SendNameQueryOpcodeCallBack(uint64 guid, PreparedQueryResult
         return;
     }
 
-    auto const fields = result->Fetch();
-
-    auto const playerName = fields[0].GetString();
-    auto const race = fields[1].GetUInt8();
-    auto const gender = fields[2].GetUInt8();
-    auto const playerClass = fields[3].GetUInt8();
-    auto const level = fields[4].GetUInt8();
-    auto const hasDeclinedName = sWorld->getBoolConfig(CONFIG_DECLINED_NAMES_USED) && *fields[5].GetCString() != '\0';
-
     data << uint8(0);
     data << uint32(0);
-    data << uint8(GetPlayer() ? GetPlayer()->getRace() : race);
-    data << gender;
-    data << level;
-    data << playerClass;
+    data << uint8(GetPlayer() ? GetPlayer()->getRace() : nameData->race);
+    data << nameData->gender;
+    data << nameData->level;
+    data << nameData->playerClass;
     data << uint32(realmID);
 
     data.WriteByteSeq<1, 5, 0, 6, 2>(playerGuid);
 
     data.WriteBitSeq<6>(playerGuid);
     data.WriteBitSeq<7>(unkGuid);
-    data.WriteBits(playerName.size(), 6);
+    data.WriteBits(nameData->name.size(), 6);
     data.WriteBitSeq<1, 7, 2>(playerGuid);
     data.WriteBitSeq<4>(unkGuid);
     data.WriteBitSeq<4, 0>(playerGuid);
     data.WriteBitSeq<1>(unkGuid);
 
-    if (hasDeclinedName)
-    {
-        for (uint8 i = 0; i < MAX_DECLINED_NAME_CASES; ++i)
-            data.WriteBits(fields[5 + i].GetString().size(), 7);
-    }
-    else
-    {
-        for (uint8 i = 0; i < MAX_DECLINED_NAME_CASES; ++i)
-            data.WriteBits(0, 7);
-    }
+    for (uint8 i = 0; i < MAX_DECLINED_NAME_CASES; ++i)
+        data.WriteBits(nameData->hasDeclinedName ? nameData->declinedName[i].size() : 0, 7);
 
     data.WriteBitSeq<3>(unkGuid);
     data.WriteBitSeq<3>(playerGuid);
@@ -186,17 +203,17 @@ void WorldSession::SendNameQueryOpcodeCallBack(uint64 guid, PreparedQueryResult
     data.WriteBitSeq<2, 6>(unkGuid);
     data.FlushBits();
 
-    data.WriteString(playerName);
+    data.WriteString(nameData->name);
     data.WriteByteSeq<4>(playerGuid);
     data.WriteByteSeq<3>(unkGuid);
     data.WriteByteSeq<6>(playerGuid);
     data.WriteByteSeq<2, 4>(unkGuid);
     data.WriteByteSeq<5, 1, 7>(playerGuid);
 
-    if (hasDeclinedName)
+    if (nameData->hasDeclinedName)
     {
         for (uint8 i = 0; i < MAX_DECLINED_NAME_CASES; ++i)
-            data.WriteString(fields[5 + i].GetString());
+            data.WriteString(nameData->declinedName[i]);
     }
 
     data.WriteByteSeq<3>(playerGuid);
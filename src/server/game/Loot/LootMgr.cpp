@@ -127,8 +127,9 @@ uint32 LootStore::LoadLootTable()
     // Clearing store (for reloading case)
     Clear();
 
-    //                                                  0     1            2               3         4         5             6
-    QueryResult result = WorldDatabase.PQuery("SELECT entry, item, ChanceOrQuestChance, lootmode, groupid, mincountOrRef, maxcount FROM %s", GetName());
+    //                                             0      1     2                    3         4        5              6
+    std::string const query = std::string("SELECT entry, item, ChanceOrQuestChance, lootmode, groupid, mincountOrRef, maxcount FROM ") + GetName();
+    PreparedQueryResult result = WorldDatabase.StreamQuery(query.c_str());
 
     if (!result)
         return 0;
@@ -19,6 +19,7 @@
 #include "Map.h"
 #include "ScriptMgr.h"
 #include "VMapFactory.h"
+#include "MMapFactory.h"
 #include "MapInstanced.h"
 #include "CellImpl.h"
 #include "GridNotifiers.h"
@@ -36,6 +37,8 @@
 #include "Profiler/ProbePoint.hpp"
 #include "BattlePetSpawnMgr.h"
 
+#include <ace/Mem_Map.h>
+
 namespace {
 
 union u_map_magic
@@ -45,12 +48,15 @@ union u_map_magic
 };
 
 u_map_magic MapMagic        = { {'M','A','P','S'} };
-u_map_magic MapVersionMagic = { {'v','1','.','3'} };
+u_map_magic MapVersionMagic = { {'v','1','.','4'} };
 u_map_magic MapAreaMagic    = { {'A','R','E','A'} };
 u_map_magic MapHeightMagic  = { {'M','H','G','T'} };
 u_map_magic MapLiquidMagic  = { {'M','L','I','Q'} };
 
 #define DEFAULT_GRID_EXPIRY     300
+#define GRID_CHURN_WINDOW       4                           // in grid expiries
+#define MAX_GRID_EXPIRY_FACTOR  8
+#define GRID_BUDGET_CHECK_INTERVAL  (1 * IN_MILLISECONDS)
 #define MAX_GRID_LOAD_TIME      50
 #define MAX_CREATURE_ATTACK_RADIUS  (45.0f * sWorld->getRate(RATE_CREATURE_AGGRO))
 
@@ -73,6 +79,7 @@ void ActiveStateUpdate(Map &map, Map::GridContainerType::iterator itr, uint32 di
         Trinity::ObjectGridStoper worker;
         grid.VisitAllGrids(Trinity::makeGridVisitor(worker));
         grid.SetGridState(GRID_STATE_IDLE);
+        grid.SetLastActiveTime(sWorld->GetGameTime());
 
         TC_LOG_DEBUG("maps", "Grid[%u, %u] on map %u moved to IDLE state",
                      grid.getX(), grid.getY(), map.GetId());
@@ -87,7 +94,7 @@ void IdleStateUpdate(Map &map, Map::GridContainerType::iterator itr, uint32)
 {
     auto &grid = itr->second;
 
-    map.ResetGridExpiry(grid);
+    map.ResetGridExpiry(grid, map.GetGridExpiryFactor(grid));
     grid.SetGridState(GRID_STATE_REMOVAL);
     TC_LOG_DEBUG("maps", "Grid[%u, %u] on map %u moved to REMOVAL state",
                  grid.getX(), grid.getY(), map.GetId());
@@ -105,6 +112,10 @@ void RemovalStateUpdate(Map &map, Map::GridContainerType::iterator itr, uint32 d
     if (!info.getTimeTracker().Passed())
         return;
 
+    // kept until the memory budget needs the room, see Map::UnloadGridsOverBudget
+    if (map.GetGridMemoryBudget())
+        return;
+
     if (!map.UnloadGrid(itr, false))
     {
         TC_LOG_DEBUG("maps", "Grid[%u, %u] for map %u differed unloading due to players or active objects nearby",
@@ -121,37 +132,6 @@ GridStateUpdate si_GridStates[MAX_GRID_STATE] =
     &RemovalStateUpdate
 };
 
-template <typename GridVisitor, typename WorldVisitor>
-void VisitNearbyCellsOf(Map *map, WorldObject* obj, GridVisitor &&gridVisitor, WorldVisitor &&worldVisitor)
-{
-    // Check for valid position
-    if (!obj->IsPositionValid())
-        return;
-
-    // Update mobs/objects in ALL visible cells around object!
-    CellArea area = Cell::CalculateCellArea(obj->GetPositionX(), obj->GetPositionY(), obj->GetGridActivationRange());
-
-    for (uint32 x = area.low_bound.x_coord; x <= area.high_bound.x_coord; ++x)
-    {
-        for (uint32 y = area.low_bound.y_coord; y <= area.high_bound.y_coord; ++y)
-        {
-            // marked cells are those that have been visited
-            // don't visit the same cell twice
-            uint32 cell_id = (y * TOTAL_NUMBER_OF_CELLS_PER_MAP) + x;
-            if (map->isCellMarked(cell_id))
-                continue;
-
-            map->markCell(cell_id);
-
-            Cell cell(CellCoord(x, y));
-            cell.SetNoCreate();
-
-            map->Visit(cell, std::forward<GridVisitor>(gridVisitor));
-            map->Visit(cell, std::forward<WorldVisitor>(worldVisitor));
-        }
-    }
-}
-
 struct CorpseGridReset final
 {
     void Visit(CorpseMapType &m)
@@ -168,6 +148,15 @@ struct CorpseGridReset final
 
 void Map::ObjectUpdater::updateCollected(uint32 diff)
 {
+    for (auto &creature : i_creaturesNearPlayers)
+        updateCreature(creature, diff, true);
+
+    for (auto &creature : i_creaturesAway)
+        updateCreature(creature, diff, false);
+
+    i_creaturesNearPlayers.clear();
+    i_creaturesAway.clear();
+
     if (!i_objectsToUpdate.empty())
     {
         for (auto &object : i_objectsToUpdate)
@@ -176,6 +165,39 @@ void Map::ObjectUpdater::updateCollected(uint32 diff)
 
         i_objectsToUpdate.clear();
     }
+
+    i_nearPlayers = true;
+}
+
+void Map::ObjectUpdater::updateCreature(Creature* creature, uint32 diff, bool nearPlayers)
+{
+    if (!creature->IsInWorld())
+        return;
+
+    if (i_idleUpdateInterval && creature->CanUpdateAtIdleRate(nearPlayers))
+    {
+        // the first wait is spread over the interval by guid, so creatures
+        // becoming idle together, like those of a freshly loaded grid, are
+        // not all updated on the same tick afterwards
+        if (!creature->_idleUpdateDue)
+            creature->_idleUpdateDue = 1 + creature->GetGUIDLow() % i_idleUpdateInterval;
+
+        creature->_idleUpdateDiff += diff;
+        if (creature->_idleUpdateDiff < creature->_idleUpdateDue)
+            return;
+
+        diff = creature->_idleUpdateDiff;
+        creature->_idleUpdateDiff = 0;
+        creature->_idleUpdateDue = i_idleUpdateInterval;
+    }
+    else
+    {
+        diff += creature->_idleUpdateDiff;
+        creature->_idleUpdateDiff = 0;
+        creature->_idleUpdateDue = 0;
+    }
+
+    creature->Update(diff);
 }
 
 Map::~Map()
@@ -195,6 +217,8 @@ Map::~Map()
 
     if (!m_scriptSchedule.empty())
         sScriptMgr->DecreaseScheduledScriptCount(m_scriptSchedule.size());
+
+    MMAP::MMapFactory::createOrGetMMapManager()->unloadMapInstance(GetId(), i_InstanceId);
 }
 
 bool Map::ExistMap(uint32 mapid, int gx, int gy)
@@ -243,6 +267,19 @@ bool Map::ExistVMap(uint32 mapid, int gx, int gy)
     return true;
 }
 
+void Map::LoadMMap(int gx, int gy)
+{
+    if (!MMAP::MMapFactory::IsPathfindingEnabled(GetId()))
+        return;
+
+    bool mmapLoadResult = MMAP::MMapFactory::createOrGetMMapManager()->loadMap(sWorld->GetDataPath() + "mmaps", GetId(), gx, gy);
+
+    if (mmapLoadResult)
+        TC_LOG_DEBUG("maps", "MMAP loaded name:%s, id:%d, x:%d, y:%d (mmap rep.: x:%d, y:%d)", GetMapName(), GetId(), gx, gy, gx, gy);
+    else
+        TC_LOG_DEBUG("maps", "Could not load MMAP name:%s, id:%d, x:%d, y:%d (mmap rep.: x:%d, y:%d)", GetMapName(), GetId(), gx, gy, gx, gy);
+}
+
 void Map::LoadVMap(int gx, int gy)
 {
                                                             // x and y are swapped !!
@@ -306,9 +343,93 @@ void Map::LoadMap(int gx, int gy, bool reload)
 
 void Map::LoadMapAndVMap(int gx, int gy)
 {
+    // Data read ahead by the prefetcher only has to be published, the VMap
+    // models it holds on to turn loading the tile into a cache lookup
+    PrefetchedGridPtr prefetched;
+    if (i_InstanceId == 0 && !i_gridMaps[gx][gy])
+        if ((prefetched = TakePrefetchedGrid(gx, gy)))
+            i_gridMaps[gx][gy] = prefetched->TakeGridMap();
+
     LoadMap(gx, gy);
+    // Only load the data for the base map
     if (i_InstanceId == 0)
-        LoadVMap(gx, gy);                                   // Only load the data for the base map
+    {
+        LoadVMap(gx, gy);
+        LoadMMap(gx, gy);
+    }
+
+    _queryCache.Invalidate();
+}
+
+void Map::PrefetchGridsAhead(Player const* player)
+{
+    if (i_InstanceId != 0 || !sTerrainPrefetcher->IsEnabled() || !player->isMoving())
+        return;
+
+    float const distance = player->GetSpeed(player->IsFlying() ? MOVE_FLIGHT : MOVE_RUN) * sWorld->getIntConfig(CONFIG_TERRAIN_PREFETCH_LOOKAHEAD);
+    float const dx = std::cos(player->GetOrientation());
+    float const dy = std::sin(player->GetOrientation());
+
+    // Sample the path in half grid steps, so that no grid along it is skipped
+    float const stepSize = SIZE_OF_GRIDS / 2;
+    for (float step = stepSize; step < distance + stepSize; step += stepSize)
+    {
+        float const ahead = std::min(step, distance);
+        GridCoord const p = Trinity::ComputeGridCoord(player->GetPositionX() + dx * ahead, player->GetPositionY() + dy * ahead);
+        if (!p.IsCoordValid())
+            break;
+
+        int const gx = (MAX_NUMBER_OF_GRIDS - 1) - p.x_coord;
+        int const gy = (MAX_NUMBER_OF_GRIDS - 1) - p.y_coord;
+        if (i_gridMaps[gx][gy])
+            continue;
+
+        std::lock_guard<std::mutex> guard(_prefetchLock);
+
+        auto &prefetched = _prefetchedGrids[gx * MAX_NUMBER_OF_GRIDS + gy];
+        if (prefetched)
+            continue;
+
+        TC_LOG_DEBUG("maps", "Prefetching grid[%u, %u] of map %u ahead of player %s", p.x_coord, p.y_coord, GetId(), player->GetName().c_str());
+
+        prefetched = std::make_shared<PrefetchedGrid>(GetId(), gx, gy);
+        sTerrainPrefetcher->Queue(prefetched);
+    }
+}
+
+PrefetchedGridPtr Map::TakePrefetchedGrid(int gx, int gy)
+{
+    std::lock_guard<std::mutex> guard(_prefetchLock);
+
+    auto const itr = _prefetchedGrids.find(gx * MAX_NUMBER_OF_GRIDS + gy);
+    if (itr == _prefetchedGrids.end())
+        return PrefetchedGridPtr();
+
+    // Still in flight, loading it here is faster than waiting for it
+    PrefetchedGridPtr result;
+    if (itr->second->ready.load(std::memory_order_acquire))
+        result = itr->second;
+
+    _prefetchedGrids.erase(itr);
+    return result;
+}
+
+void Map::DropStalePrefetchedGrids()
+{
+    if (!sTerrainPrefetcher->IsEnabled())
+        return;
+
+    std::lock_guard<std::mutex> guard(_prefetchLock);
+
+    // The player turned away before reaching the grid
+    time_t const expireTime = time(NULL) - 2 * sWorld->getIntConfig(CONFIG_TERRAIN_PREFETCH_LOOKAHEAD);
+    for (auto itr = _prefetchedGrids.begin(); itr != _prefetchedGrids.end();)
+    {
+        if (itr->second->requestTime < expireTime && itr->second->ready.load(std::memory_order_acquire))
+            itr = _prefetchedGrids.erase(itr);
+        else
+            ++itr;
+    }
 }
 
 Map::Map(uint32 id, time_t expiry, uint32 InstanceId, uint8 SpawnMode,
@@ -321,6 +442,17 @@ Map::Map(uint32 id, time_t expiry, uint32 InstanceId, uint8 SpawnMode,
 {
     m_parentMap = (_parent ? _parent : this);
     Map::InitVisibilityDistance();
+
+    _pathCache.SetCapacity(sWorld->getIntConfig(CONFIG_MMAP_PATH_CACHE_SIZE));
+    // the parent of instanced maps is queried by all its instances, from their own threads
+    if (!Instanceable() || i_InstanceId != 0)
+        _queryCache.SetCapacity(sWorld->getIntConfig(CONFIG_MAP_QUERY_CACHE_SIZE));
+
+    i_objectUpdater.SetIdleUpdateInterval(sWorld->getIntConfig(CONFIG_CREATURE_IDLE_UPDATE_INTERVAL));
+    _idleUpdateNearDistance = sWorld->getFloatConfig(CONFIG_CREATURE_IDLE_UPDATE_NEAR_DISTANCE);
+
+    _gridMemoryBudget = std::size_t(sWorld->getIntConfig(CONFIG_GRID_MEMORY_BUDGET)) * 1024 * 1024;
+    _gridBudgetTimer.SetInterval(GRID_BUDGET_CHECK_INTERVAL);
 }
 
 void Map::InitVisibilityDistance()
@@ -334,6 +466,8 @@ void Map::AddToGrid(Player *obj, Cell const &cell)
 {
     auto const ngrid = getNGrid(cell.GridX(), cell.GridY());
     ngrid->GetGrid(cell.CellX(), cell.CellY()).AddWorldObject(obj);
+
+    obj->SetCurrentCell(cell);
 }
 
 void Map::AddToGrid(GameObject *obj, Cell const &cell)
@@ -442,6 +576,7 @@ void Map::EnsureGridCreated_i(const GridCoord &p)
     auto &ngrid = itr->second;
 
     ngrid.SetGridState(GRID_STATE_IDLE);
+    ngrid.SetLastActiveTime(sWorld->GetGameTime());
     setNGrid(&ngrid, p.x_coord, p.y_coord);
 
     //z coord
@@ -483,6 +618,23 @@ bool Map::EnsureGridLoaded(const Cell &cell)
 
     ngrid->setGridObjectDataLoaded(true);
 
+    ++_gridChurnStats.loads;
+    auto const history = _gridHistory.find(cell.GridX() * MAX_NUMBER_OF_GRIDS + cell.GridY());
+    if (history != _gridHistory.end())
+    {
+        if (sWorld->GetGameTime() - history->second.unloadTime < i_gridExpiry * GRID_CHURN_WINDOW / IN_MILLISECONDS)
+        {
+            ++_gridChurnStats.reloads;
+            if (history->second.reloads < MAX_GRID_EXPIRY_FACTOR - 1)
+                ++history->second.reloads;
+
+            TC_LOG_DEBUG("maps", "Grid[%u, %u] for map %u instance %u loaded again %u seconds after its unload, %u times in a row",
+                         cell.GridX(), cell.GridY(), GetId(), i_InstanceId, uint32(sWorld->GetGameTime() - history->second.unloadTime), history->second.reloads);
+        }
+        else
+            _gridHistory.erase(history);
+    }
+
     Trinity::ObjectGridLoader::LoadN(*ngrid, this, cell);
 
     // Add resurrectable corpses to world object list in grid
@@ -600,8 +752,8 @@ void Map::Update(const uint32 diff)
 
     _dynamicTree.update(diff);
 
-    // update active cells around players and active objects
-    resetMarkedCells();
+    if (i_InstanceId == 0)
+        DropStalePrefetchedGrids();
 
     // update worldsessions for existing players
     for (m_mapRefIter = m_mapRefManager.begin(); m_mapRefIter != m_mapRefManager.end(); ++m_mapRefIter)
@@ -613,15 +765,28 @@ void Map::Update(const uint32 diff)
             if (player->IsInWorld())
             {
                 player->Update(diff);
-                VisitNearbyCellsOf(this, player, gridObjectUpdate, worldObjectUpdate);
+                // a delayed teleport at the end of Update may have removed it from this map
+                if (player->IsInWorld() && player->GetMap() == this)
+                    UpdateObserverCells(player);
             }
         }
     }
 
-    // non-player active objects, increasing iterator in the loop in case of object removal
+    // non-player active objects
     for (auto &obj: m_activeNonPlayers)
         if (obj && obj->IsInWorld())
-            VisitNearbyCellsOf(this, obj, gridObjectUpdate, worldObjectUpdate);
+            UpdateObserverCells(obj);
+
+    // update mobs/objects in all cells around players and active objects, each cell once
+    for (std::vector<uint32>::const_iterator itr = _activeCells.begin(); itr != _activeCells.end(); ++itr)
+    {
+        Cell cell(CellCoord(*itr % TOTAL_NUMBER_OF_CELLS_PER_MAP, *itr / TOTAL_NUMBER_OF_CELLS_PER_MAP));
+        cell.SetNoCreate();
+
+        i_objectUpdater.SetNearPlayers(_activeCellRefs[*itr].nearPlayers != 0);
+        Visit(cell, gridObjectUpdate);
+        Visit(cell, worldObjectUpdate);
+    }
 
     i_objectUpdater.updateCollected(diff);
 
@@ -633,13 +798,132 @@ void Map::Update(const uint32 diff)
         i_scriptLock = false;
     }
 
+    MoveAllPlayersInMoveList();
     MoveAllCreaturesInMoveList();
+
+    ProcessVisibilityChanges();
+}
+
+void Map::UpdateObserverCells(WorldObject const* obj)
+{
+    if (!obj->IsPositionValid())
+    {
+        RemoveObserverCells(obj);
+        return;
+    }
+
+    float const x = obj->GetPositionX();
+    float const y = obj->GetPositionY();
+    float const range = obj->GetGridActivationRange();
+
+    auto itr = _observerCells.find(obj);
+    if (itr != _observerCells.end() && itr->second.x == x && itr->second.y == y && itr->second.range == range)
+        return;
+
+    bool const isNew = itr == _observerCells.end();
+    if (isNew)
+    {
+        itr = _observerCells.insert(std::make_pair(obj, ObserverCells())).first;
+        itr->second.hasNearArea = obj->GetTypeId() == TYPEID_PLAYER;
+    }
+
+    ObserverCells& cells = itr->second;
+    CellArea const area = Cell::CalculateCellArea(x, y, range);
+    bool const areaChanged = isNew || !(cells.area.low_bound == area.low_bound && cells.area.high_bound == area.high_bound);
+
+    // the new cells are added before the old ones are dropped, so the cells
+    // near the player stay active cells all along
+    if (areaChanged)
+        ChangeActiveCells(area, true);
+
+    if (cells.hasNearArea)
+    {
+        CellArea const nearArea = Cell::CalculateCellArea(x, y, std::min(_idleUpdateNearDistance, range));
+        if (isNew || !(cells.nearArea.low_bound == nearArea.low_bound && cells.nearArea.high_bound == nearArea.high_bound))
+        {
+            if (!isNew)
+                ChangeNearPlayerCells(cells.nearArea, false);
+            ChangeNearPlayerCells(nearArea, true);
+            cells.nearArea = nearArea;
+        }
+    }
+
+    if (areaChanged && !isNew)
+        ChangeActiveCells(cells.area, false);
+
+    cells.x = x;
+    cells.y = y;
+    cells.range = range;
+    cells.area = area;
+}
+
+void Map::RemoveObserverCells(WorldObject const* obj)
+{
+    auto itr = _observerCells.find(obj);
+    if (itr == _observerCells.end())
+        return;
+
+    if (itr->second.hasNearArea)
+        ChangeNearPlayerCells(itr->second.nearArea, false);
+    ChangeActiveCells(itr->second.area, false);
+    _observerCells.erase(itr);
+}
+
+void Map::ChangeActiveCells(CellArea const& area, bool add)
+{
+    for (uint32 x = area.low_bound.x_coord; x <= area.high_bound.x_coord; ++x)
+    {
+        for (uint32 y = area.low_bound.y_coord; y <= area.high_bound.y_coord; ++y)
+        {
+            uint32 const cellId = y * TOTAL_NUMBER_OF_CELLS_PER_MAP + x;
+            if (add)
+            {
+                ActiveCellRef& ref = _activeCellRefs[cellId];
+                if (!ref.observers++)
+                {
+                    ref.index = _activeCells.size();
+                    _activeCells.push_back(cellId);
+                }
+                continue;
+            }
+
+            auto itr = _activeCellRefs.find(cellId);
+            ASSERT(itr != _activeCellRefs.end());
+            if (--itr->second.observers)
+                continue;
+
+            // the last active cell takes the place of the removed one
+            uint32 const last = _activeCells.back();
+            _activeCells[itr->second.index] = last;
+            _activeCellRefs[last].index = itr->second.index;
+            _activeCells.pop_back();
+            _activeCellRefs.erase(itr);
+        }
+    }
+}
+
+void Map::ChangeNearPlayerCells(CellArea const& area, bool add)
+{
+    for (uint32 x = area.low_bound.x_coord; x <= area.high_bound.x_coord; ++x)
+    {
+        for (uint32 y = area.low_bound.y_coord; y <= area.high_bound.y_coord; ++y)
+        {
+            auto itr = _activeCellRefs.find(y * TOTAL_NUMBER_OF_CELLS_PER_MAP + x);
+            ASSERT(itr != _activeCellRefs.end());
+            if (add)
+                ++itr->second.nearPlayers;
+            else
+                --itr->second.nearPlayers;
+        }
+    }
 }
 
 void Map::RemovePlayerFromMap(Player* player, bool remove)
 {
     sScriptMgr->OnPlayerLeaveMap(this, player);
 
+    RemovePlayerFromMoveList(player);
+    RemoveObserverCells(player);
     player->RemoveFromWorld();
     SendRemoveTransports(player);
 
@@ -680,7 +964,6 @@ void Map::PlayerRelocation(Player* player, float x, float y, float z, float orie
 {
     ASSERT(player);
 
-    Cell old_cell(player->GetPositionX(), player->GetPositionY());
     Cell new_cell(x, y);
 
     //! If hovering, always increase our server-side Z position
@@ -693,19 +976,12 @@ void Map::PlayerRelocation(Player* player, float x, float y, float z, float orie
     if (player->IsVehicle())
         player->GetVehicleKit()->RelocatePassengers();
 
+    // the position is the player's at once, the move to the grid container of
+    // the new cell is done in Map::MoveAllPlayersInMoveList however many times
+    // the player moves until then
+    Cell const& old_cell = player->GetCurrentCell();
     if (old_cell.DiffGrid(new_cell) || old_cell.DiffCell(new_cell))
-    {
-        TC_LOG_DEBUG("maps", "Player %s relocation grid[%u, %u]cell[%u, %u]->grid[%u, %u]cell[%u, %u]",
-                     player->GetName().c_str(), old_cell.GridX(), old_cell.GridY(), old_cell.CellX(), old_cell.CellY(),
-                     new_cell.GridX(), new_cell.GridY(), new_cell.CellX(), new_cell.CellY());
-
-        player->RemoveFromGrid();
-
-        if (old_cell.DiffGrid(new_cell))
-            EnsureGridLoadedForActiveObject(new_cell, player);
-
-        AddToGrid(player, new_cell);
-    }
+        AddPlayerToMoveList(player);
 
     player->OnRelocated();
 }
@@ -743,6 +1019,253 @@ void Map::CreatureRelocation(Creature* creature, float x, float y, float z, floa
     }
 }
 
+void Map::ScheduleVisibilityChange(Unit* unit, bool loadGrids)
+{
+    int32 const slot = unit->GetVisibilityChangeSlot();
+    if (slot >= 0)
+    {
+        _visibilityChanges[slot].loadGrids |= loadGrids;
+        return;
+    }
+
+    VisibilityChange const change = { unit, loadGrids };
+    unit->SetVisibilityChangeSlot(_visibilityChanges.size());
+    _visibilityChanges.push_back(change);
+}
+
+void Map::CancelVisibilityChange(Unit* unit)
+{
+    int32 const slot = unit->GetVisibilityChangeSlot();
+    if (slot < 0)
+        return;
+
+    _visibilityChanges[slot].unit = NULL;
+    unit->SetVisibilityChangeSlot(-1);
+}
+
+namespace
+{
+    struct ChangedCell
+    {
+        CellCoord coord;
+        float range;                                        // largest visibility range of the units moved into it
+        uint32 begin, end;
+    };
+
+    bool IsInReachOfCell(WorldObject const* obj, ChangedCell const& cell)
+    {
+        float const minX = (float(cell.coord.x_coord) - CENTER_GRID_CELL_ID) * SIZE_OF_GRID_CELL;
+        float const minY = (float(cell.coord.y_coord) - CENTER_GRID_CELL_ID) * SIZE_OF_GRID_CELL;
+        float const dx = std::max(std::max(minX - obj->GetPositionX(), obj->GetPositionX() - (minX + SIZE_OF_GRID_CELL)), 0.0f);
+        float const dy = std::max(std::max(minY - obj->GetPositionY(), obj->GetPositionY() - (minY + SIZE_OF_GRID_CELL)), 0.0f);
+        return dx * dx + dy * dy <= cell.range * cell.range;
+    }
+
+    // appends the indexes of the changed cells, sorted by cell id, that lie within range of obj
+    void CollectCellsAround(std::vector<ChangedCell> const& cells, WorldObject const* obj, float range, std::vector<uint32>& result)
+    {
+        CellArea const area = Cell::CalculateCellArea(obj->GetPositionX(), obj->GetPositionY(), range);
+        for (uint32 y = area.low_bound.y_coord; y <= area.high_bound.y_coord; ++y)
+        {
+            uint32 const first = CellCoord(area.low_bound.x_coord, y).GetId();
+            uint32 const last = CellCoord(area.high_bound.x_coord, y).GetId();
+            std::vector<ChangedCell>::const_iterator cell = std::lower_bound(cells.begin(), cells.end(), first,
+                [](ChangedCell const& c, uint32 id) { return c.coord.GetId() < id; });
+
+            for (; cell != cells.end() && cell->coord.GetId() <= last; ++cell)
+                result.push_back(cell - cells.begin());
+        }
+    }
+}
+
+void Map::ProcessVisibilityChanges()
+{
+    if (_visibilityChanges.empty())
+        return;
+
+    // changes scheduled while processing are kept for the next update
+    uint32 const count = _visibilityChanges.size();
+
+    // moved players and the players sharing vision of a moved unit look around themselves,
+    // which covers every moved object within their sight range at its final position
+    std::vector<Player*> refreshed;
+    for (uint32 i = 0; i < count; ++i)
+    {
+        Unit* unit = _visibilityChanges[i].unit;
+        if (!unit)
+            continue;
+
+        SharedVisionList const& shList = unit->GetSharedVisionList();
+        for (SharedVisionList::const_iterator it = shList.begin(); it != shList.end();)
+        {
+            Player* viewer = *it++;
+            viewer->UpdateVisibilityForPlayer();
+            refreshed.push_back(viewer);
+        }
+
+        if (Player* player = unit->ToPlayer())
+        {
+            player->UpdateVisibilityForPlayer();
+            refreshed.push_back(player);
+        }
+    }
+
+    std::sort(refreshed.begin(), refreshed.end());
+
+    // the other observers only look at the cells units moved into
+    std::vector<std::pair<uint32, uint32> > byCell;
+    byCell.reserve(count);
+    for (uint32 i = 0; i < count; ++i)
+        if (Unit* unit = _visibilityChanges[i].unit)
+            byCell.push_back(std::make_pair(Trinity::ComputeCellCoord(unit->GetPositionX(), unit->GetPositionY()).GetId(), i));
+
+    std::sort(byCell.begin(), byCell.end());
+
+    // cells keep the order of byCell, sorted by cell id
+    std::vector<ChangedCell> cells;
+    float maxRange = 0.0f;
+    for (uint32 i = 0; i < byCell.size();)
+    {
+        Unit* first = _visibilityChanges[byCell[i].second].unit;
+        ChangedCell cell = { Trinity::ComputeCellCoord(first->GetPositionX(), first->GetPositionY()), 0.0f, i, i };
+        for (; cell.end < byCell.size() && byCell[cell.end].first == byCell[i].first; ++cell.end)
+            cell.range = std::max(cell.range, _visibilityChanges[byCell[cell.end].second].unit->GetVisibilityRange());
+
+        maxRange = std::max(maxRange, cell.range);
+        cells.push_back(cell);
+        i = cell.end;
+    }
+
+    // an observer is only tested against the changed cells around it and its seer
+    std::vector<uint32> nearCells;
+    for (MapRefManager::iterator itr = m_mapRefManager.begin(); itr != m_mapRefManager.end(); ++itr)
+    {
+        Player* player = itr->GetSource();
+        if (!player || !player->IsInWorld())
+            continue;
+
+        bool const isRefreshed = std::binary_search(refreshed.begin(), refreshed.end(), player);
+        float const sightRange = player->GetSightRange();
+
+        nearCells.clear();
+        CollectCellsAround(cells, player, maxRange, nearCells);
+        if (player->m_seer != player)
+        {
+            CollectCellsAround(cells, player->m_seer, maxRange, nearCells);
+            std::sort(nearCells.begin(), nearCells.end());
+            nearCells.erase(std::unique(nearCells.begin(), nearCells.end()), nearCells.end());
+        }
+
+        for (std::vector<uint32>::const_iterator index = nearCells.begin(); index != nearCells.end(); ++index)
+        {
+            ChangedCell const* cell = &cells[*index];
+            if (isRefreshed && cell->range <= sightRange)
+                continue;
+
+            if (!IsInReachOfCell(player, *cell) && (player->m_seer == player || !IsInReachOfCell(player->m_seer, *cell)))
+                continue;
+
+            // units may be removed by the updates, e.g. pets going out of sight
+            for (uint32 i = cell->begin; i < cell->end; ++i)
+                if (Unit* unit = _visibilityChanges[byCell[i].second].unit)
+                    if (unit != player)
+                        player->UpdateVisibilityOf(unit);
+        }
+    }
+
+    for (uint32 i = 0; i < count; ++i)
+    {
+        Unit* unit = _visibilityChanges[i].unit;
+        if (!unit)
+            continue;
+
+        unit->SetVisibilityChangeSlot(-1);
+        if (_visibilityChanges[i].loadGrids)
+            loadGridsInRange(*unit, MAX_VISIBILITY_DISTANCE);
+    }
+
+    _visibilityChanges.erase(_visibilityChanges.begin(), _visibilityChanges.begin() + count);
+    for (uint32 i = 0; i < _visibilityChanges.size(); ++i)
+        if (Unit* unit = _visibilityChanges[i].unit)
+            unit->SetVisibilityChangeSlot(i);
+}
+
+void Map::AddPlayerToMoveList(Player* player)
+{
+    if (player->_cellMoveQueued)
+        return;
+
+    player->_cellMoveQueued = true;
+    _playersToMove.push_back(player);
+}
+
+void Map::RemovePlayerFromMoveList(Player* player)
+{
+    if (!player->_cellMoveQueued)
+        return;
+
+    player->_cellMoveQueued = false;
+    std::vector<Player*>::iterator itr = std::find(_playersToMove.begin(), _playersToMove.end(), player);
+    if (itr != _playersToMove.end())
+    {
+        _playersToMove.erase(itr);
+        return;
+    }
+
+    // removed while the batch it is in is processed
+    for (std::vector<std::pair<uint32, Player*> >::iterator move = _playerMoveBatch.begin(); move != _playerMoveBatch.end(); ++move)
+        if (move->second == player)
+            move->second = NULL;
+}
+
+void Map::MoveAllPlayersInMoveList()
+{
+    if (_playersToMove.empty())
+        return;
+
+    // in cell order, so the moves into the same cell and grid come together
+    _playerMoveBatch.reserve(_playersToMove.size());
+    for (std::vector<Player*>::const_iterator itr = _playersToMove.begin(); itr != _playersToMove.end(); ++itr)
+        _playerMoveBatch.push_back(std::make_pair(Trinity::ComputeCellCoord((*itr)->GetPositionX(), (*itr)->GetPositionY()).GetId(), *itr));
+
+    _playersToMove.clear();
+    std::sort(_playerMoveBatch.begin(), _playerMoveBatch.end());
+
+    // by index, grid loading may remove players of the batch and clear their entry
+    for (size_t i = 0; i < _playerMoveBatch.size(); ++i)
+    {
+        Player* player = _playerMoveBatch[i].second;
+        if (!player)
+            continue;
+
+        player->_cellMoveQueued = false;
+        if (!player->IsInWorld())
+            continue;
+
+        Cell const old_cell(player->GetCurrentCell());
+        Cell const new_cell(player->GetPositionX(), player->GetPositionY());
+
+        // moved back into the cell it is in
+        if (!old_cell.DiffGrid(new_cell) && !old_cell.DiffCell(new_cell))
+            continue;
+
+        TC_LOG_DEBUG("maps", "Player %s relocation grid[%u, %u]cell[%u, %u]->grid[%u, %u]cell[%u, %u]",
+                     player->GetName().c_str(), old_cell.GridX(), old_cell.GridY(), old_cell.CellX(), old_cell.CellY(),
+                     new_cell.GridX(), new_cell.GridY(), new_cell.CellX(), new_cell.CellY());
+
+        player->RemoveFromGrid();
+
+        if (old_cell.DiffGrid(new_cell))
+            EnsureGridLoadedForActiveObject(new_cell, player);
+
+        AddToGrid(player, new_cell);
+
+        PrefetchGridsAhead(player);
+    }
+
+    _playerMoveBatch.clear();
+}
+
 void Map::AddCreatureToMoveList(Creature* c, float x, float y, float z, float ang)
 {
     if (_creatureToMoveLock) //can this happen?
@@ -968,6 +1491,13 @@ bool Map::UnloadGrid(GridContainerType::iterator itr, bool unloadAll)
 
         i_loadedGrids.erase(itr);
         setNGrid(NULL, x, y);
+
+        if (!unloadAll)
+        {
+            ++_gridChurnStats.unloads;
+            GridHistory& history = _gridHistory[x * MAX_NUMBER_OF_GRIDS + y];
+            history.unloadTime = sWorld->GetGameTime();
+        }
     }
 
     int gx = (MAX_NUMBER_OF_GRIDS - 1) - x;
@@ -985,11 +1515,13 @@ bool Map::UnloadGrid(GridContainerType::iterator itr, bool unloadAll)
             }
             // x and y are swapped
             VMAP::VMapFactory::createOrGetVMapManager()->unloadMap(GetId(), gx, gy);
+            MMAP::MMapFactory::createOrGetMMapManager()->unloadMap(GetId(), gx, gy);
         }
         else
             ((MapInstanced*)m_parentMap)->RemoveGridMapReference(GridCoord(gx, gy));
 
         i_gridMaps[gx][gy] = NULL;
+        _queryCache.Invalidate();
     }
     TC_LOG_DEBUG("maps", "Unloading grid[%u, %u] for map %u finished", x, y, GetId());
     return true;
@@ -1033,9 +1565,8 @@ GridMap::GridMap()
     _areaMap = NULL;
     // Height level data
     _gridHeight = INVALID_HEIGHT;
-    _gridGetHeight = &GridMap::getHeightFromFlat;
-    m_V9 = NULL;
-    m_V8 = NULL;
+    _heightBlocks = NULL;
+    _convertedHeightBlocks = NULL;
     // Liquid data
     _liquidType    = 0;
     _liquidOffX   = 0;
@@ -1046,6 +1577,7 @@ GridMap::GridMap()
     _liquidEntry = NULL;
     _liquidFlags = NULL;
     _liquidMap  = NULL;
+    _mappedFile = NULL;
 }
 
 GridMap::~GridMap()
@@ -1058,159 +1590,208 @@ bool GridMap::loadData(char *filename)
     // Unload old data if exist
     unloadData();
 
-    map_fileheader header;
-    // Not return error if file not found
-    FILE* in = fopen(filename, "rb");
-    if (!in)
-        return true;
+    _mappedFile = new ACE_Mem_Map();
+    if (_mappedFile->map(filename, static_cast<size_t>(-1), O_RDONLY, ACE_DEFAULT_FILE_PERMS, PROT_READ, ACE_MAP_SHARED) == -1)
+    {
+        // Not return error if file not found
+        bool const notFound = (errno == ENOENT);
+        unloadData();
+        return notFound;
+    }
 
-    if (fread(&header, sizeof(header), 1, in) != 1)
+    map_fileheader const* header = getMappedData<map_fileheader>(0);
+    if (!header)
     {
-        fclose(in);
+        unloadData();
         return false;
     }
 
-    if (header.mapMagic == MapMagic.asUInt && header.versionMagic == MapVersionMagic.asUInt)
+    if (header->mapMagic == MapMagic.asUInt && header->versionMagic == MapVersionMagic.asUInt)
     {
         // loadup area data
-        if (header.areaMapOffset && !loadAreaData(in, header.areaMapOffset, header.areaMapSize))
+        if (header->areaMapOffset && !loadAreaData(header->areaMapOffset, header->areaMapSize))
         {
             TC_LOG_ERROR("maps", "Error loading map area data\n");
-            fclose(in);
+            unloadData();
             return false;
         }
         // loadup height data
-        if (header.heightMapOffset && !loadHeihgtData(in, header.heightMapOffset, header.heightMapSize))
+        if (header->heightMapOffset && !loadHeihgtData(header->heightMapOffset, header->heightMapSize))
         {
             TC_LOG_ERROR("maps", "Error loading map height data\n");
-            fclose(in);
+            unloadData();
             return false;
         }
         // loadup liquid data
-        if (header.liquidMapOffset && !loadLiquidData(in, header.liquidMapOffset, header.liquidMapSize))
+        if (header->liquidMapOffset && !loadLiquidData(header->liquidMapOffset, header->liquidMapSize))
         {
             TC_LOG_ERROR("maps", "Error loading map liquids data\n");
-            fclose(in);
+            unloadData();
             return false;
         }
-        fclose(in);
         return true;
     }
     TC_LOG_ERROR("maps", "Map file '%s' is from an incompatible clientversion. Please recreate using the mapextractor.", filename);
-    fclose(in);
+    unloadData();
     return false;
 }
 
 void GridMap::unloadData()
 {
-    delete[] _areaMap;
-    delete[] m_V9;
-    delete[] m_V8;
-    delete[] _liquidEntry;
-    delete[] _liquidFlags;
-    delete[] _liquidMap;
+    delete _mappedFile;
+    _mappedFile = NULL;
     _areaMap = NULL;
-    m_V9 = NULL;
-    m_V8 = NULL;
+    _heightBlocks = NULL;
+    delete[] _convertedHeightBlocks;
+    _convertedHeightBlocks = NULL;
     _liquidEntry = NULL;
     _liquidFlags = NULL;
     _liquidMap  = NULL;
-    _gridGetHeight = &GridMap::getHeightFromFlat;
 }
 
-bool GridMap::loadAreaData(FILE* in, uint32 offset, uint32 /*size*/)
+void GridMap::touchData() const
+{
+    if (!_mappedFile)
+        return;
+
+    char const* data = static_cast<char const*>(_mappedFile->addr());
+    size_t const pageSize = ACE_OS::getpagesize();
+
+    volatile char sink;
+    for (size_t offset = 0; offset < _mappedFile->size(); offset += pageSize)
+        sink = data[offset];
+    (void)sink;
+}
+
+template <class T>
+T const* GridMap::getMappedData(uint32 offset, uint32 count) const
 {
-    map_areaHeader header;
-    fseek(in, offset, SEEK_SET);
+    // The extractor aligns every section, a misaligned array means a broken file
+    if (offset % alignof(T) != 0)
+        return NULL;
+
+    if (uint64(offset) + uint64(count) * sizeof(T) > _mappedFile->size())
+        return NULL;
+
+    return reinterpret_cast<T const*>(static_cast<char const*>(_mappedFile->addr()) + offset);
+}
 
-    if (fread(&header, sizeof(header), 1, in) != 1 || header.fourcc != MapAreaMagic.asUInt)
+bool GridMap::loadAreaData(uint32 offset, uint32 /*size*/)
+{
+    map_areaHeader const* header = getMappedData<map_areaHeader>(offset);
+    if (!header || header->fourcc != MapAreaMagic.asUInt)
         return false;
 
-    _gridArea = header.gridArea;
-    if (!(header.flags & MAP_AREA_NO_AREA))
+    _gridArea = header->gridArea;
+    if (!(header->flags & MAP_AREA_NO_AREA))
     {
-        _areaMap = new uint16 [16*16];
-        if (fread(_areaMap, sizeof(uint16), 16*16, in) != 16*16)
+        _areaMap = getMappedData<uint16>(offset + sizeof(map_areaHeader), 16*16);
+        if (!_areaMap)
             return false;
     }
     return true;
 }
 
-bool GridMap::loadHeihgtData(FILE* in, uint32 offset, uint32 /*size*/)
+bool GridMap::loadHeihgtData(uint32 offset, uint32 /*size*/)
 {
-    map_heightHeader header;
-    fseek(in, offset, SEEK_SET);
-
-    if (fread(&header, sizeof(header), 1, in) != 1 || header.fourcc != MapHeightMagic.asUInt)
+    map_heightHeader const* header = getMappedData<map_heightHeader>(offset);
+    if (!header || header->fourcc != MapHeightMagic.asUInt)
         return false;
 
-    _gridHeight = header.gridHeight;
-    if (!(header.flags & MAP_HEIGHT_NO_HEIGHT))
+    uint32 const dataOffset = offset + sizeof(map_heightHeader);
+
+    _gridHeight = header->gridHeight;
+    if (header->flags & MAP_HEIGHT_NO_HEIGHT)
+        return true;
+
+    if (header->flags & MAP_HEIGHT_AS_BLOCKS)
     {
-        if ((header.flags & MAP_HEIGHT_AS_INT16))
-        {
-            m_uint16_V9 = new uint16 [129*129];
-            m_uint16_V8 = new uint16 [128*128];
-            if (fread(m_uint16_V9, sizeof(uint16), 129*129, in) != 129*129 ||
-                fread(m_uint16_V8, sizeof(uint16), 128*128, in) != 128*128)
-                return false;
-            _gridIntHeightMultiplier = (header.gridMaxHeight - header.gridHeight) / 65535;
-            _gridGetHeight = &GridMap::getHeightFromUint16;
-        }
-        else if ((header.flags & MAP_HEIGHT_AS_INT8))
-        {
-            m_uint8_V9 = new uint8 [129*129];
-            m_uint8_V8 = new uint8 [128*128];
-            if (fread(m_uint8_V9, sizeof(uint8), 129*129, in) != 129*129 ||
-                fread(m_uint8_V8, sizeof(uint8), 128*128, in) != 128*128)
-                return false;
-            _gridIntHeightMultiplier = (header.gridMaxHeight - header.gridHeight) / 255;
-            _gridGetHeight = &GridMap::getHeightFromUint8;
-        }
-        else
-        {
-            m_V9 = new float [129*129];
-            m_V8 = new float [128*128];
-            if (fread(m_V9, sizeof(float), 129*129, in) != 129*129 ||
-                fread(m_V8, sizeof(float), 128*128, in) != 128*128)
-                return false;
-            _gridGetHeight = &GridMap::getHeightFromFloat;
-        }
+        _heightBlocks = getMappedData<map_heightBlock>(dataOffset, MAP_HEIGHT_BLOCKS * MAP_HEIGHT_BLOCKS);
+        return _heightBlocks != NULL;
+    }
+
+    return convertHeightData(header, dataOffset);
+}
+
+bool GridMap::convertHeightData(map_heightHeader const* header, uint32 dataOffset)
+{
+    std::vector<float> v9(129*129);
+    std::vector<float> v8(128*128);
+
+    if (header->flags & MAP_HEIGHT_AS_INT16)
+    {
+        uint16 const* uint16_V9 = getMappedData<uint16>(dataOffset, 129*129);
+        uint16 const* uint16_V8 = getMappedData<uint16>(dataOffset + 129*129*sizeof(uint16), 128*128);
+        if (!uint16_V9 || !uint16_V8)
+            return false;
+
+        float const multiplier = (header->gridMaxHeight - header->gridHeight) / 65535;
+        for (uint32 i = 0; i < v9.size(); ++i)
+            v9[i] = uint16_V9[i] * multiplier + header->gridHeight;
+        for (uint32 i = 0; i < v8.size(); ++i)
+            v8[i] = uint16_V8[i] * multiplier + header->gridHeight;
+    }
+    else if (header->flags & MAP_HEIGHT_AS_INT8)
+    {
+        uint8 const* uint8_V9 = getMappedData<uint8>(dataOffset, 129*129);
+        uint8 const* uint8_V8 = getMappedData<uint8>(dataOffset + 129*129*sizeof(uint8), 128*128);
+        if (!uint8_V9 || !uint8_V8)
+            return false;
+
+        float const multiplier = (header->gridMaxHeight - header->gridHeight) / 255;
+        for (uint32 i = 0; i < v9.size(); ++i)
+            v9[i] = uint8_V9[i] * multiplier + header->gridHeight;
+        for (uint32 i = 0; i < v8.size(); ++i)
+            v8[i] = uint8_V8[i] * multiplier + header->gridHeight;
     }
     else
-        _gridGetHeight = &GridMap::getHeightFromFlat;
+    {
+        float const* float_V9 = getMappedData<float>(dataOffset, 129*129);
+        float const* float_V8 = getMappedData<float>(dataOffset + 129*129*sizeof(float), 128*128);
+        if (!float_V9 || !float_V8)
+            return false;
+
+        v9.assign(float_V9, float_V9 + 129*129);
+        v8.assign(float_V8, float_V8 + 128*128);
+    }
+
+    _convertedHeightBlocks = new map_heightBlock[MAP_HEIGHT_BLOCKS * MAP_HEIGHT_BLOCKS];
+    MapHeightBlocks::Encode(&v9[0], &v8[0], _convertedHeightBlocks);
+    _heightBlocks = _convertedHeightBlocks;
     return true;
 }
 
-bool GridMap::loadLiquidData(FILE* in, uint32 offset, uint32 /*size*/)
+bool GridMap::loadLiquidData(uint32 offset, uint32 /*size*/)
 {
-    map_liquidHeader header;
-    fseek(in, offset, SEEK_SET);
-
-    if (fread(&header, sizeof(header), 1, in) != 1 || header.fourcc != MapLiquidMagic.asUInt)
+    map_liquidHeader const* header = getMappedData<map_liquidHeader>(offset);
+    if (!header || header->fourcc != MapLiquidMagic.asUInt)
         return false;
 
-    _liquidType   = header.liquidType;
-    _liquidOffX  = header.offsetX;
-    _liquidOffY  = header.offsetY;
-    _liquidWidth = header.width;
-    _liquidHeight = header.height;
-    _liquidLevel  = header.liquidLevel;
+    _liquidType   = header->liquidType;
+    _liquidOffX  = header->offsetX;
+    _liquidOffY  = header->offsetY;
+    _liquidWidth = header->width;
+    _liquidHeight = header->height;
+    _liquidLevel  = header->liquidLevel;
+
+    uint32 dataOffset = offset + sizeof(map_liquidHeader);
 
-    if (!(header.flags & MAP_LIQUID_NO_TYPE))
+    if (!(header->flags & MAP_LIQUID_NO_TYPE))
     {
-        _liquidEntry = new uint16[16*16];
-        if (fread(_liquidEntry, sizeof(uint16), 16*16, in) != 16*16)
+        _liquidEntry = getMappedData<uint16>(dataOffset, 16*16);
+        if (!_liquidEntry)
             return false;
+        dataOffset += 16*16*sizeof(uint16);
 
-        _liquidFlags = new uint8[16*16];
-        if (fread(_liquidFlags, sizeof(uint8), 16*16, in) != 16*16)
+        _liquidFlags = getMappedData<uint8>(dataOffset, 16*16);
+        if (!_liquidFlags)
             return false;
+        dataOffset += 16*16*sizeof(uint8);
     }
-    if (!(header.flags & MAP_LIQUID_NO_HEIGHT))
+    if (!(header->flags & MAP_LIQUID_NO_HEIGHT))
     {
-        _liquidMap = new float[uint32(_liquidWidth) * uint32(_liquidHeight)];
-          if (fread(_liquidMap, sizeof(float), _liquidWidth*_liquidHeight, in) != (uint32(_liquidWidth) * uint32(_liquidHeight)))
+        _liquidMap = getMappedData<float>(dataOffset, uint32(_liquidWidth) * uint32(_liquidHeight));
+        if (!_liquidMap)
             return false;
     }
     return true;
@@ -1228,225 +1809,35 @@ uint16 GridMap::getArea(float x, float y) const
     return _areaMap[lx*16 + ly];
 }
 
-float GridMap::getHeightFromFlat(float /*x*/, float /*y*/) const
+float GridMap::getHeight(float x, float y) const
 {
-    return _gridHeight;
-}
-
-float GridMap::getHeightFromFloat(float x, float y) const
-{
-    if (!m_V8 || !m_V9)
+    if (!_heightBlocks)
         return _gridHeight;
 
-    x = MAP_RESOLUTION * (32 - x/SIZE_OF_GRIDS);
-    y = MAP_RESOLUTION * (32 - y/SIZE_OF_GRIDS);
-
-    int x_int = (int)x;
-    int y_int = (int)y;
-    x -= x_int;
-    y -= y_int;
-    x_int&=(MAP_RESOLUTION - 1);
-    y_int&=(MAP_RESOLUTION - 1);
-
-    // Height stored as: h5 - its v8 grid, h1-h4 - its v9 grid
-    // +--------------> X
-    // | h1-------h2     Coordinates is:
-    // | | \  1  / |     h1 0, 0
-    // | |  \   /  |     h2 0, 1
-    // | | 2  h5 3 |     h3 1, 0
-    // | |  /   \  |     h4 1, 1
-    // | | /  4  \ |     h5 1/2, 1/2
-    // | h3-------h4
-    // V Y
-    // For find height need
-    // 1 - detect triangle
-    // 2 - solve linear equation from triangle points
-    // Calculate coefficients for solve h = a*x + b*y + c
-
-    float a, b, c;
-    // Select triangle:
-    if (x+y < 1)
-    {
-        if (x > y)
-        {
-            // 1 triangle (h1, h2, h5 points)
-            float h1 = m_V9[(x_int)*129 + y_int];
-            float h2 = m_V9[(x_int+1)*129 + y_int];
-            float h5 = 2 * m_V8[x_int*128 + y_int];
-            a = h2-h1;
-            b = h5-h1-h2;
-            c = h1;
-        }
-        else
-        {
-            // 2 triangle (h1, h3, h5 points)
-            float h1 = m_V9[x_int*129 + y_int  ];
-            float h3 = m_V9[x_int*129 + y_int+1];
-            float h5 = 2 * m_V8[x_int*128 + y_int];
-            a = h5 - h1 - h3;
-            b = h3 - h1;
-            c = h1;
-        }
-    }
-    else
-    {
-        if (x > y)
-        {
-            // 3 triangle (h2, h4, h5 points)
-            float h2 = m_V9[(x_int+1)*129 + y_int  ];
-            float h4 = m_V9[(x_int+1)*129 + y_int+1];
-            float h5 = 2 * m_V8[x_int*128 + y_int];
-            a = h2 + h4 - h5;
-            b = h4 - h2;
-            c = h5 - h4;
-        }
-        else
-        {
-            // 4 triangle (h3, h4, h5 points)
-            float h3 = m_V9[(x_int)*129 + y_int+1];
-            float h4 = m_V9[(x_int+1)*129 + y_int+1];
-            float h5 = 2 * m_V8[x_int*128 + y_int];
-            a = h4 - h3;
-            b = h3 + h4 - h5;
-            c = h5 - h4;
-        }
-    }
-    // Calculate height
-    return a * x + b * y + c;
+    return MapHeightBlocks::GetHeight(_heightBlocks, MAP_RESOLUTION * (32 - x/SIZE_OF_GRIDS), MAP_RESOLUTION * (32 - y/SIZE_OF_GRIDS));
 }
 
-float GridMap::getHeightFromUint8(float x, float y) const
+void GridMap::getHeights(float const* x, float const* y, float* heights, uint32 count) const
 {
-    if (!m_uint8_V8 || !m_uint8_V9)
-        return _gridHeight;
-
-    x = MAP_RESOLUTION * (32 - x/SIZE_OF_GRIDS);
-    y = MAP_RESOLUTION * (32 - y/SIZE_OF_GRIDS);
-
-    int x_int = (int)x;
-    int y_int = (int)y;
-    x -= x_int;
-    y -= y_int;
-    x_int&=(MAP_RESOLUTION - 1);
-    y_int&=(MAP_RESOLUTION - 1);
-
-    int32 a, b, c;
-    uint8 *V9_h1_ptr = &m_uint8_V9[x_int*128 + x_int + y_int];
-    if (x+y < 1)
-    {
-        if (x > y)
-        {
-            // 1 triangle (h1, h2, h5 points)
-            int32 h1 = V9_h1_ptr[  0];
-            int32 h2 = V9_h1_ptr[129];
-            int32 h5 = 2 * m_uint8_V8[x_int*128 + y_int];
-            a = h2-h1;
-            b = h5-h1-h2;
-            c = h1;
-        }
-        else
-        {
-            // 2 triangle (h1, h3, h5 points)
-            int32 h1 = V9_h1_ptr[0];
-            int32 h3 = V9_h1_ptr[1];
-            int32 h5 = 2 * m_uint8_V8[x_int*128 + y_int];
-            a = h5 - h1 - h3;
-            b = h3 - h1;
-            c = h1;
-        }
-    }
-    else
+    if (!_heightBlocks)
     {
-        if (x > y)
-        {
-            // 3 triangle (h2, h4, h5 points)
-            int32 h2 = V9_h1_ptr[129];
-            int32 h4 = V9_h1_ptr[130];
-            int32 h5 = 2 * m_uint8_V8[x_int*128 + y_int];
-            a = h2 + h4 - h5;
-            b = h4 - h2;
-            c = h5 - h4;
-        }
-        else
-        {
-            // 4 triangle (h3, h4, h5 points)
-            int32 h3 = V9_h1_ptr[  1];
-            int32 h4 = V9_h1_ptr[130];
-            int32 h5 = 2 * m_uint8_V8[x_int*128 + y_int];
-            a = h4 - h3;
-            b = h3 + h4 - h5;
-            c = h5 - h4;
-        }
+        std::fill(heights, heights + count, _gridHeight);
+        return;
     }
-    // Calculate height
-    return (float)((a * x) + (b * y) + c)*_gridIntHeightMultiplier + _gridHeight;
-}
-
-float GridMap::getHeightFromUint16(float x, float y) const
-{
-    if (!m_uint16_V8 || !m_uint16_V9)
-        return _gridHeight;
-
-    x = MAP_RESOLUTION * (32 - x/SIZE_OF_GRIDS);
-    y = MAP_RESOLUTION * (32 - y/SIZE_OF_GRIDS);
-
-    int x_int = (int)x;
-    int y_int = (int)y;
-    x -= x_int;
-    y -= y_int;
-    x_int&=(MAP_RESOLUTION - 1);
-    y_int&=(MAP_RESOLUTION - 1);
 
-    int32 a, b, c;
-    uint16 *V9_h1_ptr = &m_uint16_V9[x_int*128 + x_int + y_int];
-    if (x+y < 1)
+    float squareX[32];
+    float squareY[32];
+    for (uint32 start = 0; start < count; start += 32)
     {
-        if (x > y)
+        uint32 const size = std::min<uint32>(count - start, 32);
+        for (uint32 i = 0; i < size; ++i)
         {
-            // 1 triangle (h1, h2, h5 points)
-            int32 h1 = V9_h1_ptr[  0];
-            int32 h2 = V9_h1_ptr[129];
-            int32 h5 = 2 * m_uint16_V8[x_int*128 + y_int];
-            a = h2-h1;
-            b = h5-h1-h2;
-            c = h1;
-        }
-        else
-        {
-            // 2 triangle (h1, h3, h5 points)
-            int32 h1 = V9_h1_ptr[0];
-            int32 h3 = V9_h1_ptr[1];
-            int32 h5 = 2 * m_uint16_V8[x_int*128 + y_int];
-            a = h5 - h1 - h3;
-            b = h3 - h1;
-            c = h1;
-        }
-    }
-    else
-    {
-        if (x > y)
-        {
-            // 3 triangle (h2, h4, h5 points)
-            int32 h2 = V9_h1_ptr[129];
-            int32 h4 = V9_h1_ptr[130];
-            int32 h5 = 2 * m_uint16_V8[x_int*128 + y_int];
-            a = h2 + h4 - h5;
-            b = h4 - h2;
-            c = h5 - h4;
-        }
-        else
-        {
-            // 4 triangle (h3, h4, h5 points)
-            int32 h3 = V9_h1_ptr[  1];
-            int32 h4 = V9_h1_ptr[130];
-            int32 h5 = 2 * m_uint16_V8[x_int*128 + y_int];
-            a = h4 - h3;
-            b = h3 + h4 - h5;
-            c = h5 - h4;
+            squareX[i] = MAP_RESOLUTION * (32 - x[start + i]/SIZE_OF_GRIDS);
+            squareY[i] = MAP_RESOLUTION * (32 - y[start + i]/SIZE_OF_GRIDS);
         }
+
+        MapHeightBlocks::GetHeights(_heightBlocks, squareX, squareY, heights + start, size);
     }
-    // Calculate height
-    return (float)((a * x) + (b * y) + c)*_gridIntHeightMultiplier + _gridHeight;
 }
 
 float GridMap::getLiquidLevel(float x, float y) const
@@ -1611,6 +2002,30 @@ float Map::GetWaterOrGroundLevel(float x, float y, float z, float* ground /*= NU
     return VMAP_INVALID_HEIGHT_VALUE;
 }
 
+// mapHeight set for any above raw ground Z or <= INVALID_HEIGHT
+// vmapheight set for any under Z value or <= INVALID_HEIGHT
+static float SelectSurfaceHeight(float z, float mapHeight, float vmapHeight)
+{
+    if (vmapHeight > INVALID_HEIGHT)
+    {
+        if (mapHeight > INVALID_HEIGHT)
+        {
+            // we have mapheight and vmapheight and must select more appropriate
+
+            // we are already under the surface or vmap height above map heigt
+            // or if the distance of the vmap height is less the land height distance
+            if (z < mapHeight || vmapHeight > mapHeight || fabs(mapHeight-z) > fabs(vmapHeight-z))
+                return vmapHeight;
+            else
+                return mapHeight;                           // better use .map surface height
+        }
+        else
+            return vmapHeight;                              // we have only vmapHeight (if have)
+    }
+
+    return mapHeight;                               // explicitly use map data
+}
+
 float Map::GetHeight(float x, float y, float z, bool checkVMap /*= true*/, float maxSearchDist /*= DEFAULT_HEIGHT_SEARCH*/) const
 {
     // find raw .map surface under Z coordinates
@@ -1631,26 +2046,7 @@ float Map::GetHeight(float x, float y, float z, bool checkVMap /*= true*/, float
             vmapHeight = vmgr->getHeight(GetId(), x, y, z + 2.0f, maxSearchDist);   // look from a bit higher pos to find the floor
     }
 
-    // mapHeight set for any above raw ground Z or <= INVALID_HEIGHT
-    // vmapheight set for any under Z value or <= INVALID_HEIGHT
-    if (vmapHeight > INVALID_HEIGHT)
-    {
-        if (mapHeight > INVALID_HEIGHT)
-        {
-            // we have mapheight and vmapheight and must select more appropriate
-
-            // we are already under the surface or vmap height above map heigt
-            // or if the distance of the vmap height is less the land height distance
-            if (z < mapHeight || vmapHeight > mapHeight || fabs(mapHeight-z) > fabs(vmapHeight-z))
-                return vmapHeight;
-            else
-                return mapHeight;                           // better use .map surface height
-        }
-        else
-            return vmapHeight;                              // we have only vmapHeight (if have)
-    }
-
-    return mapHeight;                               // explicitly use map data
+    return SelectSurfaceHeight(z, mapHeight, vmapHeight);
 }
 
 inline bool IsOutdoorWMO(uint32 mogpFlags, int32 /*adtId*/, int32 /*rootId*/, int32 /*groupId*/, WMOAreaTableEntry const* wmoEntry, AreaTableEntry const* atEntry)
@@ -1700,32 +2096,37 @@ bool Map::GetAreaInfo(float x, float y, float z, uint32 &flags, int32 &adtId, in
 {
     float vmap_z = z;
     VMAP::IVMapManager* vmgr = VMAP::VMapFactory::createOrGetVMapManager();
-    if (vmgr->getAreaInfo(GetId(), x, y, vmap_z, flags, adtId, rootId, groupId))
+    return vmgr->getAreaInfo(GetId(), x, y, vmap_z, flags, adtId, rootId, groupId) && !IsTerrainAbove(x, y, z, vmap_z);
+}
+
+bool Map::IsTerrainAbove(float x, float y, float z, float floorZ) const
+{
+    // check if there's terrain between player height and object height
+    if (GridMap* gmap = const_cast<Map*>(this)->GetGrid(x, y))
     {
-        // check if there's terrain between player height and object height
-        if (GridMap* gmap = const_cast<Map*>(this)->GetGrid(x, y))
-        {
-            float _mapheight = gmap->getHeight(x, y);
-            // z + 2.0f condition taken from GetHeight(), not sure if it's such a great choice...
-            if (z + 2.0f > _mapheight &&  _mapheight > vmap_z)
-                return false;
-        }
-        return true;
+        float _mapheight = gmap->getHeight(x, y);
+        // z + 2.0f condition taken from GetHeight(), not sure if it's such a great choice...
+        if (z + 2.0f > _mapheight &&  _mapheight > floorZ)
+            return true;
     }
     return false;
 }
 
 uint16 Map::GetAreaFlag(float x, float y, float z, bool *isOutdoors) const
 {
-    uint32 mogpFlags;
-    int32 adtId, rootId, groupId;
+    uint32 mogpFlags = 0;
+    int32 adtId = 0, rootId = 0, groupId = 0;
+    bool haveAreaInfo = GetAreaInfo(x, y, z, mogpFlags, adtId, rootId, groupId);
+    return GetAreaFlagFromAreaInfo(x, y, haveAreaInfo, mogpFlags, adtId, rootId, groupId, isOutdoors);
+}
+
+uint16 Map::GetAreaFlagFromAreaInfo(float x, float y, bool haveAreaInfo, uint32 mogpFlags, int32 adtId, int32 rootId, int32 groupId, bool* isOutdoors) const
+{
     WMOAreaTableEntry const* wmoEntry = 0;
     AreaTableEntry const* atEntry = 0;
-    bool haveAreaInfo = false;
 
-    if (GetAreaInfo(x, y, z, mogpFlags, adtId, rootId, groupId))
+    if (haveAreaInfo)
     {
-        haveAreaInfo = true;
         wmoEntry = GetWMOAreaTableEntryByTripple(rootId, adtId, groupId);
         if (wmoEntry)
             atEntry = GetAreaEntryByAreaID(wmoEntry->areaId);
@@ -1752,7 +2153,24 @@ uint16 Map::GetAreaFlag(float x, float y, float z, bool *isOutdoors) const
             *isOutdoors = true;
     }
     return areaflag;
- }
+}
+
+void Map::GetPositionAreaInfo(float x, float y, float z, PositionAreaInfo& info) const
+{
+    VMAP::AreaAndLiquidData vmapData;
+    VMAP::VMapFactory::createOrGetVMapManager()->getAreaAndLiquidData(GetId(), x, y, z, MAP_ALL_LIQUIDS, vmapData);
+
+    bool const haveAreaInfo = vmapData.hasAreaInfo && !IsTerrainAbove(x, y, z, vmapData.areaFloorZ);
+    info.areaFlag = GetAreaFlagFromAreaInfo(x, y, haveAreaInfo, vmapData.mogpFlags, vmapData.adtId, vmapData.rootId, vmapData.groupId, &info.outdoors);
+    GetZoneAndAreaIdByAreaFlag(info.zoneId, info.areaId, info.areaFlag, GetId());
+
+    info.liquid = LiquidData();
+    if (const_cast<Map*>(this)->GetGrid(x, y))
+        info.liquidStatus = GetLiquidStatusFromVMapLiquid(x, y, z, MAP_ALL_LIQUIDS, &info.liquid, vmapData.hasLiquid,
+            vmapData.liquidLevel, vmapData.liquidFloorZ, vmapData.liquidType, &info.areaFlag);
+    else
+        info.liquidStatus = LIQUID_MAP_NO_WATER;
+}
 
 uint8 Map::GetTerrainType(float x, float y) const
 {
@@ -1764,12 +2182,19 @@ uint8 Map::GetTerrainType(float x, float y) const
 
 ZLiquidStatus Map::getLiquidStatus(float x, float y, float z, uint8 ReqLiquidType, LiquidData* data) const
 {
-    ZLiquidStatus result = LIQUID_MAP_NO_WATER;
     VMAP::IVMapManager* vmgr = VMAP::VMapFactory::createOrGetVMapManager();
     float liquid_level = INVALID_HEIGHT;
     float ground_level = INVALID_HEIGHT;
     uint32 liquid_type = 0;
-    if (vmgr->GetLiquidLevel(GetId(), x, y, z, ReqLiquidType, liquid_level, ground_level, liquid_type))
+    bool const vmapLiquid = vmgr->GetLiquidLevel(GetId(), x, y, z, ReqLiquidType, liquid_level, ground_level, liquid_type);
+    return GetLiquidStatusFromVMapLiquid(x, y, z, ReqLiquidType, data, vmapLiquid, liquid_level, ground_level, liquid_type, NULL);
+}
+
+ZLiquidStatus Map::GetLiquidStatusFromVMapLiquid(float x, float y, float z, uint8 ReqLiquidType, LiquidData* data, bool vmapLiquid,
+    float liquid_level, float ground_level, uint32 liquid_type, uint16 const* areaFlag) const
+{
+    ZLiquidStatus result = LIQUID_MAP_NO_WATER;
+    if (vmapLiquid)
     {
         TC_LOG_DEBUG("maps", "getLiquidStatus(): vmap liquid level: %f ground: %f type: %u", liquid_level, ground_level, liquid_type);
         // Check water level and ground level
@@ -1788,7 +2213,7 @@ ZLiquidStatus Map::getLiquidStatus(float x, float y, float z, uint8 ReqLiquidTyp
 
                 if (liquid_type && liquid_type < 21)
                 {
-                    if (AreaTableEntry const* area = GetAreaEntryByAreaFlagAndMap(GetAreaFlag(x, y, z), GetId()))
+                    if (AreaTableEntry const* area = GetAreaEntryByAreaFlagAndMap(areaFlag ? *areaFlag : GetAreaFlag(x, y, z), GetId()))
                     {
                         uint32 overrideLiquid = area->LiquidTypeOverride[liquidFlagType];
                         if (!overrideLiquid && area->zone)
@@ -1885,8 +2310,27 @@ void Map::GetZoneAndAreaIdByAreaFlag(uint32& zoneid, uint32& areaid, uint16 area
 
 bool Map::isInLineOfSight(float x1, float y1, float z1, float x2, float y2, float z2, uint32 phasemask) const
 {
-    return VMAP::VMapFactory::createOrGetVMapManager()->isInLineOfSight(GetId(), x1, y1, z1, x2, y2, z2)
+    bool result;
+    if (_queryCache.IsEnabled())
+    {
+        _queryCache.SyncDynamicGeneration(_dynamicTree.getGeneration());
+        if (_queryCache.FindLineOfSight(x1, y1, z1, x2, y2, z2, phasemask, result))
+            return result;
+    }
+
+    result = VMAP::VMapFactory::createOrGetVMapManager()->isInLineOfSight(GetId(), x1, y1, z1, x2, y2, z2)
         && _dynamicTree.isInLineOfSight(x1, y1, z1, x2, y2, z2, phasemask);
+
+    if (_queryCache.IsEnabled())
+        _queryCache.StoreLineOfSight(x1, y1, z1, x2, y2, z2, phasemask, result);
+    return result;
+}
+
+void Map::isInLineOfSight(VMAP::LineOfSightQuery* queries, uint32 count) const
+{
+    VMAP::VMapFactory::createOrGetVMapManager()->isInLineOfSight(GetId(), queries, count);
+    // the dynamic tree only checks the queries the static models did not block already
+    _dynamicTree.isInLineOfSight(queries, count);
 }
 
 bool Map::getObjectHitPos(uint32 phasemask, float x1, float y1, float z1, float x2, float y2, float z2, float& rx, float& ry, float& rz, float modifyDist)
@@ -1905,7 +2349,79 @@ bool Map::getObjectHitPos(uint32 phasemask, float x1, float y1, float z1, float
 
 float Map::GetHeight(uint32 phasemask, float x, float y, float z, bool vmap/*=true*/, float maxSearchDist/*=DEFAULT_HEIGHT_SEARCH*/) const
 {
-    return std::max<float>(GetHeight(x, y, z + 0.5f, vmap, maxSearchDist), _dynamicTree.getHeight(x, y, z + 0.5f, maxSearchDist, phasemask));
+    // only the common full query is cached
+    bool const cached = vmap && maxSearchDist == DEFAULT_HEIGHT_SEARCH && _queryCache.IsEnabled();
+    float height;
+    if (cached)
+    {
+        _queryCache.SyncDynamicGeneration(_dynamicTree.getGeneration());
+        if (_queryCache.FindHeight(x, y, z, phasemask, height))
+            return height;
+    }
+
+    height = std::max<float>(GetHeight(x, y, z + 0.5f, vmap, maxSearchDist), _dynamicTree.getHeight(x, y, z + 0.5f, maxSearchDist, phasemask));
+
+    if (cached)
+        _queryCache.StoreHeight(x, y, z, phasemask, height);
+    return height;
+}
+
+void Map::GetHeight(VMAP::HeightQuery* queries, uint32 count, bool vmap/*=true*/, float maxSearchDist/*=DEFAULT_HEIGHT_SEARCH*/) const
+{
+    // same as the single point version, with the vmap heights fetched in chunks of one batch each
+    VMAP::IVMapManager* vmgr = VMAP::VMapFactory::createOrGetVMapManager();
+    bool const checkVMap = vmap && vmgr->isHeightCalcEnabled();
+
+    VMAP::HeightQuery vmapQueries[32];
+    GridMap* gridMaps[32];
+    float queryX[32];
+    float queryY[32];
+    float gridHeights[32];
+    for (uint32 start = 0; start < count; start += 32)
+    {
+        uint32 const size = std::min<uint32>(count - start, 32);
+        for (uint32 i = 0; i < size; ++i)
+        {
+            queryX[i] = queries[start + i].x;
+            queryY[i] = queries[start + i].y;
+            gridMaps[i] = const_cast<Map*>(this)->GetGrid(queryX[i], queryY[i]);
+        }
+
+        // terrain heights of consecutive queries on the same grid are sampled together
+        for (uint32 first = 0; first < size;)
+        {
+            uint32 last = first + 1;
+            while (last < size && gridMaps[last] == gridMaps[first])
+                ++last;
+
+            if (gridMaps[first])
+                gridMaps[first]->getHeights(queryX + first, queryY + first, gridHeights + first, last - first);
+            first = last;
+        }
+
+        if (checkVMap)
+        {
+            for (uint32 i = 0; i < size; ++i)
+            {
+                vmapQueries[i] = queries[start + i];
+                vmapQueries[i].z += 0.5f + 2.0f;    // look from a bit higher pos to find the floor
+            }
+            vmgr->getHeight(GetId(), vmapQueries, size, maxSearchDist);
+        }
+
+        for (uint32 i = 0; i < size; ++i)
+        {
+            VMAP::HeightQuery& query = queries[start + i];
+            float const z = query.z + 0.5f;
+
+            float mapHeight = VMAP_INVALID_HEIGHT_VALUE;
+            if (gridMaps[i] && z + 2.0f > gridHeights[i])
+                mapHeight = gridHeights[i];
+
+            float const vmapHeight = checkVMap ? vmapQueries[i].height : VMAP_INVALID_HEIGHT_VALUE;
+            query.height = std::max<float>(SelectSurfaceHeight(z, mapHeight, vmapHeight), _dynamicTree.getHeight(query.x, query.y, z, maxSearchDist, query.phasemask));
+        }
+    }
 }
 
 bool Map::IsInWater(float x, float y, float pZ, LiquidData* data) const
@@ -2060,7 +2576,77 @@ void Map::DelayedUpdate(const uint32 diff)
             auto const state = i->second.GetGridState();
             si_GridStates[state](*this, i++, diff);
         }
+
+        if (_gridMemoryBudget)
+            UnloadGridsOverBudget(diff);
+    }
+}
+
+float Map::GetGridExpiryFactor(NGrid const &grid) const
+{
+    auto const itr = _gridHistory.find(grid.getX() * MAX_NUMBER_OF_GRIDS + grid.getY());
+    return itr != _gridHistory.end() ? float(1 + itr->second.reloads) : 1.0f;
+}
+
+// Only the objects are counted, the terrain of the grid is memory mapped
+std::size_t Map::EstimateGridMemory(NGrid const &grid)
+{
+    return sizeof(NGrid)
+        + grid.GetGridObjectCountInNGrid<Creature>() * sizeof(Creature)
+        + grid.GetGridObjectCountInNGrid<GameObject>() * sizeof(GameObject);
+}
+
+std::size_t Map::GetGridMemoryUsage() const
+{
+    std::size_t usage = 0;
+    for (auto const &grid : i_loadedGrids)
+        usage += EstimateGridMemory(grid.second);
+    return usage;
+}
+
+void Map::UnloadGridsOverBudget(uint32 diff)
+{
+    _gridBudgetTimer.Update(diff);
+    if (!_gridBudgetTimer.Passed())
+        return;
+
+    _gridBudgetTimer.Reset();
+
+    std::size_t usage = GetGridMemoryUsage();
+    if (usage <= _gridMemoryBudget)
+        return;
+
+    // expired grids only, players coming back within the expiry find them loaded
+    std::vector<GridContainerType::iterator> expired;
+    for (auto itr = i_loadedGrids.begin(); itr != i_loadedGrids.end(); ++itr)
+    {
+        NGrid const &grid = itr->second;
+        if (grid.GetGridState() == GRID_STATE_REMOVAL && !grid.getUnloadLock() && grid.getTimeTracker().Passed())
+            expired.push_back(itr);
+    }
+
+    std::sort(expired.begin(), expired.end(), [](GridContainerType::iterator const &a, GridContainerType::iterator const &b)
+    {
+        return a->second.GetLastActiveTime() < b->second.GetLastActiveTime();
+    });
+
+    // unloading a grid leaves the iterators to the other grids valid
+    for (auto &itr : expired)
+    {
+        if (usage <= _gridMemoryBudget)
+            break;
+
+        std::size_t const gridMemory = EstimateGridMemory(itr->second);
+        if (!UnloadGrid(itr, false))
+            continue;
+
+        usage -= std::min(usage, gridMemory);
+        ++_gridChurnStats.evictions;
     }
+
+    if (usage > _gridMemoryBudget)
+        TC_LOG_DEBUG("maps", "Map %u instance %u is still %u KB over its grid memory budget after unloading expired grids",
+                     GetId(), i_InstanceId, uint32((usage - _gridMemoryBudget) / 1024));
 }
 
 void Map::AddObjectToRemoveList(WorldObject* obj)
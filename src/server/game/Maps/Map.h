@@ -30,8 +30,13 @@
 #include "GameObjectModel.h"
 #include "NGrid.h"
 #include "ScriptInfo.hpp"
+#include "PathCache.h"
+#include "MapHeightBlocks.h"
+#include "PositionAreaInfo.h"
+#include "MapObjectRegistry.h"
+#include "MapQueryCache.h"
+#include "TerrainPrefetcher.h"
 
-#include <bitset>
 #include <list>
 #include <map>
 #include <mutex>
@@ -52,6 +57,14 @@ struct Position;
 class Battleground;
 class MapInstanced;
 class InstanceMap;
+class ACE_Mem_Map;
+
+namespace VMAP
+{
+    struct LineOfSightQuery;
+    struct HeightQuery;
+    struct AreaAndLiquidData;
+}
 
 struct ScriptAction final
 {
@@ -89,6 +102,7 @@ struct map_areaHeader
 #define MAP_HEIGHT_NO_HEIGHT  0x0001
 #define MAP_HEIGHT_AS_INT16   0x0002
 #define MAP_HEIGHT_AS_INT8    0x0004
+// MAP_HEIGHT_AS_BLOCKS is defined with the block layout in MapHeightBlocks.h
 
 struct map_heightHeader
 {
@@ -113,59 +127,23 @@ struct map_liquidHeader
     float  liquidLevel;
 };
 
-enum ZLiquidStatus
-{
-    LIQUID_MAP_NO_WATER     = 0x00000000,
-    LIQUID_MAP_ABOVE_WATER  = 0x00000001,
-    LIQUID_MAP_WATER_WALK   = 0x00000002,
-    LIQUID_MAP_IN_WATER     = 0x00000004,
-    LIQUID_MAP_UNDER_WATER  = 0x00000008
-};
-
-#define MAP_LIQUID_TYPE_NO_WATER    0x00
-#define MAP_LIQUID_TYPE_WATER       0x01
-#define MAP_LIQUID_TYPE_OCEAN       0x02
-#define MAP_LIQUID_TYPE_MAGMA       0x04
-#define MAP_LIQUID_TYPE_SLIME       0x08
-
-#define MAP_ALL_LIQUIDS   (MAP_LIQUID_TYPE_WATER | MAP_LIQUID_TYPE_OCEAN | MAP_LIQUID_TYPE_MAGMA | MAP_LIQUID_TYPE_SLIME)
-
-#define MAP_LIQUID_TYPE_DARK_WATER  0x10
-#define MAP_LIQUID_TYPE_WMO_WATER   0x20
-
-struct LiquidData
-{
-    uint32 type_flags;
-    uint32 entry;
-    float  level;
-    float  depth_level;
-};
-
 class GridMap
 {
     uint32  _flags;
-    union{
-        float* m_V9;
-        uint16* m_uint16_V9;
-        uint8* m_uint8_V9;
-    };
-    union{
-        float* m_V8;
-        uint16* m_uint16_V8;
-        uint8* m_uint8_V8;
-    };
-    // Height level data
+    // Height level data, NULL for flat grids. Files still using one of the
+    // whole grid layouts are converted to blocks while loading.
+    map_heightBlock const* _heightBlocks;
+    map_heightBlock* _convertedHeightBlocks;
     float _gridHeight;
-    float _gridIntHeightMultiplier;
 
     // Area data
-    uint16* _areaMap;
+    uint16 const* _areaMap;
 
     // Liquid data
     float _liquidLevel;
-    uint16* _liquidEntry;
-    uint8* _liquidFlags;
-    float* _liquidMap;
+    uint16 const* _liquidEntry;
+    uint8 const* _liquidFlags;
+    float const* _liquidMap;
     uint16 _gridArea;
     uint16 _liquidType;
     uint8 _liquidOffX;
@@ -173,18 +151,17 @@ class GridMap
     uint8 _liquidWidth;
     uint8 _liquidHeight;
 
+    // The map file is mapped read-only, all the arrays above point into it,
+    // so the pages are shared with every other process using the same file
+    ACE_Mem_Map* _mappedFile;
 
-    bool loadAreaData(FILE* in, uint32 offset, uint32 size);
-    bool loadHeihgtData(FILE* in, uint32 offset, uint32 size);
-    bool loadLiquidData(FILE* in, uint32 offset, uint32 size);
+    template <class T>
+    T const* getMappedData(uint32 offset, uint32 count = 1) const;
 
-    // Get height functions and pointers
-    typedef float (GridMap::*GetHeightPtr) (float x, float y) const;
-    GetHeightPtr _gridGetHeight;
-    float getHeightFromFloat(float x, float y) const;
-    float getHeightFromUint16(float x, float y) const;
-    float getHeightFromUint8(float x, float y) const;
-    float getHeightFromFlat(float x, float y) const;
+    bool loadAreaData(uint32 offset, uint32 size);
+    bool loadHeihgtData(uint32 offset, uint32 size);
+    bool convertHeightData(map_heightHeader const* header, uint32 dataOffset);
+    bool loadLiquidData(uint32 offset, uint32 size);
 
 public:
     GridMap();
@@ -192,8 +169,13 @@ public:
     bool loadData(char* filaname);
     void unloadData();
 
+    //! Faults in every page of the tile, so that later lookups do not touch the disk
+    void touchData() const;
+
     uint16 getArea(float x, float y) const;
-    inline float getHeight(float x, float y) const {return (this->*_gridGetHeight)(x, y);}
+    float getHeight(float x, float y) const;
+    //! Heights of count points at once, same results as getHeight
+    void getHeights(float const* x, float const* y, float* heights, uint32 count) const;
     float getLiquidLevel(float x, float y) const;
     uint8 getTerrainType(float x, float y) const;
     ZLiquidStatus getLiquidStatus(float x, float y, float z, uint8 ReqLiquidType, LiquidData* data = 0);
@@ -236,21 +218,43 @@ class Map
 {
     friend class MapReference;
 
+    // Creatures that would not change if updated less often are only updated
+    // every idleUpdateInterval, with the time passed since, the others on every
+    // map update. Whether a creature is idle is checked again each time, so it
+    // is back at full rate from the update after it enters combat or starts to
+    // move, catching up on the skipped time.
     class ObjectUpdater final
     {
     public:
+        ObjectUpdater() : i_idleUpdateInterval(0), i_nearPlayers(true) {}
+
         void Visit(PlayerMapType &) {}
         void Visit(CorpseMapType &) {}
+        void Visit(CreatureMapType &m)
+        {
+            std::vector<Creature*>& creatures = i_nearPlayers ? i_creaturesNearPlayers : i_creaturesAway;
+            creatures.insert(creatures.end(), m.begin(), m.end());
+        }
         template <typename OtherMapType>
         void Visit(OtherMapType &m)
         {
             i_objectsToUpdate.insert(i_objectsToUpdate.end(), m.begin(), m.end());
         }
 
+        void SetIdleUpdateInterval(uint32 interval) { i_idleUpdateInterval = interval; }
+        // for the creatures of the cells visited next
+        void SetNearPlayers(bool nearPlayers) { i_nearPlayers = nearPlayers; }
+
         void updateCollected(uint32 diff);
 
     private:
+        void updateCreature(Creature* creature, uint32 diff, bool nearPlayers);
+
+        uint32 i_idleUpdateInterval;
+        bool i_nearPlayers;
         std::vector<WorldObject*> i_objectsToUpdate;
+        std::vector<Creature*> i_creaturesNearPlayers;
+        std::vector<Creature*> i_creaturesAway;
     };
 
     public:
@@ -317,6 +321,24 @@ class Map
         }
 
         time_t GetGridExpiry(void) const { return i_gridExpiry; }
+
+        // grids unloaded and loaded again soon after wait longer for the next unload
+        float GetGridExpiryFactor(NGrid const &grid) const;
+
+        // Loads and unloads of the object data of grids
+        struct GridChurnStats
+        {
+            GridChurnStats() : loads(0), reloads(0), unloads(0), evictions(0) { }
+
+            uint32 loads;
+            uint32 reloads;                                 // loads of grids unloaded shortly before
+            uint32 unloads;
+            uint32 evictions;                               // unloads to get back within the memory budget
+        };
+
+        GridChurnStats const& GetGridChurnStats() const { return _gridChurnStats; }
+        std::size_t GetGridMemoryBudget() const { return _gridMemoryBudget; }
+        std::size_t GetGridMemoryUsage() const;
         uint32 GetId(void) const { return i_mapEntry->MapID; }
 
         static bool ExistMap(uint32 mapid, int gx, int gy);
@@ -324,6 +346,8 @@ class Map
 
         Map const* GetParent() const { return m_parentMap; }
 
+        PathCache& GetPathCache() { return _pathCache; }
+
         // some calls like isInWater should not use vmaps due to processor power
         // can return INVALID_HEIGHT if under z+2 z coord not found height
         float GetHeight(float x, float y, float z, bool checkVMap = true, float maxSearchDist = DEFAULT_HEIGHT_SEARCH) const;
@@ -335,6 +359,10 @@ class Map
 
         bool IsOutdoors(float x, float y, float z) const;
 
+        //! GetAreaFlag(), GetZoneAndAreaId(), IsOutdoors() and getLiquidStatus() for all liquids
+        //! at once, the vmaps are searched a single time for all of them
+        void GetPositionAreaInfo(float x, float y, float z, PositionAreaInfo& info) const;
+
         uint8 GetTerrainType(float x, float y) const;
         float GetWaterLevel(float x, float y) const;
         bool IsInWater(float x, float y, float z, LiquidData* data = 0) const;
@@ -359,6 +387,7 @@ class Map
             GetZoneAndAreaIdByAreaFlag(zoneid, areaid, GetAreaFlag(x, y, z), GetId());
         }
 
+        void MoveAllPlayersInMoveList();
         void MoveAllCreaturesInMoveList();
         void RemoveAllObjectsInRemoveList();
         virtual void RemoveAllPlayers();
@@ -402,11 +431,11 @@ class Map
         virtual void DelayedUpdate(const uint32 diff);
 
         void UpdateObjectVisibility(WorldObject* obj, Cell cell, CellCoord cellpair);
-        void UpdateObjectsVisibilityFor(Player* player, Cell cell, CellCoord cellpair);
 
-        void resetMarkedCells() { marked_cells.reset(); }
-        bool isCellMarked(uint32 pCellId) const { return marked_cells.test(pCellId); }
-        void markCell(uint32 pCellId) { marked_cells.set(pCellId); }
+        // visibility of units that moved is evaluated once per update, see ProcessVisibilityChanges()
+        void ScheduleVisibilityChange(Unit* unit, bool loadGrids);
+        void CancelVisibilityChange(Unit* unit);
+        void UpdateObjectsVisibilityFor(Player* player, Cell cell, CellCoord cellpair);
 
         bool HavePlayers() const { return !m_mapRefManager.isEmpty(); }
         uint32 GetPlayersCountExceptGMs() const;
@@ -487,10 +516,18 @@ class Map
         float GetWaterOrGroundLevel(float x, float y, float z, float* ground = NULL, bool swim = false) const;
         float GetHeight(uint32 phasemask, float x, float y, float z, bool vmap = true, float maxSearchDist = DEFAULT_HEIGHT_SEARCH) const;
         bool isInLineOfSight(float x1, float y1, float z1, float x2, float y2, float z2, uint32 phasemask) const;
+        // batched versions of the above, same results but the vmap rays of all queries share the tree traversals
+        void isInLineOfSight(VMAP::LineOfSightQuery* queries, uint32 count) const;
+        void GetHeight(VMAP::HeightQuery* queries, uint32 count, bool vmap = true, float maxSearchDist = DEFAULT_HEIGHT_SEARCH) const;
         void Balance() { _dynamicTree.balance(); }
         void RemoveGameObjectModel(const GameObjectModel& model) { _dynamicTree.remove(model); }
         void InsertGameObjectModel(const GameObjectModel& model) { _dynamicTree.insert(model); }
         bool ContainsGameObjectModel(const GameObjectModel& model) const { return _dynamicTree.contains(model);}
+        void RefreshGameObjectModel(const GameObjectModel& model) { _dynamicTree.refresh(model); }
+        MapQueryCache const& GetQueryCache() const { return _queryCache; }
+
+        MapObjectRegistry& GetObjectRegistry() { return _objectRegistry; }
+        MapObjectRegistry const& GetObjectRegistry() const { return _objectRegistry; }
         bool getObjectHitPos(uint32 phasemask, float x1, float y1, float z1, float x2, float y2, float z2, float& rx, float &ry, float& rz, float modifyDist);
 
         virtual uint32 GetOwnerGuildId(uint32 /*team*/ = TEAM_OTHER) const { return 0; }
@@ -526,11 +563,22 @@ class Map
         static void DeleteRespawnTimesInDB(uint16 mapId, uint32 instanceId);
 
     private:
+        void PrefetchGridsAhead(Player const* player);
+        PrefetchedGridPtr TakePrefetchedGrid(int gx, int gy);
+        void DropStalePrefetchedGrids();
+
         void LoadMapAndVMap(int gx, int gy);
         void LoadVMap(int gx, int gy);
+        void LoadMMap(int gx, int gy);
         void LoadMap(int gx, int gy, bool reload = false);
         GridMap* GetGrid(float x, float y);
 
+        // the parts of the area and liquid lookups that follow the vmap search
+        bool IsTerrainAbove(float x, float y, float z, float floorZ) const;
+        uint16 GetAreaFlagFromAreaInfo(float x, float y, bool haveAreaInfo, uint32 mogpFlags, int32 adtId, int32 rootId, int32 groupId, bool* isOutdoors) const;
+        ZLiquidStatus GetLiquidStatusFromVMapLiquid(float x, float y, float z, uint8 ReqLiquidType, LiquidData* data, bool vmapLiquid,
+            float liquid_level, float ground_level, uint32 liquid_type, uint16 const* areaFlag) const;
+
         void SetTimer(uint32 t) { i_gridExpiry = t < MIN_GRID_DELAY ? MIN_GRID_DELAY : t; }
 
         void SendInitSelf(Player* player);
@@ -541,12 +589,27 @@ class Map
         bool CreatureCellRelocation(Creature* creature, Cell new_cell);
 
         template<class T> void InitializeObject(T* obj);
+        void AddPlayerToMoveList(Player* player);
+        void RemovePlayerFromMoveList(Player* player);
+        std::vector<Player*> _playersToMove;
+        std::vector<std::pair<uint32, Player*> > _playerMoveBatch;   // cell id -> player, while MoveAllPlayersInMoveList runs
+
         void AddCreatureToMoveList(Creature* c, float x, float y, float z, float ang);
         void RemoveCreatureFromMoveList(Creature* c);
 
         bool _creatureToMoveLock;
         std::vector<Creature*> _creaturesToMove;
 
+        struct VisibilityChange
+        {
+            Unit* unit;                                     // NULL once removed from world
+            bool loadGrids;
+        };
+
+        void ProcessVisibilityChanges();
+
+        std::vector<VisibilityChange> _visibilityChanges;
+
         bool IsGridLoaded(const GridCoord &) const;
         void EnsureGridCreated(const GridCoord &);
         void EnsureGridCreated_i(const GridCoord &);
@@ -606,7 +669,67 @@ class Map
         NGrid *i_grids[MAX_NUMBER_OF_GRIDS][MAX_NUMBER_OF_GRIDS];
         GridMap *i_gridMaps[MAX_NUMBER_OF_GRIDS][MAX_NUMBER_OF_GRIDS];
 
-        std::bitset<TOTAL_NUMBER_OF_CELLS_PER_MAP*TOTAL_NUMBER_OF_CELLS_PER_MAP> marked_cells;
+        // Grid churn: when a grid is loaded again within GRID_CHURN_WINDOW
+        // expiries of its unload its next unload waits one more expiry. With a
+        // memory budget expired grids stay loaded until the budget is
+        // exceeded and are then unloaded least recently used first.
+        struct GridHistory
+        {
+            time_t unloadTime;
+            uint32 reloads;
+        };
+
+        static std::size_t EstimateGridMemory(NGrid const &grid);
+        void UnloadGridsOverBudget(uint32 diff);
+
+        std::unordered_map<uint32, GridHistory> _gridHistory;
+        GridChurnStats _gridChurnStats;
+        std::size_t _gridMemoryBudget;
+        IntervalTimer _gridBudgetTimer;
+
+        // Grids requested from the terrain prefetcher, instances may create
+        // grids of the parent map from their own thread
+        std::mutex _prefetchLock;
+        std::unordered_map<uint32, PrefetchedGridPtr> _prefetchedGrids;
+
+        // Cells around players and active objects, counted per observer so they
+        // change only when an observer moves into another cell or goes away.
+        // The cells within _idleUpdateNearDistance of players, always part of
+        // their active cells, are counted apart for the idle creature updates.
+        struct ObserverCells
+        {
+            float x, y, range;
+            CellArea area;
+            CellArea nearArea;
+            bool hasNearArea;
+        };
+
+        struct ActiveCellRef
+        {
+            uint32 observers;
+            uint32 nearPlayers;
+            uint32 index;                                   // in _activeCells
+        };
+
+        void UpdateObserverCells(WorldObject const* obj);
+        void RemoveObserverCells(WorldObject const* obj);
+        void ChangeActiveCells(CellArea const& area, bool add);
+        void ChangeNearPlayerCells(CellArea const& area, bool add);
+
+        float _idleUpdateNearDistance;
+
+        std::unordered_map<WorldObject const*, ObserverCells> _observerCells;
+        std::unordered_map<uint32, ActiveCellRef> _activeCellRefs;
+        std::vector<uint32> _activeCells;
+
+        // Poly corridors recently found by the PathGenerators of this map
+        PathCache _pathCache;
+
+        // Height and line of sight results, filled from the const queries
+        mutable MapQueryCache _queryCache;
+
+        // Objects in world on this map by guid, for the same map lookups of ObjectAccessor
+        MapObjectRegistry _objectRegistry;
 
         bool i_scriptLock;
         std::set<WorldObject*> i_objectsToRemove;
@@ -629,6 +752,7 @@ class Map
         void RemoveFromActiveHelper(T* obj)
         {
             m_activeNonPlayers.erase(obj);
+            RemoveObserverCells(obj);
         }
 
         std::unordered_map<uint32 /*dbGUID*/, time_t> _creatureRespawnTimes;
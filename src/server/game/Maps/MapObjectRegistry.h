@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MAP_OBJECT_REGISTRY_H
+#define _MAP_OBJECT_REGISTRY_H
+
+#include "Define.h"
+
+#include <vector>
+
+class Player;
+class Creature;
+class Pet;
+class GameObject;
+class DynamicObject;
+class AreaTrigger;
+
+enum MapObjectRegistryKind
+{
+    MAP_OBJECT_PLAYER = 1,
+    MAP_OBJECT_CREATURE,
+    MAP_OBJECT_PET,
+    MAP_OBJECT_GAMEOBJECT,
+    MAP_OBJECT_DYNAMICOBJECT,
+    MAP_OBJECT_AREATRIGGER
+};
+
+template <class T> struct MapObjectRegistryKindOf;
+template <> struct MapObjectRegistryKindOf<Player>        { static uint32 const value = MAP_OBJECT_PLAYER; };
+template <> struct MapObjectRegistryKindOf<Creature>      { static uint32 const value = MAP_OBJECT_CREATURE; };
+template <> struct MapObjectRegistryKindOf<Pet>           { static uint32 const value = MAP_OBJECT_PET; };
+template <> struct MapObjectRegistryKindOf<GameObject>    { static uint32 const value = MAP_OBJECT_GAMEOBJECT; };
+template <> struct MapObjectRegistryKindOf<DynamicObject> { static uint32 const value = MAP_OBJECT_DYNAMICOBJECT; };
+template <> struct MapObjectRegistryKindOf<AreaTrigger>   { static uint32 const value = MAP_OBJECT_AREATRIGGER; };
+
+//! Guid to object index of the objects in world on one map. Objects are
+//! registered under the same type as in the HashMapHolder of ObjectAccessor,
+//! so a creature guid never finds a pet and the other way around. The guid
+//! holds the low guid and the type in its high part and is the key as is.
+//! Open addressing with linear probing, removal shifts the following entries
+//! back instead of leaving tombstones.
+//! Only the thread updating the map touches it, there is no locking; lookups
+//! for objects on other maps have to go through the global HashMapHolder.
+class MapObjectRegistry
+{
+    struct Slot
+    {
+        uint64 guid;
+        void* object;
+        uint32 kind;
+    };
+
+public:
+    MapObjectRegistry() : m_mask(0), m_count(0) { }
+
+    template <class T>
+    void Insert(uint64 guid, T* object)
+    {
+        if ((m_count + 1) * 2 > m_slots.size())
+            Grow();
+
+        uint32 index = SlotOf(guid);
+        while (m_slots[index].guid && m_slots[index].guid != guid)
+            index = (index + 1) & m_mask;
+
+        if (!m_slots[index].guid)
+            ++m_count;
+
+        m_slots[index].guid = guid;
+        m_slots[index].object = object;
+        m_slots[index].kind = MapObjectRegistryKindOf<T>::value;
+    }
+
+    void Remove(uint64 guid)
+    {
+        if (!m_count)
+            return;
+
+        uint32 index = SlotOf(guid);
+        while (m_slots[index].guid != guid)
+        {
+            if (!m_slots[index].guid)
+                return;
+            index = (index + 1) & m_mask;
+        }
+
+        // move back every following entry of the run that may no longer be
+        // reached from its home slot once this one is empty
+        uint32 next = index;
+        while (true)
+        {
+            next = (next + 1) & m_mask;
+            if (!m_slots[next].guid)
+                break;
+
+            uint32 home = SlotOf(m_slots[next].guid);
+            if (((next - home) & m_mask) >= ((next - index) & m_mask))
+            {
+                m_slots[index] = m_slots[next];
+                index = next;
+            }
+        }
+
+        m_slots[index].guid = 0;
+        m_slots[index].object = NULL;
+        --m_count;
+    }
+
+    template <class T>
+    T* Find(uint64 guid) const
+    {
+        if (!m_count || !guid)
+            return NULL;
+
+        for (uint32 index = SlotOf(guid); m_slots[index].guid; index = (index + 1) & m_mask)
+            if (m_slots[index].guid == guid)
+                return m_slots[index].kind == MapObjectRegistryKindOf<T>::value ? static_cast<T*>(m_slots[index].object) : NULL;
+
+        return NULL;
+    }
+
+    uint32 GetCount() const { return m_count; }
+
+private:
+    uint32 SlotOf(uint64 guid) const
+    {
+        uint64 hash = guid * UI64LIT(0x9E3779B97F4A7C15);
+        return uint32(hash >> 32) & m_mask;
+    }
+
+    void Grow()
+    {
+        std::vector<Slot> slots(m_slots.empty() ? 64 : m_slots.size() * 2);
+        slots.swap(m_slots);
+        m_mask = m_slots.size() - 1;
+        m_count = 0;
+
+        for (std::vector<Slot>::const_iterator itr = slots.begin(); itr != slots.end(); ++itr)
+        {
+            if (!itr->guid)
+                continue;
+
+            uint32 index = SlotOf(itr->guid);
+            while (m_slots[index].guid)
+                index = (index + 1) & m_mask;
+
+            m_slots[index] = *itr;
+            ++m_count;
+        }
+    }
+
+    uint32 m_mask;
+    uint32 m_count;
+    std::vector<Slot> m_slots;
+};
+
+#endif
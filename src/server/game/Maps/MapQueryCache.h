@@ -0,0 +1,203 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MAP_QUERY_CACHE_H
+#define _MAP_QUERY_CACHE_H
+
+#include "Define.h"
+
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+//! Results of recent height and line of sight queries of one map. Creatures
+//! standing around ask the same questions from nearly the same spots over and
+//! over, positions are snapped to QUERY_CACHE_RESOLUTION so those share an
+//! entry. The slots are direct mapped from the snapped coordinates, which
+//! include the cell, no allocation happens after SetCapacity().
+//! Entries are dropped by bumping the generation: when grids (and with them
+//! terrain and vmap tiles) are loaded or unloaded, and when the dynamic tree
+//! of the map reports a change of its gameobject models.
+//! The cache has no lock, lookups must only happen on the map's update thread.
+//! The parent map of instances is queried by every instance (through
+//! GetBaseMap()) from the instance's thread, so it keeps its cache disabled.
+//! Invalidate() may be called by instances creating grids of their parent map.
+class MapQueryCache
+{
+    struct HeightEntry
+    {
+        int32 x, y, z;
+        uint32 phasemask;
+        uint32 generation;
+        float height;
+    };
+
+    struct LineOfSightEntry
+    {
+        int32 x1, y1, z1;
+        int32 x2, y2, z2;
+        uint32 phasemask;
+        uint32 generation;
+        bool result;
+    };
+
+public:
+    static float constexpr QUERY_CACHE_RESOLUTION = 0.25f;
+    static uint32 constexpr MAX_QUERY_CACHE_SIZE = 65536;
+
+    MapQueryCache() : m_mask(0), m_generation(1), m_dynamicGeneration(0),
+        m_heightHits(0), m_heightMisses(0), m_losHits(0), m_losMisses(0) { }
+
+    //! Rounded down to a power of two, 0 disables the cache
+    void SetCapacity(uint32 capacity)
+    {
+        if (capacity > MAX_QUERY_CACHE_SIZE)
+            capacity = MAX_QUERY_CACHE_SIZE;
+
+        uint32 size = 1;
+        while (size * 2 <= capacity)
+            size *= 2;
+
+        m_mask = capacity ? size - 1 : 0;
+        m_heights.assign(capacity ? size : 0, HeightEntry());
+        m_lineOfSight.assign(capacity ? size : 0, LineOfSightEntry());
+        Invalidate();
+    }
+
+    bool IsEnabled() const { return !m_heights.empty(); }
+
+    void Invalidate() { ++m_generation; }
+
+    //! Called before every lookup with the change counter of the dynamic tree
+    void SyncDynamicGeneration(uint32 dynamicGeneration)
+    {
+        if (dynamicGeneration != m_dynamicGeneration)
+        {
+            m_dynamicGeneration = dynamicGeneration;
+            Invalidate();
+        }
+    }
+
+    bool FindHeight(float x, float y, float z, uint32 phasemask, float& height)
+    {
+        HeightEntry const& entry = m_heights[HeightSlot(Snap(x), Snap(y), Snap(z), phasemask)];
+        if (entry.generation != m_generation || entry.phasemask != phasemask ||
+            entry.x != Snap(x) || entry.y != Snap(y) || entry.z != Snap(z))
+        {
+            ++m_heightMisses;
+            return false;
+        }
+
+        ++m_heightHits;
+        height = entry.height;
+        return true;
+    }
+
+    void StoreHeight(float x, float y, float z, uint32 phasemask, float height)
+    {
+        HeightEntry& entry = m_heights[HeightSlot(Snap(x), Snap(y), Snap(z), phasemask)];
+        entry.x = Snap(x);
+        entry.y = Snap(y);
+        entry.z = Snap(z);
+        entry.phasemask = phasemask;
+        entry.generation = m_generation;
+        entry.height = height;
+    }
+
+    bool FindLineOfSight(float x1, float y1, float z1, float x2, float y2, float z2, uint32 phasemask, bool& result)
+    {
+        LineOfSightEntry const& entry = m_lineOfSight[LineOfSightSlot(x1, y1, z1, x2, y2, z2, phasemask)];
+        if (entry.generation != m_generation || entry.phasemask != phasemask ||
+            entry.x1 != Snap(x1) || entry.y1 != Snap(y1) || entry.z1 != Snap(z1) ||
+            entry.x2 != Snap(x2) || entry.y2 != Snap(y2) || entry.z2 != Snap(z2))
+        {
+            ++m_losMisses;
+            return false;
+        }
+
+        ++m_losHits;
+        result = entry.result;
+        return true;
+    }
+
+    void StoreLineOfSight(float x1, float y1, float z1, float x2, float y2, float z2, uint32 phasemask, bool result)
+    {
+        LineOfSightEntry& entry = m_lineOfSight[LineOfSightSlot(x1, y1, z1, x2, y2, z2, phasemask)];
+        entry.x1 = Snap(x1);
+        entry.y1 = Snap(y1);
+        entry.z1 = Snap(z1);
+        entry.x2 = Snap(x2);
+        entry.y2 = Snap(y2);
+        entry.z2 = Snap(z2);
+        entry.phasemask = phasemask;
+        entry.generation = m_generation;
+        entry.result = result;
+    }
+
+    //! Changes whenever cached results may have become stale, also when the cache is disabled
+    uint32 GetGeneration() const { return m_generation; }
+
+    uint32 GetCapacity() const { return m_heights.size(); }
+    uint64 GetHeightHits() const { return m_heightHits; }
+    uint64 GetHeightMisses() const { return m_heightMisses; }
+    uint64 GetLineOfSightHits() const { return m_losHits; }
+    uint64 GetLineOfSightMisses() const { return m_losMisses; }
+
+private:
+    static int32 Snap(float coord) { return int32(std::floor(coord * (1.0f / QUERY_CACHE_RESOLUTION))); }
+
+    static uint32 Mix(uint32 hash, int32 value)
+    {
+        return (hash ^ uint32(value)) * 0x01000193;
+    }
+
+    uint32 HeightSlot(int32 x, int32 y, int32 z, uint32 phasemask) const
+    {
+        uint32 hash = 0x811C9DC5;
+        hash = Mix(hash, x);
+        hash = Mix(hash, y);
+        hash = Mix(hash, z);
+        hash = Mix(hash, int32(phasemask));
+        return (hash ^ (hash >> 16)) & m_mask;
+    }
+
+    uint32 LineOfSightSlot(float x1, float y1, float z1, float x2, float y2, float z2, uint32 phasemask) const
+    {
+        uint32 hash = 0x811C9DC5;
+        hash = Mix(hash, Snap(x1));
+        hash = Mix(hash, Snap(y1));
+        hash = Mix(hash, Snap(z1));
+        hash = Mix(hash, Snap(x2));
+        hash = Mix(hash, Snap(y2));
+        hash = Mix(hash, Snap(z2));
+        hash = Mix(hash, int32(phasemask));
+        return (hash ^ (hash >> 16)) & m_mask;
+    }
+
+    uint32 m_mask;
+    std::atomic<uint32> m_generation;
+    uint32 m_dynamicGeneration;
+    std::vector<HeightEntry> m_heights;
+    std::vector<LineOfSightEntry> m_lineOfSight;
+
+    uint64 m_heightHits;
+    uint64 m_heightMisses;
+    uint64 m_losHits;
+    uint64 m_losMisses;
+};
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TerrainPrefetcher.h"
+#include "Map.h"
+#include "VMapFactory.h"
+
+PrefetchedGrid::PrefetchedGrid(uint32 mapId, int gx, int gy)
+    : mapId(mapId), gx(gx), gy(gy), requestTime(time(NULL)), ready(false), gridMap(NULL)
+{ }
+
+PrefetchedGrid::~PrefetchedGrid()
+{
+    delete gridMap;
+
+    if (!vmapModels.empty())
+        VMAP::VMapFactory::createOrGetVMapManager()->releaseTileModels(vmapModels);
+}
+
+GridMap* PrefetchedGrid::TakeGridMap()
+{
+    GridMap* const result = gridMap;
+    gridMap = NULL;
+    return result;
+}
+
+void TerrainPrefetcher::Start(uint32 numThreads, std::string const &dataPath)
+{
+    m_dataPath = dataPath;
+
+    m_threads.reserve(numThreads);
+    for (uint32 i = 0; i < numThreads; ++i)
+        m_threads.emplace_back(&TerrainPrefetcher::WorkerThread, this);
+}
+
+void TerrainPrefetcher::Stop()
+{
+    if (m_threads.empty())
+        return;
+
+    m_queue.freeze();
+    for (auto &thread : m_threads)
+        thread.join();
+    m_threads.clear();
+
+    // Drop the requests nobody picked up while the VMap manager is still alive
+    PrefetchedGridPtr grid;
+    while (m_queue.try_pop(grid))
+        grid.reset();
+}
+
+void TerrainPrefetcher::Queue(PrefetchedGridPtr const &grid)
+{
+    m_queue.push(grid);
+}
+
+void TerrainPrefetcher::WorkerThread()
+{
+    PrefetchedGridPtr grid;
+    while (m_queue.pop(grid))
+    {
+        // Map already gave up on it
+        if (!grid.unique())
+            Load(*grid);
+        grid.reset();
+    }
+}
+
+void TerrainPrefetcher::Load(PrefetchedGrid &grid) const
+{
+    int const len = m_dataPath.length() + strlen("maps/%03u%02u%02u.map") + 1;
+    std::vector<char> fileName(len);
+    snprintf(fileName.data(), len, (m_dataPath + "maps/%03u%02u%02u.map").c_str(), grid.mapId, grid.gx, grid.gy);
+
+    // On failure the map thread loads the tile again and reports the error
+    GridMap* const gridMap = new GridMap();
+    if (gridMap->loadData(fileName.data()))
+    {
+        gridMap->touchData();
+        grid.gridMap = gridMap;
+    }
+    else
+        delete gridMap;
+
+    VMAP::VMapFactory::createOrGetVMapManager()->prefetchMapTile((m_dataPath + "vmaps").c_str(), grid.mapId, grid.gx, grid.gy, grid.vmapModels);
+
+    grid.ready.store(true, std::memory_order_release);
+}
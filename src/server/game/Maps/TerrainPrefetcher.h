@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _TERRAINPREFETCHER_H
+#define _TERRAINPREFETCHER_H
+
+#include "Define.h"
+#include "SynchronizedQueue.hpp"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+class GridMap;
+
+//! Terrain and VMap data of one grid, read by a prefetch thread before the
+//! grid is created. The map thread only publishes it once it is ready.
+struct PrefetchedGrid
+{
+    PrefetchedGrid(uint32 mapId, int gx, int gy);
+    ~PrefetchedGrid();
+
+    //! Hands the terrain over to the caller, NULL if the tile has no map file
+    GridMap* TakeGridMap();
+
+    uint32 const mapId;
+    int const gx;
+    int const gy;
+    time_t const requestTime;
+
+    std::atomic<bool> ready;
+    GridMap* gridMap;
+    std::vector<std::string> vmapModels;    //! VMap model references held until the grid is loaded
+};
+
+typedef std::shared_ptr<PrefetchedGrid> PrefetchedGridPtr;
+
+//! I/O threads loading map files and VMap models of grids in front of moving
+//! players, so that the map update thread does not block on the disk when
+//! the grid is entered.
+class TerrainPrefetcher final
+{
+    TerrainPrefetcher() { }
+
+public:
+    static TerrainPrefetcher * instance()
+    {
+        static TerrainPrefetcher prefetcher;
+        return &prefetcher;
+    }
+
+    void Start(uint32 numThreads, std::string const &dataPath);
+    void Stop();
+
+    bool IsEnabled() const { return !m_threads.empty(); }
+
+    void Queue(PrefetchedGridPtr const &grid);
+
+private:
+    void WorkerThread();
+
+    void Load(PrefetchedGrid &grid) const;
+
+    std::string m_dataPath;
+    std::vector<std::thread> m_threads;
+    Trinity::SynchronizedQueue<PrefetchedGridPtr> m_queue;
+};
+
+#define sTerrainPrefetcher TerrainPrefetcher::instance()
+
+#endif
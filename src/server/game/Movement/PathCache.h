@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _PATH_CACHE_H
+#define _PATH_CACHE_H
+
+#include "Define.h"
+#include "DetourNavMesh.h"
+
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+//! Recently found polygon corridors of one map. Mobs chasing the same target
+//! or returning to the same spot ask for the same corridor over and over, a
+//! hit skips the A* search and only the string pulling is done again.
+//! Owned by the map, so it is only accessed from that map's update thread.
+class PathCache
+{
+    struct Key
+    {
+        dtPolyRef startRef;
+        dtPolyRef endRef;
+        uint16 includeFlags;
+        uint16 excludeFlags;
+
+        bool operator==(Key const& other) const
+        {
+            return startRef == other.startRef && endRef == other.endRef
+                && includeFlags == other.includeFlags && excludeFlags == other.excludeFlags;
+        }
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(Key const& key) const
+        {
+            return std::hash<uint64>()(key.startRef * 0x9E3779B97F4A7C15ULL ^ key.endRef)
+                ^ (std::size_t(key.includeFlags) << 16 | key.excludeFlags);
+        }
+    };
+
+    typedef std::list<Key> LruList;
+
+    struct Entry
+    {
+        std::vector<dtPolyRef> polys;
+        LruList::iterator lruItr;
+    };
+
+public:
+    PathCache() : m_capacity(0), m_hits(0), m_misses(0) { }
+
+    void SetCapacity(uint32 capacity)
+    {
+        m_capacity = capacity;
+        while (m_entries.size() > m_capacity)
+            Evict();
+    }
+
+    //! Copies the cached corridor into polys, entries referencing a polygon
+    //! of a tile that was unloaded since are dropped
+    bool Find(dtNavMesh const* navMesh, dtPolyRef startRef, dtPolyRef endRef, uint16 includeFlags, uint16 excludeFlags,
+        dtPolyRef* polys, uint32& polyLength, uint32 maxLength)
+    {
+        Key const key = { startRef, endRef, includeFlags, excludeFlags };
+        auto itr = m_entries.find(key);
+        if (itr == m_entries.end() || itr->second.polys.size() > maxLength)
+        {
+            ++m_misses;
+            return false;
+        }
+
+        for (auto const ref : itr->second.polys)
+        {
+            if (!navMesh->isValidPolyRef(ref))
+            {
+                m_lru.erase(itr->second.lruItr);
+                m_entries.erase(itr);
+                ++m_misses;
+                return false;
+            }
+        }
+
+        m_lru.splice(m_lru.begin(), m_lru, itr->second.lruItr);
+
+        polyLength = itr->second.polys.size();
+        std::copy(itr->second.polys.begin(), itr->second.polys.end(), polys);
+        ++m_hits;
+        return true;
+    }
+
+    void Store(dtPolyRef startRef, dtPolyRef endRef, uint16 includeFlags, uint16 excludeFlags,
+        dtPolyRef const* polys, uint32 polyLength)
+    {
+        if (!m_capacity)
+            return;
+
+        Key const key = { startRef, endRef, includeFlags, excludeFlags };
+        auto itr = m_entries.find(key);
+        if (itr == m_entries.end())
+        {
+            if (m_entries.size() >= m_capacity)
+                Evict();
+
+            m_lru.push_front(key);
+            itr = m_entries.emplace(key, Entry()).first;
+            itr->second.lruItr = m_lru.begin();
+        }
+        else
+            m_lru.splice(m_lru.begin(), m_lru, itr->second.lruItr);
+
+        itr->second.polys.assign(polys, polys + polyLength);
+    }
+
+    uint64 GetHits() const { return m_hits; }
+    uint64 GetMisses() const { return m_misses; }
+
+private:
+    void Evict()
+    {
+        m_entries.erase(m_lru.back());
+        m_lru.pop_back();
+    }
+
+    uint32 m_capacity;
+    uint64 m_hits;
+    uint64 m_misses;
+    LruList m_lru;
+    std::unordered_map<Key, Entry, KeyHash> m_entries;
+};
+
+#endif
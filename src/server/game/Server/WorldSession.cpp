@@ -107,6 +107,7 @@ WorldSession::WorldSession(uint32 id, WorldSocket* sock, AccountTypes sec,
 {
         _warden = NULL;
     _filterAddonMessages = false;
+    _queryCallbacks = std::make_shared<QueryCallbackQueue>();
 
     if (sock)
     {
@@ -115,8 +116,6 @@ WorldSession::WorldSession(uint32 id, WorldSocket* sock, AccountTypes sec,
         ResetTimeOutTime();
         LoginDatabase.PExecute("UPDATE account SET online = 1 WHERE id = %u;", GetAccountId());     // One-time query
     }
-
-    InitializeQueryCallbackParameters();
 }
 
 /// WorldSession destructor
@@ -1030,102 +1029,9 @@ void WorldSession::SetPlayer(Player* player)
         m_GUIDLow = _player->GetGUIDLow();
 }
 
-void WorldSession::InitializeQueryCallbackParameters()
-{
-    // Callback parameters that have pointers in them should be properly
-    // initialized to NULL here.
-    _charCreateCallback.SetParam(NULL);
-}
-
 void WorldSession::ProcessQueryCallbacks()
 {
-    PreparedQueryResult result;
-
-    //! HandleNameQueryOpcode
-    {
-        ACE_Guard<ACE_Thread_Mutex> guard(_nameQueryCallbacksLock);
-        while (!_nameQueryCallbacks.empty())
-        {
-            NameQueryInfo &nameQuery = _nameQueryCallbacks.front();
-            if (!nameQuery.second.ready())
-                break;
-            if (nameQuery.second.get(result) == 0)
-                SendNameQueryOpcodeCallBack(nameQuery.first, result);
-            _nameQueryCallbacks.pop_front();
-        }
-    }
-
-    //! HandleCharEnumOpcode
-    if (_charEnumCallback.ready())
-    {
-        _charEnumCallback.get(result);
-        HandleCharEnum(result);
-        _charEnumCallback.cancel();
-    }
-
-    if (_charCreateCallback.IsReady())
-    {
-        _charCreateCallback.GetResult(result);
-        HandleCharCreateCallback(result, _charCreateCallback.GetParam());
-        // Don't call FreeResult() here, the callback handler will do that depending on the events in the callback chain
-    }
-
-    //! HandlePlayerLoginOpcode
-    if (_charLoginCallback.ready() && _authLoginCallback.ready())
-    {
-        SQLQueryHolder *charParam, *authParam;
-
-        _charLoginCallback.get(charParam);
-        _authLoginCallback.get(authParam);
-
-        HandlePlayerLogin((CharLoginQueryHolder*)charParam, (AuthLoginQueryHolder*)authParam);
-
-        _charLoginCallback.cancel();
-        _authLoginCallback.cancel();
-    }
-
-    //! HandleAddFriendOpcode
-    if (_addFriendCallback.IsReady())
-    {
-        std::string param = _addFriendCallback.GetParam();
-        _addFriendCallback.GetResult(result);
-        HandleAddFriendOpcodeCallBack(result, param);
-        _addFriendCallback.FreeResult();
-    }
-
-    //- HandleCharRenameOpcode
-    if (_charRenameCallback.IsReady())
-    {
-        std::string param = _charRenameCallback.GetParam();
-        _charRenameCallback.GetResult(result);
-        HandleChangePlayerNameOpcodeCallBack(result, param);
-        _charRenameCallback.FreeResult();
-    }
-
-    //- HandleCharAddIgnoreOpcode
-    if (_addIgnoreCallback.ready())
-    {
-        _addIgnoreCallback.get(result);
-        HandleAddIgnoreOpcodeCallBack(result);
-        _addIgnoreCallback.cancel();
-    }
-
-    //- SendStabledPet
-    if (_sendPetListCallback.IsReady())
-    {
-        uint64 param = _sendPetListCallback.GetParam();
-        _sendPetListCallback.GetResult(result);
-        SendPetListCallback(result, param);
-        _sendPetListCallback.FreeResult();
-    }
-
-    //- HandleSetPetSlotOpcode
-    if (_setPetSlotCallback.IsReady())
-    {
-        _setPetSlotCallback.GetResult(result);
-        SetPetSlotCallback(result, _setPetSlotCallback.GetParam());
-        _setPetSlotCallback.FreeResult();
-    }
+    _queryCallbacks->ProcessCallbacks();
 }
 
 void WorldSession::InitWarden(BigNumber* k, std::string const &os)
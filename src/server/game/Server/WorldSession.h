@@ -55,6 +55,7 @@ class WorldPacket;
 class WorldSocket;
 struct AreaTableEntry;
 struct AuctionEntry;
+struct CharacterNameData;
 struct DeclinedName;
 struct ItemTemplate;
 struct LfgJoinResultData;
@@ -326,7 +327,8 @@ class WorldSession
         //void SendTestCreatureQueryOpcode(uint32 entry, uint64 guid, uint32 testvalue);
         void SendNameQueryOpcode(Player const *player);
         void SendNameQueryOpcode(uint64 guid);
-        void SendNameQueryOpcodeCallBack(uint64 guid, PreparedQueryResult result);
+        void SendNameQueryOpcodeCallBack(uint64 guid, uint32 cacheStamp, PreparedQueryResult result);
+        void SendNameQueryResponse(uint64 guid, CharacterNameData const *nameData);
 
         void SendTrainerList(uint64 guid);
         void SendTrainerList(uint64 guid, const std::string& strTitle);
@@ -446,10 +448,10 @@ class WorldSession
         void HandleCharEnumOpcode(WorldPacket& recvPacket);
         void HandleCharDeleteOpcode(WorldPacket& recvPacket);
         void HandleCharCreateOpcode(WorldPacket& recvPacket);
-        void HandleCharCreateCallback(PreparedQueryResult result, CharacterCreateInfo* createInfo);
+        void HandleCharCreateCallback(PreparedQueryResult result, std::shared_ptr<CharacterCreateInfo> createInfo, uint8 stage);
         void HandlePlayerLoginOpcode(WorldPacket& recvPacket);
         void HandleLoadScreenOpcode(WorldPacket& recvPacket);
-        void HandleCharEnum(PreparedQueryResult result);
+        void HandleCharEnum(PreparedQueryResult result, uint32 cacheStamp);
         void HandlePlayerLogin(CharLoginQueryHolder *charHolder, AuthLoginQueryHolder *authHolder);
         void HandleCharFactionOrRaceChange(WorldPacket& recvData);
         void HandleRandomizeCharNameOpcode(WorldPacket& recvData);
@@ -1071,25 +1073,13 @@ class WorldSession
 
         void HandleMovieComplete(WorldPacket& recv_data);
     private:
-        void InitializeQueryCallbackParameters();
         void ProcessQueryCallbacks();
 
-        ACE_Thread_Mutex _nameQueryCallbacksLock;
+        //! Results of asynchronous queries issued by this session, with their continuations
+        QueryCallbackQueuePtr _queryCallbacks;
 
-        typedef std::pair<uint64, PreparedQueryResultFuture> NameQueryInfo;
-        std::deque<NameQueryInfo> _nameQueryCallbacks;
-
-        PreparedQueryResultFuture _charEnumCallback;
-        PreparedQueryResultFuture _addIgnoreCallback;
-
-        QueryCallback<PreparedQueryResult, std::string> _charRenameCallback;
-        QueryCallback<PreparedQueryResult, std::string> _addFriendCallback;
-        QueryCallback<PreparedQueryResult, uint64> _sendPetListCallback;
-        QueryCallback<PreparedQueryResult, uint8> _setPetSlotCallback;
-        QueryCallback<PreparedQueryResult, CharacterCreateInfo*, true> _charCreateCallback;
-
-        QueryResultHolderFuture _charLoginCallback;
-        QueryResultHolderFuture _authLoginCallback;
+        //! Creation request in progress, a newer request supersedes it
+        std::shared_ptr<CharacterCreateInfo> _charCreateInfo;
 
     private:
         void checkMoveCheat(uint16 opcode, MovementInfo const &movementInfo);
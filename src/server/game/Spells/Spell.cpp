@@ -794,6 +794,9 @@ void Spell::SelectSpellTargets()
         }
     }
 
+    // positions may change until the targets are checked again
+    m_lineOfSightCache.clear();
+
     if (m_spellInfo->AttributesEx9 & SPELL_ATTR9_SPECIAL_DELAY_CALCULATION)
     {
         m_delayMoment = uint64(m_spellInfo->Speed * 1000.0f);
@@ -2181,6 +2184,115 @@ void Spell::SearchAreaTargets(std::list<WorldObject*>& targets, float range, Pos
     Trinity::WorldObjectSpellAreaTargetCheck check(range, position, m_caster, referer, m_spellInfo, selectionType, condList, checkAuraStates);
     Trinity::WorldObjectListSearcher<Trinity::WorldObjectSpellAreaTargetCheck> searcher(m_caster, targets, check, containerTypeMask);
     SearchTargets<Trinity::WorldObjectListSearcher<Trinity::WorldObjectSpellAreaTargetCheck> > (searcher, containerTypeMask, m_caster, position, range);
+
+    PrefetchTargetLineOfSight(targets);
+}
+
+void Spell::PrefetchTargetLineOfSight(std::list<WorldObject*> const& targets)
+{
+    m_lineOfSightCache.clear();
+
+    // a single target gains nothing from the batch
+    if (targets.size() < 2)
+        return;
+
+    // same early outs as CheckEffectTarget, no line of sight check is done at all for these
+    if (!m_spellInfo->IsNeedAdditionalLosChecks() && (IsTriggered() || m_spellInfo->AttributesEx2 & SPELL_ATTR2_CAN_TARGET_NOT_IN_LOS) || DisableMgr::IsDisabledFor(DISABLE_TYPE_SPELL, m_spellInfo->Id, NULL, SPELL_DISABLE_LOS))
+        return;
+
+    bool const fromDest = m_targets.HasDst();
+    WorldObject* caster = NULL;
+    if (!fromDest)
+    {
+        if (IS_GAMEOBJECT_GUID(m_originalCasterGUID))
+            caster = m_caster->GetMap()->GetGameObject(m_originalCasterGUID);
+        if (!caster)
+            caster = m_caster;
+    }
+
+    float ox, oy, oz;
+    if (fromDest)
+        m_targets.GetDstPos()->GetPosition(ox, oy, oz);
+    else
+        caster->GetPosition(ox, oy, oz);
+
+    std::vector<VMAP::LineOfSightQuery> queries;
+    std::vector<uint64> queryTargets;
+    queries.reserve(targets.size());
+    queryTargets.reserve(targets.size());
+
+    for (std::list<WorldObject*>::const_iterator itr = targets.begin(); itr != targets.end(); ++itr)
+    {
+        Unit const* target = (*itr)->ToUnit();
+        if (!target || target == m_caster)
+            continue;
+
+        LineOfSightCacheEntry entry;
+        target->GetPosition(entry.x, entry.y, entry.z);
+        entry.ox = ox;
+        entry.oy = oy;
+        entry.oz = oz;
+        entry.fromDest = fromDest;
+        entry.inLineOfSight = true;
+
+        // results WorldObject::IsWithinLOSInMap and IsWithinLOS give without tracing a ray
+        if (!fromDest && !target->IsInMap(caster))
+            entry.inLineOfSight = false;
+        else if (!fromDest && ((target->GetTypeId() == TYPEID_UNIT && target->ToCreature()->GetCreatureTemplate()->flags_extra & CREATURE_FLAG_EXTRA_DISABLED_LOS) ||
+            (caster->GetTypeId() == TYPEID_UNIT && caster->ToCreature()->GetCreatureTemplate()->flags_extra & CREATURE_FLAG_EXTRA_DISABLED_LOS)))
+            entry.inLineOfSight = true;
+        else if (target->IsInWorld())
+        {
+            VMAP::LineOfSightQuery query;
+            query.x1 = entry.x;
+            query.y1 = entry.y;
+            query.z1 = entry.z + 2.f;
+            query.x2 = ox;
+            query.y2 = oy;
+            query.z2 = oz + 2.f;
+            query.phasemask = target->GetPhaseMask();
+            query.result = true;
+            queries.push_back(query);
+            queryTargets.push_back(target->GetGUID());
+        }
+
+        m_lineOfSightCache[target->GetGUID()] = entry;
+    }
+
+    if (queries.empty())
+        return;
+
+    m_caster->GetMap()->isInLineOfSight(&queries[0], queries.size());
+    for (size_t i = 0; i < queries.size(); ++i)
+        m_lineOfSightCache[queryTargets[i]].inLineOfSight = queries[i].result;
+}
+
+bool Spell::IsTargetWithinLOS(Unit const* target, float x, float y, float z) const
+{
+    LineOfSightCache::const_iterator itr = m_lineOfSightCache.find(target->GetGUID());
+    if (itr != m_lineOfSightCache.end())
+    {
+        LineOfSightCacheEntry const& entry = itr->second;
+        if (entry.fromDest && entry.ox == x && entry.oy == y && entry.oz == z &&
+            entry.x == target->GetPositionX() && entry.y == target->GetPositionY() && entry.z == target->GetPositionZ())
+            return entry.inLineOfSight;
+    }
+
+    return target->IsWithinLOS(x, y, z);
+}
+
+bool Spell::IsTargetWithinLOSInMap(Unit const* target, WorldObject const* caster) const
+{
+    LineOfSightCache::const_iterator itr = m_lineOfSightCache.find(target->GetGUID());
+    if (itr != m_lineOfSightCache.end())
+    {
+        LineOfSightCacheEntry const& entry = itr->second;
+        if (!entry.fromDest && entry.ox == caster->GetPositionX() && entry.oy == caster->GetPositionY() && entry.oz == caster->GetPositionZ() &&
+            entry.x == target->GetPositionX() && entry.y == target->GetPositionY() && entry.z == target->GetPositionZ())
+            return entry.inLineOfSight;
+    }
+
+    return target->IsWithinLOSInMap(caster);
 }
 
 void Spell::SearchChainTargets(std::list<WorldObject*>& targets, uint32 chainTargets, WorldObject* target, SpellTargetObjectTypes objectType, SpellTargetCheckTypes selectType, ConditionList* condList, bool isChainHeal)
@@ -6513,12 +6625,10 @@ SpellCastResult Spell::CheckCast(bool strict)
 
     if (m_caster->GetTypeId() == TYPEID_PLAYER && VMAP::VMapFactory::createOrGetVMapManager()->isLineOfSightCalcEnabled())
     {
-        if (m_spellInfo->Attributes & SPELL_ATTR0_OUTDOORS_ONLY &&
-                !m_caster->GetMap()->IsOutdoors(m_caster->GetPositionX(), m_caster->GetPositionY(), m_caster->GetPositionZ()))
+        if (m_spellInfo->Attributes & SPELL_ATTR0_OUTDOORS_ONLY && !m_caster->IsOutdoors())
             return SPELL_FAILED_ONLY_OUTDOORS;
 
-        if (m_spellInfo->Attributes & SPELL_ATTR0_INDOORS_ONLY &&
-                m_caster->GetMap()->IsOutdoors(m_caster->GetPositionX(), m_caster->GetPositionY(), m_caster->GetPositionZ()))
+        if (m_spellInfo->Attributes & SPELL_ATTR0_INDOORS_ONLY && m_caster->IsOutdoors())
             return SPELL_FAILED_ONLY_INDOORS;
     }
 
@@ -8504,10 +8614,10 @@ bool Spell::CheckEffectTarget(Unit const* target, uint32 eff) const
                 float x, y, z;
                 m_targets.GetDstPos()->GetPosition(x, y, z);
 
-                if (!target->IsWithinLOS(x, y, z))
+                if (!IsTargetWithinLOS(target, x, y, z))
                     return false;
             }
-            else if (target != m_caster && !target->IsWithinLOSInMap(caster))
+            else if (target != m_caster && !IsTargetWithinLOSInMap(target, caster))
                 return false;
             break;
     }
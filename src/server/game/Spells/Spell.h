@@ -704,6 +704,22 @@ class Spell
 
         SpellDestination m_destTargets[MAX_SPELL_EFFECTS];
 
+        // line of sight of area targets, traced in one batch when they are searched and read by CheckEffectTarget
+        // an entry is only used while target and origin are still at the stored positions
+        struct LineOfSightCacheEntry
+        {
+            float x, y, z;              // target
+            float ox, oy, oz;           // dest or caster
+            bool fromDest;
+            bool inLineOfSight;
+        };
+        typedef std::unordered_map<uint64, LineOfSightCacheEntry> LineOfSightCache;
+        LineOfSightCache m_lineOfSightCache;
+
+        void PrefetchTargetLineOfSight(std::list<WorldObject*> const& targets);
+        bool IsTargetWithinLOS(Unit const* target, float x, float y, float z) const;
+        bool IsTargetWithinLOSInMap(Unit const* target, WorldObject const* caster) const;
+
         void AddUnitTarget(Unit* target, uint32 effectMask, bool checkIfValid = true, bool implicit = true, uint8 effectIndex = EFFECT_0);
         void AddGOTarget(GameObject* target, uint32 effectMask);
         void AddItemTarget(Item* item, uint32 effectMask);
@@ -54,6 +54,7 @@
 #include "TemporarySummon.h"
 #include "WaypointMovementGenerator.h"
 #include "VMapFactory.h"
+#include "MMapFactory.h"
 #include "GameEventMgr.h"
 #include "PoolMgr.h"
 #include "GridNotifiersImpl.h"
@@ -82,9 +83,13 @@
 #include "PlayerDump.h"
 #include "Compress.hpp"
 #include "ThreadPoolMgr.hpp"
+#include "TaskGraph.hpp"
 #include "BattlePetSpawnMgr.h"
 #include "BattlePet.h"
+#include "CharacterCache.h"
+#include "TerrainPrefetcher.h"
 
+#include <algorithm>
 #include <memory>
 
 #define CONQUEST_RESET_PERIOD 7
@@ -212,6 +217,7 @@ World::World()
     m_maxQueuedSessionCount = 0;
     m_PlayerCount = 0;
     m_MaxPlayerCount = 0;
+    m_queryCallbacks = std::make_shared<QueryCallbackQueue>();
     m_NextDailyQuestReset = 0;
     m_NextWeeklyQuestReset = 0;
     m_NextCurrencyReset = 0;
@@ -264,6 +270,7 @@ World::~World()
         delete command;
 
     VMAP::VMapFactory::clear();
+    MMAP::MMapFactory::clear();
     //TODO free addSessQueue
 }
 
@@ -740,6 +747,7 @@ void World::LoadConfigSettings(bool reload)
     m_bool_configs[CONFIG_PRESERVE_CUSTOM_CHANNELS] = sConfigMgr->GetBoolDefault("PreserveCustomChannels", false);
     m_int_configs[CONFIG_PRESERVE_CUSTOM_CHANNEL_DURATION] = sConfigMgr->GetIntDefault("PreserveCustomChannelDuration", 14);
     m_bool_configs[CONFIG_GRID_UNLOAD] = sConfigMgr->GetBoolDefault("GridUnload", true);
+    m_int_configs[CONFIG_GRID_MEMORY_BUDGET] = sConfigMgr->GetIntDefault("GridUnload.MemoryBudget", 0);
     m_int_configs[CONFIG_INTERVAL_SAVE] = sConfigMgr->GetIntDefault("PlayerSaveInterval", 15 * MINUTE * IN_MILLISECONDS);
     m_int_configs[CONFIG_INTERVAL_DISCONNECT_TOLERANCE] = sConfigMgr->GetIntDefault("DisconnectToleranceInterval", 0);
     m_bool_configs[CONFIG_STATS_SAVE_ONLY_ON_LOGOUT] = sConfigMgr->GetBoolDefault("PlayerSave.Stats.SaveOnlyOnLogout", true);
@@ -769,6 +777,14 @@ void World::LoadConfigSettings(bool reload)
     if (reload)
         sMapMgr->SetMapUpdateInterval(m_int_configs[CONFIG_INTERVAL_MAPUPDATE]);
 
+    m_int_configs[CONFIG_CREATURE_IDLE_UPDATE_INTERVAL] = sConfigMgr->GetIntDefault("Creature.IdleUpdate.Interval", 1000);
+    if (m_int_configs[CONFIG_CREATURE_IDLE_UPDATE_INTERVAL] && m_int_configs[CONFIG_CREATURE_IDLE_UPDATE_INTERVAL] <= m_int_configs[CONFIG_INTERVAL_MAPUPDATE])
+    {
+        TC_LOG_ERROR("server.loading", "Creature.IdleUpdate.Interval (%u) must be greater than MapUpdateInterval (%u), idle creature throttling disabled.", m_int_configs[CONFIG_CREATURE_IDLE_UPDATE_INTERVAL], m_int_configs[CONFIG_INTERVAL_MAPUPDATE]);
+        m_int_configs[CONFIG_CREATURE_IDLE_UPDATE_INTERVAL] = 0;
+    }
+    m_float_configs[CONFIG_CREATURE_IDLE_UPDATE_NEAR_DISTANCE] = sConfigMgr->GetFloatDefault("Creature.IdleUpdate.NearDistance", 100.0f);
+
     m_int_configs[CONFIG_INTERVAL_CHANGEWEATHER] = sConfigMgr->GetIntDefault("ChangeWeatherInterval", 10 * MINUTE * IN_MILLISECONDS);
 
     if (reload)
@@ -863,6 +879,8 @@ void World::LoadConfigSettings(bool reload)
         m_int_configs[CONFIG_CHARACTERS_PER_ACCOUNT] = m_int_configs[CONFIG_CHARACTERS_PER_REALM];
     }
 
+    m_int_configs[CONFIG_CHARACTER_CACHE_ENUM_EXPIRE] = sConfigMgr->GetIntDefault("CharacterCache.EnumExpireTime", 300);
+
     m_int_configs[CONFIG_HEROIC_CHARACTERS_PER_REALM] = sConfigMgr->GetIntDefault("HeroicCharactersPerRealm", 1);
     if (int32(m_int_configs[CONFIG_HEROIC_CHARACTERS_PER_REALM]) < 0 || m_int_configs[CONFIG_HEROIC_CHARACTERS_PER_REALM] > 10)
     {
@@ -1340,6 +1358,21 @@ void World::LoadConfigSettings(bool reload)
     //VMAP::VMapFactory::preventSpellsFromBeingTestedForLoS(ignoreSpellIds.c_str());
     TC_LOG_INFO("server.loading", "VMap support included. LineOfSight:%i, getHeight:%i, indoorCheck:%i PetLOS:%i", enableLOS, enableHeight, enableIndoor, enablePetLOS);
     TC_LOG_INFO("server.loading", "VMap data directory is: %svmaps", m_dataPath.c_str());
+    m_int_configs[CONFIG_MAP_QUERY_CACHE_SIZE] = sConfigMgr->GetIntDefault("vmap.queryCacheSize", 2048);
+    if (m_int_configs[CONFIG_MAP_QUERY_CACHE_SIZE] > MapQueryCache::MAX_QUERY_CACHE_SIZE)
+    {
+        TC_LOG_ERROR("server.loading", "vmap.queryCacheSize (%i) must be in range 0..%u. Set to %u.", m_int_configs[CONFIG_MAP_QUERY_CACHE_SIZE], MapQueryCache::MAX_QUERY_CACHE_SIZE, MapQueryCache::MAX_QUERY_CACHE_SIZE);
+        m_int_configs[CONFIG_MAP_QUERY_CACHE_SIZE] = MapQueryCache::MAX_QUERY_CACHE_SIZE;
+    }
+
+    m_bool_configs[CONFIG_ENABLE_MMAPS] = sConfigMgr->GetBoolDefault("mmap.enablePathFinding", false);
+    m_int_configs[CONFIG_MMAP_MAX_SEARCH_NODES] = sConfigMgr->GetIntDefault("mmap.maxSearchNodes", 1024);
+    m_int_configs[CONFIG_MMAP_PATH_CACHE_SIZE] = sConfigMgr->GetIntDefault("mmap.pathCacheSize", 64);
+    MMAP::MMapFactory::createOrGetMMapManager()->setMaxSearchNodes(m_int_configs[CONFIG_MMAP_MAX_SEARCH_NODES]);
+    TC_LOG_INFO("server.loading", "WORLD: MMap data directory is: %smmaps", m_dataPath.c_str());
+
+    m_int_configs[CONFIG_TERRAIN_PREFETCH_THREADS] = sConfigMgr->GetIntDefault("Terrain.Prefetch.Threads", 2);
+    m_int_configs[CONFIG_TERRAIN_PREFETCH_LOOKAHEAD] = sConfigMgr->GetIntDefault("Terrain.Prefetch.Lookahead", 10);
 
     m_int_configs[CONFIG_MAX_WHO] = sConfigMgr->GetIntDefault("MaxWhoListReturns", 49);
     m_bool_configs[CONFIG_LIMIT_WHO_ONLINE] = sConfigMgr->GetBoolDefault("LimitWhoOnline", true);
@@ -1497,6 +1530,31 @@ void World::LoadConfigSettings(bool reload)
 
 extern void LoadGameObjectModelList();
 
+/// Logs how long each startup loader took, slowest first
+static void LogLoaderTimings(Trinity::TaskGraph const &loaders)
+{
+    typedef std::chrono::milliseconds Ms;
+
+    std::vector<Trinity::TaskGraph::Timing> timings = loaders.timings();
+    std::sort(timings.begin(), timings.end(), [](Trinity::TaskGraph::Timing const &a, Trinity::TaskGraph::Timing const &b)
+    {
+        return a.elapsed > b.elapsed;
+    });
+
+    Trinity::TaskGraph::ClockType::duration busy = Trinity::TaskGraph::ClockType::duration::zero();
+    for (auto const &timing : timings)
+        busy += timing.elapsed;
+
+    TC_LOG_INFO("server.loading", ">> Loaded %u template stores in %u ms (%u ms of loader time)", uint32(timings.size()),
+        uint32(std::chrono::duration_cast<Ms>(loaders.elapsed()).count()), uint32(std::chrono::duration_cast<Ms>(busy).count()));
+
+    TC_LOG_INFO("server.loading", "   %-40s %10s %10s", "Loader", "Start ms", "Took ms");
+    for (auto const &timing : timings)
+        TC_LOG_INFO("server.loading", "   %-40s %10u %10u", timing.name.c_str(),
+            uint32(std::chrono::duration_cast<Ms>(timing.start).count()),
+            uint32(std::chrono::duration_cast<Ms>(timing.elapsed).count()));
+}
+
 /// Initialize the World
 void World::SetInitialWorldSettings()
 {
@@ -1559,6 +1617,9 @@ void World::SetInitialWorldSettings()
     TC_LOG_INFO("server.loading", "Starting thread pool manager");
     sThreadPoolMgr->start(getIntConfig(CONFIG_NUMTHREADS));
 
+    TC_LOG_INFO("server.loading", "Starting terrain prefetch threads");
+    sTerrainPrefetcher->Start(getIntConfig(CONFIG_TERRAIN_PREFETCH_THREADS), m_dataPath);
+
     ///- Load the DBC files
     TC_LOG_INFO("server.loading", "Initialize data stores...");
     LoadDBCStores(m_dataPath);
@@ -1602,118 +1663,74 @@ void World::SetInitialWorldSettings()
     TC_LOG_INFO("server.loading", "Loading instances...");
     sInstanceSaveMgr->LoadInstances();
 
-    TC_LOG_INFO("server.loading", "Loading Localization strings...");
-    uint32 oldMSTime = getMSTime();
-    sObjectMgr->LoadCreatureLocales();
-    sObjectMgr->LoadGameObjectLocales();
-    sObjectMgr->LoadItemLocales();
-    sObjectMgr->LoadQuestLocales();
-    sObjectMgr->LoadNpcTextLocales();
-    sObjectMgr->LoadPageTextLocales();
-    sObjectMgr->LoadGossipMenuItemsLocales();
-    sObjectMgr->LoadPointOfInterestLocales();
-
     sObjectMgr->SetDBCLocaleIndex(GetDefaultDbcLocale());        // Get once for all the locale index of DBC language (console/broadcasts)
-    TC_LOG_INFO("server.loading", ">> Localization strings loaded in %u ms", GetMSTimeDiffToNow(oldMSTime));
-
-    TC_LOG_INFO("server.loading", "Loading Page Texts...");
-    sObjectMgr->LoadPageTexts();
-
-    TC_LOG_INFO("server.loading", "Loading Game Object Templates...");         // must be after LoadPageTexts
-    sObjectMgr->LoadGameObjectTemplate();
-
-    TC_LOG_INFO("server.loading", "Loading Spell Rank Data...");
-    sSpellMgr->LoadSpellRanks();
-
-    TC_LOG_INFO("server.loading", "Loading Spell Required Data...");
-    sSpellMgr->LoadSpellRequired();
-
-    TC_LOG_INFO("server.loading", "Loading Spell Group types...");
-    sSpellMgr->LoadSpellGroups();
-
-    TC_LOG_INFO("server.loading", "Loading Spell Learn Skills...");
-    sSpellMgr->LoadSpellLearnSkills();                           // must be after LoadSpellRanks
-
-    TC_LOG_INFO("server.loading", "Loading Spell Learn Spells...");
-    sSpellMgr->LoadSpellLearnSpells();
-
-    TC_LOG_INFO("server.loading", "Loading Spell Proc Event conditions...");
-    sSpellMgr->LoadSpellProcEvents();
-
-    TC_LOG_INFO("server.loading", "Loading Spell Proc conditions and data...");
-    sSpellMgr->LoadSpellProcs();
-
-    TC_LOG_INFO("server.loading", "Loading Spell Bonus Data...");
-    sSpellMgr->LoadSpellBonusess();
-
-    TC_LOG_INFO("server.loading", "Loading Aggro Spells Definitions...");
-    sSpellMgr->LoadSpellThreats();
 
-    TC_LOG_INFO("server.loading", "Loading Spell Group Stack Rules...");
-    sSpellMgr->LoadSpellGroupStackRules();
+    ///- Load the template stores which do not depend on each other in parallel,
+    ///  each loader runs on a pool thread with its own database connection.
+    ///  Loaders sharing a container or reading another loader's data must be
+    ///  connected with an edge, the "must be after" comments below are edges.
+    TC_LOG_INFO("server.loading", "Loading template stores...");
+    Trinity::TaskGraph loaders;
 
-    TC_LOG_INFO("server.loading", "Loading Spell Phase Dbc Info...");
-    sObjectMgr->LoadSpellPhaseInfo();
-
-    TC_LOG_INFO("server.loading", "Loading Spell AreaTrigger templates...");
-    sObjectMgr->LoadSpellAreaTriggerTemplates();
-
-    TC_LOG_INFO("server.loading", "Loading NPC Texts...");
-    sObjectMgr->LoadGossipText();
-
-    TC_LOG_INFO("server.loading", "Loading Enchant Spells Proc datas...");
-    sSpellMgr->LoadSpellEnchantProcData();
-
-    TC_LOG_INFO("server.loading", "Loading Item Random Enchantments Table...");
-    LoadRandomEnchantmentsTable();
-
-    TC_LOG_INFO("server.loading", "Loading Disables");
-    DisableMgr::LoadDisables();                                 // must be before loading quests and items
-
-    TC_LOG_INFO("server.loading", "Loading Items...");                         // must be after LoadRandomEnchantmentsTable and LoadPageTexts
-    sObjectMgr->LoadItemTemplates();
-
-    TC_LOG_INFO("server.loading", "Loading Items Specialisations...");
-    sObjectMgr->LoadItemSpecialisation();
-
-    TC_LOG_INFO("server.loading", "Loading Item set names...");                // must be after LoadItemPrototypes
-    sObjectMgr->LoadItemTemplateAddon();
-
-    TC_LOG_INFO("misc", "Loading Item Scripts...");                 // must be after LoadItemPrototypes
-    sObjectMgr->LoadItemScriptNames();
-
-    TC_LOG_INFO("server.loading", "Loading Creature Model Based Info Data...");
-    sObjectMgr->LoadCreatureModelInfo();
-
-    TC_LOG_INFO("server.loading", "Loading Equipment templates...");
-    sObjectMgr->LoadEquipmentTemplates();
-
-    TC_LOG_INFO("server.loading", "Loading Creature templates...");
-    sObjectMgr->LoadCreatureTemplates();
-
-    TC_LOG_INFO("server.loading", "Loading Creature template addons...");
-    sObjectMgr->LoadCreatureTemplateAddons();
-
-    TC_LOG_INFO("server.loading", "Loading Creature template currencies...");
-    sObjectMgr->LoadCreatureTemplateCurrency();
-
-    TC_LOG_INFO("server.loading", "Loading Creature Script Names currencies...");
-    sObjectMgr->LoadCreatureScriptNames();
-
-    TC_LOG_INFO("server.loading", "Loading Reputation Reward Rates...");
-    sObjectMgr->LoadReputationRewardRate();
-
-    TC_LOG_INFO("server.loading", "Loading Creature Reputation OnKill Data...");
-    sObjectMgr->LoadReputationOnKill();
-
-    TC_LOG_INFO("server.loading", "Loading Reputation Spillover Data...");
-    sObjectMgr->LoadReputationSpilloverTemplate();
-
-    TC_LOG_INFO("server.loading", "Loading Points Of Interest Data...");
-    sObjectMgr->LoadPointsOfInterest();
-
-    TC_LOG_INFO("server.loading", "Loading Creature Base Stats...");
-    sObjectMgr->LoadCreatureClassLevelStats();
+    auto const addLoader = [&loaders](char const *name, std::function<void()> loader, std::initializer_list<Trinity::TaskGraph::TaskId> dependencies)
+    {
+        return loaders.add(name, [name, loader]
+        {
+            TC_LOG_INFO("server.loading", "Loading %s...", name);
+            loader();
+        }, dependencies);
+    };
+
+    addLoader("Creature Locales", [] { sObjectMgr->LoadCreatureLocales(); }, {});
+    addLoader("GameObject Locales", [] { sObjectMgr->LoadGameObjectLocales(); }, {});
+    addLoader("Item Locales", [] { sObjectMgr->LoadItemLocales(); }, {});
+    addLoader("Quest Locales", [] { sObjectMgr->LoadQuestLocales(); }, {});
+    addLoader("NPC Text Locales", [] { sObjectMgr->LoadNpcTextLocales(); }, {});
+    addLoader("Page Text Locales", [] { sObjectMgr->LoadPageTextLocales(); }, {});
+    addLoader("Gossip Menu Option Locales", [] { sObjectMgr->LoadGossipMenuItemsLocales(); }, {});
+    addLoader("Point of Interest Locales", [] { sObjectMgr->LoadPointOfInterestLocales(); }, {});
+
+    // Spell ranks write SpellInfo::ChainEntry, everything looking at spells goes after it
+    auto const spellRanks = addLoader("Spell Rank Data", [] { sSpellMgr->LoadSpellRanks(); }, {});
+
+    auto const pageTexts = addLoader("Page Texts", [] { sObjectMgr->LoadPageTexts(); }, {});
+    addLoader("Game Object Templates", [] { sObjectMgr->LoadGameObjectTemplate(); }, { pageTexts, spellRanks });
+
+    addLoader("Spell Required Data", [] { sSpellMgr->LoadSpellRequired(); }, { spellRanks });
+    auto const spellGroups = addLoader("Spell Group types", [] { sSpellMgr->LoadSpellGroups(); }, { spellRanks });
+    addLoader("Spell Learn Skills", [] { sSpellMgr->LoadSpellLearnSkills(); }, { spellRanks });
+    addLoader("Spell Learn Spells", [] { sSpellMgr->LoadSpellLearnSpells(); }, { spellRanks });
+    addLoader("Spell Proc Event conditions", [] { sSpellMgr->LoadSpellProcEvents(); }, { spellRanks });
+    addLoader("Spell Proc conditions and data", [] { sSpellMgr->LoadSpellProcs(); }, { spellRanks });
+    addLoader("Spell Bonus Data", [] { sSpellMgr->LoadSpellBonusess(); }, { spellRanks });
+    addLoader("Aggro Spells Definitions", [] { sSpellMgr->LoadSpellThreats(); }, { spellRanks });
+    addLoader("Spell Group Stack Rules", [] { sSpellMgr->LoadSpellGroupStackRules(); }, { spellGroups });
+    addLoader("Spell Phase Dbc Info", [] { sObjectMgr->LoadSpellPhaseInfo(); }, { spellRanks });
+    addLoader("Spell AreaTrigger templates", [] { sObjectMgr->LoadSpellAreaTriggerTemplates(); }, {});
+    addLoader("NPC Texts", [] { sObjectMgr->LoadGossipText(); }, {});
+    addLoader("Enchant Spells Proc datas", [] { sSpellMgr->LoadSpellEnchantProcData(); }, {});
+
+    auto const randomEnchantments = addLoader("Item Random Enchantments Table", [] { LoadRandomEnchantmentsTable(); }, {});
+    auto const disables = addLoader("Disables", [] { DisableMgr::LoadDisables(); }, { spellRanks });                    // must be before loading quests and items
+    auto const items = addLoader("Items", [] { sObjectMgr->LoadItemTemplates(); }, { randomEnchantments, pageTexts, disables });
+    auto const itemSpecialisations = addLoader("Items Specialisations", [] { sObjectMgr->LoadItemSpecialisation(); }, { items });
+    auto const itemAddons = addLoader("Item set names", [] { sObjectMgr->LoadItemTemplateAddon(); }, { itemSpecialisations });  // must be after LoadItemPrototypes
+    addLoader("Item Scripts", [] { sObjectMgr->LoadItemScriptNames(); }, { itemAddons });                                       // must be after LoadItemPrototypes
+
+    auto const creatureModels = addLoader("Creature Model Based Info Data", [] { sObjectMgr->LoadCreatureModelInfo(); }, {});
+    auto const equipments = addLoader("Equipment templates", [] { sObjectMgr->LoadEquipmentTemplates(); }, {});
+    auto const creatures = addLoader("Creature templates", [] { sObjectMgr->LoadCreatureTemplates(); }, { creatureModels, equipments, spellRanks });
+    addLoader("Creature template addons", [] { sObjectMgr->LoadCreatureTemplateAddons(); }, { creatures });
+    addLoader("Creature template currencies", [] { sObjectMgr->LoadCreatureTemplateCurrency(); }, { creatures });
+    addLoader("Creature Script Names", [] { sObjectMgr->LoadCreatureScriptNames(); }, {});
+    addLoader("Reputation Reward Rates", [] { sObjectMgr->LoadReputationRewardRate(); }, {});
+    addLoader("Creature Reputation OnKill Data", [] { sObjectMgr->LoadReputationOnKill(); }, { creatures });
+    addLoader("Reputation Spillover Data", [] { sObjectMgr->LoadReputationSpilloverTemplate(); }, {});
+    addLoader("Points Of Interest Data", [] { sObjectMgr->LoadPointsOfInterest(); }, {});
+    addLoader("Creature Base Stats", [] { sObjectMgr->LoadCreatureClassLevelStats(); }, { creatures });
+
+    loaders.run();
+    LogLoaderTimings(loaders);
 
     TC_LOG_INFO("server.loading", "Loading Creature Data...");
     sObjectMgr->LoadCreatures();
@@ -2937,6 +2954,7 @@ BanReturn World::BanCharacter(std::string const& name, std::string const& durati
     stmt->setString(3, reason);
     trans->Append(stmt);
 
+    sCharacterCache->InvalidateCharacter(guid, 0, trans);
     CharacterDatabase.CommitTransaction(trans);
 
     if (pBanned)
@@ -2972,6 +2990,8 @@ bool World::RemoveBanCharacter(std::string const& name)
     PreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_UPD_CHARACTER_BAN);
     stmt->setUInt32(0, guid);
     CharacterDatabase.Execute(stmt);
+
+    sCharacterCache->InvalidateCharacter(guid);
     return true;
 }
 
@@ -3167,8 +3187,7 @@ void World::UpdateRealmCharCount(uint32 accountId)
 {
     PreparedStatement* stmt = CharacterDatabase.GetPreparedStatement(CHAR_SEL_CHARACTER_COUNT);
     stmt->setUInt32(0, accountId);
-    PreparedQueryResultFuture result = CharacterDatabase.AsyncQuery(stmt);
-    m_realmCharCallbacks.insert(result);
+    CharacterDatabase.AsyncQuery(stmt, m_queryCallbacks, std::bind(&World::_UpdateRealmCharCount, this, std::placeholders::_1));
 }
 
 void World::_UpdateRealmCharCount(PreparedQueryResult resultCharCount)
@@ -3609,22 +3628,7 @@ uint64 World::getWorldState(uint32 index) const
 
 void World::ProcessQueryCallbacks()
 {
-    PreparedQueryResult result;
-
-    while (!m_realmCharCallbacks.is_empty())
-    {
-        ACE_Future<PreparedQueryResult> lResult;
-        ACE_Time_Value timeout = ACE_Time_Value::zero;
-        if (m_realmCharCallbacks.next_readable(lResult, &timeout) != 1)
-            break;
-
-        if (lResult.ready())
-        {
-            lResult.get(result);
-            _UpdateRealmCharCount(result);
-            lResult.cancel();
-        }
-    }
+    m_queryCallbacks->ProcessCallbacks();
 }
 
 void World::UpdatePhaseDefinitions()
@@ -3708,6 +3712,8 @@ void World::ProcessRealmTransfers()
 
 void World::InvalidatePlayerData(uint64 guid)
 {
+    sCharacterCache->InvalidateCharacter(GUID_LOPART(guid));
+
     ObjectGuid _guid = guid;
     WorldPacket data(SMSG_INVALIDATE_PLAYER, 8);
     data.WriteBitSeq<7, 2, 5, 1, 3, 0, 6, 4>(_guid);
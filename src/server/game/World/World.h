@@ -27,7 +27,7 @@
 #include "Timer.h"
 #include "SharedDefines.h"
 #include "MySQLPtrTypesFwd.h"
-#include "Callback.h"
+#include "QueryCallbackQueue.h"
 #include "Threading/LockedQueue.h"
 
 #include <ace/Singleton.h>
@@ -194,6 +194,7 @@ enum WorldBoolConfigs
 	CONFIG_APRIL_FOOLS_NO_FLYING,
 	CONFIG_APRIL_FOOLS_FFA,
 	CONFIG_APRIL_FOOLS_PERMA_DEATH,
+    CONFIG_ENABLE_MMAPS,
     BOOL_CONFIG_VALUE_COUNT
 };
 
@@ -217,6 +218,7 @@ enum WorldFloatConfigs
     CONFIG_STATS_LIMITS_CRIT,
     CONFIG_CHEAT_MOVING_TELEPORT_DISTANCE_DETECT,
     CONFIG_CHEAT_MOVING_MAX_SPEED_MULTIPLIER,
+    CONFIG_CREATURE_IDLE_UPDATE_NEAR_DISTANCE,
     FLOAT_CONFIG_VALUE_COUNT
 };
 
@@ -382,6 +384,14 @@ enum WorldIntConfigs
     CONFIG_SUMMONALERT_COUNT,
     CONFIG_RAID_FINDER_MODE,
     CONFIG_PERSONAL_LOOT_CHANCE,
+    CONFIG_CHARACTER_CACHE_ENUM_EXPIRE,
+    CONFIG_TERRAIN_PREFETCH_THREADS,
+    CONFIG_TERRAIN_PREFETCH_LOOKAHEAD,
+    CONFIG_MMAP_MAX_SEARCH_NODES,
+    CONFIG_MMAP_PATH_CACHE_SIZE,
+    CONFIG_MAP_QUERY_CACHE_SIZE,
+    CONFIG_CREATURE_IDLE_UPDATE_INTERVAL,
+    CONFIG_GRID_MEMORY_BUDGET,
     INT_CONFIG_VALUE_COUNT
 };
 
@@ -936,7 +946,7 @@ class World
         void ProcessRealmTransfers();
 
         void ProcessQueryCallbacks();
-        ACE_Future_Set<PreparedQueryResult> m_realmCharCallbacks;
+        QueryCallbackQueuePtr m_queryCallbacks;
 
         uint32 m_worldLoopCounter;
 
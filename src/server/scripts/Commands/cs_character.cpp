@@ -23,6 +23,7 @@ Category: commandscripts
 EndScriptData */
 
 #include "AccountMgr.h"
+#include "CharacterCache.h"
 #include "Chat.h"
 #include "ObjectMgr.h"
 #include "PlayerDump.h"
@@ -224,6 +225,8 @@ public:
         stmt->setUInt32(1, delInfo.accountId);
         stmt->setUInt32(2, delInfo.lowGuid);
         CharacterDatabase.Execute(stmt);
+
+        sCharacterCache->InvalidateCharacter(delInfo.lowGuid, delInfo.accountId);
     }
 
     static void HandleCharacterLevel(Player* player, uint64 playerGuid, uint32 oldLevel, uint32 newLevel, ChatHandler* handler)
@@ -251,6 +254,8 @@ public:
             stmt->setUInt8(0, uint8(newLevel));
             stmt->setUInt32(1, GUID_LOPART(playerGuid));
             CharacterDatabase.Execute(stmt);
+
+            sCharacterCache->InvalidateCharacter(GUID_LOPART(playerGuid));
         }
     }
 
@@ -383,6 +388,8 @@ public:
                 CharacterDatabase.Execute(stmt);
             }
 
+            sCharacterCache->InvalidateCharacter(GUID_LOPART(targetGuid));
+
             handler->PSendSysMessage(LANG_RENAME_PLAYER_WITH_NEW_NAME, playerOldName.c_str(), newName.c_str());
 
             if (WorldSession* session = handler->GetSession())
@@ -420,6 +427,8 @@ public:
                 stmt->setUInt16(0, uint16(AT_LOGIN_RENAME));
                 stmt->setUInt32(1, GUID_LOPART(targetGuid));
                 CharacterDatabase.Execute(stmt);
+
+                sCharacterCache->InvalidateCharacter(GUID_LOPART(targetGuid));
             }
         }
 
@@ -491,6 +500,8 @@ public:
         }
         CharacterDatabase.Execute(stmt);
 
+        sCharacterCache->InvalidateCharacter(GUID_LOPART(targetGuid));
+
         return true;
     }
 
@@ -519,6 +530,8 @@ public:
         }
         CharacterDatabase.Execute(stmt);
 
+        sCharacterCache->InvalidateCharacter(GUID_LOPART(targetGuid));
+
         return true;
     }
 
@@ -548,6 +561,8 @@ public:
         }
         CharacterDatabase.Execute(stmt);
 
+        sCharacterCache->InvalidateCharacter(GUID_LOPART(targetGuid));
+
         return true;
     }
 
@@ -36,7 +36,10 @@ EndScriptData */
 #include "LexicalCast.h"
 #include "ObjectVisitors.hpp"
 
+#include <atomic>
+#include <chrono>
 #include <fstream>
+#include <thread>
 
 class debug_commandscript : public CommandScript
 {
@@ -95,6 +98,9 @@ public:
             { "areatriggers",  SEC_ADMINISTRATOR, false, &HandleDebugAreaTriggersCommand,     "", NULL },
             { "los",           SEC_ADMINISTRATOR, false, &HandleDebugLoSCommand,              "", NULL },
             { "moveflags",     SEC_ADMINISTRATOR, false, &HandleDebugMoveflagsCommand,        "", NULL },
+            { "querycache",    SEC_ADMINISTRATOR, false, &HandleDebugQueryCacheCommand,       "", NULL },
+            { "gridchurn",     SEC_ADMINISTRATOR, false, &HandleDebugGridChurnCommand,        "", NULL },
+            { "lookupbench",   SEC_ADMINISTRATOR, true,  &HandleDebugLookupBenchCommand,      "", NULL },
             { NULL,            0,                                     false, NULL,                                "", NULL }
         };
         static ChatCommand commandTable[] =
@@ -1121,6 +1127,114 @@ public:
         return true;
     }
 
+    static bool HandleDebugQueryCacheCommand(ChatHandler* handler, char const* /*args*/)
+    {
+        Map* map = handler->GetSession()->GetPlayer()->GetMap();
+        MapQueryCache const& cache = map->GetQueryCache();
+        if (!cache.GetCapacity())
+        {
+            handler->SendSysMessage("Query cache is disabled.");
+            return true;
+        }
+
+        uint64 heightTotal = cache.GetHeightHits() + cache.GetHeightMisses();
+        uint64 losTotal = cache.GetLineOfSightHits() + cache.GetLineOfSightMisses();
+        handler->PSendSysMessage("Query cache of map %u (instance %u), %u slots:", map->GetId(), map->GetInstanceId(), cache.GetCapacity());
+        handler->PSendSysMessage("Height: " UI64FMTD " hits, " UI64FMTD " misses (%.1f%%)", cache.GetHeightHits(), cache.GetHeightMisses(),
+            heightTotal ? 100.0 * cache.GetHeightHits() / heightTotal : 0.0);
+        handler->PSendSysMessage("LoS: " UI64FMTD " hits, " UI64FMTD " misses (%.1f%%)", cache.GetLineOfSightHits(), cache.GetLineOfSightMisses(),
+            losTotal ? 100.0 * cache.GetLineOfSightHits() / losTotal : 0.0);
+        return true;
+    }
+
+    static bool HandleDebugGridChurnCommand(ChatHandler* handler, char const* /*args*/)
+    {
+        Map* map = handler->GetSession()->GetPlayer()->GetMap();
+        Map::GridChurnStats const& stats = map->GetGridChurnStats();
+
+        handler->PSendSysMessage("Grids of map %u (instance %u): %u loads, %u of them shortly after an unload, %u unloads, %u to stay within the memory budget",
+            map->GetId(), map->GetInstanceId(), stats.loads, stats.reloads, stats.unloads, stats.evictions);
+        if (map->GetGridMemoryBudget())
+            handler->PSendSysMessage("Estimated memory of the grid objects: %u KB of %u KB", uint32(map->GetGridMemoryUsage() / 1024), uint32(map->GetGridMemoryBudget() / 1024));
+        else
+            handler->PSendSysMessage("Estimated memory of the grid objects: %u KB, no budget", uint32(map->GetGridMemoryUsage() / 1024));
+        return true;
+    }
+
+    // .debug lookupbench [maxThreads] [lookupsPerThread]
+    // looks up the guids of all creatures in the world from 1, 2, 4 ... maxThreads
+    // threads at once, the way map threads do, and reports the lookup rate
+    static bool HandleDebugLookupBenchCommand(ChatHandler* handler, char const* args)
+    {
+        char* threadsStr = strtok((char*)args, " ");
+        char* lookupsStr = strtok(NULL, " ");
+
+        uint32 maxThreads = threadsStr ? uint32(atoi(threadsStr)) : 8;
+        uint32 lookups = lookupsStr ? uint32(atoi(lookupsStr)) : 1000000;
+        if (!maxThreads || maxThreads > 64 || !lookups)
+        {
+            handler->SendSysMessage(LANG_BAD_VALUE);
+            handler->SetSentErrorMessage(true);
+            return false;
+        }
+
+        std::vector<uint64> guids;
+        {
+            HashMapHolder<Creature>::ReadGuardType guard(HashMapHolder<Creature>::GetLock());
+            HashMapHolder<Creature>::MapType const& creatures = ObjectAccessor::GetCreatures();
+            guids.reserve(creatures.size());
+            for (HashMapHolder<Creature>::MapType::const_iterator itr = creatures.begin(); itr != creatures.end(); ++itr)
+                guids.push_back(itr->first);
+        }
+
+        if (guids.empty())
+        {
+            handler->SendSysMessage("No creatures in the world to look up.");
+            return true;
+        }
+
+        handler->PSendSysMessage("Looking up %u creature guids, %u lookups per thread:", uint32(guids.size()), lookups);
+
+        double singleRate = 0.0;
+        for (uint32 threadCount = 1; threadCount <= maxThreads; threadCount *= 2)
+        {
+            std::atomic<uint32> found(0);
+            std::vector<std::thread> threads;
+            threads.reserve(threadCount);
+
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            for (uint32 i = 0; i < threadCount; ++i)
+            {
+                threads.emplace_back([&guids, &found, lookups, i]()
+                {
+                    uint32 hits = 0;
+                    std::size_t index = (i * 7919) % guids.size();
+                    for (uint32 n = 0; n < lookups; ++n)
+                    {
+                        if (HashMapHolder<Creature>::Find(guids[index]))
+                            ++hits;
+                        if (++index == guids.size())
+                            index = 0;
+                    }
+                    found += hits;
+                });
+            }
+
+            for (std::thread& thread : threads)
+                thread.join();
+
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            double rate = seconds > 0.0 ? double(lookups) * threadCount / seconds : 0.0;
+            if (threadCount == 1)
+                singleRate = rate;
+
+            handler->PSendSysMessage("%u threads: %.0f lookups/s (%.2fx of 1 thread), %u found", threadCount, rate,
+                singleRate > 0.0 ? rate / singleRate : 0.0, found.load());
+        }
+
+        return true;
+    }
+
     static bool HandleDebugSetAuraStateCommand(ChatHandler* handler, char const* args)
     {
         if (!*args)
@@ -15,8 +15,12 @@
 #include <ace/Assert.h>
 #include <mysqld_error.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdarg>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace {
 
@@ -39,29 +43,27 @@ private:
 class AsyncQueryTask : public SQLOperation
 {
 public:
-    AsyncQueryTask(const char* sql, QueryResultFuture &result)
+    AsyncQueryTask(const char* sql, QueryCallbackQueuePtr const &queue, QueryResultCallback &&callback)
         : m_sql(sql)
-        , m_result(result)
+        , m_queue(queue)
+        , m_callback(std::move(callback))
     { }
 
 private:
     void executeImpl(MySQLConnection *conn)
     {
-        ResultSet *result = conn->Query(m_sql.c_str());
-        if (!result || !result->GetRowCount())
-        {
-            delete result;
-            m_result.set(QueryResult());
-        }
-        else
-        {
+        QueryResult result(conn->Query(m_sql.c_str()));
+        if (result && result->GetRowCount())
             result->NextRow();
-            m_result.set(QueryResult(result));
-        }
+        else
+            result.reset();
+
+        m_queue->Post(std::bind(std::move(m_callback), std::move(result)));
     }
 
     std::string m_sql;
-    QueryResultFuture m_result;
+    QueryCallbackQueuePtr m_queue;
+    QueryResultCallback m_callback;
 };
 
 class DirectPreparedStatementTask : public SQLOperation
@@ -85,9 +87,10 @@ private:
 class AsyncPreparedStatementTask : public SQLOperation
 {
 public:
-    AsyncPreparedStatementTask(PreparedStatement *data, PreparedQueryResultFuture result)
+    AsyncPreparedStatementTask(PreparedStatement *data, QueryCallbackQueuePtr const &queue, PreparedQueryResultCallback &&callback)
         : m_data(data)
-        , m_result(result)
+        , m_queue(queue)
+        , m_callback(std::move(callback))
     { }
 
     ~AsyncPreparedStatementTask() { delete m_data; }
@@ -95,34 +98,50 @@ public:
 private:
     void executeImpl(MySQLConnection *conn)
     {
-        PreparedResultSet *result = conn->Query(m_data);
-        if (!result || !result->GetRowCount())
-            m_result.set(PreparedQueryResult());
-        else
-            m_result.set(PreparedQueryResult(result));
+        PreparedQueryResult result(conn->Query(m_data));
+        if (result && !result->GetRowCount())
+            result.reset();
+
+        m_queue->Post(std::bind(std::move(m_callback), std::move(result)));
     }
 
     PreparedStatement *m_data;
-    PreparedQueryResultFuture m_result;
+    QueryCallbackQueuePtr m_queue;
+    PreparedQueryResultCallback m_callback;
 };
 
 class SQLQueryHolderTask : public SQLOperation
 {
 public:
-    SQLQueryHolderTask(SQLQueryHolder *holder, QueryResultHolderFuture res)
+    typedef std::shared_ptr<std::atomic<std::size_t>> PendingCounter;
+
+    SQLQueryHolderTask(SQLQueryHolder *holder, QueryCallbackQueuePtr const &queue, QueryResultHolderCallback const &callback,
+                       std::size_t begin, std::size_t end, PendingCounter pending)
         : m_holder(holder)
-        , m_result(res)
+        , m_queue(queue)
+        , m_callback(callback)
+        , m_begin(begin)
+        , m_end(end)
+        , m_pending(pending)
     { }
 
 private:
     void executeImpl(MySQLConnection *conn)
     {
-        m_holder->executeAll(conn);
-        m_result.set(m_holder);
+        m_holder->executeRange(conn, m_begin, m_end);
+
+        // Last part to finish publishes the holder, results of the other
+        // parts are visible through the acq_rel decrement
+        if (m_pending->fetch_sub(1, std::memory_order_acq_rel) == 1)
+            m_queue->Post(std::bind(std::move(m_callback), m_holder));
     }
 
     SQLQueryHolder *m_holder;
-    QueryResultHolderFuture m_result;
+    QueryCallbackQueuePtr m_queue;
+    QueryResultHolderCallback m_callback;
+    std::size_t m_begin;
+    std::size_t m_end;
+    PendingCounter m_pending;
 };
 
 class TransactionTask : public SQLOperation
@@ -165,6 +184,7 @@ private:
 DatabaseWorkerPool::DatabaseWorkerPool()
     : m_tssConn(new DbConnectionTSS)
     , m_asyncWorker(NULL)
+    , m_asyncThreads(0)
 {
     ACE_ASSERT(MySQLHelper::libraryThreadSafe());
 }
@@ -173,6 +193,7 @@ bool DatabaseWorkerPool::Open(std::string const &infoString, uint8 numThreads, M
 {
     m_connectionInfo = MySQLConnectionInfo(infoString);
     m_initHookFnPtr = initHookFnPtr;
+    m_asyncThreads = numThreads;
     m_asyncWorker = new DatabaseWorker(m_connectionInfo, numThreads, m_initHookFnPtr);
     TC_LOG_INFO("sql.sql", "Opening databasepool '%s'. %u async connections running.", m_connectionInfo.database.c_str(), numThreads);
     return true;
@@ -276,36 +297,44 @@ PreparedQueryResult DatabaseWorkerPool::Query(PreparedStatement *data)
     return PreparedQueryResult(ret);
 }
 
-QueryResultFuture DatabaseWorkerPool::AsyncQuery(char const *sql)
+PreparedQueryResult DatabaseWorkerPool::StreamQuery(char const *sql)
 {
-    QueryResultFuture res;
-    Enqueue(new AsyncQueryTask(sql, res));
-    return res;         //! Actual return value has no use yet
+    PreparedResultSet *ret = GetConnection()->StreamQuery(sql);
+    if (!ret || !ret->GetRowCount())
+    {
+        delete ret;
+        return PreparedQueryResult();
+    }
+
+    return PreparedQueryResult(ret);
 }
 
-QueryResultFuture DatabaseWorkerPool::AsyncPQuery(char const *sql, ...)
+void DatabaseWorkerPool::AsyncQuery(char const *sql, QueryCallbackQueuePtr const &queue, QueryResultCallback callback)
 {
-    std::va_list ap;
-    char szQuery[MAX_QUERY_LEN];
-    va_start(ap, sql);
-    vsnprintf(szQuery, MAX_QUERY_LEN, sql, ap);
-    va_end(ap);
-
-    return AsyncQuery(szQuery);
+    Enqueue(new AsyncQueryTask(sql, queue, std::move(callback)));
 }
 
-PreparedQueryResultFuture DatabaseWorkerPool::AsyncQuery(PreparedStatement *data)
+void DatabaseWorkerPool::AsyncQuery(PreparedStatement *data, QueryCallbackQueuePtr const &queue, PreparedQueryResultCallback callback)
 {
-    PreparedQueryResultFuture res;
-    Enqueue(new AsyncPreparedStatementTask(data, res));
-    return res;
+    Enqueue(new AsyncPreparedStatementTask(data, queue, std::move(callback)));
 }
 
-QueryResultHolderFuture DatabaseWorkerPool::DelayQueryHolder(SQLQueryHolder *holder)
+void DatabaseWorkerPool::DelayQueryHolder(SQLQueryHolder *holder, QueryCallbackQueuePtr const &queue, QueryResultHolderCallback callback)
 {
-    QueryResultHolderFuture res;
-    Enqueue(new SQLQueryHolderTask(holder, res));
-    return res;
+
+    // Split the holder into contiguous parts, one per async connection, so that
+    // independent queries run in parallel instead of back to back on a single connection
+    std::size_t const size = holder->GetSize();
+    std::size_t const parts = std::max<std::size_t>(1, std::min<std::size_t>(m_asyncThreads, size));
+    std::size_t const partSize = (size + parts - 1) / parts;
+
+    std::vector<std::pair<std::size_t, std::size_t>> ranges;
+    for (std::size_t begin = 0; begin < size || ranges.empty(); begin += partSize)
+        ranges.emplace_back(begin, std::min(begin + partSize, size));
+
+    auto const pending = std::make_shared<std::atomic<std::size_t>>(ranges.size());
+    for (auto const &range : ranges)
+        Enqueue(new SQLQueryHolderTask(holder, queue, callback, range.first, range.second, pending));
 }
 
 SQLTransaction DatabaseWorkerPool::BeginTransaction()
@@ -22,16 +22,17 @@
 #include "MySQLFwd.h"
 #include "MySQLPtrTypesFwd.h"
 #include "MySQLConnectionInfo.h"
+#include "QueryCallbackQueue.h"
 
-#include <ace/Future.h>
 #include <ace/TSS_T.h>
 
+#include <functional>
 #include <memory>
 #include <string>
 
-typedef ACE_Future<QueryResult> QueryResultFuture;
-typedef ACE_Future<PreparedQueryResult> PreparedQueryResultFuture;
-typedef ACE_Future<SQLQueryHolder *> QueryResultHolderFuture;
+typedef std::function<void(QueryResult)> QueryResultCallback;
+typedef std::function<void(PreparedQueryResult)> PreparedQueryResultCallback;
+typedef std::function<void(SQLQueryHolder *)> QueryResultHolderCallback;
 
 class DatabaseWorkerPool
 {
@@ -85,26 +86,27 @@ public:
     //! Returns reference counted auto pointer, no need for manual memory management in upper level code.
     PreparedQueryResult Query(PreparedStatement *data);
 
+    //! Directly executes an SQL query in string format through the binary protocol, rows are fetched from a
+    //! server side cursor in chunks while iterating the result instead of being held in memory at once.
+    //! Meant for large loads, the total row count is not known up front.
+    PreparedQueryResult StreamQuery(char const *sql);
+
     /**
       * Asynchronous query (with resultset) methods.
       */
 
-    //! Enqueues a query in string format that will set the value of the QueryResultFuture return object as soon as the query is executed.
-    //! The return value is then processed in ProcessQueryCallback methods.
-    QueryResultFuture AsyncQuery(char const *sql);
-
-    //! Enqueues a query in string format -with variable args- that will set the value of the QueryResultFuture return object as soon as the query is executed.
-    //! The return value is then processed in ProcessQueryCallback methods.
-    QueryResultFuture AsyncPQuery(char const *sql, ...);
+    //! Enqueues a query in string format. As soon as the query is executed, the callback is posted
+    //! with its result to the completion queue, which is drained by the owner of the queue.
+    void AsyncQuery(char const *sql, QueryCallbackQueuePtr const &queue, QueryResultCallback callback);
 
-    //! Enqueues a query in prepared format that will set the value of the PreparedQueryResultFuture return object as soon as the query is executed.
-    //! The return value is then processed in ProcessQueryCallback methods.
-    PreparedQueryResultFuture AsyncQuery(PreparedStatement *data);
+    //! Enqueues a query in prepared format. As soon as the query is executed, the callback is posted
+    //! with its result to the completion queue, which is drained by the owner of the queue.
+    void AsyncQuery(PreparedStatement *data, QueryCallbackQueuePtr const &queue, PreparedQueryResultCallback callback);
 
-    //! Enqueues a vector of SQL operations (can be both adhoc and prepared) that will set the value of the QueryResultHolderFuture
-    //! return object as soon as the query is executed.
-    //! The return value is then processed in ProcessQueryCallback methods.
-    QueryResultHolderFuture DelayQueryHolder(SQLQueryHolder *holder);
+    //! Enqueues a vector of SQL operations (can be both adhoc and prepared). As soon as all the queries
+    //! are executed, the callback is posted with the holder to the completion queue. The holder is split
+    //! across the async connections, so queries in the same holder must not depend on each other.
+    void DelayQueryHolder(SQLQueryHolder *holder, QueryCallbackQueuePtr const &queue, QueryResultHolderCallback callback);
 
     /**
       * Transaction context methods.
@@ -150,6 +152,7 @@ private:
 
     DbConnectionTSS *m_tssConn;           //! Holds a mysql connection per thread.
     DatabaseWorker *m_asyncWorker;        //! Async connection pool.
+    uint8 m_asyncThreads;                 //! Number of connections in the async pool.
 };
 
 #endif
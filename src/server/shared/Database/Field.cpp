@@ -25,27 +25,71 @@
 #include <mysql.h>
 
 #include <cstring>
+#include <type_traits>
 
 namespace {
 
 template <typename T>
-T signed_field_cast(char const *value, bool raw)
+T text_field_cast(char const *value)
 {
-    if (value == NULL)
-        return T(0);
-    return raw
-            ? *reinterpret_cast<T const *>(value)
-            : static_cast<T>(ACE_OS::strtoll(value, NULL, 10));
+    return std::is_floating_point<T>::value
+            ? static_cast<T>(ACE_OS::strtod(value, NULL))
+            : std::is_signed<T>::value
+                ? static_cast<T>(ACE_OS::strtoll(value, NULL, 10))
+                : static_cast<T>(ACE_OS::strtoull(value, NULL, 10));
+}
+
+// Binary protocol values are converted according to their column type, so
+// getters do not have to match the exact column width and signedness
+template <typename T>
+T raw_field_cast(char const *value, int32 type, bool isUnsigned)
+{
+    switch (enum_field_types(type))
+    {
+        case MYSQL_TYPE_TINY:
+            return isUnsigned
+                    ? static_cast<T>(*reinterpret_cast<uint8 const *>(value))
+                    : static_cast<T>(*reinterpret_cast<int8 const *>(value));
+        case MYSQL_TYPE_YEAR:
+        case MYSQL_TYPE_SHORT:
+            return isUnsigned
+                    ? static_cast<T>(*reinterpret_cast<uint16 const *>(value))
+                    : static_cast<T>(*reinterpret_cast<int16 const *>(value));
+        case MYSQL_TYPE_INT24:
+        case MYSQL_TYPE_LONG:
+            return isUnsigned
+                    ? static_cast<T>(*reinterpret_cast<uint32 const *>(value))
+                    : static_cast<T>(*reinterpret_cast<int32 const *>(value));
+        case MYSQL_TYPE_LONGLONG:
+            return isUnsigned
+                    ? static_cast<T>(*reinterpret_cast<uint64 const *>(value))
+                    : static_cast<T>(*reinterpret_cast<int64 const *>(value));
+        case MYSQL_TYPE_FLOAT:
+            return static_cast<T>(*reinterpret_cast<float const *>(value));
+        case MYSQL_TYPE_DOUBLE:
+            return static_cast<T>(*reinterpret_cast<double const *>(value));
+        case MYSQL_TYPE_DECIMAL:
+        case MYSQL_TYPE_NEWDECIMAL:
+        case MYSQL_TYPE_TINY_BLOB:
+        case MYSQL_TYPE_MEDIUM_BLOB:
+        case MYSQL_TYPE_LONG_BLOB:
+        case MYSQL_TYPE_BLOB:
+        case MYSQL_TYPE_STRING:
+        case MYSQL_TYPE_VAR_STRING:
+            return text_field_cast<T>(value);
+        default:
+            return *reinterpret_cast<T const *>(value);
+    }
 }
 
 template <typename T>
-T unsigned_field_cast(char const *value, bool raw)
+T field_cast(char const *value, bool raw, int32 type, bool isUnsigned)
 {
     if (value == NULL)
         return T(0);
     return raw
-            ? *reinterpret_cast<T const *>(value)
-            : static_cast<T>(ACE_OS::strtoull(value, NULL, 10));
+            ? raw_field_cast<T>(value, type, isUnsigned)
+            : text_field_cast<T>(value);
 }
 
 } // namespace
@@ -59,7 +103,7 @@ Field::~Field()
     CleanUp();
 }
 
-void Field::SetByteValue(char const* newValue, size_t newSize, int32 newType)
+void Field::SetByteValue(char const* newValue, size_t newSize, int32 newType, bool isUnsigned)
 {
     if (m_data.value)
         CleanUp();
@@ -86,10 +130,12 @@ void Field::SetByteValue(char const* newValue, size_t newSize, int32 newType)
 
         std::memcpy(m_data.value, newValue, newSize);
         m_data.size = newSize;
+        m_data.owned = true;
     }
 
     m_data.type = newType;
     m_data.raw = true;
+    m_data.isUnsigned = isUnsigned;
 }
 
 void Field::SetStructuredValue(char const *newValue, size_t newSize, int32 newType)
@@ -103,68 +149,74 @@ void Field::SetStructuredValue(char const *newValue, size_t newSize, int32 newTy
         m_data.size = newSize;
         m_data.value = new char[m_data.size + 1];
         std::memcpy(m_data.value, newValue, m_data.size + 1);
+        m_data.owned = true;
     }
 
     m_data.type = newType;
     m_data.raw = false;
 }
 
+void Field::SetBufferValue(char const *buffer, size_t size, int32 type, bool isUnsigned)
+{
+    if (m_data.value)
+        CleanUp();
+
+    m_data.value = const_cast<char *>(buffer);
+    m_data.size = size;
+    m_data.type = type;
+    m_data.raw = true;
+    m_data.isUnsigned = isUnsigned;
+    m_data.owned = false;
+}
+
 uint8 Field::GetUInt8() const
 {
-    return unsigned_field_cast<uint8>(m_data.value, m_data.raw);
+    return field_cast<uint8>(m_data.value, m_data.raw, m_data.type, m_data.isUnsigned);
 }
 
 int8 Field::GetInt8() const
 {
-    return signed_field_cast<int8>(m_data.value, m_data.raw);
+    return field_cast<int8>(m_data.value, m_data.raw, m_data.type, m_data.isUnsigned);
 }
 
 uint16 Field::GetUInt16() const
 {
-    return unsigned_field_cast<uint16>(m_data.value, m_data.raw);
+    return field_cast<uint16>(m_data.value, m_data.raw, m_data.type, m_data.isUnsigned);
 }
 
 int16 Field::GetInt16() const
 {
-    return signed_field_cast<int16>(m_data.value, m_data.raw);
+    return field_cast<int16>(m_data.value, m_data.raw, m_data.type, m_data.isUnsigned);
 }
 
 uint32 Field::GetUInt32() const
 {
-    return unsigned_field_cast<uint32>(m_data.value, m_data.raw);
+    return field_cast<uint32>(m_data.value, m_data.raw, m_data.type, m_data.isUnsigned);
 }
 
 int32 Field::GetInt32() const
 {
-    return signed_field_cast<int32>(m_data.value, m_data.raw);
+    return field_cast<int32>(m_data.value, m_data.raw, m_data.type, m_data.isUnsigned);
 }
 
 uint64 Field::GetUInt64() const
 {
-    return unsigned_field_cast<uint64>(m_data.value, m_data.raw);
+    return field_cast<uint64>(m_data.value, m_data.raw, m_data.type, m_data.isUnsigned);
 }
 
 int64 Field::GetInt64() const
 {
-    return signed_field_cast<int64>(m_data.value, m_data.raw);
+    return field_cast<int64>(m_data.value, m_data.raw, m_data.type, m_data.isUnsigned);
 }
 
 double Field::GetDouble() const
 {
-    if (m_data.value == NULL)
-        return 0.0;
-    return m_data.raw
-            ? *reinterpret_cast<double const *>(m_data.value)
-            : static_cast<double>(ACE_OS::strtod(m_data.value, NULL));
+    return field_cast<double>(m_data.value, m_data.raw, m_data.type, m_data.isUnsigned);
 }
 
 float Field::GetFloat() const
 {
-    if (m_data.value == NULL)
-        return 0.0f;
-    return m_data.raw
-            ? *reinterpret_cast<float const *>(m_data.value)
-            : static_cast<float>(ACE_OS::strtod(m_data.value, NULL));
+    return field_cast<float>(m_data.value, m_data.raw, m_data.type, m_data.isUnsigned);
 }
 
 std::string Field::GetString() const
@@ -176,6 +228,7 @@ std::string Field::GetString() const
 
 void Field::CleanUp()
 {
-    delete[] m_data.value;
+    if (m_data.owned)
+        delete[] m_data.value;
     m_data.value = NULL;
 }
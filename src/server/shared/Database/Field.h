@@ -31,15 +31,21 @@ class Field
         int32 type;             // Field type
         char *value;            // Actual data in memory
         uint8 raw;              // Raw bytes? (Prepared statement or ad hoc)
+        bool isUnsigned;        // Raw integer type is unsigned
+        bool owned;             // Value is owned, false for buffers of a streamed result set
     };
 
 public:
     Field();
     ~Field();
 
-    void SetByteValue(char const *newValue, size_t newSize, int32 newType);
+    void SetByteValue(char const *newValue, size_t newSize, int32 newType, bool isUnsigned = false);
     void SetStructuredValue(char const *newValue, size_t newSize, int32 newType);
 
+    //! Points the field to raw bytes owned by the result set, valid until it fetches the next row.
+    //! String types must be null terminated.
+    void SetBufferValue(char const *buffer, size_t size, int32 type, bool isUnsigned);
+
     bool IsNull() const { return m_data.value == NULL; }
 
     bool GetBool() const { return GetUInt8() == 1; }
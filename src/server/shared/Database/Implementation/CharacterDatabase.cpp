@@ -46,7 +46,7 @@ void DoPrepareStatements(MySQLConnection &conn)
                      "SUBJECT, deliver_time, expire_time, money, has_items FROM mail WHERE receiver = ? ");
     conn.prepareStatement(CHAR_SEL_MAIL_LIST_ITEMS, "SELECT itemEntry,count FROM item_instance WHERE guid = ?");
     conn.prepareStatement(CHAR_SEL_ENUM, "SELECT c.guid, c.name, c.race, c.class, c.gender, c.playerBytes, c.playerBytes2, c.level, c.zone, c.map, c.position_x, c.position_y, c.position_z, "
-                          "gm.guildid, c.playerFlags, c.at_login, p.entry, p.model_id, p.level, c.equipmentCache, cb.guid, c.slot "
+                          "gm.guildid, c.playerFlags, c.at_login, p.entry, p.model_id, p.level, c.equipmentCache, cb.guid, c.slot, cb.bandate, cb.unbandate "
                           "FROM characters AS c "
                           "LEFT JOIN character_pet AS cp ON c.guid = cp.guid "
                           "LEFT JOIN pet_info AS p ON cp.pet_id = p.id "
@@ -55,7 +55,7 @@ void DoPrepareStatements(MySQLConnection &conn)
                           "WHERE c.account = ? AND c.deleteInfos_Name IS NULL AND (at_login & 512) <> 512");
     conn.prepareStatement(CHAR_SEL_ENUM_DECLINED_NAME, "SELECT c.guid, c.name, c.race, c.class, c.gender, c.playerBytes, c.playerBytes2, c.level, c.zone, c.map, "
                           "c.position_x, c.position_y, c.position_z, gm.guildid, c.playerFlags, c.at_login, p.entry, p.model_id, p.level, c.equipmentCache, "
-                          "cb.guid, c.slot, cd.genitive "
+                          "cb.guid, c.slot, cb.bandate, cb.unbandate, cd.genitive "
                           "FROM characters AS c "
                           "LEFT JOIN character_pet AS cp ON c.guid = cp.guid "
                           "LEFT JOIN pet_info AS p ON cp.pet_id = p.id "
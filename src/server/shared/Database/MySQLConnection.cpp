@@ -36,6 +36,7 @@
 #include <errmsg.h>
 
 #include <cstdlib>
+#include <cstring>
 #include <list>
 
 MySQLConnection::MySQLConnection()
@@ -189,6 +190,45 @@ PreparedResultSet * MySQLConnection::Query(PreparedStatement *data)
     return stmt ? new PreparedResultSet(stmt) : NULL;
 }
 
+PreparedResultSet * MySQLConnection::StreamQuery(char const *sql)
+{
+    //! Number of rows transferred by each fetch from the server side cursor
+    unsigned long const prefetchRows = 4096;
+    unsigned long const cursorType = CURSOR_TYPE_READ_ONLY;
+
+    TC_LOG_TRACE("sql.sql", "%s", sql);
+
+    MYSQL_STMT * const stmt = mysql_stmt_init(m_handle);
+    if (!stmt)
+    {
+        TC_LOG_ERROR("sql.sql", "SQL(s): %s\n [ERROR]: %s", sql, mysql_error(m_handle));
+        setLastError(mysql_errno(m_handle));
+        return NULL;
+    }
+
+    if (mysql_stmt_prepare(stmt, sql, std::strlen(sql)) != 0
+            || mysql_stmt_attr_set(stmt, STMT_ATTR_CURSOR_TYPE, &cursorType) != 0
+            || mysql_stmt_attr_set(stmt, STMT_ATTR_PREFETCH_ROWS, &prefetchRows) != 0
+            || mysql_stmt_execute(stmt) != 0)
+    {
+        uint32 const errnum = mysql_stmt_errno(stmt);
+
+        TC_LOG_ERROR("sql.sql", "SQL(s): %s\n [ERROR]: [%u] %s", sql, errnum, mysql_stmt_error(stmt));
+        mysql_stmt_close(stmt);
+
+        // If it returns true, an error was handled successfully (i.e. reconnection)
+        // and we try again
+        if (_HandleMySQLErrno(errnum))
+            return StreamQuery(sql);
+
+        setLastError(errnum);
+        return NULL;
+    }
+
+    setLastError(0);
+    return new PreparedResultSet(stmt, true);
+}
+
 MYSQL_RES * MySQLConnection::_Query(char const *sql)
 {
     TC_LOG_TRACE("sql.sql", "%s", sql);
@@ -43,6 +43,10 @@ public:
     ResultSet * Query(const char* sql);
     PreparedResultSet * Query(PreparedStatement *data);
 
+    //! Executes an ad hoc query through the binary protocol with a read-only cursor,
+    //! the returned result set fetches the rows in chunks while it is iterated.
+    PreparedResultSet * StreamQuery(char const *sql);
+
     void BeginTransaction();
     void RollbackTransaction();
     void CommitTransaction();
@@ -3,6 +3,7 @@
 #include "Log.h"
 
 #include <ace/Assert.h>
+#include <algorithm>
 #ifdef _WIN32
 #  include <winsock2.h>
 #endif
@@ -12,8 +13,8 @@ namespace {
 
 typedef std::vector<MYSQL_BIND> BindStorageType;
 
-void cleanupBindBuffersHelper(BindStorageType::iterator begin,
-                              BindStorageType::iterator end)
+template <typename Iterator>
+void cleanupBindBuffersHelper(Iterator begin, Iterator end)
 {
     for (; begin != end; ++begin)
     {
@@ -82,14 +83,19 @@ std::size_t SizeForType(enum_field_types type)
 
 } // namespace
 
-PreparedResultSet::PreparedResultSet(MYSQL_STMT *stmt)
+PreparedResultSet::PreparedResultSet(MYSQL_STMT *stmt, bool stream)
     : m_rowPosition(0)
     , m_fieldCount(mysql_stmt_field_count(stmt))
+    , m_stmt(NULL)
+    , m_bind(NULL)
+    , m_streamedRows(0)
 {
     MYSQL_RES * const metadata = mysql_stmt_result_metadata(stmt);
     if (!metadata)
     {
         TC_LOG_ERROR("sql.sql", "PreparedResultSet: mysql_stmt_result_metadata failed. Error: %s", mysql_stmt_error(stmt));
+        if (stream)
+            mysql_stmt_close(stmt);
         return;
     }
 
@@ -103,6 +109,7 @@ PreparedResultSet::PreparedResultSet(MYSQL_STMT *stmt)
         {
             bindDataPtr->buffer_type = field->type;
             bindDataPtr->is_null = new my_bool;
+            bindDataPtr->is_unsigned = (field->flags & UNSIGNED_FLAG) != 0;
 
             if ((bindDataPtr->buffer_length = SizeForType(field->type)))
                 bindDataPtr->buffer = new char[bindDataPtr->buffer_length];
@@ -115,6 +122,20 @@ PreparedResultSet::PreparedResultSet(MYSQL_STMT *stmt)
 
     mysql_free_result(metadata);
 
+    if (stream)
+    {
+        m_stmt = stmt;
+        m_bind = new MYSQL_BIND[m_fieldCount];
+        std::copy(bindData.begin(), bindData.end(), m_bind);
+        m_rows.push_back(new Field[m_fieldCount]);
+
+        //- Rows are fetched through the cursor on demand, only the first one is read here
+        if (mysql_stmt_bind_result(stmt, m_bind) == 0)
+            FetchStreamRow();
+
+        return;
+    }
+
     //- This is where we bind the buffer to the statement
     if (mysql_stmt_bind_result(stmt, &bindData[0]) == 0
             && mysql_stmt_store_result(stmt) == 0)
@@ -149,7 +170,7 @@ PreparedResultSet::PreparedResultSet(MYSQL_STMT *stmt)
                         ? static_cast<char const *>(bind.buffer)
                         : NULL;
 
-                rowPtr[i].SetByteValue(exactBuffer, bind.buffer_length, bind.buffer_type);
+                rowPtr[i].SetByteValue(exactBuffer, bind.buffer_length, bind.buffer_type, bind.is_unsigned);
             }
 
             m_rows.push_back(rowPtr);
@@ -164,15 +185,68 @@ PreparedResultSet::~PreparedResultSet()
 {
     for (StorageType::const_iterator i = m_rows.begin(); i != m_rows.end(); ++i)
         delete[] (*i);
+
+    if (m_stmt)
+    {
+        cleanupBindBuffersHelper(m_bind, m_bind + m_fieldCount);
+        delete[] m_bind;
+
+        mysql_stmt_free_result(m_stmt);
+        mysql_stmt_close(m_stmt);
+    }
 }
 
 bool PreparedResultSet::NextRow()
 {
+    if (m_stmt)
+        return FetchStreamRow();
+
     /// Only updates the m_rowPosition so upper level code knows in which element
     /// of the rows vector to look
     return (++m_rowPosition < GetRowCount());
 }
 
+bool PreparedResultSet::FetchStreamRow()
+{
+    if (!nextRowFetchHelper(m_stmt))
+        return false;
+
+    Field * const row = m_rows[0];
+
+    for (std::size_t i = 0; i < m_fieldCount; ++i)
+    {
+        MYSQL_BIND &bind = m_bind[i];
+        std::size_t size = bind.buffer_length;
+
+        //- Variable length columns are fetched into a buffer kept across rows,
+        //- grown when needed and null terminated for GetCString
+        if (*bind.is_null == 0 && bind.length)
+        {
+            size = *bind.length;
+            if (size + 1 > bind.buffer_length)
+            {
+                delete[] static_cast<char *>(bind.buffer);
+                bind.buffer_length = size + 1;
+                bind.buffer = new char[bind.buffer_length];
+            }
+
+            if (size != 0)
+                mysql_stmt_fetch_column(m_stmt, &bind, i, 0);
+
+            static_cast<char *>(bind.buffer)[size] = '\0';
+        }
+
+        char const *exactBuffer = (*bind.is_null == 0)
+                ? static_cast<char const *>(bind.buffer)
+                : NULL;
+
+        row[i].SetBufferValue(exactBuffer, size, bind.buffer_type, bind.is_unsigned);
+    }
+
+    ++m_streamedRows;
+    return true;
+}
+
 Field const & PreparedResultSet::operator [] (std::size_t index) const
 {
     return m_rows[m_rowPosition][index];
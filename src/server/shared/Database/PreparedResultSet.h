@@ -11,12 +11,17 @@ class PreparedResultSet
     typedef std::vector<Field *> StorageType;
 
 public:
-    PreparedResultSet(MYSQL_STMT* stmt);
+    //! Materializes all rows of the statement result.
+    //! In streaming mode the result set takes ownership of a statement executed with
+    //! a read-only cursor and fetches its rows in chunks while iterating, the fields
+    //! of the current row point to the bind buffers instead of holding copies.
+    PreparedResultSet(MYSQL_STMT* stmt, bool stream = false);
     ~PreparedResultSet();
 
     bool NextRow();
 
-    std::size_t GetRowCount() const { return m_rows.size(); }
+    //! In streaming mode the total is unknown, returns the number of rows fetched so far
+    std::size_t GetRowCount() const { return m_stmt ? m_streamedRows : m_rows.size(); }
     std::size_t GetFieldCount() const { return m_fieldCount; }
 
     Field * Fetch() const
@@ -27,9 +32,15 @@ public:
     Field const & operator [] (std::size_t index) const;
 
 private:
+    bool FetchStreamRow();
+
     std::size_t m_rowPosition;
     StorageType m_rows;
     std::size_t m_fieldCount;
+
+    MYSQL_STMT *m_stmt;             //! Streamed statement, NULL for materialized results
+    MYSQL_BIND *m_bind;
+    std::size_t m_streamedRows;
 };
 
 #endif // PREPAREDRESULTSET_H
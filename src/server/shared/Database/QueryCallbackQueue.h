@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef QUERYCALLBACKQUEUE_H
+#define QUERYCALLBACKQUEUE_H
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//! Completion queue of asynchronous database requests.
+//! Database workers post the continuation of a finished request together with
+//! its result, the owner drains the queue once per update from its own thread
+//! and runs the continuations in completion order.
+class QueryCallbackQueue final
+{
+public:
+    typedef std::function<void()> Callback;
+
+    void Post(Callback callback)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_callbacks.push_back(std::move(callback));
+    }
+
+    //! Runs all continuations posted so far. Continuations posted while
+    //! draining (e.g. by chained requests) are run on the next call.
+    void ProcessCallbacks()
+    {
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            if (m_callbacks.empty())
+                return;
+
+            m_processing.swap(m_callbacks);
+        }
+
+        for (auto &callback : m_processing)
+            callback();
+
+        m_processing.clear();
+    }
+
+private:
+    std::mutex m_lock;
+    std::vector<Callback> m_callbacks;
+    std::vector<Callback> m_processing;     //! only accessed by the owner
+};
+
+//! Shared with the pending requests, so that the owner can go away before they finish
+typedef std::shared_ptr<QueryCallbackQueue> QueryCallbackQueuePtr;
+
+#endif // QUERYCALLBACKQUEUE_H
@@ -129,9 +129,16 @@ SQLQueryHolder::~SQLQueryHolder()
 
 void SQLQueryHolder::executeAll(MySQLConnection *conn)
 {
-    for (StorageType::iterator i = m_queries.begin(); i != m_queries.end(); ++i)
+    executeRange(conn, 0, m_queries.size());
+}
+
+void SQLQueryHolder::executeRange(MySQLConnection *conn, std::size_t begin, std::size_t end)
+{
+    ACE_ASSERT(begin <= end && end <= m_queries.size());
+
+    for (StorageType::iterator i = m_queries.begin() + begin; i != m_queries.begin() + end; ++i)
     {
-        // execute all queries in the holder and pass the results
+        // execute all queries in the range and pass the results
         SQLElementData const &data = (*i).first;
         switch (data.type)
         {
@@ -39,11 +39,16 @@ public:
 
     void executeAll(MySQLConnection *conn);
 
+    //! Executes the queries in [begin, end) only. Disjoint ranges of the same holder
+    //! may be executed concurrently on different connections.
+    void executeRange(MySQLConnection *conn, std::size_t begin, std::size_t end);
+
     bool SetQuery(std::size_t index, const char *sql);
     bool SetPQuery(std::size_t index, const char *format, ...);
     bool SetPreparedQuery(std::size_t index, PreparedStatement *data);
 
     void SetSize(std::size_t size) { m_queries.resize(size); }
+    std::size_t GetSize() const { return m_queries.size(); }
 
     QueryResult GetResult(std::size_t index);
     PreparedQueryResult GetPreparedResult(std::size_t index);
@@ -35,6 +35,9 @@ Transaction::Transaction()
 Transaction::~Transaction()
 {
     Cleanup();
+
+    if (m_completionHook)
+        m_completionHook();
 }
 
 //- Append a raw ad-hoc query to the transaction
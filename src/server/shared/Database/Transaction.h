@@ -22,6 +22,7 @@
 #include "MySQLDataTypes.h"
 
 #include <cstddef>
+#include <functional>
 #include <list>
 
 /*! Transactions, high level class. */
@@ -42,11 +43,16 @@ public:
 
     void Cleanup();
 
+    //! Called when the last reference to the transaction is dropped. For a committed
+    //! transaction that is on the database thread, after its queries were executed.
+    void SetCompletionHook(std::function<void()> hook) { m_completionHook = hook; }
+
     bool execute(MySQLConnection *conn);
 
 private:
     StorageType m_queries;
     bool _cleanedUp;
+    std::function<void()> m_completionHook;
 
 };
 
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TRINITY_CONTAINERPOSITIONS_H
+#define TRINITY_CONTAINERPOSITIONS_H
+
+#include "Define.h"
+
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CONTAINER_POSITIONS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Trinity {
+
+/*
+ * @class ContainerPositions keeps the positions and phase masks of the
+ * elements of a ContainerMapList in separate arrays, in the order of the
+ * elements. Range checks over a cell read these instead of dereferencing
+ * every object, and only touch the objects that pass.
+ */
+class ContainerPositions final
+{
+public:
+    std::size_t size() const { return m_x.size(); }
+
+    void push_back(float x, float y, float z, uint32 phaseMask)
+    {
+        m_x.push_back(x);
+        m_y.push_back(y);
+        m_z.push_back(z);
+        m_phaseMask.push_back(phaseMask);
+    }
+
+    // same swap with the last element as done for the elements
+    void erase(std::size_t index)
+    {
+        m_x[index] = m_x.back();
+        m_y[index] = m_y.back();
+        m_z[index] = m_z.back();
+        m_phaseMask[index] = m_phaseMask.back();
+
+        m_x.pop_back();
+        m_y.pop_back();
+        m_z.pop_back();
+        m_phaseMask.pop_back();
+    }
+
+    void relocate(std::size_t index, float x, float y, float z)
+    {
+        m_x[index] = x;
+        m_y[index] = y;
+        m_z[index] = z;
+    }
+
+    void setPhaseMask(std::size_t index, uint32 phaseMask) { m_phaseMask[index] = phaseMask; }
+
+    float x(std::size_t index) const { return m_x[index]; }
+    float y(std::size_t index) const { return m_y[index]; }
+    float z(std::size_t index) const { return m_z[index]; }
+    uint32 phaseMask(std::size_t index) const { return m_phaseMask[index]; }
+
+    /*
+     * Calls func(index) for every element sharing a phase with phaseMask
+     * within distSq squared 2d distance of (x, y), four elements at a time
+     * where SSE2 is available. func must not add or remove elements.
+     */
+    template <typename Func>
+    void forEachInRange2d(float x, float y, float distSq, uint32 phaseMask, Func &&func) const
+    {
+        std::size_t const count = size();
+        std::size_t i = 0;
+
+#ifdef CONTAINER_POSITIONS_SSE2
+        __m128 const centerX = _mm_set1_ps(x);
+        __m128 const centerY = _mm_set1_ps(y);
+        __m128 const limit = _mm_set1_ps(distSq);
+        __m128i const phase = _mm_set1_epi32(int32(phaseMask));
+        __m128i const zero = _mm_setzero_si128();
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 const dx = _mm_sub_ps(_mm_loadu_ps(&m_x[i]), centerX);
+            __m128 const dy = _mm_sub_ps(_mm_loadu_ps(&m_y[i]), centerY);
+            __m128 const inRange = _mm_cmple_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), limit);
+            __m128i const otherPhase = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128(reinterpret_cast<__m128i const*>(&m_phaseMask[i])), phase), zero);
+
+            int const mask = _mm_movemask_ps(_mm_andnot_ps(_mm_castsi128_ps(otherPhase), inRange));
+            for (int bit = 0; mask >> bit; ++bit)
+                if (mask & (1 << bit))
+                    func(i + bit);
+        }
+#endif
+
+        for (; i < count; ++i)
+        {
+            if (!(m_phaseMask[i] & phaseMask))
+                continue;
+
+            float const dx = m_x[i] - x;
+            float const dy = m_y[i] - y;
+            if (dx * dx + dy * dy <= distSq)
+                func(i);
+        }
+    }
+
+private:
+    std::vector<float> m_x;
+    std::vector<float> m_y;
+    std::vector<float> m_z;
+    std::vector<uint32> m_phaseMask;
+};
+
+} // namespace Trinity
+
+#endif
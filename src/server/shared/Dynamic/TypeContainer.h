@@ -25,6 +25,7 @@
  */
 
 #include "Define.h"
+#include "Dynamic/ContainerPositions.h"
 #include "Dynamic/TypeList.h"
 
 #include <type_traits>
@@ -43,6 +44,7 @@ template <typename T>
 struct ContainerMapList
 {
     std::vector<T*> elements;
+    ContainerPositions positions;
 };
 
 template <>
@@ -122,7 +124,7 @@ public:
     void insert(SpecificType *obj)
     {
         auto &m = Detail::mapForType<SpecificType>(m_objectMap);
-        obj->AddToGrid(m.elements);
+        obj->AddToGrid(m.elements, m.positions);
     }
 
     ObjectMap & objectMap() { return m_objectMap; }
@@ -22,7 +22,8 @@
 /*
  * @class TypeContainerVisitor is implemented as a visitor pattern.  It is
  * a visitor to the ContainerMapList.  The visitor has to overload its types as
- * a visit method is called.
+ * a visit method is called.  Visitors filtering by position may overload
+ * Visit(elements, positions) instead to get the positions of the elements.
  */
 
 #include "Define.h"
@@ -37,11 +38,23 @@ template <typename Visitor>
 inline void VisitorHelper(Visitor &/*v*/, ContainerMapList<TypeNull> &/*c*/) { }
 
 template <typename Visitor, typename T>
-inline void VisitorHelper(Visitor &v, ContainerMapList<T> &c)
+inline auto VisitElements(Visitor &v, ContainerMapList<T> &c, int) -> decltype(v.Visit(c.elements, c.positions))
+{
+    return v.Visit(c.elements, c.positions);
+}
+
+template <typename Visitor, typename T>
+inline void VisitElements(Visitor &v, ContainerMapList<T> &c, long)
 {
     v.Visit(c.elements);
 }
 
+template <typename Visitor, typename T>
+inline void VisitorHelper(Visitor &v, ContainerMapList<T> &c)
+{
+    VisitElements(v, c, 0);
+}
+
 // recursion container map list
 template <typename Visitor, typename Head, typename Tail>
 inline void VisitorHelper(Visitor &v, ContainerMapList<TypeList<Head, Tail>> &c)
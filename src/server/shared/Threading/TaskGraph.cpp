@@ -0,0 +1,79 @@
+#include "TaskGraph.hpp"
+#include "ThreadPoolMgr.hpp"
+
+#include <cassert>
+
+namespace Trinity {
+
+TaskGraph::TaskId TaskGraph::add(std::string name, FunctorType functor,
+                                 std::initializer_list<TaskId> dependencies)
+{
+    TaskId const id = tasks_.size();
+
+    Task task;
+    task.functor = std::move(functor);
+    task.dependencyCount = dependencies.size();
+    task.pendingCount = 0;
+    tasks_.push_back(std::move(task));
+
+    Timing timing;
+    timing.name = std::move(name);
+    timings_.push_back(std::move(timing));
+
+    for (auto const dep : dependencies) {
+        assert(dep < id);
+        tasks_[dep].dependents.push_back(id);
+    }
+
+    return id;
+}
+
+void TaskGraph::run()
+{
+    for (auto &task : tasks_)
+        task.pendingCount = task.dependencyCount;
+
+    startTime_ = ClockType::now();
+
+    // Roots are collected first, a finished root may already be scheduling
+    // its dependents while we are still iterating
+    std::vector<TaskId> roots;
+    for (TaskId id = 0; id < tasks_.size(); ++id)
+        if (tasks_[id].dependencyCount == 0)
+            roots.push_back(id);
+
+    for (auto const id : roots)
+        sThreadPoolMgr->schedule([this, id] { execute(id); });
+
+    // Dependents are scheduled from within the finishing task, before the
+    // pool drops its request count, so wait() cannot return early
+    sThreadPoolMgr->wait();
+
+    elapsed_ = ClockType::now() - startTime_;
+}
+
+void TaskGraph::execute(TaskId id)
+{
+    Task &task = tasks_[id];
+    Timing &timing = timings_[id];
+
+    auto const start = ClockType::now();
+    task.functor();
+    auto const end = ClockType::now();
+
+    timing.start = start - startTime_;
+    timing.elapsed = end - start;
+
+    std::vector<TaskId> ready;
+    {
+        GuardType g(lock_);
+        for (auto const dep : task.dependents)
+            if (--tasks_[dep].pendingCount == 0)
+                ready.push_back(dep);
+    }
+
+    for (auto const dep : ready)
+        sThreadPoolMgr->schedule([this, dep] { execute(dep); });
+}
+
+} // namespace Trinity
@@ -0,0 +1,82 @@
+#ifndef TRINITY_SHARED_TASK_GRAPH_HPP
+#define TRINITY_SHARED_TASK_GRAPH_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Trinity {
+
+// Set of tasks with "must run after" edges, executed on sThreadPoolMgr.
+// A task is scheduled as soon as all of its dependencies have finished, so
+// independent chains run in parallel while the declared order is kept
+// within each chain.
+class TaskGraph final
+{
+    typedef std::mutex LockType;
+
+    typedef std::lock_guard<LockType> GuardType;
+
+    typedef std::function<void()> FunctorType;
+
+public:
+    typedef std::size_t TaskId;
+
+    typedef std::chrono::steady_clock ClockType;
+
+    struct Timing
+    {
+        std::string name;
+        ClockType::duration start;      // relative to the start of run()
+        ClockType::duration elapsed;
+    };
+
+    // Dependencies must have been added before, which also rules out cycles
+    TaskId add(std::string name, FunctorType functor,
+               std::initializer_list<TaskId> dependencies = {});
+
+    // Blocks until every task has finished. The pool must not be running
+    // other work, since completion is detected with ThreadPoolMgr::wait().
+    void run();
+
+    // Valid after run(), in the order the tasks were added
+    std::vector<Timing> const & timings() const
+    {
+        return timings_;
+    }
+
+    // Wall clock time of the last run()
+    ClockType::duration elapsed() const
+    {
+        return elapsed_;
+    }
+
+private:
+    struct Task
+    {
+        FunctorType functor;
+        std::vector<TaskId> dependents;
+        std::size_t dependencyCount;
+        std::size_t pendingCount;
+    };
+
+    void execute(TaskId id);
+
+    std::vector<Task> tasks_;
+
+    std::vector<Timing> timings_;
+
+    ClockType::time_point startTime_;
+
+    ClockType::duration elapsed_;
+
+    LockType lock_;
+};
+
+} // namespace Trinity
+
+#endif // TRINITY_SHARED_TASK_GRAPH_HPP
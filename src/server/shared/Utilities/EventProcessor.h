@@ -64,6 +64,7 @@ class EventProcessor
         void AddEvent(BasicEvent* Event, uint64 e_time, bool set_addtime = true, uint32 eventId = 0);
         uint64 CalculateTime(uint64 t_offset) const;
         void DeleteEventId(uint32 eventId, bool force = true);
+        bool Empty() const { return m_events.empty(); }
     protected:
         uint64 m_time;
         EventList m_events;
@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MAP_HEIGHT_BLOCKS_H
+#define _MAP_HEIGHT_BLOCKS_H
+
+#include "Define.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MAP_HEIGHT_BLOCKS_SSE2
+#include <emmintrin.h>
+#endif
+
+// Height section layout of .map files converted by mapconverter, the height
+// header is followed by MAP_HEIGHT_BLOCKS * MAP_HEIGHT_BLOCKS map_heightBlock
+#define MAP_HEIGHT_AS_BLOCKS  0x0008
+
+#define MAP_HEIGHT_GRID_SQUARES   128                       // squares per grid side, V8 has one height per square
+#define MAP_HEIGHT_BLOCK_SQUARES  8                         // squares per block side
+#define MAP_HEIGHT_BLOCKS         (MAP_HEIGHT_GRID_SQUARES / MAP_HEIGHT_BLOCK_SQUARES)
+
+// 8x8 squares of a grid: the 9x9 corner heights (V9) and the 8x8 center
+// heights (V8) next to each other, so that one lookup stays in a few cache
+// lines. The heights are quantized to the range of the block,
+// height = base + step * value.
+struct map_heightBlock
+{
+    float  base;
+    float  step;
+    uint16 v9[MAP_HEIGHT_BLOCK_SQUARES + 1][MAP_HEIGHT_BLOCK_SQUARES + 1];
+    uint16 v8[MAP_HEIGHT_BLOCK_SQUARES][MAP_HEIGHT_BLOCK_SQUARES];
+    uint16 padding;
+};
+
+static_assert(sizeof(map_heightBlock) == 300, "map_heightBlock is part of the .map file format");
+
+namespace MapHeightBlocks
+{
+    //! Packs V9 (129*129) and V8 (128*128) heights, indexed [x * size + y] as
+    //! in the .map file, into MAP_HEIGHT_BLOCKS * MAP_HEIGHT_BLOCKS blocks
+    inline void Encode(float const* v9, float const* v8, map_heightBlock* blocks)
+    {
+        for (uint32 bx = 0; bx < MAP_HEIGHT_BLOCKS; ++bx)
+        {
+            for (uint32 by = 0; by < MAP_HEIGHT_BLOCKS; ++by)
+            {
+                map_heightBlock& block = blocks[bx * MAP_HEIGHT_BLOCKS + by];
+                uint32 const x0 = bx * MAP_HEIGHT_BLOCK_SQUARES;
+                uint32 const y0 = by * MAP_HEIGHT_BLOCK_SQUARES;
+
+                float minHeight = v9[x0 * (MAP_HEIGHT_GRID_SQUARES + 1) + y0];
+                float maxHeight = minHeight;
+                for (uint32 x = 0; x <= MAP_HEIGHT_BLOCK_SQUARES; ++x)
+                {
+                    for (uint32 y = 0; y <= MAP_HEIGHT_BLOCK_SQUARES; ++y)
+                    {
+                        float const h = v9[(x0 + x) * (MAP_HEIGHT_GRID_SQUARES + 1) + y0 + y];
+                        minHeight = std::min(minHeight, h);
+                        maxHeight = std::max(maxHeight, h);
+                        if (x < MAP_HEIGHT_BLOCK_SQUARES && y < MAP_HEIGHT_BLOCK_SQUARES)
+                        {
+                            float const h8 = v8[(x0 + x) * MAP_HEIGHT_GRID_SQUARES + y0 + y];
+                            minHeight = std::min(minHeight, h8);
+                            maxHeight = std::max(maxHeight, h8);
+                        }
+                    }
+                }
+
+                block.base = minHeight;
+                block.step = (maxHeight - minHeight) / 65535;
+                block.padding = 0;
+
+                float const scale = block.step > 0.0f ? 1.0f / block.step : 0.0f;
+                for (uint32 x = 0; x <= MAP_HEIGHT_BLOCK_SQUARES; ++x)
+                {
+                    for (uint32 y = 0; y <= MAP_HEIGHT_BLOCK_SQUARES; ++y)
+                    {
+                        float const h = v9[(x0 + x) * (MAP_HEIGHT_GRID_SQUARES + 1) + y0 + y];
+                        block.v9[x][y] = uint16(std::min((h - minHeight) * scale + 0.5f, 65535.0f));
+                        if (x < MAP_HEIGHT_BLOCK_SQUARES && y < MAP_HEIGHT_BLOCK_SQUARES)
+                        {
+                            float const h8 = v8[(x0 + x) * MAP_HEIGHT_GRID_SQUARES + y0 + y];
+                            block.v8[x][y] = uint16(std::min((h8 - minHeight) * scale + 0.5f, 65535.0f));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    //! Inverse of Encode, corners shared by several blocks are taken from the block starting at them,
+    //! only the far edge of the grid is read from the last block
+    inline void Decode(map_heightBlock const* blocks, float* v9, float* v8)
+    {
+        for (uint32 x = 0; x <= MAP_HEIGHT_GRID_SQUARES; ++x)
+        {
+            for (uint32 y = 0; y <= MAP_HEIGHT_GRID_SQUARES; ++y)
+            {
+                uint32 const bx = std::min<uint32>(x / MAP_HEIGHT_BLOCK_SQUARES, MAP_HEIGHT_BLOCKS - 1);
+                uint32 const by = std::min<uint32>(y / MAP_HEIGHT_BLOCK_SQUARES, MAP_HEIGHT_BLOCKS - 1);
+                map_heightBlock const& block = blocks[bx * MAP_HEIGHT_BLOCKS + by];
+                uint32 const lx = x - bx * MAP_HEIGHT_BLOCK_SQUARES;
+                uint32 const ly = y - by * MAP_HEIGHT_BLOCK_SQUARES;
+
+                v9[x * (MAP_HEIGHT_GRID_SQUARES + 1) + y] = block.base + block.step * block.v9[lx][ly];
+                if (x < MAP_HEIGHT_GRID_SQUARES && y < MAP_HEIGHT_GRID_SQUARES)
+                    v8[x * MAP_HEIGHT_GRID_SQUARES + y] = block.base + block.step * block.v8[lx][ly];
+            }
+        }
+    }
+
+    // Height stored as: h5 - its v8 grid, h1-h4 - its v9 grid
+    // +--------------> X
+    // | h1-------h2     Coordinates is:
+    // | | \  1  / |     h1 0, 0
+    // | |  \   /  |     h2 0, 1
+    // | | 2  h5 3 |     h3 1, 0
+    // | |  /   \  |     h4 1, 1
+    // | | /  4  \ |     h5 1/2, 1/2
+    // | h3-------h4
+    // V Y
+    // The height is a*x + b*y + c with the coefficients of the triangle the
+    // point is in. h5 is passed doubled, as the triangles use it.
+
+    //! x and y are in squares of the grid, as computed by GridMap
+    inline float GetHeight(map_heightBlock const* blocks, float x, float y)
+    {
+        int x_int = (int)x;
+        int y_int = (int)y;
+        x -= x_int;
+        y -= y_int;
+        x_int &= (MAP_HEIGHT_GRID_SQUARES - 1);
+        y_int &= (MAP_HEIGHT_GRID_SQUARES - 1);
+
+        map_heightBlock const& block = blocks[(x_int / MAP_HEIGHT_BLOCK_SQUARES) * MAP_HEIGHT_BLOCKS + y_int / MAP_HEIGHT_BLOCK_SQUARES];
+        int const lx = x_int & (MAP_HEIGHT_BLOCK_SQUARES - 1);
+        int const ly = y_int & (MAP_HEIGHT_BLOCK_SQUARES - 1);
+
+        float const h1 = block.v9[lx][ly];
+        float const h2 = block.v9[lx + 1][ly];
+        float const h3 = block.v9[lx][ly + 1];
+        float const h4 = block.v9[lx + 1][ly + 1];
+        float const h5 = 2.0f * block.v8[lx][ly];
+
+        bool const upper = x + y < 1.0f;     // triangles 1 and 2
+        bool const right = x > y;            // triangles 1 and 3
+        float const a = upper ? (right ? h2 - h1 : h5 - h1 - h3) : (right ? h2 + h4 - h5 : h4 - h3);
+        float const b = upper ? (right ? h5 - h1 - h2 : h3 - h1) : (right ? h4 - h2 : h3 + h4 - h5);
+        float const c = upper ? h1 : h5 - h4;
+
+        return block.base + block.step * (a * x + b * y + c);
+    }
+
+#ifdef MAP_HEIGHT_BLOCKS_SSE2
+    inline __m128 Select(__m128 mask, __m128 whenSet, __m128 whenClear)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, whenSet), _mm_andnot_ps(mask, whenClear));
+    }
+#endif
+
+    //! Same as GetHeight for count points, four at a time where SSE2 is available
+    inline void GetHeights(map_heightBlock const* blocks, float const* x, float const* y, float* heights, uint32 count)
+    {
+        uint32 i = 0;
+#ifdef MAP_HEIGHT_BLOCKS_SSE2
+        __m128i const squareMask = _mm_set1_epi32(MAP_HEIGHT_GRID_SQUARES - 1);
+        __m128 const one = _mm_set1_ps(1.0f);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 const px = _mm_loadu_ps(x + i);
+            __m128 const py = _mm_loadu_ps(y + i);
+            __m128i const truncX = _mm_cvttps_epi32(px);
+            __m128i const truncY = _mm_cvttps_epi32(py);
+            __m128 const fx = _mm_sub_ps(px, _mm_cvtepi32_ps(truncX));
+            __m128 const fy = _mm_sub_ps(py, _mm_cvtepi32_ps(truncY));
+
+            alignas(16) int32 squareX[4];
+            alignas(16) int32 squareY[4];
+            _mm_store_si128(reinterpret_cast<__m128i*>(squareX), _mm_and_si128(truncX, squareMask));
+            _mm_store_si128(reinterpret_cast<__m128i*>(squareY), _mm_and_si128(truncY, squareMask));
+
+            // the corners are gathered lane by lane, everything else is computed for all four points
+            alignas(16) float h1[4], h2[4], h3[4], h4[4], h5[4], base[4], step[4];
+            for (uint32 lane = 0; lane < 4; ++lane)
+            {
+                map_heightBlock const& block = blocks[(squareX[lane] / MAP_HEIGHT_BLOCK_SQUARES) * MAP_HEIGHT_BLOCKS + squareY[lane] / MAP_HEIGHT_BLOCK_SQUARES];
+                int const lx = squareX[lane] & (MAP_HEIGHT_BLOCK_SQUARES - 1);
+                int const ly = squareY[lane] & (MAP_HEIGHT_BLOCK_SQUARES - 1);
+                h1[lane] = block.v9[lx][ly];
+                h2[lane] = block.v9[lx + 1][ly];
+                h3[lane] = block.v9[lx][ly + 1];
+                h4[lane] = block.v9[lx + 1][ly + 1];
+                h5[lane] = 2.0f * block.v8[lx][ly];
+                base[lane] = block.base;
+                step[lane] = block.step;
+            }
+
+            __m128 const H1 = _mm_load_ps(h1);
+            __m128 const H2 = _mm_load_ps(h2);
+            __m128 const H3 = _mm_load_ps(h3);
+            __m128 const H4 = _mm_load_ps(h4);
+            __m128 const H5 = _mm_load_ps(h5);
+
+            __m128 const upper = _mm_cmplt_ps(_mm_add_ps(fx, fy), one);
+            __m128 const right = _mm_cmpgt_ps(fx, fy);
+
+            __m128 const a = Select(upper,
+                Select(right, _mm_sub_ps(H2, H1), _mm_sub_ps(_mm_sub_ps(H5, H1), H3)),
+                Select(right, _mm_sub_ps(_mm_add_ps(H2, H4), H5), _mm_sub_ps(H4, H3)));
+            __m128 const b = Select(upper,
+                Select(right, _mm_sub_ps(_mm_sub_ps(H5, H1), H2), _mm_sub_ps(H3, H1)),
+                Select(right, _mm_sub_ps(H4, H2), _mm_sub_ps(_mm_add_ps(H3, H4), H5)));
+            __m128 const c = Select(upper, H1, _mm_sub_ps(H5, H4));
+
+            __m128 const h = _mm_add_ps(_mm_add_ps(_mm_mul_ps(a, fx), _mm_mul_ps(b, fy)), c);
+            _mm_storeu_ps(heights + i, _mm_add_ps(_mm_load_ps(base), _mm_mul_ps(_mm_load_ps(step), h)));
+        }
+#endif
+
+        for (; i < count; ++i)
+            heights[i] = GetHeight(blocks, x[i], y[i]);
+    }
+}
+
+#endif
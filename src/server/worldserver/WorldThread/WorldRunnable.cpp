@@ -32,6 +32,7 @@
 #include "WorldRunnable.h"
 #include "OutdoorPvPMgr.h"
 #include "ThreadPoolMgr.hpp"
+#include "TerrainPrefetcher.h"
 
 #define WORLD_SLEEP_CONST 25
 
@@ -92,6 +93,7 @@ void WorldRunnable::run()
 
     sWorldSocketMgr->StopNetwork();
 
+    sTerrainPrefetcher->Stop();
     sMapMgr->UnloadAll();                     // unload all grids (including locked in memory)
     sThreadPoolMgr->stop();
 
@@ -0,0 +1,417 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// Rewrites the height section of extracted .map files in the blocked layout
+// of MapHeightBlocks.h, the other sections are copied as they are.
+// Every converted grid is checked against its source heights, stored and interpolated.
+
+#include "MapHeightBlocks.h"
+#include "PathCommon.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+static char const* MAP_MAGIC         = "MAPS";
+static char const* MAP_VERSION_MAGIC = "v1.4";
+static char const* MAP_HEIGHT_MAGIC  = "MHGT";
+
+struct map_fileheader
+{
+    uint32 mapMagic;
+    uint32 versionMagic;
+    uint32 buildMagic;
+    uint32 areaMapOffset;
+    uint32 areaMapSize;
+    uint32 heightMapOffset;
+    uint32 heightMapSize;
+    uint32 liquidMapOffset;
+    uint32 liquidMapSize;
+    uint32 holesOffset;
+    uint32 holesSize;
+};
+
+#define MAP_SECTION_ALIGNMENT 16
+
+#define MAP_HEIGHT_NO_HEIGHT  0x0001
+#define MAP_HEIGHT_AS_INT16   0x0002
+#define MAP_HEIGHT_AS_INT8    0x0004
+
+struct map_heightHeader
+{
+    uint32 fourcc;
+    uint32 flags;
+    float  gridHeight;
+    float  gridMaxHeight;
+};
+
+enum ConvertResult
+{
+    CONVERT_DONE,
+    CONVERT_SKIPPED,
+    CONVERT_FAILED
+};
+
+static uint32 alignSection(uint32 offset)
+{
+    return (offset + MAP_SECTION_ALIGNMENT - 1) & ~uint32(MAP_SECTION_ALIGNMENT - 1);
+}
+
+static bool readFile(std::string const& path, std::vector<uint8>& data)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file)
+        return false;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    bool result = size > 0;
+    if (result)
+    {
+        data.resize(size);
+        result = fread(&data[0], size, 1, file) == 1;
+    }
+
+    fclose(file);
+    return result;
+}
+
+static bool hasSection(std::vector<uint8> const& data, uint32 offset, uint32 size)
+{
+    return offset <= data.size() && size <= data.size() - offset;
+}
+
+// heights of the legacy section as floats, the way the server used to read them
+static bool decodeLegacyHeights(std::vector<uint8> const& data, uint32 offset, map_heightHeader const& header, float* v9, float* v8)
+{
+    uint32 const dataOffset = offset + sizeof(map_heightHeader);
+
+    if (header.flags & MAP_HEIGHT_AS_INT16)
+    {
+        if (!hasSection(data, dataOffset, (129*129 + 128*128) * sizeof(uint16)))
+            return false;
+
+        std::vector<uint16> values(129*129 + 128*128);
+        memcpy(&values[0], &data[dataOffset], values.size() * sizeof(uint16));
+        float const multiplier = (header.gridMaxHeight - header.gridHeight) / 65535;
+        for (uint32 i = 0; i < 129*129; ++i)
+            v9[i] = values[i] * multiplier + header.gridHeight;
+        for (uint32 i = 0; i < 128*128; ++i)
+            v8[i] = values[129*129 + i] * multiplier + header.gridHeight;
+    }
+    else if (header.flags & MAP_HEIGHT_AS_INT8)
+    {
+        if (!hasSection(data, dataOffset, 129*129 + 128*128))
+            return false;
+
+        uint8 const* values = &data[dataOffset];
+        float const multiplier = (header.gridMaxHeight - header.gridHeight) / 255;
+        for (uint32 i = 0; i < 129*129; ++i)
+            v9[i] = values[i] * multiplier + header.gridHeight;
+        for (uint32 i = 0; i < 128*128; ++i)
+            v8[i] = values[129*129 + i] * multiplier + header.gridHeight;
+    }
+    else
+    {
+        if (!hasSection(data, dataOffset, (129*129 + 128*128) * sizeof(float)))
+            return false;
+
+        memcpy(v9, &data[dataOffset], 129*129 * sizeof(float));
+        memcpy(v8, &data[dataOffset + 129*129 * sizeof(float)], 128*128 * sizeof(float));
+    }
+
+    return true;
+}
+
+// height inside a square the way the server interpolated the legacy V9/V8 heights,
+// x and y are in squares of the grid
+static float legacyHeight(float const* v9, float const* v8, float x, float y)
+{
+    int const x_int = (int)x;
+    int const y_int = (int)y;
+    x -= x_int;
+    y -= y_int;
+
+    float const h1 = v9[x_int * 129 + y_int];
+    float const h2 = v9[(x_int + 1) * 129 + y_int];
+    float const h3 = v9[x_int * 129 + y_int + 1];
+    float const h4 = v9[(x_int + 1) * 129 + y_int + 1];
+    float const h5 = 2 * v8[x_int * 128 + y_int];
+
+    if (x + y < 1)
+    {
+        if (x > y)
+            return (h2 - h1) * x + (h5 - h1 - h2) * y + h1;
+        return (h5 - h1 - h3) * x + (h3 - h1) * y + h1;
+    }
+
+    if (x > y)
+        return (h2 + h4 - h5) * x + (h4 - h2) * y + h5 - h4;
+    return (h4 - h3) * x + (h3 + h4 - h5) * y + h5 - h4;
+}
+
+// a quantized height is within half a step of its block from the source one,
+// an interpolated height weighs heights of a single block so the same holds,
+// the rest is room for float rounding
+static float heightTolerance(map_heightBlock const& block)
+{
+    return block.step * 0.51f + 0.001f;
+}
+
+// compares the blocks with the source heights: every stored height, and heights
+// read back through GetHeight and GetHeights against the legacy interpolation at
+// points of all four triangles of every square. Returns false on the first
+// height out of the tolerance of its block.
+static bool verifyBlocks(std::string const& path, float const* v9, float const* v8, map_heightBlock const* blocks, float& maxError)
+{
+    maxError = 0.0f;
+
+    std::vector<float> decodedV9(129*129), decodedV8(128*128);
+    MapHeightBlocks::Decode(blocks, &decodedV9[0], &decodedV8[0]);
+    for (uint32 x = 0; x <= MAP_HEIGHT_GRID_SQUARES; ++x)
+    {
+        for (uint32 y = 0; y <= MAP_HEIGHT_GRID_SQUARES; ++y)
+        {
+            // Decode takes corners from the block starting at them, clamped at the far edge
+            uint32 const bx = std::min<uint32>(x / MAP_HEIGHT_BLOCK_SQUARES, MAP_HEIGHT_BLOCKS - 1);
+            uint32 const by = std::min<uint32>(y / MAP_HEIGHT_BLOCK_SQUARES, MAP_HEIGHT_BLOCKS - 1);
+            float const tolerance = heightTolerance(blocks[bx * MAP_HEIGHT_BLOCKS + by]);
+
+            float error = std::fabs(decodedV9[x * 129 + y] - v9[x * 129 + y]);
+            if (x < MAP_HEIGHT_GRID_SQUARES && y < MAP_HEIGHT_GRID_SQUARES)
+                error = std::max(error, std::fabs(decodedV8[x * 128 + y] - v8[x * 128 + y]));
+
+            maxError = std::max(maxError, error);
+            if (error > tolerance)
+            {
+                printf("%s: stored height of square %u,%u differs by %f, file not converted\n", path.c_str(), x, y, error);
+                return false;
+            }
+        }
+    }
+
+    static float const offsets[][2] = { { 0.75f, 0.5f }, { 0.25f, 0.5f }, { 0.5f, 0.25f }, { 0.5f, 0.75f }, { 0.0f, 0.0f } };
+    uint32 const samplesPerSquare = sizeof(offsets) / sizeof(offsets[0]);
+
+    std::vector<float> sampleX, sampleY;
+    sampleX.reserve(MAP_HEIGHT_GRID_SQUARES * MAP_HEIGHT_GRID_SQUARES * samplesPerSquare);
+    sampleY.reserve(MAP_HEIGHT_GRID_SQUARES * MAP_HEIGHT_GRID_SQUARES * samplesPerSquare);
+    for (uint32 x = 0; x < MAP_HEIGHT_GRID_SQUARES; ++x)
+    {
+        for (uint32 y = 0; y < MAP_HEIGHT_GRID_SQUARES; ++y)
+        {
+            for (uint32 i = 0; i < samplesPerSquare; ++i)
+            {
+                sampleX.push_back(x + offsets[i][0]);
+                sampleY.push_back(y + offsets[i][1]);
+            }
+        }
+    }
+
+    std::vector<float> heights(sampleX.size());
+    MapHeightBlocks::GetHeights(blocks, &sampleX[0], &sampleY[0], &heights[0], heights.size());
+
+    for (uint32 i = 0; i < heights.size(); ++i)
+    {
+        uint32 const x = uint32(sampleX[i]);
+        uint32 const y = uint32(sampleY[i]);
+        float const tolerance = heightTolerance(blocks[(x / MAP_HEIGHT_BLOCK_SQUARES) * MAP_HEIGHT_BLOCKS + y / MAP_HEIGHT_BLOCK_SQUARES]);
+        float const expected = legacyHeight(v9, v8, sampleX[i], sampleY[i]);
+
+        float const error = std::max(std::fabs(heights[i] - expected),
+            std::fabs(MapHeightBlocks::GetHeight(blocks, sampleX[i], sampleY[i]) - expected));
+
+        maxError = std::max(maxError, error);
+        if (error > tolerance)
+        {
+            printf("%s: height at %f,%f differs by %f, file not converted\n", path.c_str(), sampleX[i], sampleY[i], error);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void writeSection(FILE* output, std::vector<uint8> const& section, uint32 offset)
+{
+    static char const padding[MAP_SECTION_ALIGNMENT] = { };
+    long const current = ftell(output);
+    if (current >= 0 && uint32(current) < offset)
+        fwrite(padding, offset - uint32(current), 1, output);
+
+    if (!section.empty())
+        fwrite(&section[0], section.size(), 1, output);
+}
+
+// rename does not replace an existing file on windows
+static bool replaceFile(std::string const& from, std::string const& to)
+{
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+static ConvertResult convertFile(std::string const& path, float& maxError)
+{
+    std::vector<uint8> data;
+    if (!readFile(path, data) || data.size() < sizeof(map_fileheader))
+    {
+        printf("%s: can not read file\n", path.c_str());
+        return CONVERT_FAILED;
+    }
+
+    map_fileheader header;
+    memcpy(&header, &data[0], sizeof(header));
+    if (header.mapMagic != *(uint32 const*)MAP_MAGIC || header.versionMagic != *(uint32 const*)MAP_VERSION_MAGIC)
+    {
+        printf("%s: is the wrong version, please extract new .map files\n", path.c_str());
+        return CONVERT_FAILED;
+    }
+
+    if (!header.heightMapOffset || !hasSection(data, header.heightMapOffset, sizeof(map_heightHeader)))
+        return CONVERT_SKIPPED;
+
+    map_heightHeader heightHeader;
+    memcpy(&heightHeader, &data[header.heightMapOffset], sizeof(heightHeader));
+    if (heightHeader.fourcc != *(uint32 const*)MAP_HEIGHT_MAGIC)
+    {
+        printf("%s: invalid height section\n", path.c_str());
+        return CONVERT_FAILED;
+    }
+
+    if (heightHeader.flags & (MAP_HEIGHT_NO_HEIGHT | MAP_HEIGHT_AS_BLOCKS))
+        return CONVERT_SKIPPED;
+
+    std::vector<float> v9(129*129), v8(128*128);
+    if (!decodeLegacyHeights(data, header.heightMapOffset, heightHeader, &v9[0], &v8[0]))
+    {
+        printf("%s: height section is truncated\n", path.c_str());
+        return CONVERT_FAILED;
+    }
+
+    std::vector<map_heightBlock> blocks(MAP_HEIGHT_BLOCKS * MAP_HEIGHT_BLOCKS);
+    MapHeightBlocks::Encode(&v9[0], &v8[0], &blocks[0]);
+
+    // anything out of tolerance means the encoder or a reader is broken and the file is kept
+    if (!verifyBlocks(path, &v9[0], &v8[0], &blocks[0], maxError))
+        return CONVERT_FAILED;
+
+    std::vector<uint8> area, height, liquid, holes;
+    if (header.areaMapOffset && hasSection(data, header.areaMapOffset, header.areaMapSize))
+        area.assign(data.begin() + header.areaMapOffset, data.begin() + header.areaMapOffset + header.areaMapSize);
+    if (header.liquidMapOffset && hasSection(data, header.liquidMapOffset, header.liquidMapSize))
+        liquid.assign(data.begin() + header.liquidMapOffset, data.begin() + header.liquidMapOffset + header.liquidMapSize);
+    if (header.holesSize && hasSection(data, header.holesOffset, header.holesSize))
+        holes.assign(data.begin() + header.holesOffset, data.begin() + header.holesOffset + header.holesSize);
+
+    heightHeader.flags = MAP_HEIGHT_AS_BLOCKS;
+    height.resize(sizeof(heightHeader) + blocks.size() * sizeof(map_heightBlock));
+    memcpy(&height[0], &heightHeader, sizeof(heightHeader));
+    memcpy(&height[sizeof(heightHeader)], &blocks[0], blocks.size() * sizeof(map_heightBlock));
+
+    // same section order as the extractor writes
+    header.areaMapOffset = area.empty() ? 0 : alignSection(sizeof(header));
+    header.areaMapSize = area.size();
+    header.heightMapOffset = alignSection(header.areaMapOffset ? header.areaMapOffset + header.areaMapSize : sizeof(header));
+    header.heightMapSize = height.size();
+    header.liquidMapOffset = liquid.empty() ? 0 : alignSection(header.heightMapOffset + header.heightMapSize);
+    header.liquidMapSize = liquid.size();
+    header.holesOffset = alignSection(header.liquidMapOffset ? header.liquidMapOffset + header.liquidMapSize : header.heightMapOffset + header.heightMapSize);
+    header.holesSize = holes.size();
+
+    std::string const tmpPath = path + ".tmp";
+    FILE* output = fopen(tmpPath.c_str(), "wb");
+    if (!output)
+    {
+        printf("%s: can not create output file\n", tmpPath.c_str());
+        return CONVERT_FAILED;
+    }
+
+    fwrite(&header, sizeof(header), 1, output);
+    if (header.areaMapOffset)
+        writeSection(output, area, header.areaMapOffset);
+    writeSection(output, height, header.heightMapOffset);
+    if (header.liquidMapOffset)
+        writeSection(output, liquid, header.liquidMapOffset);
+    if (header.holesSize)
+        writeSection(output, holes, header.holesOffset);
+
+    bool const written = !ferror(output);
+    fclose(output);
+
+    // the original is kept until the converted file replaces it
+    if (!written || !replaceFile(tmpPath, path))
+    {
+        printf("%s: can not write output file\n", path.c_str());
+        remove(tmpPath.c_str());
+        return CONVERT_FAILED;
+    }
+
+    return CONVERT_DONE;
+}
+
+int main(int argc, char* argv[])
+{
+    printf("Map height converter\n");
+    printf("====================\n");
+
+    if (argc > 2)
+    {
+        printf("usage: %s [maps directory, defaults to ./maps]\n", argv[0]);
+        return 1;
+    }
+
+    std::string const directory = argc == 2 ? argv[1] : "maps";
+
+    std::vector<std::string> files;
+    if (MMAP::getDirContents(files, directory, "*.map") == MMAP::LISTFILE_DIRECTORY_NOT_FOUND)
+    {
+        printf("directory %s not found\n", directory.c_str());
+        return 1;
+    }
+
+    uint32 converted = 0, skipped = 0, failed = 0;
+    float maxError = 0.0f;
+    for (std::vector<std::string>::const_iterator itr = files.begin(); itr != files.end(); ++itr)
+    {
+        float error = 0.0f;
+        switch (convertFile(directory + "/" + *itr, error))
+        {
+            case CONVERT_DONE:
+                ++converted;
+                maxError = std::max(maxError, error);
+                break;
+            case CONVERT_SKIPPED:
+                ++skipped;
+                break;
+            default:
+                ++failed;
+                break;
+        }
+    }
+
+    printf("converted %u files, %u skipped, %u failed\n", converted, skipped, failed);
+    printf("largest height difference after conversion: %f\n", maxError);
+    return failed ? 1 : 0;
+}
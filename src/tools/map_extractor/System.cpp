@@ -20,9 +20,14 @@
 #define _CRT_SECURE_NO_DEPRECATE
 
 #include <stdio.h>
+#include <atomic>
 #include <deque>
 #include <list>
+#include <map>
+#include <mutex>
 #include <cstdlib>
+#include <thread>
+#include <vector>
 
 #ifdef _WIN32
 #include "direct.h"
@@ -37,6 +42,7 @@
 
 #include "adt.h"
 #include "wdt.h"
+#include "SynchronizedQueue.hpp"
 #include <fcntl.h>
 
 #if defined( __GNUC__ )
@@ -55,7 +61,8 @@
     #define OPEN_FLAGS (O_RDONLY | O_BINARY)
 #endif
 
-HANDLE WorldMpq = NULL;
+// every thread converting tiles opens its own set of archives, StormLib handles are not thread safe
+thread_local HANDLE WorldMpq = NULL;
 HANDLE LocaleMpq = NULL;
 
 typedef struct
@@ -70,6 +77,7 @@ uint16 *LiqType;
 char output_path[128] = ".";
 char input_path[128] = ".";
 uint32 maxAreaId = 0;
+uint32 maxLiquidTypeId = 0;
 
 // **************************************************
 // Extractor options
@@ -96,6 +104,12 @@ float CONF_flat_liquid_delta_limit = 0.001f; // If max - min less this value - l
 
 uint32 CONF_TargetBuild = 17399;              // 5.4.0 17399
 
+// Number of tiles converted at the same time, 0 uses all cores
+uint32 CONF_threads = 0;
+
+// Skip tiles whose .map file exists and whose source data did not change since the last run
+bool  CONF_resume = true;
+
 // List MPQ for extract maps from
 char const* CONF_mpq_list[] =
 {
@@ -168,6 +182,8 @@ void Usage(char const* prg)
         "-e extract only MAP(1)/DBC(2) - standard: both(3)\n"\
         "-f height stored as int (less map size but lost some accuracy) 1 by default\n"\
         "-b target build (default %u)\n"\
+        "-t number of threads converting tiles (default: number of cores)\n"\
+        "-r skip tiles unchanged since the last run 1 by default\n"\
         "Example: %s -f 0 -i \"c:\\games\\game\"", prg, CONF_TargetBuild, prg);
     exit(1);
 }
@@ -182,6 +198,8 @@ void HandleArgs(int argc, char* arg[])
         // f - use float to int conversion
         // h - limit minimum height
         // b - target client build
+        // t - number of threads
+        // r - skip unchanged tiles
         if (arg[c][0] != '-')
             Usage(arg[0]);
 
@@ -221,6 +239,18 @@ void HandleArgs(int argc, char* arg[])
                 else
                     Usage(arg[0]);
                 break;
+            case 't':
+                if (c + 1 < argc)                            // all ok
+                    CONF_threads = atoi(arg[c++ + 1]);
+                else
+                    Usage(arg[0]);
+                break;
+            case 'r':
+                if (c + 1 < argc)                            // all ok
+                    CONF_resume = atoi(arg[c++ + 1]) != 0;
+                else
+                    Usage(arg[0]);
+                break;
             default:
                 break;
         }
@@ -324,6 +354,7 @@ void ReadAreaTableDBC()
     size_t area_count = dbc.getRecordCount();
     maxAreaId = dbc.getMaxId();
     areas = new uint16[maxAreaId + 1];
+    memset(areas, 0xff, (maxAreaId + 1) * sizeof(uint16));
 
     for (uint32 x = 0; x < area_count; ++x)
         areas[dbc.getRecord(x).getUInt(0)] = dbc.getRecord(x).getUInt(3);
@@ -369,6 +400,7 @@ void ReadLiquidTypeTableDBC()
 
     size_t LiqType_count = dbc.getRecordCount();
     size_t LiqType_maxid = dbc.getMaxId();
+    maxLiquidTypeId = LiqType_maxid;
     LiqType = new uint16[LiqType_maxid + 1];
     memset(LiqType, 0xff, (LiqType_maxid + 1) * sizeof(uint16));
 
@@ -384,7 +416,7 @@ void ReadLiquidTypeTableDBC()
 
 // Map file format data
 static char const* MAP_MAGIC         = "MAPS";
-static char const* MAP_VERSION_MAGIC = "v1.3";
+static char const* MAP_VERSION_MAGIC = "v1.4";
 static char const* MAP_AREA_MAGIC    = "AREA";
 static char const* MAP_HEIGHT_MAGIC  = "MHGT";
 static char const* MAP_LIQUID_MAGIC  = "MLIQ";
@@ -404,6 +436,23 @@ struct map_fileheader
     uint32 holesSize;
 };
 
+// Every section starts aligned, so that the server can map the file and
+// read the arrays in place
+#define MAP_SECTION_ALIGNMENT 16
+
+static uint32 AlignSection(uint32 offset)
+{
+    return (offset + MAP_SECTION_ALIGNMENT - 1) & ~uint32(MAP_SECTION_ALIGNMENT - 1);
+}
+
+static void PadSection(FILE* output, uint32 offset)
+{
+    static char const padding[MAP_SECTION_ALIGNMENT] = { };
+    long const current = ftell(output);
+    if (current >= 0 && uint32(current) < offset)
+        fwrite(padding, offset - uint32(current), 1, output);
+}
+
 #define MAP_AREA_NO_AREA      0x0001
 
 struct map_areaHeader
@@ -459,28 +508,23 @@ float selectUInt16StepStore(float maxDiff)
 {
     return 65535 / maxDiff;
 }
-// Temporary grid data store
-uint16 area_flags[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
-
-float V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
-float V9[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
-uint16 uint16_V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
-uint16 uint16_V9[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
-uint8  uint8_V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
-uint8  uint8_V9[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
-
-uint16 liquid_entry[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
-uint8 liquid_flags[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
-bool  liquid_show[ADT_GRID_SIZE][ADT_GRID_SIZE];
-float liquid_height[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
-
-bool ConvertADT(char *filename, char *filename2, int /*cell_y*/, int /*cell_x*/, uint32 build)
+// Temporary grid data store, one per converting thread
+thread_local uint16 area_flags[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
+
+thread_local float V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
+thread_local float V9[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
+thread_local uint16 uint16_V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
+thread_local uint16 uint16_V9[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
+thread_local uint8  uint8_V8[ADT_GRID_SIZE][ADT_GRID_SIZE];
+thread_local uint8  uint8_V9[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
+
+thread_local uint16 liquid_entry[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
+thread_local uint8 liquid_flags[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
+thread_local bool  liquid_show[ADT_GRID_SIZE][ADT_GRID_SIZE];
+thread_local float liquid_height[ADT_GRID_SIZE+1][ADT_GRID_SIZE+1];
+
+bool ConvertADT(ADT_file& adt, char const* filename, char const* filename2, uint32 build)
 {
-    ADT_file adt;
-
-    if (!adt.loadFile(WorldMpq, filename))
-        return false;
-
     memset(liquid_show, 0, sizeof(liquid_show));
     memset(liquid_flags, 0, sizeof(liquid_flags));
     memset(liquid_entry, 0, sizeof(liquid_entry));
@@ -530,7 +574,7 @@ bool ConvertADT(char *filename, char *filename2, int /*cell_y*/, int /*cell_x*/,
         }
     }
 
-    map.areaMapOffset = sizeof(map);
+    map.areaMapOffset = AlignSection(sizeof(map));
     map.areaMapSize   = sizeof(map_areaHeader);
 
     map_areaHeader areaHeader;
@@ -661,7 +705,7 @@ bool ConvertADT(char *filename, char *filename2, int /*cell_y*/, int /*cell_x*/,
             maxHeight = CONF_use_minHeight;
     }
 
-    map.heightMapOffset = map.areaMapOffset + map.areaMapSize;
+    map.heightMapOffset = AlignSection(map.areaMapOffset + map.areaMapSize);
     map.heightMapSize = sizeof(map_heightHeader);
 
     map_heightHeader heightHeader;
@@ -907,7 +951,7 @@ bool ConvertADT(char *filename, char *filename2, int /*cell_y*/, int /*cell_x*/,
                     liquid_height[y][x] = CONF_use_minHeight;
             }
         }
-        map.liquidMapOffset = map.heightMapOffset + map.heightMapSize;
+        map.liquidMapOffset = AlignSection(map.heightMapOffset + map.heightMapSize);
         map.liquidMapSize = sizeof(map_liquidHeader);
         liquidHeader.fourcc = *(uint32 const*)MAP_LIQUID_MAGIC;
         liquidHeader.flags = 0;
@@ -941,9 +985,9 @@ bool ConvertADT(char *filename, char *filename2, int /*cell_y*/, int /*cell_x*/,
     uint16 holes[ADT_CELLS_PER_GRID][ADT_CELLS_PER_GRID];
 
     if (map.liquidMapOffset)
-        map.holesOffset = map.liquidMapOffset + map.liquidMapSize;
+        map.holesOffset = AlignSection(map.liquidMapOffset + map.liquidMapSize);
     else
-        map.holesOffset = map.heightMapOffset + map.heightMapSize;
+        map.holesOffset = AlignSection(map.heightMapOffset + map.heightMapSize);
 
     memset(holes, 0, sizeof(holes));
     bool hasHoles = false;
@@ -975,11 +1019,13 @@ bool ConvertADT(char *filename, char *filename2, int /*cell_y*/, int /*cell_x*/,
     }
     fwrite(&map, sizeof(map), 1, output);
     // Store area data
+    PadSection(output, map.areaMapOffset);
     fwrite(&areaHeader, sizeof(areaHeader), 1, output);
     if (!(areaHeader.flags & MAP_AREA_NO_AREA))
         fwrite(area_flags, sizeof(area_flags), 1, output);
 
     // Store height data
+    PadSection(output, map.heightMapOffset);
     fwrite(&heightHeader, sizeof(heightHeader), 1, output);
     if (!(heightHeader.flags & MAP_HEIGHT_NO_HEIGHT))
     {
@@ -1003,6 +1049,7 @@ bool ConvertADT(char *filename, char *filename2, int /*cell_y*/, int /*cell_x*/,
     // Store liquid data if need
     if (map.liquidMapOffset)
     {
+        PadSection(output, map.liquidMapOffset);
         fwrite(&liquidHeader, sizeof(liquidHeader), 1, output);
         if (!(liquidHeader.flags & MAP_LIQUID_NO_TYPE))
         {
@@ -1019,17 +1066,82 @@ bool ConvertADT(char *filename, char *filename2, int /*cell_y*/, int /*cell_x*/,
 
     // store hole data
     if (hasHoles)
+    {
+        PadSection(output, map.holesOffset);
         fwrite(holes, map.holesSize, 1, output);
+    }
 
     fclose(output);
 
     return true;
 }
 
+struct TileJob
+{
+    uint32 mapIndex;
+    uint32 y;
+    uint32 x;
+};
+
+// FNV-1a, identifies the source data of a tile between runs
+uint64 HashData(uint64 hash, void const* data, size_t size)
+{
+    uint8 const* bytes = static_cast<uint8 const*>(data);
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+    return hash;
+}
+
+// Everything besides the adt itself that ends up in the .map file
+uint64 HashConversionSettings(uint32 build)
+{
+    uint64 hash = 0xCBF29CE484222325ULL;
+    hash = HashData(hash, MAP_VERSION_MAGIC, 4);
+    hash = HashData(hash, &build, sizeof(build));
+    hash = HashData(hash, &CONF_allow_height_limit, sizeof(CONF_allow_height_limit));
+    hash = HashData(hash, &CONF_use_minHeight, sizeof(CONF_use_minHeight));
+    hash = HashData(hash, &CONF_allow_float_to_int, sizeof(CONF_allow_float_to_int));
+    hash = HashData(hash, &CONF_float_to_int8_limit, sizeof(CONF_float_to_int8_limit));
+    hash = HashData(hash, &CONF_float_to_int16_limit, sizeof(CONF_float_to_int16_limit));
+    hash = HashData(hash, &CONF_flat_height_delta_limit, sizeof(CONF_flat_height_delta_limit));
+    hash = HashData(hash, &CONF_flat_liquid_delta_limit, sizeof(CONF_flat_liquid_delta_limit));
+    hash = HashData(hash, areas, (maxAreaId + 1) * sizeof(uint16));
+    hash = HashData(hash, LiqType, (maxLiquidTypeId + 1) * sizeof(uint16));
+    return hash;
+}
+
+// Checksums of the tiles written by previous runs, one "<map file> <checksum>" line per tile.
+// Lines are appended as tiles finish so an interrupted run can be resumed, the file is
+// rewritten sorted once all tiles are done.
+typedef std::map<uint32, uint64> TileChecksums;
+
+uint32 TileKey(uint32 mapId, uint32 y, uint32 x)
+{
+    return mapId * 10000 + y * 100 + x;
+}
+
+void LoadTileChecksums(std::string const& fileName, TileChecksums& checksums)
+{
+    FILE* file = fopen(fileName.c_str(), "r");
+    if (!file)
+        return;
+
+    uint32 key, high, low;
+    while (fscanf(file, "%u %8x%8x", &key, &high, &low) == 3)
+        checksums[key] = (uint64(high) << 32) | low;
+
+    fclose(file);
+}
+
+void WriteTileChecksum(FILE* file, uint32 key, uint64 checksum)
+{
+    fprintf(file, "%07u %08x%08x\n", key, uint32(checksum >> 32), uint32(checksum));
+}
+
+void LoadCommonMPQFiles(uint32 build, bool log = true);
+
 void ExtractMapsFromMpq(uint32 build)
 {
-    char mpq_filename[1024];
-    char output_filename[1024];
     char mpq_map_name[1024];
 
     printf("Extracting maps...\n");
@@ -1043,7 +1155,15 @@ void ExtractMapsFromMpq(uint32 build)
     path += "/maps/";
     CreateDir(path);
 
+    std::string const checksumsFile = path + "extract.checksums";
+    TileChecksums previousChecksums;
+    if (CONF_resume)
+        LoadTileChecksums(checksumsFile, previousChecksums);
+
+    uint64 const settingsHash = HashConversionSettings(build);
+
     printf("Convert map files\n");
+    std::vector<TileJob> jobs;
     for (uint32 z = 0; z < map_count; ++z)
     {
         printf("Extract %s (%d/%u)                  \n", map_ids[z].name, z+1, map_count);
@@ -1060,17 +1180,109 @@ void ExtractMapsFromMpq(uint32 build)
                 if (!(wdt.main->adt_list[y][x].flag & 0x1))
                     continue;
 
-                sprintf(mpq_filename, "World\\Maps\\%s\\%s_%u_%u.adt", map_ids[z].name, map_ids[z].name, x, y);
-                sprintf(output_filename, "%s/maps/%03u%02u%02u.map", output_path, map_ids[z].id, y, x);
-                ConvertADT(mpq_filename, output_filename, y, x, build);
+                TileJob job = { z, y, x };
+                jobs.push_back(job);
             }
-
-            // draw progress bar
-            printf("Processing........................%d%%\r", (100 * (y+1)) / WDT_MAP_SIZE);
         }
     }
 
+    // the queue is filled up front, the workers only drain it
+    Trinity::SynchronizedQueue<TileJob> queue;
+    for (std::vector<TileJob>::const_iterator itr = jobs.begin(); itr != jobs.end(); ++itr)
+        queue.push(*itr);
+
+    uint32 threads = CONF_threads ? CONF_threads : std::thread::hardware_concurrency();
+    if (!threads)
+        threads = 1;
+
+    printf("Converting %u tiles using %u threads\n", uint32(jobs.size()), threads);
+
+    TileChecksums checksums;
+    std::mutex checksumsLock;
+    FILE* checksumsOutput = fopen(checksumsFile.c_str(), "a");
+    std::atomic<uint32> tilesDone(0);
+    std::atomic<uint32> tilesSkipped(0);
+
+    std::vector<std::thread> workers;
+    for (uint32 i = 0; i < threads; ++i)
+    {
+        workers.push_back(std::thread([&]()
+        {
+            LoadCommonMPQFiles(build, false);
+
+            char mpq_filename[1024];
+            char output_filename[1024];
+            char temp_filename[1024];
+
+            TileJob job;
+            while (queue.try_pop(job))
+            {
+                map_id const& map = map_ids[job.mapIndex];
+                uint32 const key = TileKey(map.id, job.y, job.x);
+                sprintf(mpq_filename, "World\\Maps\\%s\\%s_%u_%u.adt", map.name, map.name, job.x, job.y);
+                sprintf(output_filename, "%s/maps/%03u%02u%02u.map", output_path, map.id, job.y, job.x);
+
+                ADT_file adt;
+                if (adt.loadFile(WorldMpq, mpq_filename))
+                {
+                    uint64 const checksum = HashData(settingsHash, adt.GetData(), adt.GetDataSize());
+
+                    TileChecksums::const_iterator previous = previousChecksums.find(key);
+                    bool converted = previous != previousChecksums.end() && previous->second == checksum && FileExists(output_filename);
+                    if (converted)
+                        ++tilesSkipped;
+                    else
+                    {
+                        // written aside and renamed, an interrupted run never leaves a partial .map file behind
+                        sprintf(temp_filename, "%s.tmp", output_filename);
+                        converted = ConvertADT(adt, mpq_filename, temp_filename, build);
+                        if (converted)
+                        {
+                            remove(output_filename);
+                            converted = rename(temp_filename, output_filename) == 0;
+                        }
+                    }
+
+                    if (converted)
+                    {
+                        std::lock_guard<std::mutex> guard(checksumsLock);
+                        checksums[key] = checksum;
+                        if (checksumsOutput)
+                        {
+                            WriteTileChecksum(checksumsOutput, key, checksum);
+                            fflush(checksumsOutput);
+                        }
+                    }
+                }
+
+                // draw progress bar
+                uint32 const done = ++tilesDone;
+                if (done % 64 == 0 || done == jobs.size())
+                    printf("Processing........................%u%%\r", uint32((100 * uint64(done)) / jobs.size()));
+            }
+
+            SFileCloseArchive(WorldMpq);
+        }));
+    }
+
+    for (std::vector<std::thread>::iterator itr = workers.begin(); itr != workers.end(); ++itr)
+        itr->join();
+
+    if (checksumsOutput)
+        fclose(checksumsOutput);
+
+    // same content for the same input, no matter which thread finished first
+    if (FILE* output = fopen(checksumsFile.c_str(), "w"))
+    {
+        for (TileChecksums::const_iterator itr = checksums.begin(); itr != checksums.end(); ++itr)
+            WriteTileChecksum(output, itr->first, itr->second);
+        fclose(output);
+    }
+
     printf("\n");
+    if (tilesSkipped)
+        printf("Skipped %u unchanged tiles\n", uint32(tilesSkipped));
+
     delete [] areas;
     delete [] map_ids;
 }
@@ -1266,12 +1478,13 @@ bool LoadLocaleMPQFile(int locale)
     return true;
 }
 
-void LoadCommonMPQFiles(uint32 build)
+void LoadCommonMPQFiles(uint32 build, bool log)
 {
     TCHAR filename[512];
 
     _stprintf(filename, _T("%s/Data/world.MPQ"), input_path);
-    _tprintf(_T("Loading common MPQ files\n"));
+    if (log)
+        _tprintf(_T("Loading common MPQ files\n"));
     if (!SFileOpenArchive(filename, 0, MPQ_OPEN_READ_ONLY, &WorldMpq))
     {
         if (GetLastError() != ERROR_PATH_NOT_FOUND)
@@ -1287,10 +1500,10 @@ void LoadCommonMPQFiles(uint32 build)
         {
             if (GetLastError() != ERROR_PATH_NOT_FOUND)
                 _tprintf(_T("Cannot open archive %s\n"), filename);
-            else
+            else if (log)
                 _tprintf(_T("Not found %s\n"), filename);
         }
-        else
+        else if (log)
             _tprintf(_T("Loaded %s\n"), filename);
 
     }
@@ -1309,15 +1522,16 @@ void LoadCommonMPQFiles(uint32 build)
         {
             if (GetLastError() != ERROR_PATH_NOT_FOUND)
                 _tprintf(_T("Cannot open patch archive %s\n"), filename);
-            else
+            else if (log)
                 _tprintf(_T("Not found %s\n"), filename);
             continue;
         }
-        else
+        else if (log)
             _tprintf(_T("Loaded %s\n"), filename);
     }
 
-    printf("\n");
+    if (log)
+        printf("\n");
 }
 
 int main(int argc, char * arg[])
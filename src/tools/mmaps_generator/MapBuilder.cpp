@@ -0,0 +1,561 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MapBuilder.h"
+#include "PathCommon.h"
+#include "SynchronizedQueue.hpp"
+
+#include "DetourCommon.h"
+#include "DetourNavMeshBuilder.h"
+
+#include <cfloat>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+namespace MMAP
+{
+    // fixed origin, so every tile can be built without knowing the other tiles of its map
+    static const float NAVMESH_ORIGIN[3] = { -32*GRID_SIZE, 0.0f, -32*GRID_SIZE };
+
+    static uint32 packTileID(uint32 tileX, uint32 tileY) { return tileX << 16 | tileY; }
+
+    MapBuilder::MapBuilder(std::string const& dataPath, float maxWalkableAngle, bool skipLiquid, bool bigBaseUnit, bool silent) :
+        m_dataPath(dataPath), m_maxWalkableAngle(maxWalkableAngle), m_skipLiquid(skipLiquid),
+        m_bigBaseUnit(bigBaseUnit), m_silent(silent), m_tilesDone(0), m_tilesTotal(0)
+    {
+        discoverTiles();
+    }
+
+    /**************************************************************************/
+    void MapBuilder::discoverTiles()
+    {
+        std::vector<std::string> files;
+        uint32 mapID, tileX, tileY;
+
+        printf("Discovering maps... ");
+        getDirContents(files, m_dataPath + "/maps", "*.map");
+        for (uint32 i = 0; i < files.size(); ++i)
+        {
+            // mapID, then the map file naming order, which is tileY first
+            mapID = uint32(atoi(files[i].substr(0, 3).c_str()));
+            tileY = uint32(atoi(files[i].substr(3, 2).c_str()));
+            tileX = uint32(atoi(files[i].substr(5, 2).c_str()));
+            m_tiles[mapID].insert(packTileID(tileX, tileY));
+        }
+
+        files.clear();
+        getDirContents(files, m_dataPath + "/vmaps", "*.vmtile");
+        for (uint32 i = 0; i < files.size(); ++i)
+        {
+            mapID = uint32(atoi(files[i].substr(0, 3).c_str()));
+            tileX = uint32(atoi(files[i].substr(4, 2).c_str()));
+            tileY = uint32(atoi(files[i].substr(7, 2).c_str()));
+            m_tiles[mapID].insert(packTileID(tileX, tileY));
+        }
+
+        uint32 count = 0;
+        for (std::map<uint32, std::set<uint32> >::const_iterator itr = m_tiles.begin(); itr != m_tiles.end(); ++itr)
+            count += itr->second.size();
+
+        printf("found %u maps, %u tiles\n", uint32(m_tiles.size()), count);
+    }
+
+    /**************************************************************************/
+    void MapBuilder::buildAllMaps(uint32 threads)
+    {
+        std::vector<TileJob> jobs;
+        for (std::map<uint32, std::set<uint32> >::const_iterator itr = m_tiles.begin(); itr != m_tiles.end(); ++itr)
+        {
+            if (!buildNavMeshParams(itr->first))
+                continue;
+
+            for (std::set<uint32>::const_iterator tile = itr->second.begin(); tile != itr->second.end(); ++tile)
+            {
+                TileJob job = { itr->first, *tile >> 16, *tile & 0xFFFF };
+                jobs.push_back(job);
+            }
+        }
+
+        runJobs(jobs, threads);
+    }
+
+    /**************************************************************************/
+    void MapBuilder::buildMap(uint32 mapID, uint32 threads)
+    {
+        std::map<uint32, std::set<uint32> >::const_iterator itr = m_tiles.find(mapID);
+        if (itr == m_tiles.end() || !buildNavMeshParams(mapID))
+        {
+            printf("[Map %03u] No tiles found\n", mapID);
+            return;
+        }
+
+        std::vector<TileJob> jobs;
+        for (std::set<uint32>::const_iterator tile = itr->second.begin(); tile != itr->second.end(); ++tile)
+        {
+            TileJob job = { mapID, *tile >> 16, *tile & 0xFFFF };
+            jobs.push_back(job);
+        }
+
+        runJobs(jobs, threads);
+    }
+
+    /**************************************************************************/
+    void MapBuilder::buildSingleTile(uint32 mapID, uint32 tileX, uint32 tileY)
+    {
+        if (!buildNavMeshParams(mapID))
+            return;
+
+        TileJob job = { mapID, tileX, tileY };
+        runJobs(std::vector<TileJob>(1, job), 1);
+    }
+
+    /**************************************************************************/
+    void MapBuilder::runJobs(std::vector<TileJob> const& jobs, uint32 threads)
+    {
+        m_tilesDone = 0;
+        m_tilesTotal = jobs.size();
+
+        // the queue is filled up front, the workers only drain it
+        Trinity::SynchronizedQueue<TileJob> queue;
+        for (std::vector<TileJob>::const_iterator itr = jobs.begin(); itr != jobs.end(); ++itr)
+            queue.push(*itr);
+
+        if (!threads)
+            threads = 1;
+
+        printf("Building %u tiles using %u threads\n", m_tilesTotal, threads);
+
+        std::vector<std::thread> workers;
+        for (uint32 i = 0; i < threads; ++i)
+        {
+            workers.push_back(std::thread([this, &queue]()
+            {
+                // tiles only depend on their input files, so the output does not
+                // depend on which worker builds which tile
+                TerrainBuilder terrainBuilder(m_dataPath, m_skipLiquid);
+                rcContext context(false);
+                uint32 lastMapID = uint32(-1);
+
+                TileJob job;
+                while (queue.try_pop(job))
+                {
+                    if (job.mapID != lastMapID)
+                    {
+                        terrainBuilder.clearModels();
+                        lastMapID = job.mapID;
+                    }
+
+                    buildTile(job, terrainBuilder, context);
+                }
+            }));
+        }
+
+        for (std::vector<std::thread>::iterator itr = workers.begin(); itr != workers.end(); ++itr)
+            itr->join();
+    }
+
+    /**************************************************************************/
+    bool MapBuilder::buildNavMeshParams(uint32 mapID)
+    {
+        std::map<uint32, std::set<uint32> >::const_iterator itr = m_tiles.find(mapID);
+        uint32 maxTiles = itr != m_tiles.end() ? itr->second.size() : 1;
+
+        dtNavMeshParams navMeshParams;
+        memset(&navMeshParams, 0, sizeof(dtNavMeshParams));
+        navMeshParams.tileWidth = GRID_SIZE;
+        navMeshParams.tileHeight = GRID_SIZE;
+        rcVcopy(navMeshParams.orig, NAVMESH_ORIGIN);
+        navMeshParams.maxTiles = maxTiles;
+        // poly refs always use STATIC_POLY_BITS, the value only has to be large enough
+        navMeshParams.maxPolys = INT_MAX;
+
+        char fileName[255];
+        snprintf(fileName, sizeof(fileName), "%s/mmaps/%03u.mmap", m_dataPath.c_str(), mapID);
+        FILE* file = fopen(fileName, "wb");
+        if (!file)
+        {
+            perror(fileName);
+            return false;
+        }
+
+        // now that we know navMesh params are valid, we can write them to file
+        fwrite(&navMeshParams, sizeof(dtNavMeshParams), 1, file);
+        fclose(file);
+        return true;
+    }
+
+    /**************************************************************************/
+    void MapBuilder::buildTile(TileJob const& job, TerrainBuilder &terrainBuilder, rcContext &context)
+    {
+        MeshData meshData;
+
+        // get heightmap data
+        terrainBuilder.loadMap(job.mapID, job.tileX, job.tileY, meshData);
+
+        // get model data
+        terrainBuilder.loadVMap(job.mapID, job.tileX, job.tileY, meshData);
+
+        // remove unused vertices
+        TerrainBuilder::cleanVertices(meshData.solidVerts, meshData.solidTris);
+        TerrainBuilder::cleanVertices(meshData.liquidVerts, meshData.liquidTris);
+
+        // gather all mesh data for final data check, and bounds calculation
+        std::vector<float> allVerts(meshData.liquidVerts);
+        allVerts.insert(allVerts.end(), meshData.solidVerts.begin(), meshData.solidVerts.end());
+
+        if (!allVerts.empty())
+        {
+            // get bounds of current tile
+            float bmin[3], bmax[3];
+            getTileBounds(job.tileX, job.tileY, &allVerts[0], allVerts.size() / 3, bmin, bmax);
+
+            // build navmesh tile
+            buildMoveMapTile(job, meshData, bmin, bmax, terrainBuilder.usesLiquids(), context);
+        }
+
+        uint32 done = ++m_tilesDone;
+        if (!m_silent)
+            printf("[Map %03u] [%02u,%02u] done, %u of %u tiles\n", job.mapID, job.tileX, job.tileY, done, m_tilesTotal);
+    }
+
+    /**************************************************************************/
+    // per subtile intermediate results, released as soon as the subtile is merged
+    struct SubTile
+    {
+        SubTile() : solid(NULL), chf(NULL), cset(NULL), pmesh(NULL), dmesh(NULL) { }
+        SubTile(SubTile const&) = delete;
+        SubTile& operator=(SubTile const&) = delete;
+        ~SubTile()
+        {
+            rcFreeHeightField(solid);
+            rcFreeCompactHeightfield(chf);
+            rcFreeContourSet(cset);
+            rcFreePolyMesh(pmesh);
+            rcFreePolyMeshDetail(dmesh);
+        }
+
+        rcHeightfield* solid;
+        rcCompactHeightfield* chf;
+        rcContourSet* cset;
+        rcPolyMesh* pmesh;
+        rcPolyMeshDetail* dmesh;
+    };
+
+    void MapBuilder::buildMoveMapTile(TileJob const& job, MeshData &meshData, float* bmin, float* bmax, bool usesLiquids, rcContext &context)
+    {
+        char tileString[32];
+        snprintf(tileString, sizeof(tileString), "[Map %03u] [%02u,%02u]:", job.mapID, job.tileX, job.tileY);
+
+        float* tVerts = meshData.solidVerts.empty() ? NULL : &meshData.solidVerts[0];
+        int tVertCount = meshData.solidVerts.size() / 3;
+        int* tTris = meshData.solidTris.empty() ? NULL : &meshData.solidTris[0];
+        int tTriCount = meshData.solidTris.size() / 3;
+
+        float* lVerts = meshData.liquidVerts.empty() ? NULL : &meshData.liquidVerts[0];
+        int lVertCount = meshData.liquidVerts.size() / 3;
+        int* lTris = meshData.liquidTris.empty() ? NULL : &meshData.liquidTris[0];
+        int lTriCount = meshData.liquidTris.size() / 3;
+        uint8* lTriFlags = meshData.liquidType.empty() ? NULL : &meshData.liquidType[0];
+
+        // these are WORLD UNIT based metrics
+        // this are basic unit dimentions
+        // value have to divide GRID_SIZE(533.3333f) ( aka: 0.5333, 0.2666, 0.3333, 0.1333, etc )
+        float const BASE_UNIT_DIM = m_bigBaseUnit ? 0.5333333f : 0.2666666f;
+
+        // All are in UNIT metrics!
+        int const VERTEX_PER_MAP = int(GRID_SIZE/BASE_UNIT_DIM + 0.5f);
+        int const VERTEX_PER_TILE = m_bigBaseUnit ? 40 : 80; // must divide VERTEX_PER_MAP
+        int const TILES_PER_MAP = VERTEX_PER_MAP/VERTEX_PER_TILE;
+
+        rcConfig config;
+        memset(&config, 0, sizeof(rcConfig));
+
+        rcVcopy(config.bmin, bmin);
+        rcVcopy(config.bmax, bmax);
+
+        config.maxVertsPerPoly = DT_VERTS_PER_POLYGON;
+        config.cs = BASE_UNIT_DIM;
+        config.ch = BASE_UNIT_DIM;
+        config.walkableSlopeAngle = m_maxWalkableAngle;
+        config.tileSize = VERTEX_PER_TILE;
+        config.walkableRadius = m_bigBaseUnit ? 1 : 2;
+        config.borderSize = config.walkableRadius + 3;
+        config.maxEdgeLen = VERTEX_PER_TILE + 1;        // anything bigger than tileSize
+        config.walkableHeight = m_bigBaseUnit ? 3 : 6;
+        // a value >= 3|6 allows npcs to walk over some fences
+        // a value >= 4|8 allows npcs to walk over all fences
+        config.walkableClimb = m_bigBaseUnit ? 2 : 4;
+        config.minRegionArea = rcSqr(60);
+        config.mergeRegionArea = rcSqr(50);
+        config.maxSimplificationError = 1.8f;           // eliminates most jagged edges (tiny polygons)
+        config.detailSampleDist = config.cs * 64;
+        config.detailSampleMaxError = config.ch * 2;
+
+        // this sets the dimensions of the heightfield - should maybe happen before border padding
+        rcCalcGridSize(config.bmin, config.bmax, config.cs, &config.width, &config.height);
+
+        // Initialize per tile config.
+        rcConfig tileCfg = config;
+        tileCfg.width = config.tileSize + config.borderSize*2;
+        tileCfg.height = config.tileSize + config.borderSize*2;
+
+        std::vector<SubTile> tiles(TILES_PER_MAP * TILES_PER_MAP);
+
+        // merge per tile poly and detail meshes
+        std::vector<rcPolyMesh*> pmmerge;
+        std::vector<rcPolyMeshDetail*> dmmerge;
+        pmmerge.reserve(tiles.size());
+        dmmerge.reserve(tiles.size());
+
+        std::vector<unsigned char> triFlags(tTriCount);
+
+        // build all tiles
+        for (int y = 0; y < TILES_PER_MAP; ++y)
+        {
+            for (int x = 0; x < TILES_PER_MAP; ++x)
+            {
+                SubTile& tile = tiles[x + y * TILES_PER_MAP];
+
+                // Calculate the per tile bounding box.
+                tileCfg.bmin[0] = config.bmin[0] + float(x*config.tileSize - config.borderSize)*config.cs;
+                tileCfg.bmin[2] = config.bmin[2] + float(y*config.tileSize - config.borderSize)*config.cs;
+                tileCfg.bmax[0] = config.bmin[0] + float((x+1)*config.tileSize + config.borderSize)*config.cs;
+                tileCfg.bmax[2] = config.bmin[2] + float((y+1)*config.tileSize + config.borderSize)*config.cs;
+
+                // build heightfield
+                tile.solid = rcAllocHeightfield();
+                if (!tile.solid || !rcCreateHeightfield(&context, *tile.solid, tileCfg.width, tileCfg.height, tileCfg.bmin, tileCfg.bmax, tileCfg.cs, tileCfg.ch))
+                {
+                    printf("%s Failed building heightfield!\n", tileString);
+                    continue;
+                }
+
+                // mark all walkable tiles, both liquids and solids
+                if (tTriCount)
+                {
+                    std::fill(triFlags.begin(), triFlags.end(), NAV_GROUND);
+                    rcClearUnwalkableTriangles(&context, tileCfg.walkableSlopeAngle, tVerts, tVertCount, tTris, tTriCount, &triFlags[0]);
+                    rcRasterizeTriangles(&context, tVerts, tVertCount, tTris, &triFlags[0], tTriCount, *tile.solid, config.walkableClimb);
+                }
+
+                rcFilterLowHangingWalkableObstacles(&context, config.walkableClimb, *tile.solid);
+                rcFilterLedgeSpans(&context, tileCfg.walkableHeight, tileCfg.walkableClimb, *tile.solid);
+                rcFilterWalkableLowHeightSpans(&context, tileCfg.walkableHeight, *tile.solid);
+
+                if (lTriCount)
+                    rcRasterizeTriangles(&context, lVerts, lVertCount, lTris, lTriFlags, lTriCount, *tile.solid, config.walkableClimb);
+
+                // compact heightfield spans
+                tile.chf = rcAllocCompactHeightfield();
+                if (!tile.chf || !rcBuildCompactHeightfield(&context, tileCfg.walkableHeight, tileCfg.walkableClimb, *tile.solid, *tile.chf))
+                {
+                    printf("%s Failed compacting heightfield!\n", tileString);
+                    continue;
+                }
+
+                // build polymesh intermediates
+                if (!rcErodeWalkableArea(&context, config.walkableRadius, *tile.chf))
+                {
+                    printf("%s Failed eroding area!\n", tileString);
+                    continue;
+                }
+
+                if (!rcBuildDistanceField(&context, *tile.chf))
+                {
+                    printf("%s Failed building distance field!\n", tileString);
+                    continue;
+                }
+
+                if (!rcBuildRegions(&context, *tile.chf, tileCfg.borderSize, tileCfg.minRegionArea, tileCfg.mergeRegionArea))
+                {
+                    printf("%s Failed building regions!\n", tileString);
+                    continue;
+                }
+
+                tile.cset = rcAllocContourSet();
+                if (!tile.cset || !rcBuildContours(&context, *tile.chf, tileCfg.maxSimplificationError, tileCfg.maxEdgeLen, *tile.cset))
+                {
+                    printf("%s Failed building contours!\n", tileString);
+                    continue;
+                }
+
+                // build polymesh
+                tile.pmesh = rcAllocPolyMesh();
+                if (!tile.pmesh || !rcBuildPolyMesh(&context, *tile.cset, tileCfg.maxVertsPerPoly, *tile.pmesh))
+                {
+                    printf("%s Failed building polymesh!\n", tileString);
+                    continue;
+                }
+
+                tile.dmesh = rcAllocPolyMeshDetail();
+                if (!tile.dmesh || !rcBuildPolyMeshDetail(&context, *tile.pmesh, *tile.chf, tileCfg.detailSampleDist, tileCfg.detailSampleMaxError, *tile.dmesh))
+                {
+                    printf("%s Failed building polymesh detail!\n", tileString);
+                    continue;
+                }
+
+                // free those up, only the meshes are merged
+                rcFreeHeightField(tile.solid);
+                tile.solid = NULL;
+                rcFreeCompactHeightfield(tile.chf);
+                tile.chf = NULL;
+                rcFreeContourSet(tile.cset);
+                tile.cset = NULL;
+
+                pmmerge.push_back(tile.pmesh);
+                dmmerge.push_back(tile.dmesh);
+            }
+        }
+
+        if (pmmerge.empty())
+            return;
+
+        SubTile merged;
+        merged.pmesh = rcAllocPolyMesh();
+        merged.dmesh = rcAllocPolyMeshDetail();
+        if (!merged.pmesh || !merged.dmesh ||
+            !rcMergePolyMeshes(&context, &pmmerge[0], pmmerge.size(), *merged.pmesh) ||
+            !rcMergePolyMeshDetails(&context, &dmmerge[0], dmmerge.size(), *merged.dmesh))
+        {
+            printf("%s Failed merging subtile meshes!\n", tileString);
+            return;
+        }
+
+        // the merged meshes are copies
+        tiles.clear();
+
+        rcPolyMesh& polyMesh = *merged.pmesh;
+        rcPolyMeshDetail& polyMeshDetail = *merged.dmesh;
+
+        // set polygons as walkable
+        for (int i = 0; i < polyMesh.npolys; ++i)
+            if (polyMesh.areas[i] & RC_WALKABLE_AREA)
+                polyMesh.flags[i] = polyMesh.areas[i];
+
+        // setup mesh parameters
+        dtNavMeshCreateParams params;
+        memset(&params, 0, sizeof(params));
+        params.verts = polyMesh.verts;
+        params.vertCount = polyMesh.nverts;
+        params.polys = polyMesh.polys;
+        params.polyAreas = polyMesh.areas;
+        params.polyFlags = polyMesh.flags;
+        params.polyCount = polyMesh.npolys;
+        params.nvp = polyMesh.nvp;
+        params.detailMeshes = polyMeshDetail.meshes;
+        params.detailVerts = polyMeshDetail.verts;
+        params.detailVertsCount = polyMeshDetail.nverts;
+        params.detailTris = polyMeshDetail.tris;
+        params.detailTriCount = polyMeshDetail.ntris;
+
+        params.walkableHeight = BASE_UNIT_DIM*config.walkableHeight;    // agent height
+        params.walkableRadius = BASE_UNIT_DIM*config.walkableRadius;    // agent radius
+        params.walkableClimb = BASE_UNIT_DIM*config.walkableClimb;      // keep less that walkableHeight (aka agent height)!
+        params.tileX = (((bmin[0] + bmax[0]) / 2) - NAVMESH_ORIGIN[0]) / GRID_SIZE;
+        params.tileY = (((bmin[2] + bmax[2]) / 2) - NAVMESH_ORIGIN[2]) / GRID_SIZE;
+        rcVcopy(params.bmin, bmin);
+        rcVcopy(params.bmax, bmax);
+        params.cs = config.cs;
+        params.ch = config.ch;
+        params.tileLayer = 0;
+        params.buildBvTree = true;
+
+        // these values are checked within dtCreateNavMeshData - handle them here
+        // so we have a clear error message
+        if (params.nvp > DT_VERTS_PER_POLYGON)
+        {
+            printf("%s Invalid verts-per-polygon value!\n", tileString);
+            return;
+        }
+
+        if (params.vertCount >= 0xffff)
+        {
+            printf("%s Too many vertices!\n", tileString);
+            return;
+        }
+
+        // occurs mostly when adjacent tiles have models
+        // loaded but those models don't span into this tile
+        if (!params.vertCount || !params.verts)
+            return;
+
+        // we have flat tiles with no actual geometry - don't build those, its useless
+        // drop tiles with only exact count - some tiles may have geometry while having less tiles
+        if (!params.polyCount || !params.polys || TILES_PER_MAP*TILES_PER_MAP == params.polyCount)
+            return;
+
+        if (!params.detailMeshes || !params.detailVerts || !params.detailTris)
+        {
+            printf("%s No detail mesh to build tile!\n", tileString);
+            return;
+        }
+
+        // will hold final navmesh
+        unsigned char* navData = NULL;
+        int navDataSize = 0;
+        if (!dtCreateNavMeshData(&params, &navData, &navDataSize))
+        {
+            printf("%s Failed building navmesh tile!\n", tileString);
+            return;
+        }
+
+        // file output
+        char fileName[255];
+        snprintf(fileName, sizeof(fileName), "%s/mmaps/%03u%02u%02u.mmtile", m_dataPath.c_str(), job.mapID, job.tileY, job.tileX);
+        FILE* file = fopen(fileName, "wb");
+        if (!file)
+        {
+            perror(fileName);
+            dtFree(navData);
+            return;
+        }
+
+        // write header
+        MmapTileHeader header;
+        header.usesLiquids = usesLiquids;
+        header.size = uint32(navDataSize);
+        fwrite(&header, sizeof(MmapTileHeader), 1, file);
+
+        // write data
+        fwrite(navData, sizeof(unsigned char), navDataSize, file);
+        fclose(file);
+
+        dtFree(navData);
+    }
+
+    /**************************************************************************/
+    void MapBuilder::getTileBounds(uint32 tileX, uint32 tileY, float const* verts, int vertCount, float* bmin, float* bmax) const
+    {
+        // this is for elevation
+        if (verts && vertCount)
+            rcCalcBounds(verts, vertCount, bmin, bmax);
+        else
+        {
+            bmin[1] = FLT_MIN;
+            bmax[1] = FLT_MAX;
+        }
+
+        // this is for width and depth
+        bmax[0] = (32 - int(tileX)) * GRID_SIZE;
+        bmax[2] = (32 - int(tileY)) * GRID_SIZE;
+        bmin[0] = bmax[0] - GRID_SIZE;
+        bmin[2] = bmax[2] - GRID_SIZE;
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MAP_BUILDER_H
+#define _MAP_BUILDER_H
+
+#include "TerrainBuilder.h"
+
+#include "Recast.h"
+#include "DetourNavMesh.h"
+
+#include <atomic>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace MMAP
+{
+    class MapBuilder
+    {
+        public:
+            MapBuilder(std::string const& dataPath, float maxWalkableAngle, bool skipLiquid, bool bigBaseUnit, bool silent);
+
+            // builds every tile of every map, or of a single map, on the given number of threads
+            void buildAllMaps(uint32 threads);
+            void buildMap(uint32 mapID, uint32 threads);
+
+            // builds one tile, the .mmap of its map is rewritten as well
+            void buildSingleTile(uint32 mapID, uint32 tileX, uint32 tileY);
+
+        private:
+            struct TileJob
+            {
+                uint32 mapID;
+                uint32 tileX;
+                uint32 tileY;
+            };
+
+            // collects the tiles of all maps from the .map and .vmtile files
+            void discoverTiles();
+
+            bool buildNavMeshParams(uint32 mapID);
+            void runJobs(std::vector<TileJob> const& jobs, uint32 threads);
+            void buildTile(TileJob const& job, TerrainBuilder &terrainBuilder, rcContext &context);
+            void buildMoveMapTile(TileJob const& job, MeshData &meshData, float* bmin, float* bmax, bool usesLiquids, rcContext &context);
+
+            void getTileBounds(uint32 tileX, uint32 tileY, float const* verts, int vertCount, float* bmin, float* bmax) const;
+
+            // tile ids are tileX << 16 | tileY, sorted so the build order does not depend on the directory listing
+            std::map<uint32, std::set<uint32> > m_tiles;
+
+            std::string m_dataPath;
+            float m_maxWalkableAngle;
+            bool m_skipLiquid;
+            bool m_bigBaseUnit;
+            bool m_silent;
+
+            std::atomic<uint32> m_tilesDone;
+            uint32 m_tilesTotal;
+    };
+}
+
+#endif
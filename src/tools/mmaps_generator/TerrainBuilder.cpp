@@ -0,0 +1,868 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TerrainBuilder.h"
+
+#include "BoundingIntervalHierarchy.h"
+#include "Utilities/MapHeightBlocks.h"
+#include "VMapDefinitions.h"
+
+#include <G3D/g3dmath.h>
+
+#include <cstdio>
+#include <cstring>
+
+// ******************************************
+// Map file format defines
+// ******************************************
+struct map_fileheader
+{
+    uint32 mapMagic;
+    uint32 versionMagic;
+    uint32 buildMagic;
+    uint32 areaMapOffset;
+    uint32 areaMapSize;
+    uint32 heightMapOffset;
+    uint32 heightMapSize;
+    uint32 liquidMapOffset;
+    uint32 liquidMapSize;
+    uint32 holesOffset;
+    uint32 holesSize;
+};
+
+#define MAP_HEIGHT_NO_HEIGHT  0x0001
+#define MAP_HEIGHT_AS_INT16   0x0002
+#define MAP_HEIGHT_AS_INT8    0x0004
+
+struct map_heightHeader
+{
+    uint32 fourcc;
+    uint32 flags;
+    float  gridHeight;
+    float  gridMaxHeight;
+};
+
+#define MAP_LIQUID_NO_TYPE    0x0001
+#define MAP_LIQUID_NO_HEIGHT  0x0002
+
+struct map_liquidHeader
+{
+    uint32 fourcc;
+    uint16 flags;
+    uint16 liquidType;
+    uint8  offsetX;
+    uint8  offsetY;
+    uint8  width;
+    uint8  height;
+    float  liquidLevel;
+};
+
+#define MAP_LIQUID_TYPE_NO_WATER    0x00
+#define MAP_LIQUID_TYPE_WATER       0x01
+#define MAP_LIQUID_TYPE_OCEAN       0x02
+#define MAP_LIQUID_TYPE_MAGMA       0x04
+#define MAP_LIQUID_TYPE_SLIME       0x08
+#define MAP_LIQUID_TYPE_DARK_WATER  0x10
+
+static char const* MAP_VERSION_MAGIC = "v1.4";
+
+namespace MMAP
+{
+    TerrainBuilder::TerrainBuilder(std::string const& dataPath, bool skipLiquid) :
+        m_dataPath(dataPath), m_skipLiquid(skipLiquid)
+    {
+    }
+
+    /**************************************************************************/
+    void TerrainBuilder::getLoopVars(Spot portion, int &loopStart, int &loopEnd, int &loopInc) const
+    {
+        switch (portion)
+        {
+            case ENTIRE:
+                loopStart = 0;
+                loopEnd = V8_SIZE_SQ;
+                loopInc = 1;
+                break;
+            case TOP:
+                loopStart = 0;
+                loopEnd = V8_SIZE;
+                loopInc = 1;
+                break;
+            case LEFT:
+                loopStart = 0;
+                loopEnd = V8_SIZE_SQ - V8_SIZE + 1;
+                loopInc = V8_SIZE;
+                break;
+            case RIGHT:
+                loopStart = V8_SIZE - 1;
+                loopEnd = V8_SIZE_SQ;
+                loopInc = V8_SIZE;
+                break;
+            case BOTTOM:
+                loopStart = V8_SIZE_SQ - V8_SIZE;
+                loopEnd = V8_SIZE_SQ;
+                loopInc = 1;
+                break;
+        }
+    }
+
+    /**************************************************************************/
+    bool TerrainBuilder::loadMap(uint32 mapID, uint32 tileX, uint32 tileY, MeshData &meshData)
+    {
+        if (!loadMap(mapID, tileX, tileY, meshData, ENTIRE))
+            return false;
+
+        loadMap(mapID, tileX+1, tileY, meshData, LEFT);
+        loadMap(mapID, tileX-1, tileY, meshData, RIGHT);
+        loadMap(mapID, tileX, tileY+1, meshData, TOP);
+        loadMap(mapID, tileX, tileY-1, meshData, BOTTOM);
+        return true;
+    }
+
+    /**************************************************************************/
+    bool TerrainBuilder::loadMap(uint32 mapID, uint32 tileX, uint32 tileY, MeshData &meshData, Spot portion)
+    {
+        char mapFileName[255];
+        snprintf(mapFileName, sizeof(mapFileName), "%s/maps/%03u%02u%02u.map", m_dataPath.c_str(), mapID, tileY, tileX);
+
+        FILE* mapFile = fopen(mapFileName, "rb");
+        if (!mapFile)
+            return false;
+
+        map_fileheader fheader;
+        if (fread(&fheader, sizeof(map_fileheader), 1, mapFile) != 1 ||
+            fheader.versionMagic != *((uint32 const*)(MAP_VERSION_MAGIC)))
+        {
+            fclose(mapFile);
+            printf("%s is the wrong version, please extract new .map files\n", mapFileName);
+            return false;
+        }
+
+        map_heightHeader hheader;
+        fseek(mapFile, fheader.heightMapOffset, SEEK_SET);
+
+        bool haveTerrain = false;
+        bool haveLiquid = false;
+        if (fread(&hheader, sizeof(map_heightHeader), 1, mapFile) == 1)
+        {
+            haveTerrain = !(hheader.flags & MAP_HEIGHT_NO_HEIGHT);
+            haveLiquid = fheader.liquidMapOffset && !m_skipLiquid;
+        }
+
+        // no data used, return false
+        if (!haveTerrain && !haveLiquid)
+        {
+            fclose(mapFile);
+            return false;
+        }
+
+        // data used later
+        uint16 holes[16][16];
+        memset(holes, 0, sizeof(holes));
+        uint8 liquidFlags[16*16];
+        memset(liquidFlags, 0, sizeof(liquidFlags));
+        std::vector<int> ltriangles;
+        std::vector<int> ttriangles;
+
+        // terrain data
+        if (haveTerrain)
+        {
+            float V9[V9_SIZE_SQ], V8[V8_SIZE_SQ];
+            int expected = V9_SIZE_SQ + V8_SIZE_SQ;
+            if (hheader.flags & MAP_HEIGHT_AS_BLOCKS)
+            {
+                map_heightBlock blocks[MAP_HEIGHT_BLOCKS * MAP_HEIGHT_BLOCKS];
+                int count = fread(blocks, sizeof(map_heightBlock), MAP_HEIGHT_BLOCKS * MAP_HEIGHT_BLOCKS, mapFile);
+                if (count != MAP_HEIGHT_BLOCKS * MAP_HEIGHT_BLOCKS)
+                    printf("TerrainBuilder::loadMap: Failed to read some data expected %d, read %d\n", MAP_HEIGHT_BLOCKS * MAP_HEIGHT_BLOCKS, count);
+
+                MapHeightBlocks::Decode(blocks, V9, V8);
+            }
+            else if (hheader.flags & MAP_HEIGHT_AS_INT8)
+            {
+                uint8 v9[V9_SIZE_SQ];
+                uint8 v8[V8_SIZE_SQ];
+                int count = 0;
+                count += fread(v9, sizeof(uint8), V9_SIZE_SQ, mapFile);
+                count += fread(v8, sizeof(uint8), V8_SIZE_SQ, mapFile);
+                if (count != expected)
+                    printf("TerrainBuilder::loadMap: Failed to read some data expected %d, read %d\n", expected, count);
+
+                float heightMultiplier = (hheader.gridMaxHeight - hheader.gridHeight) / 255;
+
+                for (int i = 0; i < V9_SIZE_SQ; ++i)
+                    V9[i] = (float)v9[i]*heightMultiplier + hheader.gridHeight;
+
+                for (int i = 0; i < V8_SIZE_SQ; ++i)
+                    V8[i] = (float)v8[i]*heightMultiplier + hheader.gridHeight;
+            }
+            else if (hheader.flags & MAP_HEIGHT_AS_INT16)
+            {
+                uint16 v9[V9_SIZE_SQ];
+                uint16 v8[V8_SIZE_SQ];
+                int count = 0;
+                count += fread(v9, sizeof(uint16), V9_SIZE_SQ, mapFile);
+                count += fread(v8, sizeof(uint16), V8_SIZE_SQ, mapFile);
+                if (count != expected)
+                    printf("TerrainBuilder::loadMap: Failed to read some data expected %d, read %d\n", expected, count);
+
+                float heightMultiplier = (hheader.gridMaxHeight - hheader.gridHeight) / 65535;
+
+                for (int i = 0; i < V9_SIZE_SQ; ++i)
+                    V9[i] = (float)v9[i]*heightMultiplier + hheader.gridHeight;
+
+                for (int i = 0; i < V8_SIZE_SQ; ++i)
+                    V8[i] = (float)v8[i]*heightMultiplier + hheader.gridHeight;
+            }
+            else
+            {
+                int count = 0;
+                count += fread(V9, sizeof(float), V9_SIZE_SQ, mapFile);
+                count += fread(V8, sizeof(float), V8_SIZE_SQ, mapFile);
+                if (count != expected)
+                    printf("TerrainBuilder::loadMap: Failed to read some data expected %d, read %d\n", expected, count);
+            }
+
+            // hole data
+            if (fheader.holesSize != 0)
+            {
+                fseek(mapFile, fheader.holesOffset, SEEK_SET);
+                if (fheader.holesSize > sizeof(holes) || fread(holes, fheader.holesSize, 1, mapFile) != 1)
+                {
+                    printf("TerrainBuilder::loadMap: Failed to read hole data\n");
+                    memset(holes, 0, sizeof(holes));
+                }
+            }
+
+            int count = meshData.solidVerts.size() / 3;
+            float xoffset = (float(tileX)-32)*GRID_SIZE;
+            float yoffset = (float(tileY)-32)*GRID_SIZE;
+
+            float coord[3];
+
+            for (int i = 0; i < V9_SIZE_SQ; ++i)
+            {
+                getHeightCoord(i, GRID_V9, xoffset, yoffset, coord, V9);
+                meshData.solidVerts.push_back(coord[0]);
+                meshData.solidVerts.push_back(coord[2]);
+                meshData.solidVerts.push_back(coord[1]);
+            }
+
+            for (int i = 0; i < V8_SIZE_SQ; ++i)
+            {
+                getHeightCoord(i, GRID_V8, xoffset, yoffset, coord, V8);
+                meshData.solidVerts.push_back(coord[0]);
+                meshData.solidVerts.push_back(coord[2]);
+                meshData.solidVerts.push_back(coord[1]);
+            }
+
+            int indices[] = { 0, 0, 0 };
+            int loopStart = 0, loopEnd = 0, loopInc = 0;
+            getLoopVars(portion, loopStart, loopEnd, loopInc);
+            for (int i = loopStart; i < loopEnd; i+=loopInc)
+                for (int j = TOP; j <= BOTTOM; j+=1)
+                {
+                    getHeightTriangle(i, Spot(j), indices);
+                    ttriangles.push_back(indices[2] + count);
+                    ttriangles.push_back(indices[1] + count);
+                    ttriangles.push_back(indices[0] + count);
+                }
+        }
+
+        // liquid data
+        if (haveLiquid)
+        {
+            map_liquidHeader lheader;
+            fseek(mapFile, fheader.liquidMapOffset, SEEK_SET);
+            if (fread(&lheader, sizeof(map_liquidHeader), 1, mapFile) != 1)
+                printf("TerrainBuilder::loadMap: Failed to read some data expected 1, read 0\n");
+
+            if (!(lheader.flags & MAP_LIQUID_NO_TYPE))
+            {
+                // the per chunk liquid entries are not needed, only the type flags
+                fseek(mapFile, 16*16*sizeof(uint16), SEEK_CUR);
+                if (fread(liquidFlags, sizeof(liquidFlags), 1, mapFile) != 1)
+                    printf("TerrainBuilder::loadMap: Failed to read liquid type data\n");
+            }
+            else
+                memset(liquidFlags, uint8(lheader.liquidType), sizeof(liquidFlags));
+
+            std::vector<float> liquidMap;
+            if (!(lheader.flags & MAP_LIQUID_NO_HEIGHT))
+            {
+                uint32 toRead = lheader.width * lheader.height;
+                liquidMap.resize(toRead);
+                if (toRead && fread(&liquidMap[0], sizeof(float), toRead, mapFile) != toRead)
+                {
+                    printf("TerrainBuilder::loadMap: Failed to read some data expected %u\n", toRead);
+                    liquidMap.clear();
+                }
+            }
+
+            int count = meshData.liquidVerts.size() / 3;
+            float xoffset = (float(tileX)-32)*GRID_SIZE;
+            float yoffset = (float(tileY)-32)*GRID_SIZE;
+
+            float coord[3];
+            int row, col;
+
+            // generate coordinates
+            if (!liquidMap.empty())
+            {
+                int j = 0;
+                for (int i = 0; i < V9_SIZE_SQ; ++i)
+                {
+                    row = i / V9_SIZE;
+                    col = i % V9_SIZE;
+
+                    if (row < lheader.offsetY || row >= lheader.offsetY + lheader.height ||
+                        col < lheader.offsetX || col >= lheader.offsetX + lheader.width)
+                    {
+                        // dummy vert using invalid height
+                        meshData.liquidVerts.push_back((xoffset+col*GRID_PART_SIZE)*-1);
+                        meshData.liquidVerts.push_back(INVALID_MAP_LIQ_HEIGHT);
+                        meshData.liquidVerts.push_back((yoffset+row*GRID_PART_SIZE)*-1);
+                        continue;
+                    }
+
+                    getLiquidCoord(i, j, xoffset, yoffset, coord, &liquidMap[0]);
+                    meshData.liquidVerts.push_back(coord[0]);
+                    meshData.liquidVerts.push_back(coord[2]);
+                    meshData.liquidVerts.push_back(coord[1]);
+                    j++;
+                }
+            }
+            else
+            {
+                for (int i = 0; i < V9_SIZE_SQ; ++i)
+                {
+                    row = i / V9_SIZE;
+                    col = i % V9_SIZE;
+                    meshData.liquidVerts.push_back((xoffset+col*GRID_PART_SIZE)*-1);
+                    meshData.liquidVerts.push_back(lheader.liquidLevel);
+                    meshData.liquidVerts.push_back((yoffset+row*GRID_PART_SIZE)*-1);
+                }
+            }
+
+            int indices[] = { 0, 0, 0 };
+            int loopStart = 0, loopEnd = 0, loopInc = 0, triInc = BOTTOM-TOP;
+            getLoopVars(portion, loopStart, loopEnd, loopInc);
+
+            // generate triangles
+            for (int i = loopStart; i < loopEnd; i+=loopInc)
+                for (int j = TOP; j <= BOTTOM; j+= triInc)
+                {
+                    getHeightTriangle(i, Spot(j), indices, true);
+                    ltriangles.push_back(indices[2] + count);
+                    ltriangles.push_back(indices[1] + count);
+                    ltriangles.push_back(indices[0] + count);
+                }
+        }
+
+        fclose(mapFile);
+
+        if (ltriangles.empty() && ttriangles.empty())
+            return false;
+
+        // now that we have gathered the data, we can figure out which parts to keep:
+        // liquid above ground, ground above liquid
+        int loopStart = 0, loopEnd = 0, loopInc = 0, tTriCount = 4;
+        bool useTerrain, useLiquid;
+
+        std::vector<float>& lverts = meshData.liquidVerts;
+        std::vector<float> const& tverts = meshData.solidVerts;
+        uint32 ltri = 0;
+        uint32 ttri = 0;
+
+        // make a copy of liquid vertices
+        // used to pad right-bottom frame due to lost vertex data at extraction
+        std::vector<float> const lvertsCopy(lverts);
+
+        getLoopVars(portion, loopStart, loopEnd, loopInc);
+        for (int i = loopStart; i < loopEnd; i+=loopInc)
+        {
+            for (int j = 0; j < 2; ++j)
+            {
+                // default is true, will change to false if needed
+                useTerrain = true;
+                useLiquid = true;
+                uint8 liquidType = MAP_LIQUID_TYPE_NO_WATER;
+
+                // if there is no liquid, don't use liquid
+                if (lverts.empty() || ltriangles.empty())
+                    useLiquid = false;
+                else
+                {
+                    liquidType = getLiquidType(i, liquidFlags);
+                    if (liquidType & MAP_LIQUID_TYPE_DARK_WATER)
+                    {
+                        // players should not be here, so logically neither should creatures
+                        useTerrain = false;
+                        useLiquid = false;
+                    }
+                    else if (liquidType & (MAP_LIQUID_TYPE_WATER | MAP_LIQUID_TYPE_OCEAN))
+                        liquidType = NAV_WATER;     // merge different types of water
+                    else if (liquidType & MAP_LIQUID_TYPE_MAGMA)
+                        liquidType = NAV_MAGMA;
+                    else if (liquidType & MAP_LIQUID_TYPE_SLIME)
+                        liquidType = NAV_SLIME;
+                    else
+                        useLiquid = false;
+                }
+
+                // if there is no terrain, don't use terrain
+                if (ttriangles.empty())
+                    useTerrain = false;
+
+                // while extracting ADT data we are losing right-bottom vertices
+                // this code adds fair approximation of lost data
+                if (useLiquid)
+                {
+                    float quadHeight = 0;
+                    uint32 validCount = 0;
+                    for (uint32 idx = 0; idx < 3; idx++)
+                    {
+                        float h = lvertsCopy[ltriangles[ltri + idx]*3 + 1];
+                        if (h != INVALID_MAP_LIQ_HEIGHT && h < INVALID_MAP_LIQ_HEIGHT_MAX)
+                        {
+                            quadHeight += h;
+                            validCount++;
+                        }
+                    }
+
+                    // update vertex height data
+                    if (validCount > 0 && validCount < 3)
+                    {
+                        quadHeight /= validCount;
+                        for (uint32 idx = 0; idx < 3; idx++)
+                        {
+                            float& h = lverts[ltriangles[ltri + idx]*3 + 1];
+                            if (h == INVALID_MAP_LIQ_HEIGHT || h > INVALID_MAP_LIQ_HEIGHT_MAX)
+                                h = quadHeight;
+                        }
+                    }
+
+                    // no valid vertexes - don't use this poly at all
+                    if (validCount == 0)
+                        useLiquid = false;
+                }
+
+                // if there is a hole here, don't use the terrain
+                if (useTerrain && fheader.holesSize != 0)
+                    useTerrain = !isHole(i, holes);
+
+                // we use only one terrain kind per quad - pick higher one
+                if (useTerrain && useLiquid)
+                {
+                    float minLLevel = INVALID_MAP_LIQ_HEIGHT_MAX;
+                    float maxLLevel = INVALID_MAP_LIQ_HEIGHT;
+                    for (uint32 x = 0; x < 3; x++)
+                    {
+                        float h = lverts[ltriangles[ltri + x]*3 + 1];
+                        if (minLLevel > h)
+                            minLLevel = h;
+
+                        if (maxLLevel < h)
+                            maxLLevel = h;
+                    }
+
+                    float maxTLevel = INVALID_MAP_LIQ_HEIGHT;
+                    float minTLevel = INVALID_MAP_LIQ_HEIGHT_MAX;
+                    for (uint32 x = 0; x < 6; x++)
+                    {
+                        float h = tverts[ttriangles[ttri + x]*3 + 1];
+                        if (maxTLevel < h)
+                            maxTLevel = h;
+
+                        if (minTLevel > h)
+                            minTLevel = h;
+                    }
+
+                    // terrain under the liquid?
+                    if (minLLevel > maxTLevel)
+                        useTerrain = false;
+
+                    //liquid under the terrain?
+                    if (minTLevel > maxLLevel)
+                        useLiquid = false;
+                }
+
+                // store the result
+                if (useLiquid)
+                {
+                    meshData.liquidType.push_back(liquidType);
+                    for (int k = 0; k < 3; ++k)
+                        meshData.liquidTris.push_back(ltriangles[ltri + k]);
+                }
+
+                if (useTerrain)
+                    for (int k = 0; k < 3*tTriCount/2; ++k)
+                        meshData.solidTris.push_back(ttriangles[ttri + k]);
+
+                // advance to next set of triangles
+                ltri += 3;
+                ttri += 3*tTriCount/2;
+            }
+        }
+
+        return !meshData.solidTris.empty() || !meshData.liquidTris.empty();
+    }
+
+    /**************************************************************************/
+    void TerrainBuilder::getHeightCoord(int index, Grid grid, float xOffset, float yOffset, float* coord, float const* v) const
+    {
+        // wow coords: x, y, height
+        // coord is mirroed about the horizontal axes
+        switch (grid)
+        {
+            case GRID_V9:
+                coord[0] = (xOffset + index%(V9_SIZE)*GRID_PART_SIZE) * -1.f;
+                coord[1] = (yOffset + (int)(index/(V9_SIZE))*GRID_PART_SIZE) * -1.f;
+                coord[2] = v[index];
+                break;
+            case GRID_V8:
+                coord[0] = (xOffset + index%(V8_SIZE)*GRID_PART_SIZE + GRID_PART_SIZE/2.f) * -1.f;
+                coord[1] = (yOffset + (int)(index/(V8_SIZE))*GRID_PART_SIZE + GRID_PART_SIZE/2.f) * -1.f;
+                coord[2] = v[index];
+                break;
+        }
+    }
+
+    /**************************************************************************/
+    void TerrainBuilder::getHeightTriangle(int square, Spot triangle, int* indices, bool liquid/* = false*/) const
+    {
+        int rowOffset = square/V8_SIZE;
+        if (!liquid)
+            switch (triangle)
+            {
+                case TOP:
+                    indices[0] = square+rowOffset;                  //           0-----1 .... 128
+                    indices[1] = square+1+rowOffset;                //           |\ T /|
+                    indices[2] = (V9_SIZE_SQ)+square;               //           | \ / |
+                    break;                                          //           |L 0 R| .. 127
+                case LEFT:                                          //           | / \ |
+                    indices[0] = square+rowOffset;                  //           |/ B \|
+                    indices[1] = (V9_SIZE_SQ)+square;               //          129---130 ... 386
+                    indices[2] = square+V9_SIZE+rowOffset;          //           |\   /|
+                    break;                                          //           | \ / |
+                case RIGHT:                                         //           | 128 | .. 255
+                    indices[0] = square+1+rowOffset;                //           | / \ |
+                    indices[1] = square+V9_SIZE+1+rowOffset;        //           |/   \|
+                    indices[2] = (V9_SIZE_SQ)+square;               //          258---259 ... 515
+                    break;
+                case BOTTOM:
+                    indices[0] = (V9_SIZE_SQ)+square;
+                    indices[1] = square+V9_SIZE+1+rowOffset;
+                    indices[2] = square+V9_SIZE+rowOffset;
+                    break;
+                default: break;
+            }
+        else
+            switch (triangle)
+            {                                                           //           0-----1 .... 128
+                case TOP:                                               //           |\    |
+                    indices[0] = square+rowOffset;                      //           | \ T |
+                    indices[1] = square+1+rowOffset;                    //           |  \  |
+                    indices[2] = square+V9_SIZE+1+rowOffset;            //           | B \ |
+                    break;                                              //           |    \|
+                case BOTTOM:                                            //          129---130 ... 386
+                    indices[0] = square+rowOffset;                      //           |\    |
+                    indices[1] = square+V9_SIZE+1+rowOffset;            //           | \   |
+                    indices[2] = square+V9_SIZE+rowOffset;              //           |  \  |
+                    break;                                              //           |   \ |
+                default: break;                                         //           |    \|
+            }                                                           //          258---259 ... 515
+    }
+
+    /**************************************************************************/
+    void TerrainBuilder::getLiquidCoord(int index, int index2, float xOffset, float yOffset, float* coord, float const* v) const
+    {
+        // wow coords: x, y, height
+        // coord is mirroed about the horizontal axes
+        coord[0] = (xOffset + index%(V9_SIZE)*GRID_PART_SIZE) * -1.f;
+        coord[1] = (yOffset + (int)(index/(V9_SIZE))*GRID_PART_SIZE) * -1.f;
+        coord[2] = v[index2];
+    }
+
+    static uint16 holetab_h[4] = {0x1111, 0x2222, 0x4444, 0x8888};
+    static uint16 holetab_v[4] = {0x000F, 0x00F0, 0x0F00, 0xF000};
+
+    /**************************************************************************/
+    bool TerrainBuilder::isHole(int square, uint16 const holes[16][16]) const
+    {
+        int row = square / 128;
+        int col = square % 128;
+        int cellRow = row / 8;     // 8 squares per cell
+        int cellCol = col / 8;
+        int holeRow = row % 8 / 2;
+        int holeCol = (square - (row * 128 + cellCol * 8)) / 2;
+
+        uint16 hole = holes[cellRow][cellCol];
+
+        return (hole & holetab_h[holeCol] & holetab_v[holeRow]) != 0;
+    }
+
+    /**************************************************************************/
+    uint8 TerrainBuilder::getLiquidType(int square, uint8 const liquidFlags[16*16]) const
+    {
+        int row = square / 128;
+        int col = square % 128;
+        int cellRow = row / 8;     // 8 squares per cell
+        int cellCol = col / 8;
+
+        return liquidFlags[cellRow*16 + cellCol];
+    }
+
+    /**************************************************************************/
+    bool TerrainBuilder::readTileSpawns(uint32 mapID, uint32 tileX, uint32 tileY, std::vector<VMAP::ModelSpawn> &spawns) const
+    {
+        char fileName[255];
+        char chunk[8];
+
+        snprintf(fileName, sizeof(fileName), "%s/vmaps/%03u.vmtree", m_dataPath.c_str(), mapID);
+        FILE* rf = fopen(fileName, "rb");
+        if (!rf)
+            return false;
+
+        char tiled = '\0';
+        bool success = VMAP::readChunk(rf, chunk, VMAP::VMAP_MAGIC, 8) && fread(&tiled, sizeof(char), 1, rf) == 1;
+
+        // non-tiled maps have exactly one global spawn, stored after the model tree
+        if (success && !tiled)
+        {
+            VMAP::ModelSpawn spawn;
+            BIH tree;
+            if (VMAP::readChunk(rf, chunk, "NODE", 4) && tree.readFromFile(rf) &&
+                VMAP::readChunk(rf, chunk, "GOBJ", 4) && VMAP::ModelSpawn::readFromFile(rf, spawn))
+                spawns.push_back(spawn);
+        }
+
+        fclose(rf);
+
+        if (!success || !tiled)
+            return success;
+
+        // vmtiles are named the other way round than the .map files
+        snprintf(fileName, sizeof(fileName), "%s/vmaps/%03u_%02u_%02u.vmtile", m_dataPath.c_str(), mapID, tileX, tileY);
+        FILE* tf = fopen(fileName, "rb");
+        if (!tf)
+            return false;
+
+        uint32 numSpawns = 0;
+        success = VMAP::readChunk(tf, chunk, VMAP::VMAP_MAGIC, 8) && fread(&numSpawns, sizeof(uint32), 1, tf) == 1;
+        for (uint32 i = 0; i < numSpawns && success; ++i)
+        {
+            VMAP::ModelSpawn spawn;
+            uint32 referencedVal;
+            success = VMAP::ModelSpawn::readFromFile(tf, spawn) && fread(&referencedVal, sizeof(uint32), 1, tf) == 1;
+            if (success)
+                spawns.push_back(spawn);
+        }
+
+        fclose(tf);
+        return success;
+    }
+
+    /**************************************************************************/
+    VMAP::WorldModel* TerrainBuilder::getModel(std::string const& name)
+    {
+        auto itr = m_models.find(name);
+        if (itr != m_models.end())
+            return itr->second.get();
+
+        std::unique_ptr<VMAP::WorldModel> model(new VMAP::WorldModel());
+        if (!model->readFile(m_dataPath + "/vmaps/" + name + ".vmo"))
+        {
+            printf("TerrainBuilder::getModel: could not load '%s'\n", name.c_str());
+            model.reset();
+        }
+
+        // failed loads are cached as well, so they are only reported once
+        return (m_models[name] = std::move(model)).get();
+    }
+
+    /**************************************************************************/
+    bool TerrainBuilder::loadVMap(uint32 mapID, uint32 tileX, uint32 tileY, MeshData &meshData)
+    {
+        std::vector<VMAP::ModelSpawn> spawns;
+        if (!readTileSpawns(mapID, tileX, tileY, spawns))
+            return false;
+
+        bool retval = false;
+        for (std::vector<VMAP::ModelSpawn>::const_iterator itr = spawns.begin(); itr != spawns.end(); ++itr)
+        {
+            VMAP::WorldModel* model = getModel(itr->name);
+            if (!model)
+                continue;
+
+            // now we have a model to add to the meshdata
+            retval = true;
+            addModel(*itr, model, meshData);
+        }
+
+        return retval;
+    }
+
+    /**************************************************************************/
+    void TerrainBuilder::addModel(VMAP::ModelSpawn const& spawn, VMAP::WorldModel* model, MeshData &meshData) const
+    {
+        std::vector<VMAP::GroupModel> groupModels;
+        model->getGroupModels(groupModels);
+
+        // all M2s need to have triangle indices reversed
+        bool isM2 = (spawn.flags & VMAP::MOD_M2) != 0;
+
+        // transform data
+        float scale = spawn.iScale;
+        G3D::Matrix3 rotation = G3D::Matrix3::fromEulerAnglesXYZ(G3D::pi()*spawn.iRot.z/-180.f, G3D::pi()*spawn.iRot.x/-180.f, G3D::pi()*spawn.iRot.y/-180.f);
+        G3D::Vector3 position = spawn.iPos;
+        position.x -= 32*GRID_SIZE;
+        position.y -= 32*GRID_SIZE;
+
+        for (std::vector<VMAP::GroupModel>::iterator it = groupModels.begin(); it != groupModels.end(); ++it)
+        {
+            std::vector<G3D::Vector3> tempVertices;
+            std::vector<VMAP::MeshTriangle> tempTriangles;
+            VMAP::WmoLiquid* liquid = NULL;
+
+            it->getMeshData(tempVertices, tempTriangles, liquid);
+
+            // first handle collision mesh
+            int offset = meshData.solidVerts.size() / 3;
+            for (std::vector<G3D::Vector3>::const_iterator v = tempVertices.begin(); v != tempVertices.end(); ++v)
+            {
+                // apply tranform, then mirror along the horizontal axes
+                G3D::Vector3 vert = (*v) * rotation * scale + position;
+                meshData.solidVerts.push_back(-vert.y);
+                meshData.solidVerts.push_back(vert.z);
+                meshData.solidVerts.push_back(-vert.x);
+            }
+
+            for (std::vector<VMAP::MeshTriangle>::const_iterator t = tempTriangles.begin(); t != tempTriangles.end(); ++t)
+            {
+                if (isM2)
+                {
+                    meshData.solidTris.push_back(t->idx2 + offset);
+                    meshData.solidTris.push_back(t->idx1 + offset);
+                    meshData.solidTris.push_back(t->idx0 + offset);
+                }
+                else
+                {
+                    meshData.solidTris.push_back(t->idx0 + offset);
+                    meshData.solidTris.push_back(t->idx1 + offset);
+                    meshData.solidTris.push_back(t->idx2 + offset);
+                }
+            }
+
+            // now handle liquid data
+            if (!liquid || !liquid->GetFlagsStorage() || m_skipLiquid)
+                continue;
+
+            uint32 tilesX, tilesY, vertsX, vertsY;
+            G3D::Vector3 corner;
+            liquid->getPosInfo(tilesX, tilesY, corner);
+            vertsX = tilesX + 1;
+            vertsY = tilesY + 1;
+            uint8* flags = liquid->GetFlagsStorage();
+            float* data = liquid->GetHeightStorage();
+            uint8 type = NAV_EMPTY;
+
+            // convert liquid type to NavTerrain
+            switch (liquid->GetType() & 3)
+            {
+                case 0:
+                case 1:
+                    type = NAV_WATER;
+                    break;
+                case 2:
+                    type = NAV_MAGMA;
+                    break;
+                case 3:
+                    type = NAV_SLIME;
+                    break;
+            }
+
+            // indexing is weird...
+            // after a lot of trial and error, this is what works:
+            // vertex = y*vertsX+x
+            // tile   = x*tilesY+y
+            // flag   = y*tilesY+x
+            uint32 liqOffset = meshData.liquidVerts.size() / 3;
+            for (uint32 x = 0; x < vertsX; ++x)
+                for (uint32 y = 0; y < vertsY; ++y)
+                {
+                    G3D::Vector3 vert(corner.x + x * GRID_PART_SIZE, corner.y + y * GRID_PART_SIZE, data[y*vertsX + x]);
+                    vert = vert * rotation * scale + position;
+                    meshData.liquidVerts.push_back(-vert.y);
+                    meshData.liquidVerts.push_back(vert.z);
+                    meshData.liquidVerts.push_back(-vert.x);
+                }
+
+            for (uint32 x = 0; x < tilesX; ++x)
+                for (uint32 y = 0; y < tilesY; ++y)
+                    if ((flags[x+y*tilesX] & 0x0f) != 0x0f)
+                    {
+                        uint32 square = x * tilesY + y;
+                        int idx1 = square+x;
+                        int idx2 = square+1+x;
+                        int idx3 = square+tilesY+1+1+x;
+                        int idx4 = square+tilesY+1+x;
+
+                        // top triangle
+                        meshData.liquidTris.push_back(idx2 + liqOffset);
+                        meshData.liquidTris.push_back(idx1 + liqOffset);
+                        meshData.liquidTris.push_back(idx3 + liqOffset);
+                        meshData.liquidType.push_back(type);
+
+                        // bottom triangle
+                        meshData.liquidTris.push_back(idx3 + liqOffset);
+                        meshData.liquidTris.push_back(idx1 + liqOffset);
+                        meshData.liquidTris.push_back(idx4 + liqOffset);
+                        meshData.liquidType.push_back(type);
+                    }
+        }
+    }
+
+    /**************************************************************************/
+    void TerrainBuilder::cleanVertices(std::vector<float> &verts, std::vector<int> &tris)
+    {
+        std::unordered_map<int, int> vertMap;
+        std::vector<float> cleanVerts;
+        cleanVerts.reserve(verts.size());
+
+        // collect all the vertex indices from triangle
+        for (std::vector<int>::iterator itr = tris.begin(); itr != tris.end(); ++itr)
+        {
+            auto found = vertMap.find(*itr);
+            if (found != vertMap.end())
+            {
+                *itr = found->second;
+                continue;
+            }
+
+            int index = cleanVerts.size() / 3;
+            cleanVerts.push_back(verts[(*itr)*3]);
+            cleanVerts.push_back(verts[(*itr)*3+1]);
+            cleanVerts.push_back(verts[(*itr)*3+2]);
+
+            vertMap[*itr] = index;
+            *itr = index;
+        }
+
+        verts.swap(cleanVerts);
+    }
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _MMAP_TERRAIN_BUILDER_H
+#define _MMAP_TERRAIN_BUILDER_H
+
+#include "MapDefines.h"
+#include "ModelInstance.h"
+#include "WorldModel.h"
+
+#include <G3D/Matrix3.h>
+#include <G3D/Vector3.h>
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace MMAP
+{
+    enum Spot
+    {
+        TOP     = 1,
+        RIGHT   = 2,
+        LEFT    = 3,
+        BOTTOM  = 4,
+        ENTIRE  = 5
+    };
+
+    enum Grid
+    {
+        GRID_V8,
+        GRID_V9
+    };
+
+    static const int V9_SIZE = 129;
+    static const int V9_SIZE_SQ = V9_SIZE*V9_SIZE;
+    static const int V8_SIZE = 128;
+    static const int V8_SIZE_SQ = V8_SIZE*V8_SIZE;
+    static const float GRID_SIZE = 533.3333f;
+    static const float GRID_PART_SIZE = GRID_SIZE/V8_SIZE;
+
+    // see map_extractor/System.cpp, CONF_use_minHeight
+    static const float INVALID_MAP_LIQ_HEIGHT = -500.f;
+    static const float INVALID_MAP_LIQ_HEIGHT_MAX = 5000.0f;
+
+    // Recast coordinates: x = wow y, y = wow z, z = wow x
+    struct MeshData
+    {
+        std::vector<float> solidVerts;
+        std::vector<int> solidTris;
+
+        std::vector<float> liquidVerts;
+        std::vector<int> liquidTris;
+        std::vector<uint8> liquidType;
+    };
+
+    // Collects the terrain and the static models of one tile. Every worker
+    // thread owns its own builder, the model cache is not shared.
+    class TerrainBuilder
+    {
+        public:
+            TerrainBuilder(std::string const& dataPath, bool skipLiquid);
+
+            // terrain of the tile plus the adjacent strips of the neighbours, so the tile borders are seamless
+            bool loadMap(uint32 mapID, uint32 tileX, uint32 tileY, MeshData &meshData);
+            bool loadVMap(uint32 mapID, uint32 tileX, uint32 tileY, MeshData &meshData);
+
+            bool usesLiquids() const { return !m_skipLiquid; }
+
+            // drops cached models, called between maps
+            void clearModels() { m_models.clear(); }
+
+            // removes vertices not referenced by any triangle
+            static void cleanVertices(std::vector<float> &verts, std::vector<int> &tris);
+
+        private:
+            bool loadMap(uint32 mapID, uint32 tileX, uint32 tileY, MeshData &meshData, Spot portion);
+            bool readTileSpawns(uint32 mapID, uint32 tileX, uint32 tileY, std::vector<VMAP::ModelSpawn> &spawns) const;
+            VMAP::WorldModel* getModel(std::string const& name);
+
+            void addModel(VMAP::ModelSpawn const& spawn, VMAP::WorldModel* model, MeshData &meshData) const;
+
+            void getLoopVars(Spot portion, int &loopStart, int &loopEnd, int &loopInc) const;
+            void getHeightCoord(int index, Grid grid, float xOffset, float yOffset, float* coord, float const* v) const;
+            void getHeightTriangle(int square, Spot triangle, int* indices, bool liquid = false) const;
+            void getLiquidCoord(int index, int index2, float xOffset, float yOffset, float* coord, float const* v) const;
+            bool isHole(int square, uint16 const holes[16][16]) const;
+            uint8 getLiquidType(int square, uint8 const liquidFlags[16*16]) const;
+
+            std::string m_dataPath;
+            bool m_skipLiquid;
+
+            std::unordered_map<std::string, std::unique_ptr<VMAP::WorldModel>> m_models;
+    };
+}
+
+#endif
@@ -0,0 +1,216 @@
+/*
+ * Copyright (C) 2008-2013 TrinityCore <http://www.trinitycore.org/>
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2 of the License, or (at your
+ * option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "PathCommon.h"
+#include "MapBuilder.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <thread>
+
+#ifdef _WIN32
+    #include <direct.h>
+#else
+    #include <sys/stat.h>
+#endif
+
+using namespace MMAP;
+
+bool checkDirectories(std::string const& dataPath)
+{
+    std::vector<std::string> dirFiles;
+
+    if (getDirContents(dirFiles, dataPath + "/maps") == LISTFILE_DIRECTORY_NOT_FOUND || dirFiles.empty())
+    {
+        printf("'maps' directory is empty or does not exist\n");
+        return false;
+    }
+
+    dirFiles.clear();
+    if (getDirContents(dirFiles, dataPath + "/vmaps", "*.vmtree") == LISTFILE_DIRECTORY_NOT_FOUND || dirFiles.empty())
+    {
+        printf("'vmaps' directory is empty or does not exist\n");
+        return false;
+    }
+
+    std::string const mmapsPath = dataPath + "/mmaps";
+#ifdef _WIN32
+    _mkdir(mmapsPath.c_str());
+#else
+    mkdir(mmapsPath.c_str(), S_IRWXU | S_IRWXG | S_IRWXO); // 0777
+#endif
+
+    dirFiles.clear();
+    if (getDirContents(dirFiles, mmapsPath) == LISTFILE_DIRECTORY_NOT_FOUND)
+    {
+        printf("'mmaps' directory does not exist and could not be created\n");
+        return false;
+    }
+
+    return true;
+}
+
+void printUsage(char const* name)
+{
+    printf("Usage: %s [mapId] [options]\n", name);
+    printf("    --threads [#]       number of tiles built at the same time, defaults to the number of cores\n");
+    printf("    --tile [#,#]        build only the given tile of mapId, tile coordinates as in the .map file name\n");
+    printf("    --maxAngle [#]      max walkable inclination angle, defaults to 60\n");
+    printf("    --dataDir [path]    directory containing maps and vmaps, mmaps are written there as well\n");
+    printf("    --skipLiquid        do not include liquid in the navmesh\n");
+    printf("    --bigBaseUnit       use a coarser voxel size, builds faster at the cost of precision\n");
+    printf("    --silent            do not print progress per tile\n");
+}
+
+bool handleArgs(int argc, char** argv,
+               int &mapnum,
+               int &tileX,
+               int &tileY,
+               float &maxAngle,
+               uint32 &threads,
+               std::string &dataPath,
+               bool &skipLiquid,
+               bool &bigBaseUnit,
+               bool &silent)
+{
+    char* param = NULL;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--maxAngle") == 0)
+        {
+            param = argv[++i];
+            if (!param)
+                return false;
+
+            float maxangle = atof(param);
+            if (maxangle <= 90.f && maxangle >= 45.f)
+                maxAngle = maxangle;
+            else
+                printf("invalid option for '--maxAngle', using default\n");
+        }
+        else if (strcmp(argv[i], "--threads") == 0)
+        {
+            param = argv[++i];
+            if (!param)
+                return false;
+
+            int count = atoi(param);
+            if (count > 0)
+                threads = count;
+            else
+                printf("invalid option for '--threads', using default\n");
+        }
+        else if (strcmp(argv[i], "--tile") == 0)
+        {
+            param = argv[++i];
+            if (!param)
+                return false;
+
+            char* stileX = strtok(param, ",");
+            char* stileY = strtok(NULL, ",");
+            if (!stileX || !stileY)
+            {
+                printf("invalid tile coords.\n");
+                return false;
+            }
+
+            // the .map file name has the x coordinate of the grid first, which is tileY here
+            tileY = atoi(stileX);
+            tileX = atoi(stileY);
+
+            if (tileX < 0 || tileY < 0 || tileX > 63 || tileY > 63)
+            {
+                printf("invalid tile coords.\n");
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--dataDir") == 0)
+        {
+            param = argv[++i];
+            if (!param)
+                return false;
+
+            dataPath = param;
+        }
+        else if (strcmp(argv[i], "--skipLiquid") == 0)
+            skipLiquid = true;
+        else if (strcmp(argv[i], "--bigBaseUnit") == 0)
+            bigBaseUnit = true;
+        else if (strcmp(argv[i], "--silent") == 0)
+            silent = true;
+        else if (strcmp(argv[i], "-?") == 0 || strcmp(argv[i], "--help") == 0)
+            return false;
+        else
+        {
+            int map = atoi(argv[i]);
+            if (map > 0 || (map == 0 && (strcmp(argv[i], "0") == 0)))
+                mapnum = map;
+            else
+            {
+                printf("invalid map id\n");
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    int mapnum = -1;
+    int tileX = -1, tileY = -1;
+    float maxAngle = 60.0f;
+    uint32 threads = std::thread::hardware_concurrency();
+    std::string dataPath = ".";
+    bool skipLiquid = false;
+    bool bigBaseUnit = false;
+    bool silent = false;
+
+    if (!handleArgs(argc, argv, mapnum, tileX, tileY, maxAngle, threads, dataPath, skipLiquid, bigBaseUnit, silent))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if ((tileX >= 0 || tileY >= 0) && mapnum < 0)
+    {
+        printf("--tile requires a mapId\n");
+        return 1;
+    }
+
+    if (!checkDirectories(dataPath))
+        return 1;
+
+    clock_t const start = clock();
+    time_t const startTime = time(NULL);
+
+    MapBuilder builder(dataPath, maxAngle, skipLiquid, bigBaseUnit, silent);
+
+    if (tileX >= 0 && tileY >= 0)
+        builder.buildSingleTile(mapnum, tileX, tileY);
+    else if (mapnum >= 0)
+        builder.buildMap(uint32(mapnum), threads);
+    else
+        builder.buildAllMaps(threads);
+
+    printf("Finished in %u seconds (%.1f seconds of CPU time)\n", uint32(time(NULL) - startTime),
+        double(clock() - start) / CLOCKS_PER_SEC);
+    return 0;
+}
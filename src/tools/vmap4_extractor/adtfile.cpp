@@ -78,14 +78,19 @@ char* GetExtension(char* FileName)
     return NULL;
 }
 
-extern HANDLE WorldMpq;
+extern thread_local HANDLE WorldMpq;
 
 ADTFile::ADTFile(char* filename) : ADT(WorldMpq, filename, false)
 {
     Adtfilename.append(filename);
 }
 
-bool ADTFile::init(uint32 map_num, uint32 tileX, uint32 tileY)
+uint64 ADTFile::checksum(uint64 hash)
+{
+    return HashData(hash, ADT.getBuffer(), ADT.getSize());
+}
+
+bool ADTFile::init(uint32 map_num, uint32 tileX, uint32 tileY, FILE* dirfile)
 {
     if(ADT.isEof())
         return false;
@@ -107,15 +112,6 @@ bool ADTFile::init(uint32 map_num, uint32 tileX, uint32 tileY)
     //printf("xMap = %s\n", xMap.c_str());
     //printf("yMap = %s\n", yMap.c_str());
 
-    std::string dirname = std::string(szWorkDirWmo) + "/dir_bin";
-    FILE *dirfile;
-    dirfile = fopen(dirname.c_str(), "ab");
-    if(!dirfile)
-    {
-        printf("Can't open dirfile!'%s'\n", dirname.c_str());
-        return false;
-    }
-
     while (!ADT.isEof())
     {
         char fourcc[5];
@@ -222,7 +218,6 @@ bool ADTFile::init(uint32 map_num, uint32 tileX, uint32 tileY)
     }
 
     ADT.close();
-    fclose(dirfile);
     return true;
 }
 
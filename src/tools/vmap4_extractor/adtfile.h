@@ -122,7 +122,9 @@ public:
     int nMDX;
     std::string* WmoInstanceNames;
     std::string* ModelInstanceNames;
-    bool init(uint32 map_num, uint32 tileX, uint32 tileY);
+    bool isValid() { return !ADT.isEof(); }
+    uint64 checksum(uint64 hash);
+    bool init(uint32 map_num, uint32 tileX, uint32 tileY, FILE* dirfile);
     //void LoadMapChunks();
 
     //uint32 wmo_count;
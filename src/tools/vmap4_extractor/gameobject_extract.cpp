@@ -43,14 +43,28 @@ bool ExtractSingleModel(std::string& fname)
     output += "/";
     output += name;
 
+    // a file another thread could not extract is missing once the claim returns
+    ExtractedFileClaim claim(output);
     if (FileExists(output.c_str()))
         return true;
 
+    if (!claim.isOwner())
+        return false;
+
     Model mdl(originalName);
     if (!mdl.open())
         return false;
 
-    return mdl.ConvertToVMAPModel(output.c_str());
+    // written aside and renamed, a file left by an interrupted run is never taken as extracted on resume
+    std::string temp = output + ".tmp";
+    if (!mdl.ConvertToVMAPModel(temp.c_str()))
+    {
+        remove(temp.c_str());
+        return false;
+    }
+
+    remove(output.c_str());
+    return rename(temp.c_str(), output.c_str()) == 0;
 }
 
 extern HANDLE LocaleMpq;
@@ -25,7 +25,7 @@
 #include <algorithm>
 #include <cstdio>
 
-extern HANDLE WorldMpq;
+extern thread_local HANDLE WorldMpq;
 
 Model::Model(std::string &filename) : filename(filename), vertices(0), indices(0)
 {
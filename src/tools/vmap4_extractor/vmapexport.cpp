@@ -18,10 +18,15 @@
  */
 
 #define _CRT_SECURE_NO_DEPRECATE
+#include <atomic>
+#include <condition_variable>
 #include <cstdio>
 #include <iostream>
 #include <vector>
 #include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <errno.h>
 
 #ifdef WIN32
@@ -58,10 +63,13 @@
 
 //-----------------------------------------------------------------------------
 
-HANDLE WorldMpq = NULL;
+// every thread parsing tiles opens its own set of archives, StormLib handles are not thread safe
+thread_local HANDLE WorldMpq = NULL;
 HANDLE LocaleMpq = NULL;
 
 uint32 CONF_TargetBuild = 17399;              // 5.4.0.17399
+uint32 CONF_threads = 0;                      // tiles parsed at the same time, 0 uses all cores
+bool CONF_resume = false;                     // reuse the spawns of tiles unchanged since the last run
 
 // List MPQ for extract maps from
 char const* CONF_mpq_list[]=
@@ -169,12 +177,13 @@ bool LoadLocaleMPQFile(int locale)
     return true;
 }
 
-void LoadCommonMPQFiles(uint32 build)
+void LoadCommonMPQFiles(uint32 build, bool log = true)
 {
     TCHAR filename[512];
 
     _stprintf(filename, _T("%sworld.MPQ"), input_path);
-    _tprintf(_T("Loading common MPQ files\n"));
+    if (log)
+        _tprintf(_T("Loading common MPQ files\n"));
 
     if (!SFileOpenArchive(filename, 0, MPQ_OPEN_READ_ONLY, &WorldMpq))
     {
@@ -191,10 +200,10 @@ void LoadCommonMPQFiles(uint32 build)
         {
             if (GetLastError() != ERROR_PATH_NOT_FOUND)
                 _tprintf(_T("Cannot open archive %s\n"), filename);
-            else
+            else if (log)
                 _tprintf(_T("Not found %s\n"), filename);
         }
-        else
+        else if (log)
             _tprintf(_T("Loaded %s\n"), filename);
     }
 
@@ -212,15 +221,16 @@ void LoadCommonMPQFiles(uint32 build)
         {
             if (GetLastError() != ERROR_PATH_NOT_FOUND)
                 _tprintf(_T("Cannot open patch archive %s\n"), filename);
-            else
+            else if (log)
                 _tprintf(_T("Not found %s\n"), filename);
             continue;
         }
-        else
+        else if (log)
             _tprintf(_T("Loaded %s\n"), filename);
     }
 
-    printf("\n");
+    if (log)
+        printf("\n");
 }
 
 
@@ -236,6 +246,49 @@ bool FileExists(const char* file)
     return false;
 }
 
+uint64_t HashData(uint64_t hash, void const* data, size_t size)
+{
+    // FNV-1a
+    uint8 const* bytes = static_cast<uint8 const*>(data);
+    for (size_t i = 0; i < size; ++i)
+        hash = (hash ^ bytes[i]) * 0x100000001B3ULL;
+    return hash;
+}
+
+namespace
+{
+    std::mutex claimLock;
+    std::condition_variable claimDone;
+    std::unordered_map<std::string, bool> claimedFiles;    // file name -> extraction finished
+}
+
+ExtractedFileClaim::ExtractedFileClaim(std::string const& fileName) : name(fileName), owner(false)
+{
+    std::unique_lock<std::mutex> guard(claimLock);
+    std::unordered_map<std::string, bool>::iterator itr = claimedFiles.find(name);
+    if (itr == claimedFiles.end())
+    {
+        claimedFiles[name] = false;
+        owner = true;
+        return;
+    }
+
+    claimDone.wait(guard, [this] { return claimedFiles[name]; });
+}
+
+ExtractedFileClaim::~ExtractedFileClaim()
+{
+    if (!owner)
+        return;
+
+    {
+        std::lock_guard<std::mutex> guard(claimLock);
+        claimedFiles[name] = true;
+    }
+
+    claimDone.notify_all();
+}
+
 void strToLower(char* str)
 {
     while(*str)
@@ -327,9 +380,6 @@ bool ExtractSingleWmo(std::string& fname)
     sprintf(szLocalFile, "%s/%s", szWorkDirWmo, plain_name);
     FixNameCase(szLocalFile,strlen(szLocalFile));
 
-    if (FileExists(szLocalFile))
-        return true;
-
     int p = 0;
     // Select root wmo files
     char const* rchr = strrchr(plain_name, '_');
@@ -348,6 +398,14 @@ bool ExtractSingleWmo(std::string& fname)
     if (p == 3)
         return true;
 
+    // another thread extracting the same root wmo may have failed
+    ExtractedFileClaim claim(szLocalFile);
+    if (!claim.isOwner())
+        return FileExists(szLocalFile);
+
+    if (FileExists(szLocalFile))
+        return true;
+
     bool file_ok = true;
     //std::cout << "Extracting " << fname << std::endl;
     WMORoot froot(fname);
@@ -356,10 +414,13 @@ bool ExtractSingleWmo(std::string& fname)
         printf("Couldn't open RootWmo!!!\n");
         return true;
     }
-    FILE *output = fopen(szLocalFile,"wb");
+    // written aside and renamed, a file left by an interrupted run is never taken as extracted on resume
+    char szTempFile[1024 + 4];
+    sprintf(szTempFile, "%s.tmp", szLocalFile);
+    FILE *output = fopen(szTempFile,"wb");
     if(!output)
     {
-        printf("couldn't open %s for writing!\n", szLocalFile);
+        printf("couldn't open %s for writing!\n", szTempFile);
         return false;
     }
     froot.ConvertToVMAPRootWmo(output);
@@ -395,47 +456,272 @@ bool ExtractSingleWmo(std::string& fname)
 
     // Delete the extracted file in the case of an error
     if (!file_ok)
-        remove(szLocalFile);
-    return true;
+    {
+        remove(szTempFile);
+        return true;
+    }
+
+    remove(szLocalFile);
+    return rename(szTempFile, szLocalFile) == 0;
+}
+
+struct MapJob
+{
+    uint32 id;
+    char const* name;
+    std::vector<char> wdtRecords;     // global wmo spawns, written before the first tile
+};
+
+struct TileResult
+{
+    TileResult() : exists(false), checksum(0) { }
+
+    bool exists;
+    uint64 checksum;
+    std::vector<char> records;
+};
+
+#define TILES_PER_MAP 4096
+
+// Spawns of every tile, saved with dir_bin so that a resumed run can reuse
+// them for tiles whose adts did not change
+typedef std::unordered_map<uint32, TileResult> TileCache;
+
+uint32 TileCacheKey(uint32 mapId, uint32 x, uint32 y)
+{
+    return (mapId << 12) | (x << 6) | y;
+}
+
+void LoadTileCache(std::string const& fileName, TileCache& cache)
+{
+    FILE* file = fopen(fileName.c_str(), "rb");
+    if (!file)
+        return;
+
+    uint32 key, size;
+    uint64 checksum;
+    while (fread(&key, sizeof(key), 1, file) == 1 && fread(&checksum, sizeof(checksum), 1, file) == 1 &&
+        fread(&size, sizeof(size), 1, file) == 1)
+    {
+        TileResult& tile = cache[key];
+        tile.exists = true;
+        tile.checksum = checksum;
+        tile.records.resize(size);
+        if (size && fread(&tile.records[0], size, 1, file) != 1)
+        {
+            cache.erase(key);
+            break;
+        }
+    }
+
+    fclose(file);
+}
+
+// Instances write their spawn records to a file, collect them from a scratch file
+FILE* OpenScratchFile(uint32 id)
+{
+    char fileName[512];
+    sprintf(fileName, "%s/dir_bin.%u", szWorkDirWmo, id);
+    return fopen(fileName, "w+b");
+}
+
+void CloseScratchFile(FILE* file, uint32 id)
+{
+    char fileName[512];
+    sprintf(fileName, "%s/dir_bin.%u", szWorkDirWmo, id);
+    fclose(file);
+    remove(fileName);
+}
+
+void ReadScratchFile(FILE* file, std::vector<char>& records)
+{
+    long size = ftell(file);
+    records.resize(size > 0 ? size : 0);
+    rewind(file);
+    if (size > 0 && fread(&records[0], size, 1, file) != 1)
+        records.clear();
+    rewind(file);
 }
 
+// Tiles finish in any order, their records are written in the order the
+// extractor always used (map, x, y), so dir_bin does not depend on the threads
+class OrderedRecordWriter
+{
+public:
+    OrderedRecordWriter(std::vector<MapJob> const& maps, FILE* dirfile, FILE* cacheFile)
+        : _maps(maps), _dirfile(dirfile), _cacheFile(cacheFile), _next(0) { }
+
+    void submit(uint32 index, TileResult& result)
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        std::swap(_pending[index], result);
+
+        for (std::map<uint32, TileResult>::iterator itr = _pending.begin(); itr != _pending.end() && itr->first == _next; itr = _pending.begin())
+        {
+            write(_next, itr->second);
+            _pending.erase(itr);
+            ++_next;
+        }
+    }
+
+private:
+    void write(uint32 index, TileResult const& tile)
+    {
+        MapJob const& map = _maps[index / TILES_PER_MAP];
+        if (index % TILES_PER_MAP == 0)
+        {
+            printf("Processing Map %u\n", map.id);
+            if (!map.wdtRecords.empty())
+                fwrite(&map.wdtRecords[0], map.wdtRecords.size(), 1, _dirfile);
+        }
+
+        if (!tile.exists)
+            return;
+
+        if (!tile.records.empty())
+            fwrite(&tile.records[0], tile.records.size(), 1, _dirfile);
+
+        if (_cacheFile)
+        {
+            uint32 key = TileCacheKey(map.id, (index % TILES_PER_MAP) / 64, index % 64);
+            uint32 size = tile.records.size();
+            fwrite(&key, sizeof(key), 1, _cacheFile);
+            fwrite(&tile.checksum, sizeof(tile.checksum), 1, _cacheFile);
+            fwrite(&size, sizeof(size), 1, _cacheFile);
+            if (size)
+                fwrite(&tile.records[0], size, 1, _cacheFile);
+        }
+    }
+
+    std::vector<MapJob> const& _maps;
+    FILE* _dirfile;
+    FILE* _cacheFile;
+    std::mutex _lock;
+    uint32 _next;
+    std::map<uint32, TileResult> _pending;
+};
+
 void ParsMapFiles()
 {
     char fn[512];
     //char id_filename[64];
     char id[10];
-    for (unsigned int i = 0; i < map_count; ++i)
+
+    std::string const cacheName = std::string(szWorkDirWmo) + "/tile_cache";
+    TileCache cache;
+    if (CONF_resume)
+        LoadTileCache(cacheName, cache);
+
+    std::string const dirname = std::string(szWorkDirWmo) + "/dir_bin";
+    FILE* dirfile = fopen(dirname.c_str(), "wb");
+    if (!dirfile)
+    {
+        printf("Can't open dirfile!'%s'\n", dirname.c_str());
+        return;
+    }
+
+    FILE* cacheFile = fopen(cacheName.c_str(), "wb");
+
+    // global spawns first, this also extracts the wmos they reference
+    std::vector<MapJob> maps;
+    FILE* scratch = OpenScratchFile(0);
+    for (unsigned int i = 0; i < map_count && scratch; ++i)
     {
         sprintf(id, "%03u", map_ids[i].id);
         sprintf(fn, "World\\Maps\\%s\\%s.wdt", map_ids[i].name, map_ids[i].name);
         WDTFile WDT(fn, map_ids[i].name);
-        if(WDT.init(id, map_ids[i].id))
+        if (WDT.init(id, map_ids[i].id, scratch))
+        {
+            MapJob map;
+            map.id = map_ids[i].id;
+            map.name = map_ids[i].name;
+            ReadScratchFile(scratch, map.wdtRecords);
+            maps.push_back(map);
+        }
+        else
+            rewind(scratch);
+    }
+
+    if (scratch)
+        CloseScratchFile(scratch, 0);
+
+    uint32 threads = CONF_threads ? CONF_threads : std::thread::hardware_concurrency();
+    if (!threads)
+        threads = 1;
+
+    printf("Processing %u maps using %u threads\n", uint32(maps.size()), threads);
+
+    uint64 settingsHash = HashData(0xCBF29CE484222325ULL, szRawVMAPMagic, strlen(szRawVMAPMagic));
+    settingsHash = HashData(settingsHash, &preciseVectorData, sizeof(preciseVectorData));
+    settingsHash = HashData(settingsHash, &CONF_TargetBuild, sizeof(CONF_TargetBuild));
+
+    OrderedRecordWriter writer(maps, dirfile, cacheFile);
+    uint32 const tileCount = maps.size() * TILES_PER_MAP;
+    std::atomic<uint32> nextTile(0);
+    std::atomic<uint32> tilesReused(0);
+
+    std::vector<std::thread> workers;
+    for (uint32 i = 0; i < threads; ++i)
+    {
+        workers.push_back(std::thread([&, i]()
         {
-            printf("Processing Map %u\n[", map_ids[i].id);
-            for (int x = 0; x < 64; ++x)
+            LoadCommonMPQFiles(CONF_TargetBuild, false);
+            FILE* records = OpenScratchFile(i + 1);
+            if (!records)
             {
-                for (int y = 0; y < 64; ++y)
+                printf("Can't open scratch file of thread %u!\n", i + 1);
+                exit(1);
+            }
+
+            char name[512];
+            for (uint32 index = nextTile++; index < tileCount; index = nextTile++)
+            {
+                MapJob const& map = maps[index / TILES_PER_MAP];
+                uint32 const x = (index % TILES_PER_MAP) / 64;
+                uint32 const y = index % 64;
+
+                sprintf(name, "World\\Maps\\%s\\%s_%u_%u_obj0.adt", map.name, map.name, x, y);
+                ADTFile obj0(name);
+                sprintf(name, "World\\Maps\\%s\\%s_%u_%u_obj1.adt", map.name, map.name, x, y);
+                ADTFile obj1(name);
+
+                TileResult result;
+                if (obj0.isValid() || obj1.isValid())
                 {
-                    //if (!(WDT.adt_list[x][y].flag & 0x1))
-                    //    continue;
+                    result.exists = true;
+                    result.checksum = obj1.checksum(obj0.checksum(settingsHash));
 
-                    if (ADTFile *ADT = WDT.GetMap_obj0(x,y))
+                    TileCache::const_iterator cached = cache.find(TileCacheKey(map.id, x, y));
+                    if (cached != cache.end() && cached->second.checksum == result.checksum)
                     {
-                        ADT->init(map_ids[i].id, x, y);
-                        delete ADT;
+                        result.records = cached->second.records;
+                        ++tilesReused;
                     }
-                    if (ADTFile *ADT = WDT.GetMap_obj1(x,y))
+                    else
                     {
-                        ADT->init(map_ids[i].id, x, y);
-                        delete ADT;
+                        obj0.init(map.id, x, y, records);
+                        obj1.init(map.id, x, y, records);
+                        ReadScratchFile(records, result.records);
                     }
                 }
-                printf("#");
-                fflush(stdout);
+
+                writer.submit(index, result);
             }
-            printf("]\n");
-        }
+
+            CloseScratchFile(records, i + 1);
+            SFileCloseArchive(WorldMpq);
+        }));
     }
+
+    for (std::vector<std::thread>::iterator itr = workers.begin(); itr != workers.end(); ++itr)
+        itr->join();
+
+    if (tilesReused)
+        printf("Reused the spawns of %u unchanged tiles\n", uint32(tilesReused));
+
+    if (cacheFile)
+        fclose(cacheFile);
+    fclose(dirfile);
 }
 
 void getGamePath()
@@ -487,6 +773,15 @@ bool processArgv(int argc, char ** argv, const char *versionString)
             if (i + 1 < argc)                            // all ok
                 CONF_TargetBuild = atoi(argv[i++ + 1]);
         }
+        else if(strcmp("-t",argv[i]) == 0)
+        {
+            if (i + 1 < argc)                            // all ok
+                CONF_threads = atoi(argv[i++ + 1]);
+        }
+        else if(strcmp("-r",argv[i]) == 0)
+        {
+            CONF_resume = true;
+        }
         else
         {
             result = false;
@@ -497,11 +792,13 @@ bool processArgv(int argc, char ** argv, const char *versionString)
     if(!result)
     {
         printf("Extract %s.\n",versionString);
-        printf("%s [-?][-s][-l][-d <path>]\n", argv[0]);
+        printf("%s [-?][-s][-l][-d <path>][-t <threads>][-r]\n", argv[0]);
         printf("   -s : (default) small size (data size optimization), ~500MB less vmap data.\n");
         printf("   -l : large size, ~500MB more vmap data. (might contain more details)\n");
         printf("   -d <path>: Path to the vector data source folder.\n");
         printf("   -b : target build (default %u)\n", CONF_TargetBuild);
+        printf("   -t <threads>: number of threads parsing tiles (default: number of cores)\n");
+        printf("   -r : resume in a used output directory, tiles unchanged since the last run are not parsed again\n");
         printf("   -? : This message.\n");
     }
 
@@ -536,7 +833,7 @@ int main(int argc, char ** argv)
         std::string sdir = std::string(szWorkDirWmo) + "/dir";
         std::string sdir_bin = std::string(szWorkDirWmo) + "/dir_bin";
         struct stat status;
-        if (!stat(sdir.c_str(), &status) || !stat(sdir_bin.c_str(), &status))
+        if (!CONF_resume && (!stat(sdir.c_str(), &status) || !stat(sdir_bin.c_str(), &status)))
         {
             printf("Your output directory seems to be polluted, please use an empty directory!\n");
             printf("<press return to exit>");
@@ -20,6 +20,8 @@
 #ifndef VMAPEXPORT_H
 #define VMAPEXPORT_H
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 enum ModelFlags
@@ -34,6 +36,22 @@ extern const char * szRawVMAPMagic;                         // vmap magic string
 
 bool FileExists(const char * file);
 void strToLower(char* str);
+uint64_t HashData(uint64_t hash, void const* data, size_t size);
+
+// Models are referenced by many tiles. The first thread to ask for a file
+// extracts it, the others wait until it is complete.
+class ExtractedFileClaim
+{
+public:
+    explicit ExtractedFileClaim(std::string const& fileName);
+    ~ExtractedFileClaim();
+
+    bool isOwner() const { return owner; }
+
+private:
+    std::string name;
+    bool owner;
+};
 
 bool ExtractSingleWmo(std::string& fname);
 bool ExtractSingleModel(std::string& fname);
@@ -31,14 +31,14 @@ char * wdtGetPlainName(char * FileName)
     return FileName;
 }
 
-extern HANDLE WorldMpq;
+extern thread_local HANDLE WorldMpq;
 
 WDTFile::WDTFile(char* file_name, char* file_name1) : WDT(WorldMpq, file_name)
 {
     filename.append(file_name1, strlen(file_name1));
 }
 
-bool WDTFile::init(char* /*map_id*/, unsigned int mapID)
+bool WDTFile::init(char* /*map_id*/, unsigned int mapID, FILE* dirfile)
 {
     if (WDT.isEof())
     {
@@ -49,15 +49,6 @@ bool WDTFile::init(char* /*map_id*/, unsigned int mapID)
     char fourcc[5];
     uint32 size;
 
-    std::string dirname = std::string(szWorkDirWmo) + "/dir_bin";
-    FILE *dirfile;
-    dirfile = fopen(dirname.c_str(), "ab");
-    if(!dirfile)
-    {
-        printf("Can't open dirfile!'%s'\n", dirname.c_str());
-        return false;
-    }
-
     while (!WDT.isEof())
     {
         WDT.read(fourcc, 4);
@@ -84,10 +75,15 @@ bool WDTFile::init(char* /*map_id*/, unsigned int mapID)
                 gWmoInstansName = new string[size];
                 while (p < buf + size)
                 {
+                    std::string path(p);
+
                     char* s = wdtGetPlainName(p);
                     FixNameCase(s, strlen(s));
                     p = p + strlen(p) + 1;
                     gWmoInstansName[q++] = s;
+
+                    // extracted here rather than by whichever map happens to reference it first
+                    ExtractSingleWmo(path);
                 }
                 delete[] buf;
             }
@@ -113,7 +109,6 @@ bool WDTFile::init(char* /*map_id*/, unsigned int mapID)
     }
 
     WDT.close();
-    fclose(dirfile);
     return true;
 }
 
@@ -46,7 +46,7 @@ private:
 public:
     WDTFile(char* file_name, char* file_name1);
     ~WDTFile(void);
-    bool init(char* map_id, unsigned int mapID);
+    bool init(char* map_id, unsigned int mapID, FILE* dirfile);
 
     struct adtData{
         uint32 flag;
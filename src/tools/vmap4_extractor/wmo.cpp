@@ -40,7 +40,7 @@ WMORoot::WMORoot(std::string &filename)
     memset(bbcorn2, 0, sizeof(bbcorn2));
 }
 
-extern HANDLE WorldMpq;
+extern thread_local HANDLE WorldMpq;
 
 bool WMORoot::open()
 {